@@ -114,7 +114,10 @@ namespace Engine {
 				std::vector<glm::mat4> meshBones = std::vector<glm::mat4>(mesh->mNumBones, glm::mat4(1.0f));
 				out_result.skeleton->finalBoneMatrices.insert(out_result.skeleton->finalBoneMatrices.end(), meshBones.begin(), meshBones.end());
 			}
-			meshData = new MeshData(vertices, indices);
+			// Coarser levels share the vertices, the culling system picks a level for each mesh every frame
+			MeshLODChain lodChain;
+			if (generateLODs && mesh->mPrimitiveTypes == aiPrimitiveType_TRIANGLE) { lodChain = MeshSimplifier::BuildLODChain(vertices, indices); }
+			meshData = new MeshData(vertices, indices, lodChain);
 			resources->AddMeshData(fileAndMeshName, meshData, persistentResources);
 		}
 
@@ -242,6 +245,7 @@ namespace Engine {
 	}
 
 	bool ASSIMPModelLoader::loadMaterialsAsPBR = false;
+	bool ASSIMPModelLoader::generateLODs = true;
 	Material* ASSIMPModelLoader::LoadMaterialFromaiMat(const aiMaterial* material, const aiScene* scene, const std::string& filepath)
 	{
 		std::unordered_map<TextureTypes, aiTextureType> textureTranslations = ResourceManager::GetInstance()->GetTextureTranslations();
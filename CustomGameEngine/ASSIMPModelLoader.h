@@ -6,6 +6,7 @@
 #include <assimp/scene.h>
 #include <iostream>
 #include "ResourceManager.h"
+#include "MeshSimplifier.h"
 namespace Engine {
 	struct ProcessMeshResult {
 		MeshData* meshData;
@@ -47,5 +48,7 @@ namespace Engine {
 		}
 
 		static bool loadMaterialsAsPBR;
+		// Builds simplified levels of detail for each triangle mesh as it's loaded
+		static bool generateLODs;
 	};
 }
\ No newline at end of file
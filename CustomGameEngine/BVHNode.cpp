@@ -1,16 +0,0 @@
-#include "BVHNode.h"
-namespace Engine {
-	BVHNode::BVHNode(BVHNode* parent)
-	{
-		this->parentNode = parent;
-		this->leftChildNode = nullptr;
-		this->rightChildNode = nullptr;
-		isLeaf = false;
-	}
-
-	BVHNode::~BVHNode()
-	{
-		if (leftChildNode) { delete leftChildNode; }
-		if (rightChildNode) { delete rightChildNode; }
-	}
-}
\ No newline at end of file
@@ -1,39 +1,18 @@
 #pragma once
 #include "ComponentCollisionAABB.h"
-#include "Mesh.h"
+#include <glm/ext/vector_float3.hpp>
 namespace Engine {
-	class BVHNode
-	{
-	public:
-		BVHNode(BVHNode* parent = nullptr);
-		~BVHNode();
-
-		void SetParent(BVHNode* newParent) { this->parentNode = newParent; }
-		void SetLeftChild(BVHNode* newChild) { this->leftChildNode = newChild; }
-		void SetRightChild(BVHNode* newChild) { this->rightChildNode = newChild; }
-
-		void SetBoundingBox(const AABBPoints newBox) { this->boundingBox = newBox; }
-
-		const BVHNode* GetParent() const { return parentNode; }
-		const BVHNode* GetLeftChild() const { return leftChildNode; }
-		const BVHNode* GetRightChild() const { return rightChildNode; }
-
-		const bool IsLeaf() const { return isLeaf; }
-		void SetIsLeaf(const bool isLeaf) { this->isLeaf = isLeaf; }
-		
-		void SetObjectIndices(std::vector<unsigned int> indices) { this->globalObjectIndices = indices; }
-		const std::vector<unsigned int>& GetGlobalObjectIndices() const { return globalObjectIndices; }
-
-		const AABBPoints& GetBoundingBox() const { return boundingBox; }
-	private:
-		AABBPoints boundingBox;
-
-		BVHNode* parentNode;
-		BVHNode* leftChildNode;
-		BVHNode* rightChildNode;
-
-		std::vector<unsigned int> globalObjectIndices;
-
-		bool isLeaf;
+	// Node of the scene geometry BVH, 32 bytes. Nodes are stored depth first so an interior node's left child is always the next node
+	// Leaves have count > 0 and hold the objects BVHTree::GetObjectIndices()[first, first + count). Interior nodes have count 0 and their right child at first
+	struct BVHNode {
+		glm::vec3 boundsMin;
+		unsigned int first;
+		glm::vec3 boundsMax;
+		unsigned int count;
+
+		bool IsLeaf() const { return count > 0; }
+		AABBPoints GetBoundingBox() const { return AABBPoints(boundsMin.x, boundsMin.y, boundsMin.z, boundsMax.x, boundsMax.y, boundsMax.z); }
 	};
-}
\ No newline at end of file
+
+	static_assert(sizeof(BVHNode) == 32, "BVHNode is expected to be two to a cache line");
+}
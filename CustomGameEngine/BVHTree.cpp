@@ -1,86 +1,534 @@
 #include "BVHTree.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cfloat>
+#include <initializer_list>
 namespace Engine {
-	BVHTree::BVHTree(unsigned int maxObjectsPerNode) : maxObjectsPerNode(maxObjectsPerNode)
+	bool BVHTree::forceSingleThreaded = false;
+
+	void BVHObjectBounds::Resize(const unsigned int numObjects)
 	{
-		rootNode = new BVHNode();
-		nodeCount = 0;
+		// Padding is left as empty bounds at the origin, callers mask it out of their results
+		const unsigned int paddedSize = (numObjects > 0) ? numObjects + MAX_LANE_WIDTH - 1 : 0;
+		for (std::vector<float>* array : { &centreX, &centreY, &centreZ, &extentX, &extentY, &extentZ }) {
+			array->resize(paddedSize);
+			std::fill(array->begin() + numObjects, array->end(), 0.0f);
+		}
 	}
 
-	BVHTree::~BVHTree()
+	void BVHObjectBounds::Set(const unsigned int slot, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
 	{
-		delete rootNode;
+		const glm::vec3 centre = (boundsMin + boundsMax) * 0.5f;
+		const glm::vec3 extent = boundsMax - centre;
+		centreX[slot] = centre.x;
+		centreY[slot] = centre.y;
+		centreZ[slot] = centre.z;
+		extentX[slot] = extent.x;
+		extentY[slot] = extent.y;
+		extentZ[slot] = extent.z;
 	}
 
+	BVHTree::BVHTree(unsigned int maxObjectsPerNode) : structureVersion(0), boundsVersion(0), maxObjectsPerNode(std::max(maxObjectsPerNode, 1u)) {}
+
+	BVHTree::~BVHTree() {}
+
 	void BVHTree::BuildTree(const std::vector<std::pair<std::pair<glm::vec3, unsigned int>, Mesh*>>& unsortedObjects)
 	{
 		SCOPE_TIMER("BVHTree::BuildTree");
+		structureVersion++;
+		boundsVersion++;
 		globalObjects.clear();
-		AABBPoints worldAABB;
-		nodeCount = 0;
+		nodes.clear();
+		objectIndices.clear();
+		nodeParents.clear();
+		builtArea.clear();
+		dirtyNodes.clear();
 
 		// Create global objects
-		const int numObjects = unsortedObjects.size();
-		std::vector<unsigned int> indices;
-		indices.reserve(numObjects);
+		const unsigned int numObjects = unsortedObjects.size();
 		globalObjects.reserve(numObjects);
+		objectIndices.resize(numObjects);
+		objectMin.resize(numObjects);
+		objectMax.resize(numObjects);
+		objectCentre.resize(numObjects);
+		objectLeaves.resize(numObjects);
 		for (unsigned int i = 0; i < numObjects; i++) {
-			std::pair<std::pair<glm::vec3, unsigned int>, Mesh*> pair = unsortedObjects[i];
+			const std::pair<std::pair<glm::vec3, unsigned int>, Mesh*>& pair = unsortedObjects[i];
 			globalObjects.push_back(BVHObject(pair.second, pair.first.first, i, pair.first.second));
-			indices.push_back(i);
+			objectIndices[i] = i;
+
+			const AABBPoints& geoBounds = pair.second->GetGeometryAABB();
+			objectMin[i] = pair.first.first + glm::vec3(geoBounds.minX, geoBounds.minY, geoBounds.minZ);
+			objectMax[i] = pair.first.first + glm::vec3(geoBounds.maxX, geoBounds.maxY, geoBounds.maxZ);
+			objectCentre[i] = (objectMin[i] + objectMax[i]) * 0.5f;
+		}
+
+		if (numObjects == 0) {
+			leafObjectBounds.Resize(0);
+			weightedArea = 0.0;
+			builtSAHCost = 0.0f;
+			return;
+		}
+
+		if (numObjects < PARALLEL_BUILD_MIN_OBJECTS) {
+			// A binary tree with at least one object per leaf never has more than 2n - 1 nodes
+			nodes.reserve(2 * numObjects - 1);
+			nodeParents.reserve(2 * numObjects - 1);
+			builtArea.reserve(2 * numObjects - 1);
+			NodeOutput output = { nodes, nodeParents, builtArea };
+			BuildNode(output, 0, numObjects, NO_PARENT, true);
+		}
+		else {
+			BuildTreeParallel();
+		}
+		AssignObjectLeaves();
+
+		nodeDirty.assign(nodes.size(), 0);
+		rebuildNodes.assign(nodes.size(), 0);
+		ResetWeightedArea();
+		builtSAHCost = SAHCost();
+	}
+
+	BVHUpdateType BVHTree::UpdateTree(const std::vector<std::pair<std::pair<glm::vec3, unsigned int>, Mesh*>>& objects)
+	{
+		SCOPE_TIMER("BVHTree::UpdateTree");
+		if (nodes.empty() || !SetObjectBounds(objects)) {
+			BuildTree(objects);
+			return BVH_FULL_REBUILD;
 		}
 
-		if (CreateNodeAABB(indices, worldAABB)) {
-			rootNode->SetBoundingBox(worldAABB);
-			rootNode->SetParent(nullptr);
-			rootNode->SetObjectIndices(indices);
-			rootNode->SetIsLeaf(false);
+		if (dirtyNodes.empty()) { return BVH_UNCHANGED; }
+		boundsVersion++;
+
+		bool subtreeDegraded = false;
+		while (!dirtyNodes.empty()) {
+			std::pop_heap(dirtyNodes.begin(), dirtyNodes.end());
+			const unsigned int nodeIndex = dirtyNodes.back();
+			dirtyNodes.pop_back();
+			nodeDirty[nodeIndex] = 0;
+
+			// Bounds that didn't change stop the propagation along this path
+			if (!RefitNode(nodeIndex)) { continue; }
+
+			// Rebuilding a leaf can't help, its bounds are just its meshes
+			const BVHNode& node = nodes[nodeIndex];
+			if (!node.IsLeaf() && HalfSurfaceArea(node.boundsMin, node.boundsMax) > builtArea[nodeIndex] * PARTIAL_REBUILD_AREA_GROWTH) {
+				rebuildNodes[nodeIndex] = 1;
+				subtreeDegraded = true;
+			}
+
+			const unsigned int parent = nodeParents[nodeIndex];
+			if (parent != NO_PARENT && !nodeDirty[parent]) {
+				nodeDirty[parent] = 1;
+				dirtyNodes.push_back(parent);
+				std::push_heap(dirtyNodes.begin(), dirtyNodes.end());
+			}
+		}
+
+		if (SAHCost() > builtSAHCost * FULL_REBUILD_SAH_GROWTH) {
+			BuildTree(objects);
+			return BVH_FULL_REBUILD;
+		}
+
+		if (!subtreeDegraded) { return BVH_REFIT; }
+
+		// Rebuilt subtrees may come out with a different number of nodes, so the array is rewritten in depth first order around them
+		std::vector<BVHNode> oldNodes;
+		std::vector<float> oldBuiltArea;
+		structureVersion++;
+		oldNodes.swap(nodes);
+		oldBuiltArea.swap(builtArea);
+		nodeParents.clear();
+		nodes.reserve(oldNodes.size());
+		builtArea.reserve(oldNodes.size());
+		CopyOrRebuildNode(oldNodes, oldBuiltArea, 0, NO_PARENT);
+		AssignObjectLeaves();
+
+		nodeDirty.assign(nodes.size(), 0);
+		rebuildNodes.assign(nodes.size(), 0);
+		ResetWeightedArea();
+		// builtSAHCost stays at the last full build so a run of partial rebuilds can't creep the baseline upwards
+		return BVH_PARTIAL_REBUILD;
+	}
+
+	bool BVHTree::SetObjectBounds(const std::vector<std::pair<std::pair<glm::vec3, unsigned int>, Mesh*>>& objects)
+	{
+		if (objects.size() != globalObjects.size()) { return false; }
+
+		for (unsigned int i = 0; i < objects.size(); i++) {
+			const std::pair<std::pair<glm::vec3, unsigned int>, Mesh*>& pair = objects[i];
+			BVHObject& object = globalObjects[i];
+			if (pair.second != object.mesh || pair.first.second != object.entityID) { return false; }
+
+			const AABBPoints& geoBounds = pair.second->GetGeometryAABB();
+			const glm::vec3 boundsMin = pair.first.first + glm::vec3(geoBounds.minX, geoBounds.minY, geoBounds.minZ);
+			const glm::vec3 boundsMax = pair.first.first + glm::vec3(geoBounds.maxX, geoBounds.maxY, geoBounds.maxZ);
+			if (boundsMin == objectMin[i] && boundsMax == objectMax[i]) { continue; }
+
+			object.worldPosition = pair.first.first;
+			objectMin[i] = boundsMin;
+			objectMax[i] = boundsMax;
+			objectCentre[i] = (boundsMin + boundsMax) * 0.5f;
+			leafObjectBounds.Set(objectSlots[i], boundsMin, boundsMax);
 
-			// Build tree recursively
-			bool success = BuildTreeRecursive(indices, rootNode);
-			if (!success) {
-				rootNode->SetIsLeaf(true);
+			const unsigned int leaf = objectLeaves[i];
+			if (!nodeDirty[leaf]) {
+				nodeDirty[leaf] = 1;
+				dirtyNodes.push_back(leaf);
+				std::push_heap(dirtyNodes.begin(), dirtyNodes.end());
 			}
 		}
+		return true;
 	}
 
-	bool BVHTree::BuildTreeRecursive(const std::vector<unsigned int>& indicesUnsorted, BVHNode* parentNode) {
-		if (indicesUnsorted.size() > 0) {
-			unsigned int excludedAxis = 3u;
-			unsigned int attempts = 0u;
+	bool BVHTree::RefitNode(const unsigned int nodeIndex)
+	{
+		BVHNode& node = nodes[nodeIndex];
+		glm::vec3 boundsMin, boundsMax;
+		if (node.IsLeaf()) {
+			boundsMin = objectMin[objectIndices[node.first]];
+			boundsMax = objectMax[objectIndices[node.first]];
+			for (unsigned int i = node.first + 1; i < node.first + node.count; i++) {
+				boundsMin = glm::min(boundsMin, objectMin[objectIndices[i]]);
+				boundsMax = glm::max(boundsMax, objectMax[objectIndices[i]]);
+			}
+		}
+		else {
+			const BVHNode& left = nodes[nodeIndex + 1];
+			const BVHNode& right = nodes[node.first];
+			boundsMin = glm::min(left.boundsMin, right.boundsMin);
+			boundsMax = glm::max(left.boundsMax, right.boundsMax);
+		}
 
-			AABBPoints parentBounds = parentNode->GetBoundingBox();
+		if (boundsMin == node.boundsMin && boundsMax == node.boundsMax) { return false; }
 
-			bool success = false;
-			bool attemptedX = false, attemptedY = false, attemptedZ = false;
+		weightedArea += NodeSAHCost(node) * (static_cast<double>(HalfSurfaceArea(boundsMin, boundsMax)) - HalfSurfaceArea(node.boundsMin, node.boundsMax));
+		node.boundsMin = boundsMin;
+		node.boundsMax = boundsMax;
+		return true;
+	}
+
+	unsigned int BVHTree::CopyOrRebuildNode(const std::vector<BVHNode>& oldNodes, const std::vector<float>& oldBuiltArea, const unsigned int oldIndex, const unsigned int parent)
+	{
+		const BVHNode& oldNode = oldNodes[oldIndex];
+		if (rebuildNodes[oldIndex]) {
+			// A subtree's objects are one contiguous range, from its leftmost leaf to its rightmost
+			unsigned int leftmost = oldIndex;
+			while (!oldNodes[leftmost].IsLeaf()) { leftmost++; }
+			unsigned int rightmost = oldIndex;
+			while (!oldNodes[rightmost].IsLeaf()) { rightmost = oldNodes[rightmost].first; }
 
-			while (attempts < 2u && !success) {
-				// Find biggest extent
-				std::pair<unsigned int, float> axisIndexAndExtent = GetBiggestExtentAxis(parentBounds, excludedAxis); // 0 = X, 1 = Y, 2 = Z
-			
-				success = SplitNode(axisIndexAndExtent.first, axisIndexAndExtent.second, indicesUnsorted, parentBounds, parentNode);
+			NodeOutput output = { nodes, nodeParents, builtArea };
+			return BuildNode(output, oldNodes[leftmost].first, oldNodes[rightmost].first + oldNodes[rightmost].count, parent, true);
+		}
 
-				excludedAxis = axisIndexAndExtent.first;
+		const unsigned int nodeIndex = nodes.size();
+		nodes.push_back(oldNode);
+		nodeParents.push_back(parent);
+		builtArea.push_back(oldBuiltArea[oldIndex]);
 
-				if (excludedAxis == 0) { attemptedX = true; }
-				else if (excludedAxis == 1) { attemptedY = true; }
-				else if (excludedAxis == 2) { attemptedZ = true; }
+		if (oldNode.IsLeaf()) { return nodeIndex; }
 
-				attempts++;
+		CopyOrRebuildNode(oldNodes, oldBuiltArea, oldIndex + 1, nodeIndex);
+		const unsigned int rightChild = CopyOrRebuildNode(oldNodes, oldBuiltArea, oldNode.first, nodeIndex);
+		nodes[nodeIndex].first = rightChild;
+		return nodeIndex;
+	}
+
+	void BVHTree::BuildTreeParallel()
+	{
+		// Top of the tree on this thread, with the binning of large ranges split across the thread pool
+		topNodes.clear();
+		subtreeTasks.clear();
+		BuildTopNode(0, globalObjects.size());
+
+		// Every remaining range is an independent subtree
+		ThreadPool::GetInstance()->ParallelFor(subtreeTasks.size(), 1, [this](const unsigned int chunkIndex, const unsigned int begin, const unsigned int end) {
+			for (unsigned int task = begin; task < end; task++) {
+				SubtreeTask& subtree = subtreeTasks[task];
+				subtree.nodes.clear();
+				subtree.parents.clear();
+				subtree.area.clear();
+				NodeOutput output = { subtree.nodes, subtree.parents, subtree.area };
+				BuildNode(output, subtree.begin, subtree.end, NO_PARENT, false);
 			}
+		}, forceSingleThreaded);
+
+		// Lay the top nodes out depth first, leaving a gap the size of each subtree where it belongs
+		unsigned int numNodes = 0;
+		for (const TopNode& topNode : topNodes) {
+			if (topNode.task == NO_TASK) { numNodes++; }
+		}
+		for (const SubtreeTask& subtree : subtreeTasks) { numNodes += subtree.nodes.size(); }
+
+		nodes.resize(numNodes);
+		nodeParents.resize(numNodes);
+		builtArea.resize(numNodes);
+		unsigned int nextNode = 0;
+		PlaceTopNode(0, NO_PARENT, nextNode);
 
-			if (!success) {
-				if (!attemptedX) {
-					success = SplitNode(0, parentBounds.maxX - parentBounds.minX, indicesUnsorted, parentBounds, parentNode);
+		ThreadPool::GetInstance()->ParallelFor(subtreeTasks.size(), 1, [this](const unsigned int chunkIndex, const unsigned int begin, const unsigned int end) {
+			for (unsigned int task = begin; task < end; task++) {
+				const SubtreeTask& subtree = subtreeTasks[task];
+				for (unsigned int i = 0; i < subtree.nodes.size(); i++) {
+					BVHNode node = subtree.nodes[i];
+					if (!node.IsLeaf()) { node.first += subtree.offset; }
+					nodes[subtree.offset + i] = node;
+					nodeParents[subtree.offset + i] = (i == 0) ? subtree.parent : subtree.parents[i] + subtree.offset;
+					builtArea[subtree.offset + i] = subtree.area[i];
 				}
-				else if (!attemptedY) {
-					success = SplitNode(1, parentBounds.maxY - parentBounds.minY, indicesUnsorted, parentBounds, parentNode);
+			}
+		}, forceSingleThreaded);
+	}
+
+	unsigned int BVHTree::BuildTopNode(const unsigned int begin, const unsigned int end)
+	{
+		const unsigned int topIndex = topNodes.size();
+		topNodes.push_back(TopNode());
+
+		const RangeBounds bounds = GetRangeBounds(begin, end, true);
+		topNodes[topIndex].boundsMin = bounds.boundsMin;
+		topNodes[topIndex].boundsMax = bounds.boundsMax;
+
+		const unsigned int split = (end - begin > SUBTREE_TASK_OBJECTS) ? SplitRange(begin, end, bounds, true) : begin;
+		if (split == begin) {
+			topNodes[topIndex].task = subtreeTasks.size();
+			subtreeTasks.push_back(SubtreeTask());
+			subtreeTasks.back().begin = begin;
+			subtreeTasks.back().end = end;
+			return topIndex;
+		}
+
+		topNodes[topIndex].task = NO_TASK;
+		const unsigned int left = BuildTopNode(begin, split);
+		const unsigned int right = BuildTopNode(split, end);
+		topNodes[topIndex].left = left;
+		topNodes[topIndex].right = right;
+		return topIndex;
+	}
+
+	unsigned int BVHTree::PlaceTopNode(const unsigned int topIndex, const unsigned int parent, unsigned int& nextNode)
+	{
+		const TopNode& topNode = topNodes[topIndex];
+		if (topNode.task != NO_TASK) {
+			SubtreeTask& subtree = subtreeTasks[topNode.task];
+			subtree.offset = nextNode;
+			subtree.parent = parent;
+			nextNode += subtree.nodes.size();
+			return subtree.offset;
+		}
+
+		const unsigned int nodeIndex = nextNode++;
+		nodes[nodeIndex].boundsMin = topNode.boundsMin;
+		nodes[nodeIndex].boundsMax = topNode.boundsMax;
+		nodes[nodeIndex].count = 0;
+		nodeParents[nodeIndex] = parent;
+		builtArea[nodeIndex] = HalfSurfaceArea(topNode.boundsMin, topNode.boundsMax);
+
+		PlaceTopNode(topNode.left, nodeIndex, nextNode);
+		nodes[nodeIndex].first = PlaceTopNode(topNode.right, nodeIndex, nextNode);
+		return nodeIndex;
+	}
+
+	unsigned int BVHTree::BuildNode(NodeOutput& output, const unsigned int begin, const unsigned int end, const unsigned int parent, const bool parallel)
+	{
+		const unsigned int nodeIndex = output.nodes.size();
+		output.nodes.push_back(BVHNode());
+		output.parents.push_back(parent);
+
+		const RangeBounds bounds = GetRangeBounds(begin, end, parallel);
+		output.nodes[nodeIndex].boundsMin = bounds.boundsMin;
+		output.nodes[nodeIndex].boundsMax = bounds.boundsMax;
+		output.area.push_back(HalfSurfaceArea(bounds.boundsMin, bounds.boundsMax));
+
+		const unsigned int split = (end - begin > maxObjectsPerNode) ? SplitRange(begin, end, bounds, parallel) : begin;
+		if (split == begin) {
+			output.nodes[nodeIndex].first = begin;
+			output.nodes[nodeIndex].count = end - begin;
+			return nodeIndex;
+		}
+
+		// Left subtree is built first so it lands directly after this node
+		BuildNode(output, begin, split, nodeIndex, parallel);
+		const unsigned int rightChild = BuildNode(output, split, end, nodeIndex, parallel);
+		output.nodes[nodeIndex].first = rightChild;
+		output.nodes[nodeIndex].count = 0;
+		return nodeIndex;
+	}
+
+	BVHTree::RangeBounds BVHTree::GetRangeBounds(const unsigned int begin, const unsigned int end, const bool parallel)
+	{
+		if (!parallel || end - begin < PARALLEL_BINNING_MIN_OBJECTS) { return GetRangeBoundsSerial(begin, end); }
+
+		// Min and max are exact whatever order the chunks are merged in, so splitting the work doesn't change the result
+		const unsigned int numChunks = ThreadPool::NumChunks(end - begin, BINNING_CHUNK_OBJECTS);
+		chunkBounds.resize(numChunks);
+		ThreadPool::GetInstance()->ParallelFor(end - begin, BINNING_CHUNK_OBJECTS, [this, begin](const unsigned int chunkIndex, const unsigned int chunkBegin, const unsigned int chunkEnd) {
+			chunkBounds[chunkIndex] = GetRangeBoundsSerial(begin + chunkBegin, begin + chunkEnd);
+		}, forceSingleThreaded);
+
+		RangeBounds bounds = chunkBounds[0];
+		for (unsigned int chunk = 1; chunk < numChunks; chunk++) {
+			bounds.boundsMin = glm::min(bounds.boundsMin, chunkBounds[chunk].boundsMin);
+			bounds.boundsMax = glm::max(bounds.boundsMax, chunkBounds[chunk].boundsMax);
+			bounds.centreMin = glm::min(bounds.centreMin, chunkBounds[chunk].centreMin);
+			bounds.centreMax = glm::max(bounds.centreMax, chunkBounds[chunk].centreMax);
+		}
+		return bounds;
+	}
+
+	BVHTree::RangeBounds BVHTree::GetRangeBoundsSerial(const unsigned int begin, const unsigned int end) const
+	{
+		RangeBounds bounds;
+		bounds.boundsMin = objectMin[objectIndices[begin]];
+		bounds.boundsMax = objectMax[objectIndices[begin]];
+		bounds.centreMin = objectCentre[objectIndices[begin]];
+		bounds.centreMax = bounds.centreMin;
+		for (unsigned int i = begin + 1; i < end; i++) {
+			const unsigned int object = objectIndices[i];
+			bounds.boundsMin = glm::min(bounds.boundsMin, objectMin[object]);
+			bounds.boundsMax = glm::max(bounds.boundsMax, objectMax[object]);
+			bounds.centreMin = glm::min(bounds.centreMin, objectCentre[object]);
+			bounds.centreMax = glm::max(bounds.centreMax, objectCentre[object]);
+		}
+		return bounds;
+	}
+
+	void BVHTree::BinRange(const unsigned int begin, const unsigned int end, const RangeBounds& bounds, SAHBins& out_bins) const
+	{
+		for (int axis = 0; axis < 3; axis++) {
+			for (SAHBin& bin : out_bins.bins[axis]) {
+				bin.boundsMin = glm::vec3(FLT_MAX);
+				bin.boundsMax = glm::vec3(-FLT_MAX);
+				bin.count = 0;
+			}
+		}
+
+		const glm::vec3 centreExtent = bounds.centreMax - bounds.centreMin;
+		for (unsigned int i = begin; i < end; i++) {
+			const unsigned int object = objectIndices[i];
+			for (int axis = 0; axis < 3; axis++) {
+				if (centreExtent[axis] <= 0.0f) { continue; }
+
+				SAHBin& bin = out_bins.bins[axis][BinIndex(objectCentre[object][axis], bounds.centreMin[axis], NUM_SAH_BINS / centreExtent[axis])];
+				bin.boundsMin = glm::min(bin.boundsMin, objectMin[object]);
+				bin.boundsMax = glm::max(bin.boundsMax, objectMax[object]);
+				bin.count++;
+			}
+		}
+	}
+
+	unsigned int BVHTree::SplitRange(const unsigned int begin, const unsigned int end, const RangeBounds& bounds, const bool parallel)
+	{
+		SAHBins bins;
+		if (!parallel || end - begin < PARALLEL_BINNING_MIN_OBJECTS) {
+			BinRange(begin, end, bounds, bins);
+		}
+		else {
+			// Bin counts and bounds are exact whatever order the chunks are merged in, so splitting the work doesn't change the result
+			const unsigned int numChunks = ThreadPool::NumChunks(end - begin, BINNING_CHUNK_OBJECTS);
+			chunkBins.resize(numChunks);
+			ThreadPool::GetInstance()->ParallelFor(end - begin, BINNING_CHUNK_OBJECTS, [this, begin, &bounds](const unsigned int chunkIndex, const unsigned int chunkBegin, const unsigned int chunkEnd) {
+				BinRange(begin + chunkBegin, begin + chunkEnd, bounds, chunkBins[chunkIndex]);
+			}, forceSingleThreaded);
+
+			bins = chunkBins[0];
+			for (unsigned int chunk = 1; chunk < numChunks; chunk++) {
+				for (int axis = 0; axis < 3; axis++) {
+					for (unsigned int bin = 0; bin < NUM_SAH_BINS; bin++) {
+						SAHBin& merged = bins.bins[axis][bin];
+						const SAHBin& other = chunkBins[chunk].bins[axis][bin];
+						merged.boundsMin = glm::min(merged.boundsMin, other.boundsMin);
+						merged.boundsMax = glm::max(merged.boundsMax, other.boundsMax);
+						merged.count += other.count;
+					}
 				}
-				else if (!attemptedZ) {
-					success = SplitNode(2, parentBounds.maxZ - parentBounds.minZ, indicesUnsorted, parentBounds, parentNode);
+			}
+		}
+
+		// Take the plane between bins with the lowest surface area cost over all three axes
+		const glm::vec3 centreExtent = bounds.centreMax - bounds.centreMin;
+		float bestCost = FLT_MAX;
+		int bestAxis = -1;
+		unsigned int bestPlane = 0;
+
+		for (int axis = 0; axis < 3; axis++) {
+			if (centreExtent[axis] <= 0.0f) { continue; }
+			const SAHBin* axisBins = bins.bins[axis];
+
+			// Sweep from the right to get the area and count to the right of every plane, then from the left to cost each one
+			float rightArea[NUM_SAH_BINS - 1];
+			unsigned int rightCount[NUM_SAH_BINS - 1];
+			glm::vec3 sweepMin = glm::vec3(FLT_MAX);
+			glm::vec3 sweepMax = glm::vec3(-FLT_MAX);
+			unsigned int sweepCount = 0;
+			for (unsigned int plane = NUM_SAH_BINS - 1; plane > 0; plane--) {
+				sweepMin = glm::min(sweepMin, axisBins[plane].boundsMin);
+				sweepMax = glm::max(sweepMax, axisBins[plane].boundsMax);
+				sweepCount += axisBins[plane].count;
+				rightArea[plane - 1] = HalfSurfaceArea(sweepMin, sweepMax);
+				rightCount[plane - 1] = sweepCount;
+			}
+
+			sweepMin = glm::vec3(FLT_MAX);
+			sweepMax = glm::vec3(-FLT_MAX);
+			sweepCount = 0;
+			for (unsigned int plane = 0; plane < NUM_SAH_BINS - 1; plane++) {
+				sweepMin = glm::min(sweepMin, axisBins[plane].boundsMin);
+				sweepMax = glm::max(sweepMax, axisBins[plane].boundsMax);
+				sweepCount += axisBins[plane].count;
+				if (sweepCount == 0 || rightCount[plane] == 0) { continue; }
+
+				const float cost = HalfSurfaceArea(sweepMin, sweepMax) * sweepCount + rightArea[plane] * rightCount[plane];
+				if (cost < bestCost) {
+					bestCost = cost;
+					bestAxis = axis;
+					bestPlane = plane;
 				}
 			}
+		}
+
+		// Every centre is in the same place, nothing can separate them
+		if (bestAxis == -1) { return begin; }
+
+		const float binScale = NUM_SAH_BINS / centreExtent[bestAxis];
+		const float axisMin = bounds.centreMin[bestAxis];
+		const unsigned int* split = std::partition(objectIndices.data() + begin, objectIndices.data() + end, [this, bestAxis, bestPlane, binScale, axisMin](const unsigned int object) {
+			return BinIndex(objectCentre[object][bestAxis], axisMin, binScale) <= bestPlane;
+		});
+		return split - objectIndices.data();
+	}
+
+	void BVHTree::AssignObjectLeaves()
+	{
+		objectSlots.resize(objectIndices.size());
+		leafObjectBounds.Resize(objectIndices.size());
+		for (unsigned int nodeIndex = 0; nodeIndex < nodes.size(); nodeIndex++) {
+			const BVHNode& node = nodes[nodeIndex];
+			if (!node.IsLeaf()) { continue; }
+			for (unsigned int i = node.first; i < node.first + node.count; i++) {
+				const unsigned int object = objectIndices[i];
+				objectLeaves[object] = nodeIndex;
+				objectSlots[object] = i;
+				leafObjectBounds.Set(i, objectMin[object], objectMax[object]);
+			}
+		}
+	}
+
+	float BVHTree::SAHCost() const
+	{
+		if (nodes.empty()) { return 0.0f; }
 
-			return success;
+		const float rootArea = HalfSurfaceArea(nodes[0].boundsMin, nodes[0].boundsMax);
+		if (rootArea <= 0.0f) { return SAH_TRAVERSAL_COST + SAH_OBJECT_COST * globalObjects.size(); }
+		return static_cast<float>(weightedArea / rootArea);
+	}
+
+	void BVHTree::ResetWeightedArea()
+	{
+		weightedArea = 0.0;
+		for (const BVHNode& node : nodes) {
+			weightedArea += NodeSAHCost(node) * HalfSurfaceArea(node.boundsMin, node.boundsMax);
 		}
 	}
-}
\ No newline at end of file
+}
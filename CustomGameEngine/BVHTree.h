@@ -1,19 +1,10 @@
 #pragma once
 #include "BVHNode.h"
 #include "Mesh.h"
+#include "SIMDLanes.h"
+#include <vector>
 #include <algorithm>
 namespace Engine {
-
-	static bool StaticComparePositionX(std::pair<glm::vec3, Mesh*> entryOne, std::pair<const glm::vec3, Mesh*> entryTwo) {
-		return (entryOne.first.x < entryTwo.first.x);
-	}
-	static bool StaticComparePositionY(std::pair<glm::vec3, Mesh*> entryOne, std::pair<const glm::vec3, Mesh*> entryTwo) {
-		return (entryOne.first.y < entryTwo.first.y);
-	}
-	static bool StaticComparePositionZ(std::pair<glm::vec3, Mesh*> entryOne, std::pair<const glm::vec3, Mesh*> entryTwo) {
-		return (entryOne.first.z < entryTwo.first.z);
-	}
-
 	struct BVHObject {
 		Mesh* mesh;
 		glm::vec3 worldPosition;
@@ -23,276 +14,198 @@ namespace Engine {
 		BVHObject(Mesh* mesh, const glm::vec3& worldPosition, const unsigned int index, const unsigned int entityID) : mesh(mesh), worldPosition(worldPosition), globalIndex(index), entityID(entityID) {}
 	};
 
+	// World bounds of every object in the tree as centre and half extents, in BVHTree::GetObjectIndices() order so the objects of a leaf are contiguous
+	// Each array runs MAX_LANE_WIDTH - 1 entries of empty bounds past the last object so a whole batch can be read starting from any object
+	struct BVHObjectBounds {
+		std::vector<float> centreX, centreY, centreZ;
+		std::vector<float> extentX, extentY, extentZ;
+
+		void Resize(const unsigned int numObjects);
+		void Set(const unsigned int slot, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+	};
+
+	enum BVHUpdateType {
+		BVH_UNCHANGED,
+		BVH_REFIT,
+		BVH_PARTIAL_REBUILD,
+		BVH_FULL_REBUILD
+	};
+
+	// Bounding volume hierarchy over every mesh in the scene, used for culling
+	// Built top down with a binned surface area heuristic into one flat depth first node array, leaves are ranges of a single object index array
 	class BVHTree
 	{
 	public:
+		static constexpr unsigned int NO_PARENT = ~0u;
+
 		BVHTree(unsigned int maxObjectsPerNode = 3u);
 		~BVHTree();
 
+		// Rebuilds the whole tree in place, reusing the previous build's storage
 		void BuildTree(const std::vector<std::pair<std::pair<glm::vec3, unsigned int>, Mesh*>>& unsortedObjects);
-		BVHNode* GetRootNode() { return rootNode; }
-		const unsigned int GetNodeCount() const { return nodeCount; }
-		const std::vector<BVHObject>& GetGlobalObjects() const { return globalObjects; }
-	private:
-		std::vector<BVHObject> globalObjects;
-
-		// 3 == no exclusion
-		std::pair<unsigned int, float> GetBiggestExtentAxis(const AABBPoints& aabb, const unsigned int excludedAxis = 3u) {
-			unsigned int biggestExtent;
-			float extents[3]{
-				aabb.maxX - aabb.minX,
-				aabb.maxY - aabb.minY,
-				aabb.maxZ - aabb.minZ
-			};
-
-			switch (excludedAxis) {
-			case 0:
-				// Exclude X
-				biggestExtent = 1;
-				if (extents[2] > extents[1]) { biggestExtent = 2; }
-
-				return std::make_pair(biggestExtent, extents[biggestExtent]);
-				break;
-			case 1:
-				// Exclude Y
-				biggestExtent = 0;
-				if (extents[2] > extents[0]) { biggestExtent = 2; }
-
-				return std::make_pair(biggestExtent, extents[biggestExtent]);
-				break;
-			case 2:
-				// Exclude Z
-				biggestExtent = 0;
-				if (extents[1] > extents[0]) { biggestExtent = 1; }
-
-				return std::make_pair(biggestExtent, extents[biggestExtent]);
-				break;
-			case 3:
-				// No excluded axis
-				biggestExtent = 0;
-				if (extents[1] > extents[0] && extents[1] > extents[2]) { biggestExtent = 1; }
-				if (extents[2] > extents[0] && extents[2] > extents[1]) { biggestExtent = 2; }
-
-				return std::make_pair(biggestExtent, extents[biggestExtent]);
-				break;
-			}
-		}
-
-		BVHNode* rootNode;
-		unsigned int maxObjectsPerNode;
-		unsigned int nodeCount;
-
-		bool CreateNodeAABB(const std::vector<unsigned int>& indices, AABBPoints& out_aabb) {
-			if (indices.size() > 0) {
-				const glm::vec3& position = globalObjects[indices[0]].worldPosition;
-				const AABBPoints& geoBounds = globalObjects[indices[0]].mesh->GetGeometryAABB();
-
-				float minX = position.x + geoBounds.minX;
-				float minY = position.y + geoBounds.minY;
-				float minZ = position.z + geoBounds.minZ;
-				float maxX = position.x + geoBounds.maxX;
-				float maxY = position.y + geoBounds.maxY;
-				float maxZ = position.z + geoBounds.maxZ;
-
-				for (int i = 1; i < indices.size(); i++) {
-					const AABBPoints& geoBounds = globalObjects[indices[i]].mesh->GetGeometryAABB();
-					const glm::vec3& position = globalObjects[indices[i]].worldPosition;
-
-					if (position.x + geoBounds.minX < minX) { minX = position.x + geoBounds.minX; }
-					if (position.x + geoBounds.maxX > maxX) { maxX = position.x + geoBounds.maxX; }
-
-					if (position.y + geoBounds.minY < minY) { minY = position.y + geoBounds.minY; }
-					if (position.y + geoBounds.maxY > maxY) { maxY = position.y + geoBounds.maxY; }
-
-					if (position.z + geoBounds.minZ < minZ) { minZ = position.z + geoBounds.minZ; }
-					if (position.z + geoBounds.maxZ > maxZ) { maxZ = position.z + geoBounds.maxZ; }
-				}
-
-				out_aabb = AABBPoints(minX, minY, minZ, maxX, maxY, maxZ);
-				return true;
-			}
-			else {
-				return false;
-			}
-		}
-		bool SplitNode(unsigned int axisIndex, float axisExtent, const std::vector<unsigned int>& unsortedIndices, const AABBPoints& parentBounds, BVHNode* parentNode) {
-			AABBPoints leftAABB, rightAABB;
-
-			// Sort meshes from smallest position to biggest position on biggest extent axis
-			std::vector<unsigned int> sortedIndices = SortMeshesOnAxis(unsortedIndices, axisIndex);
-
-			// Split meshes into left and right
-			// --------------------------------
-			glm::vec3 parentMin = glm::vec3(parentBounds.minX, parentBounds.minY, parentBounds.minZ);
-			float halfExtent = parentMin[axisIndex] + axisExtent * 0.5f;
-
-			// Find split index
-			unsigned int splitIndex = GetSplitIndex(sortedIndices, halfExtent, axisIndex);
 
-			if (splitIndex == 0) {
-				// Split axis didn't work
-				return false;
-			}
-
-			// Create AABB for left and right nodes
-			std::vector<unsigned int> leftSplit(sortedIndices.begin(), sortedIndices.begin() + splitIndex);
-			std::vector<unsigned int> rightSplit(sortedIndices.begin() + splitIndex, sortedIndices.end());
-
-			bool leftSuccess = CreateNodeAABB(leftSplit, leftAABB);
-			bool rightSuccess = CreateNodeAABB(rightSplit, rightAABB);
+		// Brings the tree up to date with a mesh list for the same objects as the last build, in the same order, falling back to BuildTree otherwise
+		// Only the leaves of meshes that moved are refit, and their new bounds are propagated towards the root until a node doesn't change.
+		// Subtrees whose bounds have grown well past their size at build time are rebuilt on their own, and the whole tree is rebuilt once its SAH cost has grown too far
+		BVHUpdateType UpdateTree(const std::vector<std::pair<std::pair<glm::vec3, unsigned int>, Mesh*>>& objects);
+
+		bool IsEmpty() const { return nodes.empty(); }
+		const BVHNode& GetRootNode() const { return nodes[0]; }
+		const std::vector<BVHNode>& GetNodes() const { return nodes; }
+		const std::vector<unsigned int>& GetObjectIndices() const { return objectIndices; }
+		const BVHObjectBounds& GetLeafObjectBounds() const { return leafObjectBounds; }
+		// Position of each global object in GetObjectIndices() and GetLeafObjectBounds()
+		const std::vector<unsigned int>& GetObjectSlots() const { return objectSlots; }
+		const unsigned int GetNodeCount() const { return nodes.size(); }
+		const std::vector<unsigned int>& GetNodeParents() const { return nodeParents; } // NO_PARENT for the root
+		// Changes whenever nodes are added, removed or moved, so anything cached per node index knows to throw itself away. Refitting leaves it alone
+		const unsigned int GetStructureVersion() const { return structureVersion; }
+		// Changes whenever any node's bounds may have changed, refits included
+		const unsigned int GetBoundsVersion() const { return boundsVersion; }
+		const std::vector<BVHObject>& GetGlobalObjects() const { return globalObjects; }
 
-			if (leftSuccess) {
-				parentNode->SetLeftChild(BuildNode(parentNode, leftSplit, leftAABB));
-			}
+		// Expected cost of visiting the tree with a query that touches a node in proportion to its surface area, counting one unit per node
+		// and one per object tested. Only meaningful for comparing builds over the same objects, lower is better
+		float SAHCost() const;
+		float SAHCostAtBuild() const { return builtSAHCost; } // as of the last full rebuild
 
-			if (rightSuccess) {
-				parentNode->SetRightChild(BuildNode(parentNode, rightSplit, rightAABB));
-			}
+		// Build large trees on the calling thread only, for debugging. The tree is identical either way
+		static void SetForceSingleThreaded(const bool singleThreaded) { forceSingleThreaded = singleThreaded; }
+		static bool ForceSingleThreaded() { return forceSingleThreaded; }
 
-			return true;
-		}
-		std::vector<unsigned int> SortMeshesOnAxis(const std::vector<unsigned int>& unsortedIndices, unsigned int axisIndex) {
-			std::vector<unsigned int> sorted = unsortedIndices;
-
-			switch (axisIndex) {
-			case 0:
-				QuickSortIndicesXAxis(sorted, 0, sorted.size() - 1);
-				break;
-			case 1:
-				QuickSortIndicesYAxis(sorted, 0, sorted.size() - 1);
-				break;
-			case 2:
-				QuickSortIndicesZAxis(sorted, 0, sorted.size() - 1);
-				break;
-			default:
-				break;
-			}
-
-			return sorted;
-		}
-		unsigned int GetSplitIndex(const std::vector<unsigned int>& sortedIndices, float halfExtent, unsigned int axisIndex) {
-			if (sortedIndices.size() == 0) {
-				return 0;
-			}
-
-			for (int i = 0; i < sortedIndices.size(); i++) {
-				const BVHObject& bvhObject = globalObjects[sortedIndices[i]];
-				glm::vec3 position = bvhObject.worldPosition;
-				if (position[axisIndex] >= halfExtent) {
-					return i;
-				}
-			}
-			return sortedIndices.size() - 1;
-		}
-		BVHNode* BuildNode(BVHNode* parent, const std::vector<unsigned int>& localIndices, const AABBPoints aabb) {
-			BVHNode* node = nullptr;
-			if (localIndices.size() > 0u) {
-				nodeCount++;
-				node = new BVHNode(parent);
-				node->SetBoundingBox(aabb);
-				node->SetObjectIndices(localIndices);
-				node->SetIsLeaf(false);
-
-				// Check number of objects in this node
-				if (localIndices.size() <= maxObjectsPerNode) {
-					node->SetIsLeaf(true);
-				}
-				else {
-					// Split node
-					bool success = BuildTreeRecursive(localIndices, node);
-					if (!success) {
-						node->SetIsLeaf(true);
-					}
-				}
-			}
-			return node;
+	private:
+		static constexpr unsigned int NUM_SAH_BINS = 16;
+		static constexpr float SAH_TRAVERSAL_COST = 1.0f;
+		static constexpr float SAH_OBJECT_COST = 1.0f;
+
+		// Refitting never changes the tree's shape, so its quality drops as meshes move away from where they were at build time
+		static constexpr float FULL_REBUILD_SAH_GROWTH = 1.5f;
+		static constexpr float PARTIAL_REBUILD_AREA_GROWTH = 2.0f;
+
+		// Trees with this many objects are built in parallel. The top is split on the calling thread until every range has at most
+		// SUBTREE_TASK_OBJECTS objects, then each range is built as an independent subtree. Ranges of at least PARALLEL_BINNING_MIN_OBJECTS
+		// have their bounds and bins gathered across the thread pool, BINNING_CHUNK_OBJECTS at a time
+		static constexpr unsigned int PARALLEL_BUILD_MIN_OBJECTS = 4096;
+		static constexpr unsigned int SUBTREE_TASK_OBJECTS = 1024;
+		static constexpr unsigned int PARALLEL_BINNING_MIN_OBJECTS = 8192;
+		static constexpr unsigned int BINNING_CHUNK_OBJECTS = 2048;
+		static constexpr unsigned int NO_TASK = ~0u;
+
+		struct SAHBin {
+			glm::vec3 boundsMin;
+			glm::vec3 boundsMax;
+			unsigned int count;
+		};
+
+		struct SAHBins {
+			SAHBin bins[3][NUM_SAH_BINS];
+		};
+
+		struct RangeBounds {
+			glm::vec3 boundsMin;
+			glm::vec3 boundsMax;
+			glm::vec3 centreMin;
+			glm::vec3 centreMax;
+		};
+
+		// Where BuildNode writes, either the tree itself or a subtree task
+		struct NodeOutput {
+			std::vector<BVHNode>& nodes;
+			std::vector<unsigned int>& parents;
+			std::vector<float>& area;
+		};
+
+		// Node from the top of a parallel build. Either an interior node or a range left to a subtree task
+		struct TopNode {
+			glm::vec3 boundsMin;
+			glm::vec3 boundsMax;
+			unsigned int left;
+			unsigned int right;
+			unsigned int task;
+		};
+
+		// Subtree built by one task into its own arrays, with indices local to it until copied into place at offset
+		struct SubtreeTask {
+			unsigned int begin;
+			unsigned int end;
+			unsigned int offset;
+			unsigned int parent;
+			std::vector<BVHNode> nodes;
+			std::vector<unsigned int> parents;
+			std::vector<float> area;
+		};
+
+		// Builds the subtree over objectIndices[begin, end) and returns the index of its root
+		// Must be called with parallel false from inside a thread pool job, as the pool isn't re-entrant
+		unsigned int BuildNode(NodeOutput& output, const unsigned int begin, const unsigned int end, const unsigned int parent, const bool parallel);
+
+		void BuildTreeParallel();
+		unsigned int BuildTopNode(const unsigned int begin, const unsigned int end);
+		unsigned int PlaceTopNode(const unsigned int topIndex, const unsigned int parent, unsigned int& nextNode);
+		// Records the leaf and slot of every object and lays out leafObjectBounds to match, after anything that reorders objectIndices
+		void AssignObjectLeaves();
+
+		// Large ranges are gathered in parallel when allowed
+		RangeBounds GetRangeBounds(const unsigned int begin, const unsigned int end, const bool parallel);
+		RangeBounds GetRangeBoundsSerial(const unsigned int begin, const unsigned int end) const;
+		void BinRange(const unsigned int begin, const unsigned int end, const RangeBounds& bounds, SAHBins& out_bins) const;
+
+		static unsigned int BinIndex(const float centre, const float axisMin, const float binScale) {
+			return std::min(static_cast<unsigned int>((centre - axisMin) * binScale), NUM_SAH_BINS - 1);
 		}
 
-		// Returns false if parent node could not be split on any axis
-		bool BuildTreeRecursive(const std::vector<unsigned int>& indicesUnsorted, BVHNode* parentNode);
+		// Returns false if the mesh list isn't the one the tree was built from
+		bool SetObjectBounds(const std::vector<std::pair<std::pair<glm::vec3, unsigned int>, Mesh*>>& objects);
+		bool RefitNode(const unsigned int nodeIndex);
 
-		void QuickSortIndicesXAxis(std::vector<unsigned int>& indicesUnsorted, const int low, const int high) {
-			if (low < high) {
-				int partition = QuickSortSplitXCompare(indicesUnsorted, low, high);
+		// Copies a subtree of oldNodes into nodes, rebuilding any subtree marked in rebuildNodes. Returns the new index of its root
+		unsigned int CopyOrRebuildNode(const std::vector<BVHNode>& oldNodes, const std::vector<float>& oldBuiltArea, const unsigned int oldIndex, const unsigned int parent);
 
-				QuickSortIndicesXAxis(indicesUnsorted, low, partition - 1);
-				QuickSortIndicesXAxis(indicesUnsorted, partition + 1, high);
-			}
-		}
-		void QuickSortIndicesYAxis(std::vector<unsigned int>& indicesUnsorted, const int low, const int high) {
-			if (low < high) {
-				int partition = QuickSortSplitYCompare(indicesUnsorted, low, high);
+		float NodeSAHCost(const BVHNode& node) const { return SAH_TRAVERSAL_COST + (node.IsLeaf() ? SAH_OBJECT_COST * node.count : 0.0f); }
+		void ResetWeightedArea();
 
-				QuickSortIndicesYAxis(indicesUnsorted, low, partition - 1);
-				QuickSortIndicesYAxis(indicesUnsorted, partition + 1, high);
-			}
-		}
-		void QuickSortIndicesZAxis(std::vector<unsigned int>& indicesUnsorted, const int low, const int high) {
-			if (low < high) {
-				int partition = QuickSortSplitZCompare(indicesUnsorted, low, high);
+		// Returns the split position within [begin, end), partitioning the range around it. Returns begin if the range can't be split
+		unsigned int SplitRange(const unsigned int begin, const unsigned int end, const RangeBounds& bounds, const bool parallel);
 
-				QuickSortIndicesZAxis(indicesUnsorted, low, partition - 1);
-				QuickSortIndicesZAxis(indicesUnsorted, partition + 1, high);
-			}
+		static float HalfSurfaceArea(const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+			const glm::vec3 extent = glm::max(boundsMax - boundsMin, glm::vec3(0.0f));
+			return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
 		}
 
-		int QuickSortSplitXCompare(std::vector<unsigned int>& indices, const int low, const int high) {
-			unsigned int pivot = indices[high];
-			const BVHObject& pivotObject = globalObjects[pivot];
-
-			int i = low - 1;
-			for (int j = low; j <= high - 1; j++) {
-				const BVHObject& jObject = globalObjects[indices[j]];
-				if (ComparePositionX(jObject, pivotObject)) {
-					i++;
-					std::swap(indices[i], indices[j]);
-				}
-			}
-
-			std::swap(indices[i + 1], indices[high]);
-			return i + 1;
-		}
-		int QuickSortSplitYCompare(std::vector<unsigned int>& indices, const int low, const int high) {
-			unsigned int pivot = indices[high];
-			const BVHObject& pivotObject = globalObjects[pivot];
-
-			int i = low - 1;
-			for (int j = low; j <= high - 1; j++) {
-				const BVHObject& jObject = globalObjects[indices[j]];
-				if (ComparePositionY(jObject, pivotObject)) {
-					i++;
-					std::swap(indices[i], indices[j]);
-				}
-			}
-
-			std::swap(indices[i + 1], indices[high]);
-			return i + 1;
-		}
-		int QuickSortSplitZCompare(std::vector<unsigned int>& indices, const int low, const int high) {
-			unsigned int pivot = indices[high];
-			const BVHObject& pivotObject = globalObjects[pivot];
-
-			int i = low - 1;
-			for (int j = low; j <= high - 1; j++) {
-				const BVHObject& jObject = globalObjects[indices[j]];
-				if (ComparePositionZ(jObject, pivotObject)) {
-					i++;
-					std::swap(indices[i], indices[j]);
-				}
-			}
-
-			std::swap(indices[i + 1], indices[high]);
-			return i + 1;
-		}
+		std::vector<BVHObject> globalObjects;
+		std::vector<BVHNode> nodes;
+		std::vector<unsigned int> objectIndices;
+
+		std::vector<unsigned int> nodeParents;
+		unsigned int structureVersion;
+		unsigned int boundsVersion;
+		std::vector<float> builtArea; // each node's surface area when it was last built
+		std::vector<unsigned int> objectLeaves; // leaf holding each global object
+		std::vector<unsigned int> objectSlots; // position of each global object in objectIndices
+		BVHObjectBounds leafObjectBounds;
+
+		// Refit work lists, kept between updates to avoid reallocating
+		std::vector<unsigned int> dirtyNodes; // max heap, children always have higher indices than their parents so they're refit first
+		std::vector<unsigned char> nodeDirty;
+		std::vector<unsigned char> rebuildNodes;
+
+		// Sum over every node of its SAH cost times its surface area, kept up to date by refits so checking the tree's quality is free
+		double weightedArea = 0.0;
+		float builtSAHCost = 0.0f;
+
+		// World bounds and bounds centre of each global object as of the last build or update
+		std::vector<glm::vec3> objectMin;
+		std::vector<glm::vec3> objectMax;
+		std::vector<glm::vec3> objectCentre;
+
+		// Parallel build scratch, kept between builds to avoid reallocating
+		std::vector<TopNode> topNodes;
+		std::vector<SubtreeTask> subtreeTasks;
+		std::vector<RangeBounds> chunkBounds;
+		std::vector<SAHBins> chunkBins;
 
-		bool ComparePositionX(const BVHObject& one, const BVHObject& two) {
-			return one.worldPosition.x < two.worldPosition.x;
-		}
-		bool ComparePositionY(const BVHObject& one, const BVHObject& two) {
-			return one.worldPosition.y < two.worldPosition.y;
-		}
-		bool ComparePositionZ(const BVHObject& one, const BVHObject& two) {
-			return one.worldPosition.z < two.worldPosition.z;
-		}
+		unsigned int maxObjectsPerNode;
+
+		static bool forceSingleThreaded;
 	};
-}
\ No newline at end of file
+}
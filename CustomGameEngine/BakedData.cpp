@@ -237,4 +237,25 @@ namespace Engine {
 			glBindTexture(GL_TEXTURE_2D, 0);
 		}
 	}
+
+	void BakedData::WritePVSToFile(const std::string& sceneName)
+	{
+		std::cout << "BAKEDDATA::Writing potentially visible set to file" << std::endl;
+		std::error_code error;
+		std::filesystem::create_directories("Data/PVS", error);
+		if (!potentiallyVisibleSet.WriteToFile("Data/PVS/" + sceneName + ".pvs")) {
+			std::cout << "ERROR::BAKEDDATA::WritePVSToFile::Unable to write potentially visible set for " << sceneName << std::endl;
+		}
+	}
+
+	bool BakedData::LoadPVSFromFile(const std::string& sceneName)
+	{
+		std::cout << "BAKEDDATA::Loading potentially visible set from file" << std::endl;
+		if (!potentiallyVisibleSet.LoadFromFile("Data/PVS/" + sceneName + ".pvs")) {
+			std::cout << "BAKEDDATA::No potentially visible set baked for " << sceneName << std::endl;
+			potentiallyVisibleSet.Clear();
+			return false;
+		}
+		return true;
+	}
 }
\ No newline at end of file
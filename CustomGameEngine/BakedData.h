@@ -1,6 +1,7 @@
 #pragma once
 #include <glm/ext/vector_float3.hpp>
 #include "ReflectionProbe.h"
+#include "PotentiallyVisibleSet.h"
 #include <vector>
 #include <filesystem>
 #include <string>
@@ -69,8 +70,15 @@ namespace Engine {
 		void SetCulledProbeList(const std::map<float, ReflectionProbe*>& newProbeList) { this->culledProbeList = newProbeList; }
 		const std::map<float, ReflectionProbe*>& GetCulledProbeList() const { return culledProbeList; }
 
+		// Potentially visible sets, see SystemPVSBaking
+		PotentiallyVisibleSet& GetPotentiallyVisibleSet() { return potentiallyVisibleSet; }
+		const PotentiallyVisibleSet& GetPotentiallyVisibleSet() const { return potentiallyVisibleSet; }
+		void WritePVSToFile(const std::string& sceneName);
+		bool LoadPVSFromFile(const std::string& sceneName);
+
 		void ClearBakedData() {
 			ClearReflectionProbes();
+			potentiallyVisibleSet.Clear();
 		}
 
 		const unsigned int GetProbeIrradianceMapArray() const { return reflectionProbeIrradianceMapArray; }
@@ -150,5 +158,7 @@ namespace Engine {
 
 		std::vector<ReflectionProbe*> reflectionProbes;
 		std::map<float, ReflectionProbe*> culledProbeList; // <distance to probe squared, probe>
+
+		PotentiallyVisibleSet potentiallyVisibleSet;
 	};
 }
\ No newline at end of file
@@ -103,6 +103,22 @@ namespace Engine {
 		UpdateViewFrustum();
 	}
 
+	ViewFrustum ViewFrustum::FromViewProjection(const glm::mat4& viewProjection)
+	{
+		// Each plane is the sum or difference of the w row and another row of the matrix, facing into the frustum
+		const glm::mat4 rows = glm::transpose(viewProjection);
+		const glm::vec4 planeEquations[6] = { rows[3] + rows[0], rows[3] - rows[0], rows[3] + rows[1], rows[3] - rows[1], rows[3] + rows[2], rows[3] - rows[2] };
+
+		ViewFrustum frustum;
+		ViewPlane* planes[6] = { &frustum.left, &frustum.right, &frustum.bottom, &frustum.top, &frustum.near, &frustum.far };
+		for (int i = 0; i < 6; i++) {
+			const float length = glm::length(glm::vec3(planeEquations[i]));
+			planes[i]->normal = glm::vec3(planeEquations[i]) / length;
+			planes[i]->distance = -planeEquations[i].w / length;
+		}
+		return frustum;
+	}
+
 	const ViewFrustum& Camera::UpdateViewFrustum()
 	{
 		float aspect = (float)SCR_WIDTH / (float)SCR_HEIGHT;
@@ -35,6 +35,9 @@ namespace Engine {
 
 		ViewPlane far;
 		ViewPlane near;
+
+		// Planes of the clip space box of any view projection matrix, perspective or orthographic
+		static ViewFrustum FromViewProjection(const glm::mat4& viewProjection);
 	};
 
 	class Camera
@@ -65,6 +68,7 @@ namespace Engine {
 		float GetZoom() const { return zoom; }
 		float GetNearClip() const { return nearClip; }
 		float GetFarClip() const { return farClip; }
+		unsigned int GetScreenHeight() const { return SCR_HEIGHT; }
 		const ViewFrustum& GetViewFrustum() { return viewFrustum; }
 
 		// ------------------------ Set ------------------------
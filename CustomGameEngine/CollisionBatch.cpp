@@ -0,0 +1,131 @@
+#include "CollisionBatch.h"
+#include "SIMDLanes.h"
+#include <cmath>
+#include <algorithm>
+#include <utility>
+#include <initializer_list>
+namespace Engine {
+	namespace {
+		constexpr unsigned int BATCH_ALIGNMENT = MAX_LANE_WIDTH;
+
+		// Padding pairs are placed far apart with a negative radius so they can never report a hit
+		constexpr float PADDING_POSITION = 1.0e18f;
+		constexpr float PADDING_RADIUS = -1.0f;
+
+		// The tests below do the same operations in the same order as the scalar narrowphase, so a batch never disagrees with it about a pair
+
+		unsigned int RoundUpToBatch(const unsigned int count) {
+			return (count + BATCH_ALIGNMENT - 1) & ~(BATCH_ALIGNMENT - 1);
+		}
+
+		// Grow every array to hold newCount entries, new entries are filled with the matching padding value
+		void Reserve(const std::initializer_list<std::pair<std::vector<float>*, float>>& arrays, const unsigned int newCount) {
+			for (const std::pair<std::vector<float>*, float>& array : arrays) {
+				if (newCount > array.first->size()) {
+					array.first->resize(RoundUpToBatch(std::max(newCount, (unsigned int)array.first->size() * 2)), array.second);
+				}
+			}
+		}
+	}
+
+	void SphereSphereBatch::Add(const glm::vec3& centreA, const float radiusA, const glm::vec3& centreB, const float radiusB)
+	{
+		Reserve({ { &centreAX, PADDING_POSITION }, { &centreAY, PADDING_POSITION }, { &centreAZ, PADDING_POSITION }, { &this->radiusA, PADDING_RADIUS },
+			{ &centreBX, -PADDING_POSITION }, { &centreBY, -PADDING_POSITION }, { &centreBZ, -PADDING_POSITION }, { &this->radiusB, PADDING_RADIUS } }, count + 1);
+
+		centreAX[count] = centreA.x;
+		centreAY[count] = centreA.y;
+		centreAZ[count] = centreA.z;
+		this->radiusA[count] = radiusA;
+		centreBX[count] = centreB.x;
+		centreBY[count] = centreB.y;
+		centreBZ[count] = centreB.z;
+		this->radiusB[count] = radiusB;
+		count++;
+	}
+
+	template <typename Lanes>
+	void SphereSphereBatch::TestWith(unsigned char* out_hits) const
+	{
+		// The arrays are padded to a whole batch but out_hits only has room for count entries, so the last batch goes through a small buffer
+		unsigned char tail[BATCH_ALIGNMENT];
+		for (unsigned int i = 0; i < count; i += Lanes::width) {
+			const typename Lanes::Float dx = Lanes::Sub(Lanes::Load(&centreAX[i]), Lanes::Load(&centreBX[i]));
+			const typename Lanes::Float dy = Lanes::Sub(Lanes::Load(&centreAY[i]), Lanes::Load(&centreBY[i]));
+			const typename Lanes::Float dz = Lanes::Sub(Lanes::Load(&centreAZ[i]), Lanes::Load(&centreBZ[i]));
+			const typename Lanes::Float distanceSqr = Lanes::Add(Lanes::Add(Lanes::Mul(dx, dx), Lanes::Mul(dy, dy)), Lanes::Mul(dz, dz));
+			const typename Lanes::Float combinedRadius = Lanes::Add(Lanes::Load(&radiusA[i]), Lanes::Load(&radiusB[i]));
+
+			if (i + Lanes::width <= count) {
+				Lanes::StoreLess(&out_hits[i], distanceSqr, Lanes::Mul(combinedRadius, combinedRadius));
+			}
+			else {
+				Lanes::StoreLess(tail, distanceSqr, Lanes::Mul(combinedRadius, combinedRadius));
+				std::copy(tail, tail + (count - i), &out_hits[i]);
+			}
+		}
+	}
+
+	void SphereSphereBatch::Test(unsigned char* out_hits) const
+	{
+		TestWith<WideLanes>(out_hits);
+	}
+
+	void SphereSphereBatch::TestScalar(unsigned char* out_hits) const
+	{
+		TestWith<ScalarLanes>(out_hits);
+	}
+
+	void SphereAABBBatch::Add(const glm::vec3& centre, const float radius, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+	{
+		Reserve({ { &centreX, PADDING_POSITION }, { &centreY, PADDING_POSITION }, { &centreZ, PADDING_POSITION }, { &this->radius, PADDING_RADIUS },
+			{ &minX, 0.0f }, { &minY, 0.0f }, { &minZ, 0.0f }, { &maxX, 0.0f }, { &maxY, 0.0f }, { &maxZ, 0.0f } }, count + 1);
+
+		centreX[count] = centre.x;
+		centreY[count] = centre.y;
+		centreZ[count] = centre.z;
+		this->radius[count] = radius;
+		minX[count] = boundsMin.x;
+		minY[count] = boundsMin.y;
+		minZ[count] = boundsMin.z;
+		maxX[count] = boundsMax.x;
+		maxY[count] = boundsMax.y;
+		maxZ[count] = boundsMax.z;
+		count++;
+	}
+
+	template <typename Lanes>
+	void SphereAABBBatch::TestWith(unsigned char* out_hits) const
+	{
+		unsigned char tail[BATCH_ALIGNMENT];
+		for (unsigned int i = 0; i < count; i += Lanes::width) {
+			const typename Lanes::Float x = Lanes::Load(&centreX[i]);
+			const typename Lanes::Float y = Lanes::Load(&centreY[i]);
+			const typename Lanes::Float z = Lanes::Load(&centreZ[i]);
+
+			// Closest point on the box to the sphere's centre
+			const typename Lanes::Float dx = Lanes::Sub(Lanes::Max(Lanes::Load(&minX[i]), Lanes::Min(x, Lanes::Load(&maxX[i]))), x);
+			const typename Lanes::Float dy = Lanes::Sub(Lanes::Max(Lanes::Load(&minY[i]), Lanes::Min(y, Lanes::Load(&maxY[i]))), y);
+			const typename Lanes::Float dz = Lanes::Sub(Lanes::Max(Lanes::Load(&minZ[i]), Lanes::Min(z, Lanes::Load(&maxZ[i]))), z);
+			const typename Lanes::Float distance = Lanes::Sqrt(Lanes::Add(Lanes::Add(Lanes::Mul(dx, dx), Lanes::Mul(dy, dy)), Lanes::Mul(dz, dz)));
+
+			if (i + Lanes::width <= count) {
+				Lanes::StoreLess(&out_hits[i], distance, Lanes::Load(&radius[i]));
+			}
+			else {
+				Lanes::StoreLess(tail, distance, Lanes::Load(&radius[i]));
+				std::copy(tail, tail + (count - i), &out_hits[i]);
+			}
+		}
+	}
+
+	void SphereAABBBatch::Test(unsigned char* out_hits) const
+	{
+		TestWith<WideLanes>(out_hits);
+	}
+
+	void SphereAABBBatch::TestScalar(unsigned char* out_hits) const
+	{
+		TestWith<ScalarLanes>(out_hits);
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <vector>
+#include <glm/ext/vector_float3.hpp>
+namespace Engine {
+	// Sphere against sphere tests gathered into structure of arrays form so several pairs are tested per instruction
+	// Only answers whether each pair overlaps, contacts are built afterwards for the pairs that do
+	class SphereSphereBatch
+	{
+	public:
+		SphereSphereBatch() : count(0) {}
+		~SphereSphereBatch() {}
+
+		void Clear() { count = 0; }
+		unsigned int Size() const { return count; }
+
+		// Radii are world space, already scaled
+		void Add(const glm::vec3& centreA, const float radiusA, const glm::vec3& centreB, const float radiusB);
+
+		// out_hits[i] is set to 1 if pair i overlaps and 0 otherwise
+		void Test(unsigned char* out_hits) const;
+		void TestScalar(unsigned char* out_hits) const;
+
+	private:
+		template <typename Lanes>
+		void TestWith(unsigned char* out_hits) const;
+
+		unsigned int count;
+		std::vector<float> centreAX, centreAY, centreAZ, radiusA;
+		std::vector<float> centreBX, centreBY, centreBZ, radiusB;
+	};
+
+	// Sphere against world space AABB tests in structure of arrays form
+	class SphereAABBBatch
+	{
+	public:
+		SphereAABBBatch() : count(0) {}
+		~SphereAABBBatch() {}
+
+		void Clear() { count = 0; }
+		unsigned int Size() const { return count; }
+
+		void Add(const glm::vec3& centre, const float radius, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+
+		void Test(unsigned char* out_hits) const;
+		void TestScalar(unsigned char* out_hits) const;
+
+	private:
+		template <typename Lanes>
+		void TestWith(unsigned char* out_hits) const;
+
+		unsigned int count;
+		std::vector<float> centreX, centreY, centreZ, radius;
+		std::vector<float> minX, minY, minZ, maxX, maxY, maxZ;
+	};
+}
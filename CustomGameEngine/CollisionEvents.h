@@ -0,0 +1,90 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+namespace Engine {
+	enum CollisionEventType : unsigned char {
+		COLLISION_BEGIN, // first frame the pair is touching
+		COLLISION_STAY, // touching this frame and last frame
+		COLLISION_END // touched last frame but not this one
+	};
+
+	// entityIDA is always the lower of the two IDs
+	struct CollisionEvent {
+		unsigned int entityIDA;
+		unsigned int entityIDB;
+		CollisionEventType type;
+
+		bool Involves(const unsigned int entityID) const { return entityIDA == entityID || entityIDB == entityID; }
+		unsigned int Other(const unsigned int entityID) const { return (entityIDA == entityID) ? entityIDB : entityIDA; }
+	};
+
+	// Ring buffer of collision events written once per physics step by the collision system
+	// Every event is numbered by a running sequence number, so a reader that doesn't run every frame can keep a cursor and catch up,
+	// as long as it reads again before the buffer wraps past it. The current frame's events are never overwritten, the buffer grows instead
+	class CollisionEventBuffer
+	{
+	public:
+		static constexpr unsigned int DEFAULT_CAPACITY = 1024;
+
+		CollisionEventBuffer(const unsigned int initialCapacity = DEFAULT_CAPACITY) : head(0), frameStart(0) {
+			unsigned int capacity = 16;
+			while (capacity < initialCapacity) { capacity <<= 1; }
+			events.resize(capacity);
+		}
+		~CollisionEventBuffer() {}
+
+		void BeginFrame() { frameStart = head; }
+
+		void Push(const CollisionEvent& event) {
+			if (head - frameStart == events.size()) { Grow(); }
+			events[head & (events.size() - 1)] = event;
+			head++;
+		}
+
+		// Events of the most recent frame, in pair order
+		template <typename Func>
+		void ForEach(Func&& func) const {
+			for (unsigned long long sequence = frameStart; sequence < head; sequence++) {
+				func(events[sequence & (events.size() - 1)]);
+			}
+		}
+
+		// Every event still held from cursor onwards, returns the cursor to pass next time. Start from 0 or Head()
+		// Events that have already been overwritten are skipped, see Dropped()
+		template <typename Func>
+		unsigned long long ReadSince(const unsigned long long cursor, Func&& func) const {
+			for (unsigned long long sequence = std::max(cursor, Oldest()); sequence < head; sequence++) {
+				func(events[sequence & (events.size() - 1)]);
+			}
+			return head;
+		}
+
+		// Number of events a reader at cursor has missed because the buffer wrapped
+		unsigned long long Dropped(const unsigned long long cursor) const { return (cursor < Oldest()) ? Oldest() - cursor : 0; }
+
+		unsigned long long Head() const { return head; }
+		unsigned int NumFrameEvents() const { return head - frameStart; }
+		unsigned int Capacity() const { return events.size(); }
+
+		void Clear() {
+			head = 0;
+			frameStart = 0;
+		}
+
+	private:
+		unsigned long long Oldest() const { return (head > events.size()) ? head - events.size() : 0; }
+
+		// Doubles the capacity, keeping every event that was still readable
+		void Grow() {
+			std::vector<CollisionEvent> grown(events.size() * 2);
+			for (unsigned long long sequence = Oldest(); sequence < head; sequence++) {
+				grown[sequence & (grown.size() - 1)] = events[sequence & (events.size() - 1)];
+			}
+			events.swap(grown);
+		}
+
+		std::vector<CollisionEvent> events; // power of two size
+		unsigned long long head; // sequence number of the next event written
+		unsigned long long frameStart; // sequence number of the first event of the most recent frame
+	};
+}
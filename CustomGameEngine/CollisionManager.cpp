@@ -1,24 +1,68 @@
 #include "CollisionManager.h"
 #include "SystemBuildMeshList.h"
+#include "ContactCache.h"
+#include <bit>
 namespace Engine {
 	CollisionManager::CollisionManager()
 	{
 		bvhTree = new BVHTree();
+		contactCache = new ContactCache();
+
+		for (unsigned int i = 0; i < NUM_COLLISION_LAYERS; i++) { layerInteractions[i] = ALL_COLLISION_LAYERS; }
+		allLayersInteract = true;
 	}
 
 	CollisionManager::~CollisionManager()
 	{
 		delete bvhTree;
+		delete contactCache;
 	}
 
 	void CollisionManager::ConstructBVHTree()
 	{
 		SCOPE_TIMER("CollisionManager::ConstructBVHTree");
-		if (bvhTree) {
-			delete bvhTree;
-			bvhTree = new BVHTree();
+		bvhTree->BuildTree(SystemBuildMeshList::MeshList());
+	}
+
+	BVHUpdateType CollisionManager::UpdateBVHTree()
+	{
+		SCOPE_TIMER("CollisionManager::UpdateBVHTree");
+		return bvhTree->UpdateTree(SystemBuildMeshList::MeshList());
+	}
+
+	void CollisionManager::SetLayersInteract(const unsigned int layerIndexA, const unsigned int layerIndexB, const bool interact)
+	{
+		assert(layerIndexA < NUM_COLLISION_LAYERS && layerIndexB < NUM_COLLISION_LAYERS);
+		if (layerIndexA >= NUM_COLLISION_LAYERS || layerIndexB >= NUM_COLLISION_LAYERS) {
+			std::cout << "ERROR::COLLISIONMANAGER::SetLayersInteract::Layer index out of range, layers are 0 - " << NUM_COLLISION_LAYERS - 1 << std::endl;
+			return;
 		}
 
-		bvhTree->BuildTree(SystemBuildMeshList::MeshList());
+		if (interact) {
+			layerInteractions[layerIndexA] |= (1u << layerIndexB);
+			layerInteractions[layerIndexB] |= (1u << layerIndexA);
+		}
+		else {
+			layerInteractions[layerIndexA] &= ~(1u << layerIndexB);
+			layerInteractions[layerIndexB] &= ~(1u << layerIndexA);
+		}
+
+		allLayersInteract = true;
+		for (unsigned int i = 0; i < NUM_COLLISION_LAYERS; i++) {
+			if (layerInteractions[i] != ALL_COLLISION_LAYERS) { allLayersInteract = false; }
+		}
+	}
+
+	unsigned int CollisionManager::InteractingLayers(const unsigned int layerMask) const
+	{
+		if (allLayersInteract) { return ALL_COLLISION_LAYERS; }
+
+		unsigned int result = 0u;
+		unsigned int remaining = layerMask;
+		while (remaining) {
+			result |= layerInteractions[std::countr_zero(remaining)];
+			remaining &= remaining - 1u;
+		}
+		return result;
 	}
 }
\ No newline at end of file
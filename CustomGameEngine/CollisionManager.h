@@ -1,10 +1,17 @@
 #pragma once
 //#include "Entity.h"
 #include <glm/ext/vector_float3.hpp>
+#include <cassert>
 #include "BVHTree.h"
+#include "CollisionEvents.h"
+#include "CollisionQueryBVH.h"
+#include "ComponentCollision.h"
 namespace Engine {
+	class ContactCache;
+	class EntityManager;
+
 	struct ContactPoint {
-		ContactPoint(const glm::vec3& contactA, const glm::vec3& contactB, const glm::vec3& collisionNormal, const float collisionPenetration) : contactPointA(contactA), contactPointB(contactB), normal(collisionNormal), penetration(collisionPenetration), b_term(0.0f), sumImpulseContact(0.0f), sumImpulseFriction(glm::vec3(0.0f)) {}
+		ContactPoint(const glm::vec3& contactA, const glm::vec3& contactB, const glm::vec3& collisionNormal, const float collisionPenetration, const unsigned int featureID = 0) : contactPointA(contactA), contactPointB(contactB), normal(collisionNormal), penetration(collisionPenetration), featureID(featureID), b_term(0.0f), sumImpulseContact(0.0f), sumImpulseFriction(glm::vec3(0.0f)) {}
 
 		glm::vec3 contactPointA;
 		glm::vec3 contactPointB;
@@ -13,6 +20,9 @@ namespace Engine {
 
 		float penetration;
 
+		// Identifies the pair of features (faces / vertices) that generated this contact, used to match contacts across frames. 0 = unknown
+		unsigned int featureID;
+
 		float b_term;
 		glm::vec3 sumImpulseFriction;
 		float sumImpulseContact;
@@ -22,10 +32,16 @@ namespace Engine {
 		unsigned int entityIDA;
 		unsigned int entityIDB;
 
+		// Filled in by the collision pipeline so resolution never has to look colliders up again
+		ComponentCollision* colliderA;
+		ComponentCollision* colliderB;
+		ColliderType shapeA;
+		ColliderType shapeB;
+
 		std::vector<ContactPoint> contactPoints;
 
-		void AddContactPoint(const glm::vec3& contactA, const glm::vec3& contactB, const glm::vec3& normal, const float penetration) {
-			contactPoints.push_back(ContactPoint(contactA, contactB, normal, penetration));
+		void AddContactPoint(const glm::vec3& contactA, const glm::vec3& contactB, const glm::vec3& normal, const float penetration, const unsigned int featureID = 0) {
+			contactPoints.push_back(ContactPoint(contactA, contactB, normal, penetration, featureID));
 		};
 
 		bool isColliding;
@@ -37,17 +53,62 @@ namespace Engine {
 		CollisionManager();
 		~CollisionManager();
 
-		const std::vector<CollisionData>& GetUnresolvedCollisions() { return unresolvedCollisions; }
+		const std::vector<CollisionData>& GetUnresolvedCollisions() const { return unresolvedCollisions; }
+		std::vector<CollisionData>& GetUnresolvedCollisions() { return unresolvedCollisions; }
 		void ClearUnresolvedCollisions() { unresolvedCollisions.clear(); }
 
 		void AddToCollisionList(CollisionData newCollision) { unresolvedCollisions.push_back(newCollision); }
 
+		// Begin, stay and end events for every pair of entities touching this step or last, written by the collision system
+		const CollisionEventBuffer& GetCollisionEvents() const { return collisionEvents; }
+		CollisionEventBuffer& GetCollisionEvents() { return collisionEvents; }
+
 		void ConstructBVHTree();
 
+		// Refits the geometry BVH to meshes that have moved since the last build, only rebuilding when the tree has degraded. See BVHTree::UpdateTree
+		BVHUpdateType UpdateBVHTree();
+
 		BVHTree* GetBVHTree() { return bvhTree; }
+		ContactCache* GetContactCache() { return contactCache; }
+
+		static constexpr unsigned int NUM_COLLISION_LAYERS = 32;
+
+		// Scene wide layer interaction matrix, layers are given by bit index 0 - 31. Every layer interacts with every other by default
+		// Applied in the broadphase together with each collider's own mask, before any narrowphase work
+		void SetLayersInteract(const unsigned int layerIndexA, const unsigned int layerIndexB, const bool interact);
+		bool LayersInteract(const unsigned int layerIndexA, const unsigned int layerIndexB) const {
+			assert(layerIndexA < NUM_COLLISION_LAYERS && layerIndexB < NUM_COLLISION_LAYERS);
+			if (layerIndexA >= NUM_COLLISION_LAYERS || layerIndexB >= NUM_COLLISION_LAYERS) { return false; }
+			return (layerInteractions[layerIndexA] >> layerIndexB) & 1u;
+		}
+
+		// Every layer that interacts with at least one of the layers in the mask
+		unsigned int InteractingLayers(const unsigned int layerMask) const;
+
+		// Layers a collider on layerMask with the given collision mask will accept the other side of a pair from
+		unsigned int AcceptedLayers(const unsigned int layerMask, const unsigned int collisionMask) const { return collisionMask & InteractingLayers(layerMask); }
+
+		// Spatial queries against every collider, as of the last BuildQueryBVH or UpdateQueryBVH
+		void BuildQueryBVH(EntityManager& ecs) { queryBVH.Build(ecs); }
+		// Refits the query BVH to where the colliders are now, only rebuilding when colliders were added or removed. See CollisionQueryBVH::Update
+		bool UpdateQueryBVH(EntityManager& ecs) { return queryBVH.Update(ecs); }
+		const CollisionQueryBVH& GetQueryBVH() const { return queryBVH; }
+
+		bool Raycast(const Ray& ray, RaycastHit& out_hit, const unsigned int layerMask = ALL_COLLISION_LAYERS) const { return queryBVH.Raycast(ray, out_hit, layerMask); }
+		bool SphereCast(const Ray& ray, const float radius, RaycastHit& out_hit, const unsigned int layerMask = ALL_COLLISION_LAYERS) const { return queryBVH.SphereCast(ray, radius, out_hit, layerMask); }
+		void RaycastBatch(const std::vector<Ray>& rays, std::vector<RaycastHit>& out_hits, const unsigned int layerMask = ALL_COLLISION_LAYERS) const { queryBVH.RaycastBatch(rays, out_hits, layerMask); }
+		void SphereCastBatch(const std::vector<Ray>& rays, const float radius, std::vector<RaycastHit>& out_hits, const unsigned int layerMask = ALL_COLLISION_LAYERS) const { queryBVH.SphereCastBatch(rays, radius, out_hits, layerMask); }
+		unsigned int OverlapSphere(const glm::vec3& centre, const float radius, std::vector<unsigned int>& out_entities, const unsigned int layerMask = ALL_COLLISION_LAYERS) const { return queryBVH.OverlapSphere(centre, radius, out_entities, layerMask); }
+		unsigned int OverlapAABB(const glm::vec3& boundsMin, const glm::vec3& boundsMax, std::vector<unsigned int>& out_entities, const unsigned int layerMask = ALL_COLLISION_LAYERS) const { return queryBVH.OverlapAABB(boundsMin, boundsMax, out_entities, layerMask); }
 	private:
 		std::vector<CollisionData> unresolvedCollisions;
+		CollisionEventBuffer collisionEvents;
+		CollisionQueryBVH queryBVH;
+
+		unsigned int layerInteractions[NUM_COLLISION_LAYERS]; // bit j of entry i is set if layer i interacts with layer j, kept symmetric
+		bool allLayersInteract; // skips building the interaction mask in the common case
 
 		BVHTree* bvhTree;
+		ContactCache* contactCache;
 	};
 }
\ No newline at end of file
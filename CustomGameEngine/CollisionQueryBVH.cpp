@@ -0,0 +1,762 @@
+#include "CollisionQueryBVH.h"
+#include "EntityManager.h"
+#include "ComponentTransform.h"
+#include "ComponentCollisionSphere.h"
+#include "ComponentCollisionAABB.h"
+#include "ComponentCollisionBox.h"
+#include "ComponentCollisionMesh.h"
+#include "ComponentCollisionConvex.h"
+#include "GJK.h"
+#include "ThreadPool.h"
+#include "ScopeTimer.h"
+#include <algorithm>
+#include <cassert>
+#include <glm/glm.hpp>
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+#include <immintrin.h>
+#define QUERY_BVH_SSE
+#endif
+namespace Engine {
+	namespace {
+		constexpr unsigned int RAYS_PER_CHUNK = 32;
+		constexpr unsigned int MAX_STACK_DEPTH = 256;
+
+		// Keeps slab maths finite for axis aligned rays, 0 * inf would otherwise produce NaN
+		glm::vec3 SafeInverse(const glm::vec3& direction) {
+			glm::vec3 inverse;
+			for (int i = 0; i < 3; i++) {
+				const float d = (fabs(direction[i]) < 1e-20f) ? ((direction[i] < 0.0f) ? -1e-20f : 1e-20f) : direction[i];
+				inverse[i] = 1.0f / d;
+			}
+			return inverse;
+		}
+
+		// Ray against an axis aligned box, returns the entry distance and axis (-1 if the ray starts inside)
+		bool RaySlabs(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3& boxMin, const glm::vec3& boxMax, const float maxDistance, float& out_distance, int& out_axis) {
+			float tEnter = 0.0f;
+			float tExit = maxDistance;
+			out_axis = -1;
+
+			for (int i = 0; i < 3; i++) {
+				if (fabs(direction[i]) < 1e-12f) {
+					if (origin[i] < boxMin[i] || origin[i] > boxMax[i]) { return false; }
+					continue;
+				}
+
+				const float inverseDirection = 1.0f / direction[i];
+				float t1 = (boxMin[i] - origin[i]) * inverseDirection;
+				float t2 = (boxMax[i] - origin[i]) * inverseDirection;
+				if (t1 > t2) { std::swap(t1, t2); }
+
+				if (t1 > tEnter) {
+					tEnter = t1;
+					out_axis = i;
+				}
+				tExit = std::min(tExit, t2);
+				if (tEnter > tExit) { return false; }
+			}
+
+			out_distance = tEnter;
+			return true;
+		}
+
+		glm::vec3 ClosestPointOnBox(const glm::vec3& point, const glm::vec3& boxMin, const glm::vec3& boxMax) {
+			return glm::clamp(point, boxMin, boxMax);
+		}
+	}
+
+	void CollisionQueryBVH::Build(EntityManager& ecs)
+	{
+		SCOPE_TIMER("CollisionQueryBVH::Build()");
+		GatherShapes(ecs, shapes);
+		BuildFromShapes();
+	}
+
+	bool CollisionQueryBVH::Update(EntityManager& ecs)
+	{
+		SCOPE_TIMER("CollisionQueryBVH::Update()");
+		GatherShapes(ecs, gatheredShapes);
+
+		// Same colliders in the same order as the last build, so every shape can be written straight into its slot in the tree
+		bool sameShapes = gatheredShapes.size() == sourceSlots.size();
+		for (unsigned int i = 0; i < gatheredShapes.size() && sameShapes; i++) {
+			const QueryShape& current = shapes[sourceSlots[i]];
+			sameShapes = current.entityID == gatheredShapes[i].entityID && current.type == gatheredShapes[i].type;
+		}
+
+		if (!sameShapes) {
+			shapes.swap(gatheredShapes);
+			BuildFromShapes();
+			return true;
+		}
+
+		for (unsigned int i = 0; i < gatheredShapes.size(); i++) {
+			shapes[sourceSlots[i]] = gatheredShapes[i];
+		}
+		Refit();
+
+		if (TreeCost() > builtCost * REBUILD_COST_RATIO) {
+			BuildFromShapes();
+			return true;
+		}
+		return false;
+	}
+
+	void CollisionQueryBVH::GatherShapes(EntityManager& ecs, std::vector<QueryShape>& out_shapes) const
+	{
+		out_shapes.clear();
+
+		ecs.View<ComponentTransform, ComponentCollisionSphere>().ForEach([&out_shapes](const unsigned int entityID, ComponentTransform& transform, ComponentCollisionSphere& collider) {
+			QueryShape shape;
+			shape.entityID = entityID;
+			shape.layer = collider.CollisionLayer();
+			shape.type = QUERY_SHAPE_SPHERE;
+			shape.centre = transform.GetWorldPosition();
+			shape.radius = collider.CollisionRadius() * transform.GetBiggestScaleFactor();
+			shape.boundsMin = shape.centre - glm::vec3(shape.radius);
+			shape.boundsMax = shape.centre + glm::vec3(shape.radius);
+			shape.sourceIndex = out_shapes.size();
+			out_shapes.push_back(shape);
+		});
+
+		ecs.View<ComponentTransform, ComponentCollisionAABB>().ForEach([&out_shapes](const unsigned int entityID, ComponentTransform& transform, ComponentCollisionAABB& collider) {
+			const AABBPoints bounds = collider.GetWorldSpaceBounds(transform.GetWorldModelMatrix());
+			QueryShape shape;
+			shape.entityID = entityID;
+			shape.layer = collider.CollisionLayer();
+			shape.type = QUERY_SHAPE_AABB;
+			shape.boundsMin = glm::vec3(bounds.minX, bounds.minY, bounds.minZ);
+			shape.boundsMax = glm::vec3(bounds.maxX, bounds.maxY, bounds.maxZ);
+			shape.centre = (shape.boundsMin + shape.boundsMax) * 0.5f;
+			shape.sourceIndex = out_shapes.size();
+			out_shapes.push_back(shape);
+		});
+
+		ecs.View<ComponentTransform, ComponentCollisionBox>().ForEach([&out_shapes](const unsigned int entityID, ComponentTransform& transform, ComponentCollisionBox& collider) {
+			const BoxExtents& extents = collider.GetLocalPoints();
+			QueryShape shape;
+			shape.entityID = entityID;
+			shape.layer = collider.CollisionLayer();
+			shape.type = QUERY_SHAPE_BOX;
+			shape.model = transform.GetWorldModelMatrix();
+			shape.inverseModel = glm::inverse(shape.model);
+			shape.localMin = glm::vec3(extents.minX, extents.minY, extents.minZ);
+			shape.localMax = glm::vec3(extents.maxX, extents.maxY, extents.maxZ);
+			shape.scale = glm::vec3(glm::length(glm::vec3(shape.model[0])), glm::length(glm::vec3(shape.model[1])), glm::length(glm::vec3(shape.model[2])));
+			shape.centre = glm::vec3(shape.model * glm::vec4((shape.localMin + shape.localMax) * 0.5f, 1.0f));
+
+			// World bounds of the oriented box
+			const glm::vec3 halfExtents = (shape.localMax - shape.localMin) * 0.5f;
+			const glm::mat3 absolute = glm::mat3(glm::abs(glm::vec3(shape.model[0])), glm::abs(glm::vec3(shape.model[1])), glm::abs(glm::vec3(shape.model[2])));
+			const glm::vec3 worldHalfExtents = absolute * halfExtents;
+			shape.boundsMin = shape.centre - worldHalfExtents;
+			shape.boundsMax = shape.centre + worldHalfExtents;
+			shape.sourceIndex = out_shapes.size();
+			out_shapes.push_back(shape);
+		});
+
+		ecs.View<ComponentTransform, ComponentCollisionConvex>().ForEach([&out_shapes](const unsigned int entityID, ComponentTransform& transform, ComponentCollisionConvex& collider) {
+			if (!collider.GetHull() || collider.GetHull()->NumVertices() == 0) { return; }
+			QueryShape shape;
+			shape.entityID = entityID;
+			shape.layer = collider.CollisionLayer();
+			shape.type = QUERY_SHAPE_CONVEX;
+			shape.hull = collider.GetHull();
+			shape.model = transform.GetWorldModelMatrix();
+			shape.inverseModel = glm::inverse(shape.model);
+			collider.GetWorldSpaceBounds(shape.model, shape.boundsMin, shape.boundsMax);
+			shape.centre = (shape.boundsMin + shape.boundsMax) * 0.5f;
+			shape.sourceIndex = out_shapes.size();
+			out_shapes.push_back(shape);
+		});
+
+		ecs.View<ComponentTransform, ComponentCollisionMesh>().ForEach([&out_shapes](const unsigned int entityID, ComponentTransform& transform, ComponentCollisionMesh& collider) {
+			if (!collider.GetMesh() || collider.GetMesh()->NumTriangles() == 0) { return; }
+			QueryShape shape;
+			shape.entityID = entityID;
+			shape.layer = collider.CollisionLayer();
+			shape.type = QUERY_SHAPE_MESH;
+			shape.mesh = collider.GetMesh();
+			shape.model = transform.GetWorldModelMatrix();
+			shape.inverseModel = glm::inverse(shape.model);
+			collider.GetWorldSpaceBounds(shape.model, shape.boundsMin, shape.boundsMax);
+			shape.centre = (shape.boundsMin + shape.boundsMax) * 0.5f;
+			shape.sourceIndex = out_shapes.size();
+			out_shapes.push_back(shape);
+		});
+
+	}
+
+	void CollisionQueryBVH::BuildFromShapes()
+	{
+		nodes.clear();
+		treeDepth = 0;
+		if (shapes.size() > 0) {
+			nodes.reserve((shapes.size() / std::max(maxShapesPerLeaf, 1u)) + 1);
+			BuildNode(0, shapes.size(), 1);
+		}
+
+		// Median splits keep the tree balanced. Traversal pushes at most three siblings per level plus the last level's four
+		assert(3 * treeDepth + 1 <= MAX_STACK_DEPTH);
+
+		sourceSlots.resize(shapes.size());
+		for (unsigned int i = 0; i < shapes.size(); i++) {
+			sourceSlots[shapes[i].sourceIndex] = i;
+		}
+		builtCost = TreeCost();
+	}
+
+	void CollisionQueryBVH::Refit()
+	{
+		// Children are always built after their parent, so walking backwards sees every child before it's needed
+		for (int nodeIndex = (int)nodes.size() - 1; nodeIndex >= 0; nodeIndex--) {
+			Node& node = nodes[nodeIndex];
+			for (unsigned int slot = 0; slot < 4; slot++) {
+				const unsigned int child = node.child[slot];
+				if (child == EMPTY_CHILD) { continue; }
+
+				glm::vec3 boundsMin, boundsMax;
+				if (child & LEAF_FLAG) {
+					const unsigned int first = child & ~LEAF_FLAG;
+					RangeBounds(first, first + node.count[slot], boundsMin, boundsMax);
+				}
+				else {
+					const Node& childNode = nodes[child];
+					boundsMin = glm::vec3(FLT_MAX);
+					boundsMax = glm::vec3(-FLT_MAX);
+					for (unsigned int childSlot = 0; childSlot < 4; childSlot++) {
+						if (childNode.child[childSlot] == EMPTY_CHILD) { continue; }
+						boundsMin = glm::min(boundsMin, glm::vec3(childNode.minX[childSlot], childNode.minY[childSlot], childNode.minZ[childSlot]));
+						boundsMax = glm::max(boundsMax, glm::vec3(childNode.maxX[childSlot], childNode.maxY[childSlot], childNode.maxZ[childSlot]));
+					}
+				}
+
+				node.minX[slot] = boundsMin.x;
+				node.minY[slot] = boundsMin.y;
+				node.minZ[slot] = boundsMin.z;
+				node.maxX[slot] = boundsMax.x;
+				node.maxY[slot] = boundsMax.y;
+				node.maxZ[slot] = boundsMax.z;
+			}
+		}
+	}
+
+	float CollisionQueryBVH::TreeCost() const
+	{
+		if (nodes.size() == 0) { return 0.0f; }
+
+		auto surfaceArea = [](const glm::vec3& extent) { return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x); };
+
+		glm::vec3 rootMin = glm::vec3(FLT_MAX);
+		glm::vec3 rootMax = glm::vec3(-FLT_MAX);
+		float total = 0.0f;
+		for (unsigned int nodeIndex = 0; nodeIndex < nodes.size(); nodeIndex++) {
+			const Node& node = nodes[nodeIndex];
+			for (unsigned int slot = 0; slot < 4; slot++) {
+				if (node.child[slot] == EMPTY_CHILD) { continue; }
+				const glm::vec3 boundsMin = glm::vec3(node.minX[slot], node.minY[slot], node.minZ[slot]);
+				const glm::vec3 boundsMax = glm::vec3(node.maxX[slot], node.maxY[slot], node.maxZ[slot]);
+				total += surfaceArea(boundsMax - boundsMin);
+				if (nodeIndex == 0) {
+					rootMin = glm::min(rootMin, boundsMin);
+					rootMax = glm::max(rootMax, boundsMax);
+				}
+			}
+		}
+
+		const float rootArea = surfaceArea(rootMax - rootMin);
+		return (rootArea > 0.0f) ? total / rootArea : 0.0f;
+	}
+
+	unsigned int CollisionQueryBVH::SplitRange(const unsigned int begin, const unsigned int end)
+	{
+		// Median split on the longest axis of the shape centres
+		glm::vec3 centreMin = shapes[begin].centre;
+		glm::vec3 centreMax = shapes[begin].centre;
+		for (unsigned int i = begin + 1; i < end; i++) {
+			centreMin = glm::min(centreMin, shapes[i].centre);
+			centreMax = glm::max(centreMax, shapes[i].centre);
+		}
+
+		const glm::vec3 extent = centreMax - centreMin;
+		int axis = 0;
+		if (extent.y > extent[axis]) { axis = 1; }
+		if (extent.z > extent[axis]) { axis = 2; }
+
+		const unsigned int mid = begin + ((end - begin) / 2);
+		std::nth_element(shapes.begin() + begin, shapes.begin() + mid, shapes.begin() + end, [axis](const QueryShape& a, const QueryShape& b) {
+			return a.centre[axis] < b.centre[axis];
+		});
+		return mid;
+	}
+
+	unsigned int CollisionQueryBVH::BuildNode(const unsigned int begin, const unsigned int end, const unsigned int depth)
+	{
+		treeDepth = std::max(treeDepth, depth);
+		const unsigned int nodeIndex = nodes.size();
+		nodes.push_back(Node());
+		for (unsigned int slot = 0; slot < 4; slot++) {
+			nodes[nodeIndex].child[slot] = EMPTY_CHILD;
+			nodes[nodeIndex].count[slot] = 0;
+			nodes[nodeIndex].minX[slot] = nodes[nodeIndex].minY[slot] = nodes[nodeIndex].minZ[slot] = FLT_MAX;
+			nodes[nodeIndex].maxX[slot] = nodes[nodeIndex].maxY[slot] = nodes[nodeIndex].maxZ[slot] = -FLT_MAX;
+		}
+
+		// Two levels of binary splits give up to four children
+		unsigned int ranges[5] = { begin, end, end, end, end };
+		unsigned int numRanges = 1;
+		if (end - begin > maxShapesPerLeaf) {
+			const unsigned int mid = SplitRange(begin, end);
+			const unsigned int halves[3] = { begin, mid, end };
+
+			numRanges = 0;
+			ranges[0] = begin;
+			for (unsigned int half = 0; half < 2; half++) {
+				const unsigned int halfBegin = halves[half];
+				const unsigned int halfEnd = halves[half + 1];
+				if (halfEnd - halfBegin > maxShapesPerLeaf) {
+					ranges[++numRanges] = SplitRange(halfBegin, halfEnd);
+				}
+				ranges[++numRanges] = halfEnd;
+			}
+		}
+
+		for (unsigned int slot = 0; slot < numRanges; slot++) {
+			SetChild(nodeIndex, slot, ranges[slot], ranges[slot + 1], depth);
+		}
+		return nodeIndex;
+	}
+
+	void CollisionQueryBVH::SetChild(const unsigned int nodeIndex, const unsigned int slot, const unsigned int begin, const unsigned int end, const unsigned int depth)
+	{
+		glm::vec3 boundsMin, boundsMax;
+		RangeBounds(begin, end, boundsMin, boundsMax);
+
+		unsigned int child;
+		unsigned int count = 0;
+		if (end - begin <= maxShapesPerLeaf) {
+			child = LEAF_FLAG | begin;
+			count = end - begin;
+		}
+		else {
+			// Recursion can grow nodes, so don't hold a reference across it
+			child = BuildNode(begin, end, depth + 1);
+		}
+
+		Node& node = nodes[nodeIndex];
+		node.child[slot] = child;
+		node.count[slot] = count;
+		node.minX[slot] = boundsMin.x;
+		node.minY[slot] = boundsMin.y;
+		node.minZ[slot] = boundsMin.z;
+		node.maxX[slot] = boundsMax.x;
+		node.maxY[slot] = boundsMax.y;
+		node.maxZ[slot] = boundsMax.z;
+	}
+
+	void CollisionQueryBVH::RangeBounds(const unsigned int begin, const unsigned int end, glm::vec3& out_min, glm::vec3& out_max) const
+	{
+		out_min = shapes[begin].boundsMin;
+		out_max = shapes[begin].boundsMax;
+		for (unsigned int i = begin + 1; i < end; i++) {
+			out_min = glm::min(out_min, shapes[i].boundsMin);
+			out_max = glm::max(out_max, shapes[i].boundsMax);
+		}
+	}
+
+	namespace {
+		// Slab test of one ray against a node's four child boxes grown by radius
+		// Returns a bit per child the ray enters within maxDistance, with the entry distances in out_entry
+		template <typename Node>
+		unsigned int RayNode4(const Node& node, const glm::vec3& origin, const glm::vec3& inverseDirection, const float radius, const float maxDistance, float out_entry[4]) {
+#ifdef QUERY_BVH_SSE
+			const __m128 grow = _mm_set1_ps(radius);
+			const __m128 ox = _mm_set1_ps(origin.x), oy = _mm_set1_ps(origin.y), oz = _mm_set1_ps(origin.z);
+			const __m128 ix = _mm_set1_ps(inverseDirection.x), iy = _mm_set1_ps(inverseDirection.y), iz = _mm_set1_ps(inverseDirection.z);
+
+			const __m128 tx1 = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(node.minX), grow), ox), ix);
+			const __m128 tx2 = _mm_mul_ps(_mm_sub_ps(_mm_add_ps(_mm_loadu_ps(node.maxX), grow), ox), ix);
+			const __m128 ty1 = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(node.minY), grow), oy), iy);
+			const __m128 ty2 = _mm_mul_ps(_mm_sub_ps(_mm_add_ps(_mm_loadu_ps(node.maxY), grow), oy), iy);
+			const __m128 tz1 = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(node.minZ), grow), oz), iz);
+			const __m128 tz2 = _mm_mul_ps(_mm_sub_ps(_mm_add_ps(_mm_loadu_ps(node.maxZ), grow), oz), iz);
+
+			__m128 tEnter = _mm_max_ps(_mm_max_ps(_mm_min_ps(tx1, tx2), _mm_min_ps(ty1, ty2)), _mm_min_ps(tz1, tz2));
+			__m128 tExit = _mm_min_ps(_mm_min_ps(_mm_max_ps(tx1, tx2), _mm_max_ps(ty1, ty2)), _mm_max_ps(tz1, tz2));
+			tEnter = _mm_max_ps(tEnter, _mm_setzero_ps());
+			tExit = _mm_min_ps(tExit, _mm_set1_ps(maxDistance));
+
+			_mm_storeu_ps(out_entry, tEnter);
+			return (unsigned int)_mm_movemask_ps(_mm_cmple_ps(tEnter, tExit));
+#else
+			unsigned int mask = 0;
+			for (unsigned int i = 0; i < 4; i++) {
+				const float tx1 = (node.minX[i] - radius - origin.x) * inverseDirection.x, tx2 = (node.maxX[i] + radius - origin.x) * inverseDirection.x;
+				const float ty1 = (node.minY[i] - radius - origin.y) * inverseDirection.y, ty2 = (node.maxY[i] + radius - origin.y) * inverseDirection.y;
+				const float tz1 = (node.minZ[i] - radius - origin.z) * inverseDirection.z, tz2 = (node.maxZ[i] + radius - origin.z) * inverseDirection.z;
+				const float tEnter = std::max(std::max(std::max(std::min(tx1, tx2), std::min(ty1, ty2)), std::min(tz1, tz2)), 0.0f);
+				const float tExit = std::min(std::min(std::min(std::max(tx1, tx2), std::max(ty1, ty2)), std::max(tz1, tz2)), maxDistance);
+				out_entry[i] = tEnter;
+				if (tEnter <= tExit) { mask |= 1u << i; }
+			}
+			return mask;
+#endif
+		}
+
+		// Bit per child box within radius of centre
+		template <typename Node>
+		unsigned int SphereNode4(const Node& node, const glm::vec3& centre, const float radius) {
+#ifdef QUERY_BVH_SSE
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 cx = _mm_set1_ps(centre.x), cy = _mm_set1_ps(centre.y), cz = _mm_set1_ps(centre.z);
+
+			// Distance outside the box on each axis, zero when inside the slab
+			const __m128 dx = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(node.minX), cx), zero), _mm_max_ps(_mm_sub_ps(cx, _mm_loadu_ps(node.maxX)), zero));
+			const __m128 dy = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(node.minY), cy), zero), _mm_max_ps(_mm_sub_ps(cy, _mm_loadu_ps(node.maxY)), zero));
+			const __m128 dz = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(node.minZ), cz), zero), _mm_max_ps(_mm_sub_ps(cz, _mm_loadu_ps(node.maxZ)), zero));
+			const __m128 distanceSqr = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+			return (unsigned int)_mm_movemask_ps(_mm_cmple_ps(distanceSqr, _mm_set1_ps(radius * radius)));
+#else
+			unsigned int mask = 0;
+			for (unsigned int i = 0; i < 4; i++) {
+				const glm::vec3 closest = ClosestPointOnBox(centre, glm::vec3(node.minX[i], node.minY[i], node.minZ[i]), glm::vec3(node.maxX[i], node.maxY[i], node.maxZ[i]));
+				const glm::vec3 offset = closest - centre;
+				if (glm::dot(offset, offset) <= radius * radius) { mask |= 1u << i; }
+			}
+			return mask;
+#endif
+		}
+
+		// Bit per child box overlapping [boundsMin, boundsMax]
+		template <typename Node>
+		unsigned int AABBNode4(const Node& node, const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+#ifdef QUERY_BVH_SSE
+			__m128 overlap = _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(node.minX), _mm_set1_ps(boundsMax.x)), _mm_cmpge_ps(_mm_loadu_ps(node.maxX), _mm_set1_ps(boundsMin.x)));
+			overlap = _mm_and_ps(overlap, _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(node.minY), _mm_set1_ps(boundsMax.y)), _mm_cmpge_ps(_mm_loadu_ps(node.maxY), _mm_set1_ps(boundsMin.y))));
+			overlap = _mm_and_ps(overlap, _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(node.minZ), _mm_set1_ps(boundsMax.z)), _mm_cmpge_ps(_mm_loadu_ps(node.maxZ), _mm_set1_ps(boundsMin.z))));
+			return (unsigned int)_mm_movemask_ps(overlap);
+#else
+			unsigned int mask = 0;
+			for (unsigned int i = 0; i < 4; i++) {
+				if (node.minX[i] <= boundsMax.x && node.maxX[i] >= boundsMin.x && node.minY[i] <= boundsMax.y && node.maxY[i] >= boundsMin.y && node.minZ[i] <= boundsMax.z && node.maxZ[i] >= boundsMin.z) { mask |= 1u << i; }
+			}
+			return mask;
+#endif
+		}
+	}
+
+	bool CollisionQueryBVH::Raycast(const Ray& ray, RaycastHit& out_hit, const unsigned int layerMask) const
+	{
+		return Cast(ray, 0.0f, out_hit, layerMask);
+	}
+
+	bool CollisionQueryBVH::SphereCast(const Ray& ray, const float radius, RaycastHit& out_hit, const unsigned int layerMask) const
+	{
+		return Cast(ray, radius, out_hit, layerMask);
+	}
+
+	bool CollisionQueryBVH::SweepSphere(const Ray& ray, const float radius, const unsigned int ignoreEntityID, RaycastHit& out_hit, const unsigned int layerMask) const
+	{
+		return Cast(ray, radius, out_hit, layerMask, ignoreEntityID, false);
+	}
+
+	bool CollisionQueryBVH::Cast(const Ray& ray, const float radius, RaycastHit& out_hit, const unsigned int layerMask, const unsigned int ignoreEntityID, const bool reportInitialOverlap) const
+	{
+		out_hit = RaycastHit();
+		if (nodes.size() == 0) { return false; }
+
+		const glm::vec3 inverseDirection = SafeInverse(ray.direction);
+		float closest = ray.maxDistance;
+
+		unsigned int stack[MAX_STACK_DEPTH];
+		unsigned int stackSize = 0;
+		stack[stackSize++] = 0;
+
+		while (stackSize > 0) {
+			const Node& node = nodes[stack[--stackSize]];
+
+			float entry[4];
+			unsigned int mask = RayNode4(node, ray.origin, inverseDirection, radius, closest, entry);
+
+			// Nearest children are pushed last so they are visited first
+			unsigned int order[4];
+			unsigned int numHit = 0;
+			for (unsigned int slot = 0; slot < 4; slot++) {
+				if ((mask & (1u << slot)) && node.child[slot] != EMPTY_CHILD) { order[numHit++] = slot; }
+			}
+			std::sort(order, order + numHit, [&entry](const unsigned int a, const unsigned int b) { return entry[a] > entry[b]; });
+
+			for (unsigned int i = 0; i < numHit; i++) {
+				const unsigned int slot = order[i];
+				const unsigned int child = node.child[slot];
+
+				if (child & LEAF_FLAG) {
+					const unsigned int first = child & ~LEAF_FLAG;
+					for (unsigned int s = first; s < first + node.count[slot]; s++) {
+						const QueryShape& shape = shapes[s];
+						if ((shape.layer & layerMask) == 0 || shape.entityID == ignoreEntityID) { continue; }
+
+						float distance;
+						glm::vec3 normal;
+						if (CastShape(shape, ray, radius, distance, normal, reportInitialOverlap) && distance <= closest) {
+							closest = distance;
+							out_hit.entityID = shape.entityID;
+							out_hit.distance = distance;
+							out_hit.normal = normal;
+							out_hit.point = ray.origin + ray.direction * distance - normal * radius;
+						}
+					}
+				}
+				else {
+					assert(stackSize < MAX_STACK_DEPTH);
+					stack[stackSize++] = child;
+				}
+			}
+		}
+
+		return out_hit.Hit();
+	}
+
+	bool CollisionQueryBVH::CastShape(const QueryShape& shape, const Ray& ray, const float radius, float& out_distance, glm::vec3& out_normal, const bool reportInitialOverlap)
+	{
+		switch (shape.type) {
+		case QUERY_SHAPE_SPHERE: {
+			const float combinedRadius = shape.radius + radius;
+			const glm::vec3 m = ray.origin - shape.centre;
+			const float b = glm::dot(m, ray.direction);
+			const float c = glm::dot(m, m) - (combinedRadius * combinedRadius);
+
+			// Starting inside counts as an immediate hit
+			if (c <= 0.0f) {
+				if (!reportInitialOverlap) { return false; }
+				out_distance = 0.0f;
+				out_normal = -ray.direction;
+				return true;
+			}
+			if (b > 0.0f) { return false; }
+
+			const float discriminant = (b * b) - c;
+			if (discriminant < 0.0f) { return false; }
+
+			out_distance = -b - sqrt(discriminant);
+			if (out_distance > ray.maxDistance) { return false; }
+			out_normal = glm::normalize(ray.origin + ray.direction * out_distance - shape.centre);
+			return true;
+		}
+		case QUERY_SHAPE_AABB: {
+			// Sphere casts against boxes use the box grown by the radius, which slightly overestimates around edges and corners
+			int axis;
+			if (!RaySlabs(ray.origin, ray.direction, shape.boundsMin - glm::vec3(radius), shape.boundsMax + glm::vec3(radius), ray.maxDistance, out_distance, axis)) { return false; }
+			if (axis < 0 && !reportInitialOverlap) { return false; }
+
+			out_normal = -ray.direction;
+			if (axis >= 0) {
+				out_normal = glm::vec3(0.0f);
+				out_normal[axis] = (ray.direction[axis] > 0.0f) ? -1.0f : 1.0f;
+			}
+			return true;
+		}
+		case QUERY_SHAPE_BOX: {
+			// Distances along the local ray match world distances as the direction is transformed without normalising
+			const glm::vec3 localOrigin = glm::vec3(shape.inverseModel * glm::vec4(ray.origin, 1.0f));
+			const glm::vec3 localDirection = glm::vec3(shape.inverseModel * glm::vec4(ray.direction, 0.0f));
+			const glm::vec3 localRadius = glm::vec3(radius) / shape.scale;
+
+			int axis;
+			if (!RaySlabs(localOrigin, localDirection, shape.localMin - localRadius, shape.localMax + localRadius, ray.maxDistance, out_distance, axis)) { return false; }
+			if (axis < 0 && !reportInitialOverlap) { return false; }
+
+			out_normal = -ray.direction;
+			if (axis >= 0) {
+				glm::vec3 localNormal = glm::vec3(0.0f);
+				localNormal[axis] = (localDirection[axis] > 0.0f) ? -1.0f : 1.0f;
+				out_normal = glm::normalize(glm::transpose(glm::mat3(shape.inverseModel)) * localNormal);
+			}
+			return true;
+		}
+		case QUERY_SHAPE_CONVEX:
+			return shape.hull->Cast(shape.model, shape.inverseModel, ray.origin, ray.direction, radius, ray.maxDistance, out_distance, out_normal, reportInitialOverlap);
+		case QUERY_SHAPE_MESH: {
+			unsigned int triangle;
+			return shape.mesh->Cast(shape.model, shape.inverseModel, ray.origin, ray.direction, radius, ray.maxDistance, out_distance, out_normal, triangle, reportInitialOverlap);
+		}
+		}
+		return false;
+	}
+
+	bool CollisionQueryBVH::OverlapMesh(const QueryShape& shape, const glm::vec3& centre, const float radius, const glm::vec3& halfExtents)
+	{
+		const glm::vec3 worldHalfExtents = halfExtents + glm::vec3(radius);
+		const glm::vec3 axes[3] = { glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f) };
+
+		// Query bounds taken into the mesh's local space to pick the candidate triangles
+		const glm::vec3 localCentre = glm::vec3(shape.inverseModel * glm::vec4(centre, 1.0f));
+		const glm::mat3 absolute = glm::mat3(glm::abs(glm::vec3(shape.inverseModel[0])), glm::abs(glm::vec3(shape.inverseModel[1])), glm::abs(glm::vec3(shape.inverseModel[2])));
+		const glm::vec3 localHalfExtents = absolute * worldHalfExtents;
+
+		bool overlapping = false;
+		shape.mesh->ForEachTriangle(localCentre - localHalfExtents, localCentre + localHalfExtents, [&](const unsigned int triangle) {
+			if (overlapping) { return; }
+			const glm::vec3* local = shape.mesh->TriangleVertices(triangle);
+			const glm::vec3 a = glm::vec3(shape.model * glm::vec4(local[0], 1.0f));
+			const glm::vec3 b = glm::vec3(shape.model * glm::vec4(local[1], 1.0f));
+			const glm::vec3 c = glm::vec3(shape.model * glm::vec4(local[2], 1.0f));
+
+			if (radius > 0.0f) {
+				const glm::vec3 offset = TriangleMeshBVH::ClosestPointOnTriangle(centre, a, b, c) - centre;
+				overlapping = glm::dot(offset, offset) <= radius * radius;
+			}
+			else {
+				glm::vec3 axis;
+				float depth;
+				overlapping = TriangleMeshBVH::BoxTriangleOverlap(centre, axes, halfExtents, a, b, c, axis, depth);
+			}
+		});
+		return overlapping;
+	}
+
+	void CollisionQueryBVH::RaycastBatch(const std::vector<Ray>& rays, std::vector<RaycastHit>& out_hits, const unsigned int layerMask) const
+	{
+		SphereCastBatch(rays, 0.0f, out_hits, layerMask);
+	}
+
+	void CollisionQueryBVH::SphereCastBatch(const std::vector<Ray>& rays, const float radius, std::vector<RaycastHit>& out_hits, const unsigned int layerMask) const
+	{
+		SCOPE_TIMER("CollisionQueryBVH::SphereCastBatch()");
+		out_hits.resize(rays.size());
+
+		// Queries only read the tree, so each chunk of rays can run on its own thread
+		ThreadPool::GetInstance()->ParallelFor(rays.size(), RAYS_PER_CHUNK, [&](const unsigned int chunkIndex, const unsigned int begin, const unsigned int end) {
+			for (unsigned int i = begin; i < end; i++) {
+				Cast(rays[i], radius, out_hits[i], layerMask);
+			}
+		});
+	}
+
+	unsigned int CollisionQueryBVH::OverlapSphere(const glm::vec3& centre, const float radius, std::vector<unsigned int>& out_entities, const unsigned int layerMask) const
+	{
+		if (nodes.size() == 0) { return 0; }
+		const unsigned int startSize = out_entities.size();
+		const float radiusSqr = radius * radius;
+
+		unsigned int stack[MAX_STACK_DEPTH];
+		unsigned int stackSize = 0;
+		stack[stackSize++] = 0;
+
+		while (stackSize > 0) {
+			const Node& node = nodes[stack[--stackSize]];
+			const unsigned int mask = SphereNode4(node, centre, radius);
+
+			for (unsigned int slot = 0; slot < 4; slot++) {
+				const unsigned int child = node.child[slot];
+				if (!(mask & (1u << slot)) || child == EMPTY_CHILD) { continue; }
+
+				if (!(child & LEAF_FLAG)) {
+					assert(stackSize < MAX_STACK_DEPTH);
+					stack[stackSize++] = child;
+					continue;
+				}
+
+				const unsigned int first = child & ~LEAF_FLAG;
+				for (unsigned int s = first; s < first + node.count[slot]; s++) {
+					const QueryShape& shape = shapes[s];
+					if ((shape.layer & layerMask) == 0) { continue; }
+
+					glm::vec3 closest;
+					switch (shape.type) {
+					case QUERY_SHAPE_SPHERE: {
+						const glm::vec3 offset = shape.centre - centre;
+						if (glm::dot(offset, offset) <= (radius + shape.radius) * (radius + shape.radius)) { out_entities.push_back(shape.entityID); }
+						continue;
+					}
+					case QUERY_SHAPE_AABB:
+						closest = ClosestPointOnBox(centre, shape.boundsMin, shape.boundsMax);
+						break;
+					case QUERY_SHAPE_BOX: {
+						// Closest point is found in local space but measured in world space, so non uniform scale is handled
+						const glm::vec3 localCentre = glm::vec3(shape.inverseModel * glm::vec4(centre, 1.0f));
+						closest = glm::vec3(shape.model * glm::vec4(ClosestPointOnBox(localCentre, shape.localMin, shape.localMax), 1.0f));
+						break;
+					}
+					case QUERY_SHAPE_CONVEX:
+						if (GJK::Intersect(SphereSupport(centre, radius), HullSupport(*shape.hull, shape.model))) { out_entities.push_back(shape.entityID); }
+						continue;
+					case QUERY_SHAPE_MESH:
+						if (OverlapMesh(shape, centre, radius, glm::vec3(0.0f))) { out_entities.push_back(shape.entityID); }
+						continue;
+					}
+
+					const glm::vec3 offset = closest - centre;
+					if (glm::dot(offset, offset) <= radiusSqr) { out_entities.push_back(shape.entityID); }
+				}
+			}
+		}
+
+		return out_entities.size() - startSize;
+	}
+
+	unsigned int CollisionQueryBVH::OverlapAABB(const glm::vec3& boundsMin, const glm::vec3& boundsMax, std::vector<unsigned int>& out_entities, const unsigned int layerMask) const
+	{
+		if (nodes.size() == 0) { return 0; }
+		const unsigned int startSize = out_entities.size();
+		const glm::vec3 queryCentre = (boundsMin + boundsMax) * 0.5f;
+		const glm::vec3 queryHalfExtents = (boundsMax - boundsMin) * 0.5f;
+
+		unsigned int stack[MAX_STACK_DEPTH];
+		unsigned int stackSize = 0;
+		stack[stackSize++] = 0;
+
+		while (stackSize > 0) {
+			const Node& node = nodes[stack[--stackSize]];
+			const unsigned int mask = AABBNode4(node, boundsMin, boundsMax);
+
+			for (unsigned int slot = 0; slot < 4; slot++) {
+				const unsigned int child = node.child[slot];
+				if (!(mask & (1u << slot)) || child == EMPTY_CHILD) { continue; }
+
+				if (!(child & LEAF_FLAG)) {
+					assert(stackSize < MAX_STACK_DEPTH);
+					stack[stackSize++] = child;
+					continue;
+				}
+
+				const unsigned int first = child & ~LEAF_FLAG;
+				for (unsigned int s = first; s < first + node.count[slot]; s++) {
+					const QueryShape& shape = shapes[s];
+					if ((shape.layer & layerMask) == 0) { continue; }
+
+					// Shape world bounds have to overlap the query before any exact test
+					if (glm::any(glm::greaterThan(shape.boundsMin, boundsMax)) || glm::any(glm::lessThan(shape.boundsMax, boundsMin))) { continue; }
+
+					bool overlapping = true;
+					if (shape.type == QUERY_SHAPE_MESH) {
+						overlapping = OverlapMesh(shape, queryCentre, 0.0f, queryHalfExtents);
+					}
+					else if (shape.type == QUERY_SHAPE_CONVEX) {
+						const BoxSupport query(queryCentre, glm::vec3(queryHalfExtents.x, 0.0f, 0.0f), glm::vec3(0.0f, queryHalfExtents.y, 0.0f), glm::vec3(0.0f, 0.0f, queryHalfExtents.z));
+						overlapping = GJK::Intersect(query, HullSupport(*shape.hull, shape.model));
+					}
+					else if (shape.type == QUERY_SHAPE_SPHERE) {
+						const glm::vec3 offset = ClosestPointOnBox(shape.centre, boundsMin, boundsMax) - shape.centre;
+						overlapping = glm::dot(offset, offset) <= shape.radius * shape.radius;
+					}
+					else if (shape.type == QUERY_SHAPE_BOX) {
+						// World bounds already cover the query's axes, so only the box's own face axes are left to check
+						// Edge cross product axes are skipped, which can report boxes that only touch along an edge
+						const glm::vec3 boxHalfExtents = (shape.localMax - shape.localMin) * 0.5f;
+						for (int i = 0; i < 3 && overlapping; i++) {
+							const glm::vec3 axis = glm::normalize(glm::vec3(shape.model[i]));
+							const float boxProjection = boxHalfExtents[i] * shape.scale[i];
+							const float queryProjection = glm::dot(queryHalfExtents, glm::abs(axis));
+							overlapping = fabs(glm::dot(queryCentre - shape.centre, axis)) <= boxProjection + queryProjection;
+						}
+					}
+
+					if (overlapping) { out_entities.push_back(shape.entityID); }
+				}
+			}
+		}
+
+		return out_entities.size() - startSize;
+	}
+}
@@ -0,0 +1,143 @@
+#pragma once
+#include <vector>
+#include <cfloat>
+#include <glm/ext/vector_float3.hpp>
+#include <glm/ext/matrix_float4x4.hpp>
+namespace Engine {
+	class EntityManager;
+	class TriangleMeshBVH;
+	class ConvexHull;
+
+	static constexpr unsigned int ALL_COLLISION_LAYERS = 0xFFFFFFFFu;
+
+	struct Ray {
+		Ray() : origin(0.0f), direction(0.0f, 0.0f, -1.0f), maxDistance(FLT_MAX) {}
+		Ray(const glm::vec3& origin, const glm::vec3& direction, const float maxDistance = FLT_MAX) : origin(origin), direction(direction), maxDistance(maxDistance) {}
+
+		glm::vec3 origin;
+		glm::vec3 direction; // normalised
+		float maxDistance;
+	};
+
+	struct RaycastHit {
+		RaycastHit() : entityID(INVALID_HIT), point(0.0f), normal(0.0f), distance(FLT_MAX) {}
+
+		static constexpr unsigned int INVALID_HIT = 0xFFFFFFFFu;
+		bool Hit() const { return entityID != INVALID_HIT; }
+
+		unsigned int entityID;
+		glm::vec3 point; // on the surface of the collider that was hit
+		glm::vec3 normal; // surface normal at point
+		float distance; // along the ray, for shape casts this is how far the shape's centre travelled
+	};
+
+	// Flattened four wide BVH over the world space bounds of every collider in a scene, used for ray, shape cast and overlap queries
+	// Each node stores its four children's bounds side by side so one SIMD slab test covers all of them
+	// Refitted to the colliders' current bounds each update, only rebuilt when colliders are added or removed or the refitted tree has degraded, see CollisionManager::UpdateQueryBVH
+	class CollisionQueryBVH
+	{
+	public:
+		CollisionQueryBVH(const unsigned int maxShapesPerLeaf = 4u) : maxShapesPerLeaf(maxShapesPerLeaf), builtCost(0.0f), treeDepth(0) {}
+		~CollisionQueryBVH() {}
+
+		// Refitting costs more than a rebuild would save until the tree's cost has grown past this multiple of the cost it was built with
+		static constexpr float REBUILD_COST_RATIO = 1.5f;
+
+		void Build(EntityManager& ecs);
+
+		// Returns true if the tree had to be rebuilt rather than refitted
+		bool Update(EntityManager& ecs);
+
+		bool Raycast(const Ray& ray, RaycastHit& out_hit, const unsigned int layerMask = ALL_COLLISION_LAYERS) const;
+		bool SphereCast(const Ray& ray, const float radius, RaycastHit& out_hit, const unsigned int layerMask = ALL_COLLISION_LAYERS) const;
+
+		// Sphere cast used by continuous collision. Skips ignoreEntityID and anything the sphere already overlaps at the ray's origin, those contacts are left to the narrowphase
+		bool SweepSphere(const Ray& ray, const float radius, const unsigned int ignoreEntityID, RaycastHit& out_hit, const unsigned int layerMask = ALL_COLLISION_LAYERS) const;
+
+		// Ray i's result is written to out_hits[i], large batches are split across the thread pool
+		void RaycastBatch(const std::vector<Ray>& rays, std::vector<RaycastHit>& out_hits, const unsigned int layerMask = ALL_COLLISION_LAYERS) const;
+		void SphereCastBatch(const std::vector<Ray>& rays, const float radius, std::vector<RaycastHit>& out_hits, const unsigned int layerMask = ALL_COLLISION_LAYERS) const;
+
+		// Entities are appended to out_entities, returns how many were added
+		unsigned int OverlapSphere(const glm::vec3& centre, const float radius, std::vector<unsigned int>& out_entities, const unsigned int layerMask = ALL_COLLISION_LAYERS) const;
+		unsigned int OverlapAABB(const glm::vec3& boundsMin, const glm::vec3& boundsMax, std::vector<unsigned int>& out_entities, const unsigned int layerMask = ALL_COLLISION_LAYERS) const;
+
+		unsigned int NumShapes() const { return shapes.size(); }
+		unsigned int NumNodes() const { return nodes.size(); }
+
+	private:
+		enum QueryShapeType {
+			QUERY_SHAPE_SPHERE,
+			QUERY_SHAPE_AABB,
+			QUERY_SHAPE_BOX,
+			QUERY_SHAPE_CONVEX,
+			QUERY_SHAPE_MESH
+		};
+
+		struct QueryShape {
+			unsigned int entityID;
+			unsigned int sourceIndex; // order the shape was gathered from the ECS in, which stays the same while no colliders are added or removed
+			unsigned int layer;
+			QueryShapeType type;
+
+			glm::vec3 boundsMin;
+			glm::vec3 boundsMax;
+			glm::vec3 centre;
+
+			// Sphere
+			float radius;
+
+			// Oriented box, tested in its local space. Hulls and meshes use the model matrices too
+			glm::mat4 model;
+			glm::mat4 inverseModel;
+			glm::vec3 localMin;
+			glm::vec3 localMax;
+			glm::vec3 scale;
+
+			// Convex hull
+			const ConvexHull* hull;
+
+			// Mesh
+			const TriangleMeshBVH* mesh;
+		};
+
+		static constexpr unsigned int EMPTY_CHILD = 0xFFFFFFFFu;
+		static constexpr unsigned int LEAF_FLAG = 0x80000000u;
+
+		// Children are either another node or, with LEAF_FLAG set, a range of shapes [first, first + count)
+		struct Node {
+			float minX[4], minY[4], minZ[4];
+			float maxX[4], maxY[4], maxZ[4];
+			unsigned int child[4];
+			unsigned int count[4];
+		};
+
+		void GatherShapes(EntityManager& ecs, std::vector<QueryShape>& out_shapes) const;
+		void BuildFromShapes();
+		void Refit();
+
+		// Sum of every child box's surface area over the root's, lower is a better tree
+		float TreeCost() const;
+
+		unsigned int BuildNode(const unsigned int begin, const unsigned int end, const unsigned int depth);
+		unsigned int SplitRange(const unsigned int begin, const unsigned int end);
+		void SetChild(const unsigned int nodeIndex, const unsigned int slot, const unsigned int begin, const unsigned int end, const unsigned int depth);
+		void RangeBounds(const unsigned int begin, const unsigned int end, glm::vec3& out_min, glm::vec3& out_max) const;
+
+		// Shared by ray and sphere casts, a sphere cast is a ray against every shape grown by the radius
+		bool Cast(const Ray& ray, const float radius, RaycastHit& out_hit, const unsigned int layerMask, const unsigned int ignoreEntityID = RaycastHit::INVALID_HIT, const bool reportInitialOverlap = true) const;
+		static bool CastShape(const QueryShape& shape, const Ray& ray, const float radius, float& out_distance, glm::vec3& out_normal, const bool reportInitialOverlap = true);
+
+		// Sphere (zero half extents) or axis aligned box (zero radius) against a mesh's triangles
+		static bool OverlapMesh(const QueryShape& shape, const glm::vec3& centre, const float radius, const glm::vec3& halfExtents);
+
+		std::vector<QueryShape> shapes;
+		std::vector<Node> nodes;
+		unsigned int maxShapesPerLeaf;
+
+		std::vector<unsigned int> sourceSlots; // where each gathered shape ended up in shapes after the build
+		std::vector<QueryShape> gatheredShapes;
+		float builtCost;
+		unsigned int treeDepth;
+	};
+}
@@ -1,154 +1,262 @@
 #include "CollisionResolver.h"
+#include "ContactCache.h"
+#include "Scene.h"
 namespace Engine {
 	void CollisionResolver::Run(EntityManager& ecs)
 	{
 		SCOPE_TIMER("CollisionResolver::Run");
-		for (const CollisionData& collision : collisionManager->GetUnresolvedCollisions()) {
-			const unsigned int entityIDA = collision.entityIDA;
-			const unsigned int entityIDB = collision.entityIDB;
+		ContactCache* contactCache = collisionManager->GetContactCache();
+		contactCache->BeginFrame();
 
-			ComponentTransform* transformA = ecs.GetComponent<ComponentTransform>(entityIDA);
-			ComponentTransform* transformB = ecs.GetComponent<ComponentTransform>(entityIDB);
+		bodies.clear();
+		entityToBody.clear();
+		constraints.clear();
 
-			ComponentPhysics* physicsA = ecs.GetComponent<ComponentPhysics>(entityIDA);
-			ComponentPhysics* physicsB = ecs.GetComponent<ComponentPhysics>(entityIDB);
+		std::vector<CollisionData>& collisions = collisionManager->GetUnresolvedCollisions();
+		for (CollisionData& collision : collisions) {
+			const unsigned int bodyA = GetSolverBody(ecs, collision.entityIDA, collision.colliderA);
+			const unsigned int bodyB = GetSolverBody(ecs, collision.entityIDB, collision.colliderB);
 
-			ComponentCollision* colliderA = ecs.GetComponent<ComponentCollisionAABB>(entityIDA);
-			if (!colliderA) { colliderA = ecs.GetComponent<ComponentCollisionSphere>(entityIDA); }
-			if (!colliderA) { colliderA = ecs.GetComponent<ComponentCollisionBox>(entityIDA); }
+			// Pick up accumulated impulses from last frame's matching contacts
+			contactCache->Match(collision);
 
-			ComponentCollision* colliderB = ecs.GetComponent<ComponentCollisionAABB>(entityIDB);
-			if (!colliderB) { colliderB = ecs.GetComponent<ComponentCollisionSphere>(entityIDB); }
-			if (!colliderB) { colliderB = ecs.GetComponent<ComponentCollisionBox>(entityIDB); }
+			// Neither side can be moved, e.g. an immovable collider resting against static scenery. Still cached so contact events are reported
+			if (IsStaticPair(bodies[bodyA], bodies[bodyB])) { continue; }
 
-			float totalMass = 0.0f;
-			if (physicsA) { totalMass += physicsA->InverseMass(); }
-			if (physicsB) { totalMass += physicsB->InverseMass(); }
+			PreStep(collision, bodyA, bodyB);
+		}
+
+		// Re-apply last frame's impulses so the solver starts close to the solution
+		WarmStart();
 
-			// Seperate objects using projection
-			Separate(transformA, physicsA, colliderA, transformB, physicsB, colliderB, totalMass, collision);
+		for (int i = 0; i < numIterations; i++) {
+			SolveVelocities();
+		}
 
-			// Update velocity of each physics component if they exist
-			Impulse(transformA, physicsA, colliderA, transformB, physicsB, colliderB, totalMass, collision);
+		for (int i = 0; i < numPositionIterations; i++) {
+			SolvePositions();
+		}
 
-			//for (ContactPoint& contact : collision.contactPoints) {
-				//PresolveContactPoint(contact, collision.objectA, collision.objectB, collision.contactPoints.size());
-			//}
+		WriteBack();
 
-			//for (ContactPoint& contact : collision.contactPoints) {
-				//SolveContactPoint(contact, collision.objectA, collision.objectB, collision.contactPoints.size());
-			//}
+		for (const CollisionData& collision : collisions) {
+			contactCache->Store(collision);
 		}
 
+		// Any pair not seen this frame has stopped touching
+		contactCache->EndFrame();
+
 		collisionManager->ClearUnresolvedCollisions();
 	}
 
-	void CollisionResolver::Separate(ComponentTransform* transformA, ComponentPhysics* physicsA, ComponentCollision* colliderA, ComponentTransform* transformB, ComponentPhysics* physicsB, ComponentCollision* colliderB, float totalMass, const CollisionData& collision) const
+	unsigned int CollisionResolver::GetSolverBody(EntityManager& ecs, const unsigned int entityID, const ComponentCollision* collider)
 	{
-		for (const ContactPoint& contact : collision.contactPoints) {
-			//ContactPoint& contact = collision.contactPoints[0];
-			if (colliderA->IsMovedByCollisions()) {
-				if (physicsA) {
-					transformA->SetPosition(transformA->GetWorldPosition() + (contact.normal * contact.penetration) * (physicsA->InverseMass() / totalMass));
-				}
-				else {
-					transformA->SetPosition(transformA->GetWorldPosition() + (contact.normal * contact.penetration));
-				}
-			}
-			if (colliderB->IsMovedByCollisions()) {
-				if (physicsB) {
-					transformB->SetPosition(transformB->GetWorldPosition() - (contact.normal * contact.penetration) * (physicsB->InverseMass() / totalMass));
-				}
-				else {
-					transformB->SetPosition(transformB->GetWorldPosition() - (contact.normal * contact.penetration));
-				}
-			}
+		std::unordered_map<unsigned int, unsigned int>::iterator it = entityToBody.find(entityID);
+		if (it != entityToBody.end()) {
+			return it->second;
 		}
+
+		SolverBody body;
+		body.transform = ecs.GetComponent<ComponentTransform>(entityID);
+		body.physics = ecs.GetComponent<ComponentPhysics>(entityID);
+
+		// Immovable and sleeping objects contribute no mass or inertia to the contact
+		const bool asleep = body.physics && body.physics->IsAsleep();
+		const bool movable = collider && collider->IsMovedByCollisions() && !asleep;
+		const bool dynamic = body.physics && movable;
+
+		body.inverseMass = dynamic ? body.physics->InverseMass() : 0.0f;
+		body.inverseInertia = dynamic ? body.physics->InverseInertiaTensor() : glm::mat3(0.0f);
+
+		// Movable colliders without physics are still pushed out of penetration, as if they had unit mass
+		body.pseudoInverseMass = dynamic ? body.inverseMass : (movable ? 1.0f : 0.0f);
+
+		body.linearVelocity = (body.physics && !asleep) ? body.physics->Velocity() : glm::vec3(0.0f);
+		body.angularVelocity = (body.physics && !asleep) ? body.physics->AngularVelocity() : glm::vec3(0.0f);
+		body.pseudoLinearVelocity = glm::vec3(0.0f);
+		body.pseudoAngularVelocity = glm::vec3(0.0f);
+
+		const unsigned int index = bodies.size();
+		bodies.push_back(body);
+		entityToBody[entityID] = index;
+		return index;
 	}
 
-	void CollisionResolver::Impulse(ComponentTransform* transformA, ComponentPhysics* physicsA, ComponentCollision* colliderA, ComponentTransform* transformB, ComponentPhysics* physicsB, ComponentCollision* colliderB, float totalMass, const CollisionData& collision) const
+	void CollisionResolver::PreStep(CollisionData& collision, const unsigned int bodyA, const unsigned int bodyB)
 	{
-		std::vector<glm::vec3> impulses;
-		std::vector<glm::vec3> inertiaAs;
-		std::vector<glm::vec3> inertiaBs;
+		const SolverBody& a = bodies[bodyA];
+		const SolverBody& b = bodies[bodyB];
 
 		float elasticityA = 0.5f;
 		float elasticityB = 0.5f;
-		if (physicsA != nullptr) { elasticityA = physicsA->Elasticity(); }
-		if (physicsB != nullptr) { elasticityB = physicsB->Elasticity(); }
-
-		glm::vec3 startVelocityA = glm::vec3();
-		glm::vec3 startVelocityB = glm::vec3();
-
-		glm::vec3 startAngularA = glm::vec3();
-		glm::vec3 startAngularB = glm::vec3();
+		float frictionA = 0.5f;
+		float frictionB = 0.5f;
+		if (a.physics) { elasticityA = a.physics->Elasticity(); frictionA = a.physics->Friction(); }
+		if (b.physics) { elasticityB = b.physics->Elasticity(); frictionB = b.physics->Friction(); }
+		const float restitution = elasticityA * elasticityB;
+		const float friction = sqrt(frictionA * frictionB);
+
+		const float inverseMassSum = a.inverseMass + b.inverseMass;
+		const float pseudoInverseMassSum = a.pseudoInverseMass + b.pseudoInverseMass;
+
+		for (ContactPoint& contact : collision.contactPoints) {
+			ContactConstraint constraint;
+			constraint.bodyA = bodyA;
+			constraint.bodyB = bodyB;
+			constraint.contact = &contact;
+			constraint.normal = SeparationNormal(contact);
+			constraint.relativeA = contact.contactPointA;
+			constraint.relativeB = contact.contactPointB;
+			constraint.friction = friction;
+			constraint.depth = fabs(contact.penetration);
+
+			// Stable tangent basis built from the normal alone so accumulated friction can be projected across frames
+			const glm::vec3& normal = constraint.normal;
+			if (fabs(normal.x) >= 0.57735f) {
+				constraint.tangents[0] = glm::normalize(glm::vec3(normal.y, -normal.x, 0.0f));
+			}
+			else {
+				constraint.tangents[0] = glm::normalize(glm::vec3(0.0f, normal.z, -normal.y));
+			}
+			constraint.tangents[1] = glm::cross(normal, constraint.tangents[0]);
 
-		if (physicsA != nullptr) {
-			startVelocityA = physicsA->Velocity();
-			startAngularA = physicsA->AngularVelocity();
-		}
-		if (physicsB != nullptr) {
-			startVelocityB = physicsB->Velocity();
-			startAngularB = physicsB->AngularVelocity();
-		}
+			const float normalMass = EffectiveMass(inverseMassSum, a, b, constraint.relativeA, constraint.relativeB, normal);
+			const float positionMass = EffectiveMass(pseudoInverseMassSum, a, b, constraint.relativeA, constraint.relativeB, normal);
+			if (normalMass <= 0.0f && positionMass <= 0.0f) { continue; }
 
-		const glm::vec3 contactVelocity = startVelocityB - startVelocityA;
+			constraint.normalMass = (normalMass > 0.0f) ? 1.0f / normalMass : 0.0f;
+			constraint.positionMass = (positionMass > 0.0f) ? 1.0f / positionMass : 0.0f;
+			for (int i = 0; i < 2; i++) {
+				const float tangentMass = EffectiveMass(inverseMassSum, a, b, constraint.relativeA, constraint.relativeB, constraint.tangents[i]);
+				constraint.tangentMass[i] = (tangentMass > 0.0f) ? 1.0f / tangentMass : 0.0f;
+			}
 
-		for (const ContactPoint& contact : collision.contactPoints) {
-			const glm::vec3 relativeA = contact.contactPointA;
-			const glm::vec3 relativeB = contact.contactPointB;
+			// Negative when A and B are approaching each other
+			const glm::vec3 relativeVelocity = (a.linearVelocity + glm::cross(a.angularVelocity, constraint.relativeA)) - (b.linearVelocity + glm::cross(b.angularVelocity, constraint.relativeB));
+			const float normalVelocity = glm::dot(relativeVelocity, normal);
+			constraint.restitutionBias = (normalVelocity < -restitutionThreshold) ? -restitution * normalVelocity : 0.0f;
+			contact.b_term = constraint.restitutionBias;
 
-			glm::vec3 relativeAngularA = glm::vec3();
-			glm::vec3 relativeAngularB = glm::vec3();
+			constraint.normalImpulse = contact.sumImpulseContact * warmStartFactor;
+			constraint.tangentImpulse[0] = glm::dot(contact.sumImpulseFriction, constraint.tangents[0]) * warmStartFactor;
+			constraint.tangentImpulse[1] = glm::dot(contact.sumImpulseFriction, constraint.tangents[1]) * warmStartFactor;
+			constraint.pseudoImpulse = 0.0f;
 
-			glm::vec3 relativeLinearA = startVelocityA;
-			glm::vec3 relativeLinearB = startVelocityB;
+			constraints.push_back(constraint);
+		}
+	}
 
-			if (physicsA != nullptr) {
-				relativeAngularA = glm::cross(startAngularA, relativeA);
-				relativeLinearA += relativeAngularA;
+	void CollisionResolver::WarmStart()
+	{
+		for (const ContactConstraint& constraint : constraints) {
+			const glm::vec3 impulse = constraint.normal * constraint.normalImpulse + constraint.tangents[0] * constraint.tangentImpulse[0] + constraint.tangents[1] * constraint.tangentImpulse[1];
+			if (impulse != glm::vec3(0.0f)) {
+				ApplyImpulse(bodies[constraint.bodyA], constraint.relativeA, impulse);
+				ApplyImpulse(bodies[constraint.bodyB], constraint.relativeB, -impulse);
 			}
-			if (physicsB != nullptr) {
-				relativeAngularB = glm::cross(startAngularB, relativeB);
-				relativeLinearB += relativeAngularB;
+		}
+	}
+
+	void CollisionResolver::SolveVelocities()
+	{
+		for (ContactConstraint& constraint : constraints) {
+			SolverBody& a = bodies[constraint.bodyA];
+			SolverBody& b = bodies[constraint.bodyB];
+
+			// Friction, bounded by the current normal impulse
+			const float maxFriction = constraint.friction * constraint.normalImpulse;
+			for (int i = 0; i < 2; i++) {
+				const glm::vec3 relativeVelocity = (a.linearVelocity + glm::cross(a.angularVelocity, constraint.relativeA)) - (b.linearVelocity + glm::cross(b.angularVelocity, constraint.relativeB));
+				const float tangentVelocity = glm::dot(relativeVelocity, constraint.tangents[i]);
+
+				const float oldImpulse = constraint.tangentImpulse[i];
+				constraint.tangentImpulse[i] = glm::clamp(oldImpulse - tangentVelocity * constraint.tangentMass[i], -maxFriction, maxFriction);
+				const glm::vec3 impulse = constraint.tangents[i] * (constraint.tangentImpulse[i] - oldImpulse);
+
+				ApplyImpulse(a, constraint.relativeA, impulse);
+				ApplyImpulse(b, constraint.relativeB, -impulse);
 			}
 
-			const float impulseForce = glm::dot(contactVelocity, contact.normal);
+			// Normal
+			const glm::vec3 relativeVelocity = (a.linearVelocity + glm::cross(a.angularVelocity, constraint.relativeA)) - (b.linearVelocity + glm::cross(b.angularVelocity, constraint.relativeB));
+			const float normalVelocity = glm::dot(relativeVelocity, constraint.normal);
 
-			glm::vec3 inertiaA = glm::vec3(0.0f);
-			glm::vec3 inertiaB = glm::vec3(0.0f);
-			if (physicsA != nullptr) { inertiaA = glm::cross(physicsA->InertiaTensor() * glm::cross(relativeA, contact.normal), relativeA); }
-			if (physicsB != nullptr) { inertiaB = glm::cross(physicsB->InertiaTensor() * glm::cross(relativeB, contact.normal), relativeB); }
+			// Clamp the accumulated impulse rather than this iteration's impulse so warm started contacts can back off
+			const float oldImpulse = constraint.normalImpulse;
+			constraint.normalImpulse = std::max(oldImpulse + (constraint.restitutionBias - normalVelocity) * constraint.normalMass, 0.0f);
+			const glm::vec3 impulse = constraint.normal * (constraint.normalImpulse - oldImpulse);
 
-			const float angularEffect = glm::dot(inertiaA + inertiaB, contact.normal);
+			ApplyImpulse(a, constraint.relativeA, impulse);
+			ApplyImpulse(b, constraint.relativeB, -impulse);
+		}
+	}
 
-			const float coefficient = elasticityA * elasticityB;
+	void CollisionResolver::SolvePositions()
+	{
+		if (Scene::dt <= 0.0f) { return; }
+		const float inverseDt = 1.0f / Scene::dt;
 
-			const float J = (-(1.0f + coefficient) * impulseForce) / (totalMass + angularEffect);
-			const glm::vec3 fullImpulse = contact.normal * J;
+		for (ContactConstraint& constraint : constraints) {
+			SolverBody& a = bodies[constraint.bodyA];
+			SolverBody& b = bodies[constraint.bodyB];
 
-			impulses.push_back(fullImpulse);
+			const glm::vec3 relativeVelocity = (a.pseudoLinearVelocity + glm::cross(a.pseudoAngularVelocity, constraint.relativeA)) - (b.pseudoLinearVelocity + glm::cross(b.pseudoAngularVelocity, constraint.relativeB));
+			const float normalVelocity = glm::dot(relativeVelocity, constraint.normal);
 
-			inertiaAs.push_back(inertiaA);
-			inertiaBs.push_back(inertiaB);
-		}
+			const float bias = positionCorrectionFactor * inverseDt * std::max(constraint.depth - allowedPenetration, 0.0f);
 
-		for (int i = 0; i < impulses.size(); i++) {
-			//glm::vec3 impulse = impulses[i] / float(collision.contactPoints.size());
-			const glm::vec3 impulse = impulses[i];
-			const glm::vec3 relativeA = collision.contactPoints[i].contactPointA;
-			const glm::vec3 relativeB = collision.contactPoints[i].contactPointB;
+			const float oldImpulse = constraint.pseudoImpulse;
+			constraint.pseudoImpulse = std::max(oldImpulse + (bias - normalVelocity) * constraint.positionMass, 0.0f);
+			const glm::vec3 impulse = constraint.normal * (constraint.pseudoImpulse - oldImpulse);
+
+			ApplyPseudoImpulse(a, constraint.relativeA, impulse);
+			ApplyPseudoImpulse(b, constraint.relativeB, -impulse);
+		}
+	}
 
-			if (physicsA && colliderA->IsMovedByCollisions()) {
-				physicsA->ApplyLinearImpulse(-impulse / float(collision.contactPoints.size()));
-				physicsA->ApplyAngularImpulse(glm::cross(relativeA, collision.contactPoints[i].normal * -impulse));
+	void CollisionResolver::WriteBack()
+	{
+		for (SolverBody& body : bodies) {
+			if (body.physics && body.inverseMass > 0.0f) {
+				body.physics->SetVelocity(body.linearVelocity);
+				body.physics->SetAngularVelocity(body.angularVelocity);
 			}
 
-			if (physicsB && colliderB->IsMovedByCollisions()) {
-				physicsB->ApplyLinearImpulse(impulse / float(collision.contactPoints.size()));
-				physicsB->ApplyAngularImpulse(glm::cross(relativeB, collision.contactPoints[i].normal * impulse));
+			// Split impulse velocities move the body then are discarded
+			if (body.pseudoLinearVelocity != glm::vec3(0.0f)) {
+				body.transform->SetPosition(body.transform->GetWorldPosition() + body.pseudoLinearVelocity * Scene::dt);
+			}
+			if (body.pseudoAngularVelocity != glm::vec3(0.0f)) {
+				glm::quat orientation = body.transform->GetOrientation();
+				orientation = orientation + (glm::quat(glm::vec3(body.pseudoAngularVelocity * Scene::dt * 0.5f)) * orientation);
+				body.transform->SetOrientation(glm::normalize(orientation));
 			}
 		}
+
+		// Store solved impulses on the contacts for next frame's warm start
+		for (const ContactConstraint& constraint : constraints) {
+			constraint.contact->sumImpulseContact = constraint.normalImpulse;
+			constraint.contact->sumImpulseFriction = constraint.tangents[0] * constraint.tangentImpulse[0] + constraint.tangents[1] * constraint.tangentImpulse[1];
+		}
+	}
+
+	void CollisionResolver::ApplyImpulse(SolverBody& body, const glm::vec3& relative, const glm::vec3& impulse)
+	{
+		body.linearVelocity += impulse * body.inverseMass;
+		body.angularVelocity += body.inverseInertia * glm::cross(relative, impulse);
+	}
+
+	void CollisionResolver::ApplyPseudoImpulse(SolverBody& body, const glm::vec3& relative, const glm::vec3& impulse)
+	{
+		body.pseudoLinearVelocity += impulse * body.pseudoInverseMass;
+		body.pseudoAngularVelocity += body.inverseInertia * glm::cross(relative, impulse);
+	}
+
+	float CollisionResolver::EffectiveMass(const float inverseMassSum, const SolverBody& bodyA, const SolverBody& bodyB, const glm::vec3& relativeA, const glm::vec3& relativeB, const glm::vec3& direction)
+	{
+		const glm::vec3 inertiaA = glm::cross(bodyA.inverseInertia * glm::cross(relativeA, direction), relativeA);
+		const glm::vec3 inertiaB = glm::cross(bodyB.inverseInertia * glm::cross(relativeB, direction), relativeB);
+		return inverseMassSum + glm::dot(inertiaA + inertiaB, direction);
 	}
 
 	/*
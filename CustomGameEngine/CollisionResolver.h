@@ -6,23 +6,114 @@
 #include "ComponentCollisionSphere.h"
 #include "ComponentCollisionBox.h"
 #include "ComponentCollisionAABB.h"
+#include <unordered_map>
 
 namespace Engine {
+	// Per frame copy of a body's state used by the solver. Velocities are written back once solving is finished
+	struct SolverBody {
+		ComponentTransform* transform;
+		ComponentPhysics* physics;
+
+		float inverseMass;
+		float pseudoInverseMass;
+		glm::mat3 inverseInertia;
+
+		glm::vec3 linearVelocity;
+		glm::vec3 angularVelocity;
+
+		// Split impulse velocities, only used to push bodies apart and never fed back into the real velocity
+		glm::vec3 pseudoLinearVelocity;
+		glm::vec3 pseudoAngularVelocity;
+	};
+
+	struct ContactConstraint {
+		unsigned int bodyA;
+		unsigned int bodyB;
+		ContactPoint* contact;
+
+		glm::vec3 normal;
+		glm::vec3 tangents[2];
+		glm::vec3 relativeA;
+		glm::vec3 relativeB;
+
+		float normalMass;
+		float tangentMass[2];
+		float positionMass;
+		float friction;
+		float restitutionBias;
+		float depth;
+
+		float normalImpulse;
+		float tangentImpulse[2];
+		float pseudoImpulse;
+	};
+
+	// Sequential impulse contact solver
+	// Contacts are pre-stepped once, then solved over a number of velocity iterations. Penetration is removed with split impulses so position correction adds no energy to the real velocities
 	class CollisionResolver
 	{
 	public:
-		CollisionResolver(CollisionManager* collisionManager) : collisionManager(collisionManager) {}
+		CollisionResolver(CollisionManager* collisionManager, const int numIterations = 8, const int numPositionIterations = 3, const float warmStartFactor = 0.8f) : collisionManager(collisionManager), numIterations(numIterations), numPositionIterations(numPositionIterations), warmStartFactor(warmStartFactor), positionCorrectionFactor(0.2f), allowedPenetration(0.005f), restitutionThreshold(0.5f) {}
 		~CollisionResolver() {}
 
 		void Run(EntityManager& ecs);
 
+		void SetNumberOfIterations(const int newIterations) { numIterations = newIterations; }
+		int NumberOfIterations() const { return numIterations; }
+
+		void SetNumberOfPositionIterations(const int newIterations) { numPositionIterations = newIterations; }
+		int NumberOfPositionIterations() const { return numPositionIterations; }
+
+		// Fraction of last frame's accumulated impulse applied to a matched contact before solving. 0 disables warm starting
+		void SetWarmStartFactor(const float newFactor) { warmStartFactor = newFactor; }
+		float WarmStartFactor() const { return warmStartFactor; }
+
+		// Fraction of the remaining penetration removed each step by the split impulse pass
+		void SetPositionCorrectionFactor(const float newFactor) { positionCorrectionFactor = newFactor; }
+		float PositionCorrectionFactor() const { return positionCorrectionFactor; }
+
+		// Penetration depth left uncorrected to keep resting contacts from jittering
+		void SetAllowedPenetration(const float newPenetration) { allowedPenetration = newPenetration; }
+		float AllowedPenetration() const { return allowedPenetration; }
+
+		// Closing speeds below this are treated as resting and don't bounce
+		void SetRestitutionThreshold(const float newThreshold) { restitutionThreshold = newThreshold; }
+		float RestitutionThreshold() const { return restitutionThreshold; }
+
+		unsigned int NumContactConstraints() const { return constraints.size(); }
+
 	private:
-		void Separate(ComponentTransform* transformA, ComponentPhysics* physicsA, ComponentCollision* colliderA, ComponentTransform* transformB, ComponentPhysics* physicsB, ComponentCollision* colliderB, const float totalMass, const CollisionData& collision) const;
-		void Impulse(ComponentTransform* transformA, ComponentPhysics* physicsA, ComponentCollision* colliderA, ComponentTransform* transformB, ComponentPhysics* physicsB, ComponentCollision* colliderB, const float totalMass, const CollisionData& collision) const;
-		
+		// The collider comes from the contact, so only the transform and physics components are looked up
+		unsigned int GetSolverBody(EntityManager& ecs, const unsigned int entityID, const ComponentCollision* collider);
+		void PreStep(CollisionData& collision, const unsigned int bodyA, const unsigned int bodyB);
+		void WarmStart();
+		void SolveVelocities();
+		void SolvePositions();
+		void WriteBack();
+
+		static void ApplyImpulse(SolverBody& body, const glm::vec3& relative, const glm::vec3& impulse);
+		static void ApplyPseudoImpulse(SolverBody& body, const glm::vec3& relative, const glm::vec3& impulse);
+		static float EffectiveMass(const float inverseMassSum, const SolverBody& bodyA, const SolverBody& bodyB, const glm::vec3& relativeA, const glm::vec3& relativeB, const glm::vec3& direction);
+
+		static bool IsStaticPair(const SolverBody& bodyA, const SolverBody& bodyB) { return bodyA.pseudoInverseMass == 0.0f && bodyB.pseudoInverseMass == 0.0f; }
+
+		// Contact normal flipped where needed so that it always points from B towards A
+		static glm::vec3 SeparationNormal(const ContactPoint& contact) { return (contact.penetration < 0.0f) ? -contact.normal : contact.normal; }
+
 		//void PresolveContactPoint(ContactPoint& contact, Entity* objectA, Entity* objectB, int numContacts);
 		//void SolveContactPoint(ContactPoint& contact, Entity* objectA, Entity* objectB, int numContacts);
-		
+
 		CollisionManager* collisionManager;
+
+		std::vector<SolverBody> bodies;
+		std::unordered_map<unsigned int, unsigned int> entityToBody;
+		std::vector<ContactConstraint> constraints;
+
+		int numIterations;
+		int numPositionIterations;
+		float warmStartFactor;
+		float positionCorrectionFactor;
+		float allowedPenetration;
+		float restitutionThreshold;
 	};
-}
\ No newline at end of file
+}
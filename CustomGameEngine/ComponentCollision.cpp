@@ -1,11 +1,18 @@
 #include "ComponentCollision.h"
 namespace Engine {
-	void ComponentCollision::AddToEntitiesCheckedThisFrame(const unsigned int e, const std::string& name)
+	void ComponentCollision::AddToCollisions(const unsigned int e)
 	{
-		EntitiesCheckedThisFrame[e] = name;
+		if (!IsCollidingWithEntity(e)) {
+			EntitiesCollidingWith.push_back(e);
+		}
 	}
-	void ComponentCollision::AddToCollisions(const unsigned int e, const std::string& name)
+	void ComponentCollision::RemoveFromCollisions(const unsigned int e)
 	{
-		EntitiesCollidingWith[e] = name;
+		// Order doesn't matter, swap with last and pop
+		std::vector<unsigned int>::iterator it = std::find(EntitiesCollidingWith.begin(), EntitiesCollidingWith.end(), e);
+		if (it != EntitiesCollidingWith.end()) {
+			*it = EntitiesCollidingWith.back();
+			EntitiesCollidingWith.pop_back();
+		}
 	}
 }
\ No newline at end of file
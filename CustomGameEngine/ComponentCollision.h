@@ -1,6 +1,8 @@
 #pragma once
 #include "Entity.h"
 #include <unordered_map>
+#include <vector>
+#include <algorithm>
 #include <glm/ext/matrix_float4x4.hpp>
 
 // The whole physics system and collision setup is a mess anyway. Will be re-worked as a larger physics engine re-design
@@ -10,7 +12,9 @@ namespace Engine {
     enum ColliderType {
         COLLISION_SPHERE,
         COLLISION_BOX,
-        COLLISION_AABB
+        COLLISION_AABB,
+        COLLISION_CONVEX,
+        COLLISION_MESH
     };
 
     // Bounding box structure and implementation below adapted from: https://research.ncl.ac.uk/game/mastersdegree/gametechnologies/previousinformation/csc8503coderepository/
@@ -144,7 +148,7 @@ namespace Engine {
             return id;
         }
 
-        void GetMinMaxVerticesOnAxis(const glm::vec3 localAxis, int& out_minIndex, int& out_maxIndex) {
+        void GetMinMaxVerticesOnAxis(const glm::vec3 localAxis, int& out_minIndex, int& out_maxIndex) const {
             float correlation;
 
             float minCorrelation = FLT_MAX, maxCorrelation = -FLT_MAX;
@@ -189,23 +193,33 @@ namespace Engine {
 	public:
         virtual constexpr ColliderType ColliderType() const = 0;
 
-		void ClearEntitiesCheckedThisFrame() { EntitiesCheckedThisFrame.clear(); }
-		void AddToEntitiesCheckedThisFrame(const unsigned int e, const std::string& name);
-
-		bool HasEntityAlreadyBeenChecked(const unsigned int e) const { return EntitiesCheckedThisFrame.find(e) != EntitiesCheckedThisFrame.end(); }
-
 		bool IsMovedByCollisions() const { return isMovedByCollisions; }
 		void IsMovedByCollisions(const bool isMoveable) { isMovedByCollisions = isMoveable; }
 
-		const std::unordered_map<unsigned int, std::string>& Collisions() { return EntitiesCollidingWith; }
-		bool IsCollidingWithEntity(const unsigned int e) const { return EntitiesCollidingWith.find(e) != EntitiesCollidingWith.end(); }
-		void AddToCollisions(const unsigned int e, const std::string& name);
-		void RemoveFromCollisions(const unsigned int e) { EntitiesCollidingWith.erase(e); }
+		// Set by the island builder when this collider's body is put to sleep. The physics component remains the authority as forces can wake a body at any time
+		bool IsAsleep() const { return asleep; }
+		void SetAsleep(const bool asleep) { this->asleep = asleep; }
+
+		// Bit mask of the layers this collider is on, spatial queries only return colliders on a layer in their mask
+		unsigned int CollisionLayer() const { return collisionLayer; }
+		void SetCollisionLayer(const unsigned int layer) { collisionLayer = layer; }
+
+		// Bit mask of the layers this collider can collide with. A pair is only tested if each collider's layer is in the other's mask
+		unsigned int CollisionMask() const { return collisionMask; }
+		void SetCollisionMask(const unsigned int mask) { collisionMask = mask; }
+
+		// IDs of every entity this collider is currently touching
+		const std::vector<unsigned int>& Collisions() const { return EntitiesCollidingWith; }
+		bool IsCollidingWithEntity(const unsigned int e) const { return std::find(EntitiesCollidingWith.begin(), EntitiesCollidingWith.end(), e) != EntitiesCollidingWith.end(); }
+		void AddToCollisions(const unsigned int e);
+		void RemoveFromCollisions(const unsigned int e);
 	
     protected:
-        std::unordered_map<unsigned int, std::string> EntitiesCheckedThisFrame;
-        std::unordered_map<unsigned int, std::string> EntitiesCollidingWith;
+        std::vector<unsigned int> EntitiesCollidingWith;
 
         bool isMovedByCollisions;
+        bool asleep = false;
+        unsigned int collisionLayer = 1u;
+        unsigned int collisionMask = 0xFFFFFFFFu;
     };
 }
\ No newline at end of file
@@ -0,0 +1,28 @@
+#include "ComponentCollisionConvex.h"
+#include "ResourceManager.h"
+#include <glm/glm.hpp>
+namespace Engine {
+	ComponentCollisionConvex::ComponentCollisionConvex(const ConvexHull* hull) : hull(hull)
+	{
+		isMovedByCollisions = true;
+	}
+
+	ComponentCollisionConvex::ComponentCollisionConvex(const std::string& hullName, const std::vector<Mesh*>& meshes, const unsigned int maxVertices, const bool loadInPersistentResources)
+	{
+		hull = ResourceManager::GetInstance()->LoadConvexHull(hullName, meshes, maxVertices, loadInPersistentResources);
+		isMovedByCollisions = true;
+	}
+
+	void ComponentCollisionConvex::GetWorldSpaceBounds(const glm::mat4& modelMatrix, glm::vec3& out_min, glm::vec3& out_max) const
+	{
+		const glm::vec3 localMin = hull ? hull->BoundsMin() : glm::vec3(0.0f);
+		const glm::vec3 localMax = hull ? hull->BoundsMax() : glm::vec3(0.0f);
+
+		const glm::vec3 centre = glm::vec3(modelMatrix * glm::vec4((localMin + localMax) * 0.5f, 1.0f));
+		const glm::vec3 halfExtents = (localMax - localMin) * 0.5f;
+		const glm::mat3 absolute = glm::mat3(glm::abs(glm::vec3(modelMatrix[0])), glm::abs(glm::vec3(modelMatrix[1])), glm::abs(glm::vec3(modelMatrix[2])));
+		const glm::vec3 worldHalfExtents = absolute * halfExtents;
+		out_min = centre - worldHalfExtents;
+		out_max = centre + worldHalfExtents;
+	}
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "ComponentCollision.h"
+#include "ConvexHull.h"
+#include <string>
+#include <glm/ext/matrix_float4x4.hpp>
+namespace Engine {
+	class Mesh;
+
+	// Collider made of the convex hull of one or more meshes, so a prop needs one tight collider instead of several boxes and spheres
+	// The hull is shared between every collider created from the same name and is owned by the resource manager
+	// Tested against every other shape with GJK and EPA, see GJK.h
+	class ComponentCollisionConvex : public ComponentCollision
+	{
+	public:
+		constexpr Engine::ColliderType ColliderType() const override { return COLLISION_CONVEX; }
+
+		ComponentCollisionConvex(const ConvexHull* hull);
+		// Builds the hull of the meshes' vertices, or reuses the one already built under hullName
+		ComponentCollisionConvex(const std::string& hullName, const std::vector<Mesh*>& meshes, const unsigned int maxVertices = ConvexHull::DEFAULT_MAX_VERTICES, const bool loadInPersistentResources = false);
+		~ComponentCollisionConvex() {}
+
+		const ConvexHull* GetHull() const { return hull; }
+
+		// World space bounds of the hull under a model matrix
+		void GetWorldSpaceBounds(const glm::mat4& modelMatrix, glm::vec3& out_min, glm::vec3& out_max) const;
+
+	private:
+		const ConvexHull* hull;
+	};
+}
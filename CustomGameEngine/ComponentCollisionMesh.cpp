@@ -0,0 +1,28 @@
+#include "ComponentCollisionMesh.h"
+#include "ResourceManager.h"
+#include <glm/glm.hpp>
+namespace Engine {
+	ComponentCollisionMesh::ComponentCollisionMesh(const TriangleMeshBVH* mesh) : mesh(mesh)
+	{
+		isMovedByCollisions = false;
+	}
+
+	ComponentCollisionMesh::ComponentCollisionMesh(const std::string& cacheName, const std::vector<Mesh*>& meshes, const bool loadInPersistentResources)
+	{
+		mesh = ResourceManager::GetInstance()->LoadCollisionMesh(cacheName, meshes, loadInPersistentResources);
+		isMovedByCollisions = false;
+	}
+
+	void ComponentCollisionMesh::GetWorldSpaceBounds(const glm::mat4& modelMatrix, glm::vec3& out_min, glm::vec3& out_max) const
+	{
+		const glm::vec3 localMin = mesh ? mesh->BoundsMin() : glm::vec3(0.0f);
+		const glm::vec3 localMax = mesh ? mesh->BoundsMax() : glm::vec3(0.0f);
+
+		const glm::vec3 centre = glm::vec3(modelMatrix * glm::vec4((localMin + localMax) * 0.5f, 1.0f));
+		const glm::vec3 halfExtents = (localMax - localMin) * 0.5f;
+		const glm::mat3 absolute = glm::mat3(glm::abs(glm::vec3(modelMatrix[0])), glm::abs(glm::vec3(modelMatrix[1])), glm::abs(glm::vec3(modelMatrix[2])));
+		const glm::vec3 worldHalfExtents = absolute * halfExtents;
+		out_min = centre - worldHalfExtents;
+		out_max = centre + worldHalfExtents;
+	}
+}
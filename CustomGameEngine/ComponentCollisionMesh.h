@@ -0,0 +1,30 @@
+#pragma once
+#include "ComponentCollision.h"
+#include "TriangleMeshBVH.h"
+#include <string>
+#include <glm/ext/matrix_float4x4.hpp>
+namespace Engine {
+	class Mesh;
+
+	// Collider made of the triangles of one or more meshes, for static level geometry
+	// The triangle tree is shared between every collider created from the same cache name and is owned by the resource manager
+	// Mesh colliders are never moved by collisions and never collide with each other
+	class ComponentCollisionMesh : public ComponentCollision
+	{
+	public:
+		constexpr Engine::ColliderType ColliderType() const override { return COLLISION_MESH; }
+
+		ComponentCollisionMesh(const TriangleMeshBVH* mesh);
+		// Cooks the meshes' triangles, or loads them from the cache, under cacheName
+		ComponentCollisionMesh(const std::string& cacheName, const std::vector<Mesh*>& meshes, const bool loadInPersistentResources = false);
+		~ComponentCollisionMesh() {}
+
+		const TriangleMeshBVH* GetMesh() const { return mesh; }
+
+		// World space bounds of the whole mesh under a model matrix
+		void GetWorldSpaceBounds(const glm::mat4& modelMatrix, glm::vec3& out_min, glm::vec3& out_max) const;
+
+	private:
+		const TriangleMeshBVH* mesh;
+	};
+}
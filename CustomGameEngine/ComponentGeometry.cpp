@@ -14,6 +14,8 @@ namespace Engine {
 
 		this->textureScale = old_component.textureScale;
 		this->castShadows = old_component.castShadows;
+		this->occluder = old_component.occluder;
+		this->isStatic = old_component.isStatic;
 
 		this->pbr = old_component.pbr;
 		this->usingDefaultShader = old_component.usingDefaultShader;
@@ -49,6 +51,8 @@ namespace Engine {
 		usingDefaultShader = false;
 
 		castShadows = true;
+		occluder = false;
+		isStatic = false;
 
 		textureScale = glm::vec2(1.0f);
 
@@ -80,6 +84,8 @@ namespace Engine {
 		usingDefaultShader = true;
 
 		castShadows = true;
+		occluder = false;
+		isStatic = false;
 
 		shader = nullptr;
 		if (RenderManager::GetInstance()->GetRenderPipeline()->PipelineName() == "FORWARD_PIPELINE") {
@@ -120,6 +126,8 @@ namespace Engine {
 		usingDefaultShader = false;
 
 		castShadows = true;
+		occluder = false;
+		isStatic = false;
 
 		textureScale = glm::vec2(1.0f);
 
@@ -145,6 +153,8 @@ namespace Engine {
 		usingDefaultShader = true;
 
 		castShadows = true;
+		occluder = false;
+		isStatic = false;
 
 		model = ResourceManager::GetInstance()->CreateModel(modelFilepath, pbr, persistentStorage, assimpPostProcess);
 		usingPremadeModel = false;
@@ -37,6 +37,14 @@ namespace Engine {
 		void CastShadows(bool shadows) { castShadows = shadows; }
 		bool CastShadows() { return castShadows; }
 
+		// Occluders are always drawn into the CPU occlusion buffer when occlusion culling is on, whatever their triangle count
+		void SetIsOccluder(const bool isOccluder) { occluder = isOccluder; }
+		const bool IsOccluder() const { return occluder; }
+
+		// Static geometry never moves after the potentially visible set is baked, it blocks visibility in the bake and is hidden at runtime from cells where the bake never saw it
+		void SetIsStatic(const bool isStatic) { this->isStatic = isStatic; }
+		const bool IsStatic() const { return isStatic; }
+
 		void SetTextureScale(float newScale) { textureScale = glm::vec2(newScale); }
 		void SetTextureScale(glm::vec2 newScale) { textureScale = newScale; }
 
@@ -77,6 +85,8 @@ namespace Engine {
 
 		glm::vec2 textureScale;
 		bool castShadows;
+		bool occluder;
+		bool isStatic;
 
 		bool pbr;
 		bool usingDefaultShader;
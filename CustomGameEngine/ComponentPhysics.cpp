@@ -1,6 +1,6 @@
 #include "ComponentPhysics.h"
 namespace Engine {
-	ComponentPhysics::ComponentPhysics(const float mass, const float drag, const float surfaceArea, const float elasticity, const bool gravity, const bool cuboidInertiaTensor) : dragCoefficient(drag), surfaceArea(surfaceArea), gravity(gravity), elasticity(elasticity), velocity(0.0f, 0.0f, 0.0f), angularVelocity(0.0f, 0.0f, 0.0f), force(0.0f, 0.0f, 0.0f), torque(0.0f, 0.0f, 0.0f)
+	ComponentPhysics::ComponentPhysics(const float mass, const float drag, const float surfaceArea, const float elasticity, const bool gravity, const bool cuboidInertiaTensor) : dragCoefficient(drag), surfaceArea(surfaceArea), gravity(gravity), asleep(false), allowSleep(true), continuousCollision(false), sleepTimer(0.0f), elasticity(elasticity), friction(0.5f), velocity(0.0f, 0.0f, 0.0f), angularVelocity(0.0f, 0.0f, 0.0f), force(0.0f, 0.0f, 0.0f), torque(0.0f, 0.0f, 0.0f)
 	{
 		SetMass(mass);
 
@@ -24,6 +24,11 @@ namespace Engine {
         const float DragCoefficient() const                     { return dragCoefficient; }
         const float SurfaceArea() const                         { return surfaceArea; }
         const float Elasticity() const                          { return elasticity; }
+        const float Friction() const                            { return friction; }
+        const bool IsAsleep() const                             { return asleep; }
+        const bool AllowSleep() const                           { return allowSleep; }
+        const float SleepTimer() const                          { return sleepTimer; }
+        const bool ContinuousCollision() const                  { return continuousCollision; }
 
         // Set
 
@@ -31,17 +36,22 @@ namespace Engine {
         void SetVelocity(const glm::vec3& newVelocity)          { this->velocity = newVelocity; }
         void SetAngularVelocity(const glm::vec3& newVelocity)   { this->angularVelocity = newVelocity; }
         void SetTorque(const glm::vec3& newTorque)              { torque = newTorque; }
-        void AddTorque(const glm::vec3& newTorque)              { torque += newTorque; }
+        void AddTorque(const glm::vec3& newTorque)              { torque += newTorque; Wake(); }
         void SetGravity(const bool newGravity)                  { gravity = newGravity; }
         void SetDragCoefficient(const float newDrag)            { dragCoefficient = newDrag; }
         void SetSurfaceArea(const float surfaceArea)            { this->surfaceArea = surfaceArea; }
         void SetElasticity(const float elasticity)              { this->elasticity = elasticity; }
+        void SetFriction(const float friction)                  { this->friction = friction; }
+        void SetAllowSleep(const bool allowSleep)               { this->allowSleep = allowSleep; if (!allowSleep) { Wake(); } }
+        void SetSleepTimer(const float newTimer)                { sleepTimer = newTimer; }
+        void SetContinuousCollision(const bool enabled)         { continuousCollision = enabled; } // Sweep this body against other colliders so it can't tunnel through thin geometry
 
         // Update
 
         void ClearForces() { force = glm::vec3(0.0f); }
-        void AddForce(const glm::vec3& force) { this->force += force; }
+        void AddForce(const glm::vec3& force) { this->force += force; Wake(); }
         void AddForce(const glm::vec3& force, const glm::vec3& forcePositionLocal) {
+            Wake();
             this->force += force;
             torque += glm::cross(forcePositionLocal, force);
         }
@@ -50,17 +60,33 @@ namespace Engine {
         void ApplyAngularImpulse(const glm::vec3 angularForce) { angularVelocity += inverseInertiaTensor * angularForce; }
 
         void UpdateInertiaTensor(const glm::quat& orientation);
+        void SetInverseInertiaTensor(const glm::mat3& tensor) { inverseInertiaTensor = tensor; } // World space tensor already computed elsewhere, see RigidBodyStore
+
+        // Sleeping bodies are skipped by integration, narrowphase and collision resolution until woken by a contact or force
+        void Sleep() {
+            asleep = true;
+            velocity = glm::vec3(0.0f);
+            angularVelocity = glm::vec3(0.0f);
+            force = glm::vec3(0.0f);
+            torque = glm::vec3(0.0f);
+        }
+        void Wake() { asleep = false; sleepTimer = 0.0f; }
 
     private:
         void UpdateInverseMass() { inverseMass = 1.0f / mass; }
 
         bool gravity;
+        bool asleep;
+        bool allowSleep;
+        bool continuousCollision;
+        float sleepTimer;
 
         float surfaceArea;
         float dragCoefficient;
         float inverseMass;
         float mass;
         float elasticity;
+        float friction;
 
         glm::vec3 velocity;
         glm::vec3 angularVelocity;
@@ -7,6 +7,7 @@ namespace Engine
 		assert(owning_ecs);
 		orientation = glm::angleAxis(glm::radians(rotationAngle), rotationAxis);
 		forwardVector = glm::normalize(orientation * glm::vec3(0.0f, 0.0f, 1.0f));
+		StorePreviousState();
 		UpdateModelMatrix();
 	}
 
@@ -15,6 +16,7 @@ namespace Engine
 		assert(owning_ecs);
 		orientation = glm::angleAxis(glm::radians(rotationAngle), rotationAxis);
 		forwardVector = glm::normalize(orientation * glm::vec3(0.0f, 0.0f, 1.0f));
+		StorePreviousState();
 		UpdateModelMatrix();
 	}
 
@@ -23,6 +25,7 @@ namespace Engine
 		assert(owning_ecs);
 		orientation = glm::angleAxis(glm::radians(rotationAngle), rotationAxis);
 		forwardVector = glm::normalize(orientation * glm::vec3(0.0f, 0.0f, 1.0f));
+		StorePreviousState();
 		UpdateModelMatrix();
 	}
 
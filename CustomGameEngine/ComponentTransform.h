@@ -47,6 +47,13 @@ namespace Engine
 			forwardVector = glm::normalize(orientation * glm::vec3(0.0f, 0.0f, 1.0f));
 			UpdateModelMatrix();
 		}
+		// Only rebuilds the model matrix once
+		void SetPositionAndOrientation(const glm::vec3& position, const glm::quat& orientation) {
+			this->position = position;
+			this->orientation = orientation;
+			forwardVector = glm::normalize(orientation * glm::vec3(0.0f, 0.0f, 1.0f));
+			UpdateModelMatrix();
+		}
 
 		// Get
 
@@ -70,6 +77,14 @@ namespace Engine
 		}
 		const glm::quat& GetOrientation() const { return orientation; }
 
+		// Local position and orientation at the start of the last fixed step, used to interpolate rendering between steps
+		const glm::vec3& PreviousPosition() const { return previousPosition; }
+		const glm::quat& PreviousOrientation() const { return previousOrientation; }
+		void StorePreviousState() {
+			previousPosition = position;
+			previousOrientation = orientation;
+		}
+
 		const std::vector<unsigned int>& GetChildren() const { return childrenIDs; }
 		
 		const Entity* FindChildWithName(const std::string& name) const;
@@ -91,6 +106,9 @@ namespace Engine
 
 		glm::quat orientation;
 
+		glm::vec3 previousPosition;
+		glm::quat previousOrientation;
+
 		glm::mat4 worldModelMatrix;
 
 		unsigned int parentID;
@@ -1,14 +1,55 @@
 #pragma once
 #include "EntityManager.h"
 #include "ComponentPhysics.h"
+#include "ComponentTransform.h"
 namespace Engine {
+	enum ConstraintType {
+		CONSTRAINT_POSITION,
+		CONSTRAINT_ROTATION
+	};
+
+	// Per step copy of a constrained body, shared by every constraint attached to it. Written back once all iterations are done
+	struct ConstraintBody {
+		ComponentTransform* transform;
+		ComponentPhysics* physics; // null for entities without physics, which are never written to
+
+		float inverseMass;
+		glm::mat3 inverseInertia;
+
+		glm::vec3 linearVelocity;
+		glm::vec3 angularVelocity;
+		glm::vec3 torque;
+	};
+
+	// Everything about a position constraint that stays fixed for a step, only velocities change between iterations
+	struct PositionConstraintRow {
+		unsigned int bodyA;
+		unsigned int bodyB;
+
+		glm::vec3 direction; // from joint B towards joint A
+		glm::vec3 relativeA; // joint A relative to body A's centre, scaled by the angle term
+		glm::vec3 relativeB;
+		float inverseConstraintMass;
+		float bias;
+	};
+
+	struct RotationConstraintRow {
+		unsigned int bodyA;
+		unsigned int bodyB;
+
+		glm::vec3 direction;
+		glm::vec3 axisMask; // 1 for every axis currently past its limit, 0 otherwise
+		glm::vec3 bias;
+		float inverseConstraintMass;
+	};
+
 	class Constraint
 	{
 	public:
 		Constraint(unsigned int entityIDA, unsigned int entityIDB, const float bias) : entityIDA(entityIDA), entityIDB(entityIDB), active(true), bias(bias){}
-		~Constraint() {}
+		virtual ~Constraint() {}
 
-		virtual void UpdateConstraint(EntityManager& ecs, const float deltaTime) const = 0;
+		virtual ConstraintType Type() const = 0;
 
 		float Bias() const { return bias; }
 		void SetBias(const float newBias) { this->bias = newBias; }
@@ -17,10 +58,13 @@ namespace Engine {
 		void Deactivate() { active = false; }
 		void SetActive(const bool active) { this->active = active; }
 		bool IsActive() const { return active; }
+
+		unsigned int EntityIDA() const { return entityIDA; }
+		unsigned int EntityIDB() const { return entityIDB; }
 	protected:
 		float bias;
 		bool active;
 		unsigned int entityIDA;
 		unsigned int entityIDB;
 	};
-}
\ No newline at end of file
+}
@@ -1,24 +1,21 @@
 #include "ConstraintPosition.h"
-#include "ComponentPhysics.h"
-#include "ComponentTransform.h"
 namespace Engine {
-	void ConstraintPosition::UpdateConstraint(EntityManager& ecs, const float deltaTime) const
+	bool ConstraintPosition::PreStep(const ConstraintBody& bodyA, const ConstraintBody& bodyB, const float deltaTime, PositionConstraintRow& out_row) const
 	{
-		const ComponentTransform* transformA = ecs.GetComponent<ComponentTransform>(entityIDA);
-		const ComponentTransform* transformB = ecs.GetComponent<ComponentTransform>(entityIDB);
-
-		ComponentPhysics* physicsA = ecs.GetComponent<ComponentPhysics>(entityIDA);
-		ComponentPhysics* physicsB = ecs.GetComponent<ComponentPhysics>(entityIDB);
-
 		// At least one of the constrained objects must have a physics component
-		if (!physicsA && !physicsB) { return; }
+		if (!bodyA.physics && !bodyB.physics) { return false; }
 
-		const glm::vec3 worldSpaceJointPositionA = transformA->GetWorldModelMatrix() * glm::vec4(relativeJointPositionA, 1.0f);
-		const glm::vec3 worldSpaceJointPositionB = transformB->GetWorldModelMatrix() * glm::vec4(relativeJointPositionB, 1.0f);
+		const glm::vec3 worldSpaceJointPositionA = bodyA.transform->GetWorldModelMatrix() * glm::vec4(relativeJointPositionA, 1.0f);
+		const glm::vec3 worldSpaceJointPositionB = bodyB.transform->GetWorldModelMatrix() * glm::vec4(relativeJointPositionB, 1.0f);
 		const glm::vec3 relativePosition = worldSpaceJointPositionA - worldSpaceJointPositionB;
 		const float currentDistance = glm::length(relativePosition);
 		const float offset = distance - currentDistance;
 
+		if (!(abs(offset) > 0.0f)) { return false; }
+
+		const float constraintMass = bodyA.inverseMass + bodyB.inverseMass;
+		if (!(constraintMass > 0.0f)) { return false; }
+
 		const float targetAngleDegrees = 180.0f;
 
 		const glm::vec3 rotationConstraintNormal = glm::normalize(worldSpaceJointPositionA - worldSpaceJointPositionB);
@@ -31,45 +28,15 @@ namespace Engine {
 		if (angleDegrees > 180.0f) {
 			angleDegrees = 180.0f - angleDegrees;
 		}
-		if (abs(offset) > 0.0f) {
-			const glm::vec3 direction = glm::normalize(relativePosition);
 
-			glm::vec3 velocityA = glm::vec3(0.0f);
-			glm::vec3 velocityB = glm::vec3(0.0f);
-			float inverseMassA = 0.0f;
-			float inverseMassB = 0.0f;
+		// Angular impulse scales as the angle between the two faces gets larger
+		const float angularScale = angleOffset * (angleDegrees / targetAngleDegrees);
 
-			if (physicsA) {
-				velocityA = physicsA->Velocity();
-				inverseMassA = physicsA->InverseMass();
-			}
-			if (physicsB) {
-				velocityB = physicsB->Velocity();
-				inverseMassB = physicsB->InverseMass();
-			}
-
-			const glm::vec3 relativeVelocity = velocityA - velocityB;
-			const float constraintMass = inverseMassA + inverseMassB;
-
-			if (constraintMass > 0.0f) {
-				const float constraintStress = glm::dot(relativeVelocity, direction);
-				const float biasFactor = this->bias;
-				const float bias = -(biasFactor / deltaTime) * offset;
-
-				const float lambda = -(constraintStress + bias) / constraintMass;
-
-				if (physicsA) {
-					const glm::vec3 impulseA = direction * lambda;
-					physicsA->ApplyLinearImpulse(impulseA);
-					physicsA->ApplyAngularImpulse(glm::cross(worldSpaceJointPositionA - transformA->GetWorldPosition(), impulseA * (angleOffset * (angleDegrees / targetAngleDegrees)))); // Angular impulse scales as the angle between the two faces gets larger
-				}
-				if (physicsB) {
-					const glm::vec3 impulseB = -direction * lambda;
-					physicsB->ApplyLinearImpulse(impulseB);
-					physicsB->ApplyAngularImpulse(glm::cross(worldSpaceJointPositionB - transformB->GetWorldPosition(), impulseB * (angleOffset * (angleDegrees / targetAngleDegrees))));
-				}
-			}
-		}
+		out_row.direction = glm::normalize(relativePosition);
+		out_row.relativeA = (worldSpaceJointPositionA - bodyA.transform->GetWorldPosition()) * angularScale;
+		out_row.relativeB = (worldSpaceJointPositionB - bodyB.transform->GetWorldPosition()) * angularScale;
+		out_row.inverseConstraintMass = 1.0f / constraintMass;
+		out_row.bias = -(this->bias / deltaTime) * offset;
 
 		/*
 		if (abs(angleOffset) > 5.0f) {
@@ -133,5 +100,25 @@ namespace Engine {
 			}
 		}
 		*/
+
+		return true;
+	}
+
+	void ConstraintPosition::Solve(const PositionConstraintRow& row, ConstraintBody& bodyA, ConstraintBody& bodyB)
+	{
+		const glm::vec3 relativeVelocity = bodyA.linearVelocity - bodyB.linearVelocity;
+		const float constraintStress = glm::dot(relativeVelocity, row.direction);
+		const float lambda = -(constraintStress + row.bias) * row.inverseConstraintMass;
+
+		if (bodyA.physics) {
+			const glm::vec3 impulseA = row.direction * lambda;
+			bodyA.linearVelocity += impulseA * bodyA.inverseMass;
+			bodyA.angularVelocity += bodyA.inverseInertia * glm::cross(row.relativeA, impulseA);
+		}
+		if (bodyB.physics) {
+			const glm::vec3 impulseB = -row.direction * lambda;
+			bodyB.linearVelocity += impulseB * bodyB.inverseMass;
+			bodyB.angularVelocity += bodyB.inverseInertia * glm::cross(row.relativeB, impulseB);
+		}
 	}
 }
\ No newline at end of file
@@ -7,7 +7,13 @@ namespace Engine {
         ConstraintPosition(unsigned int entityIDA, unsigned int entityIDB, const float distance, const float bias = 0.000005f, const glm::vec3& relativeJointPositionA = glm::vec3(0.0f), const glm::vec3& relativeJointPositionB = glm::vec3(0.0f)) : Constraint(entityIDA, entityIDB, bias), distance(distance), relativeJointPositionA(relativeJointPositionA), relativeJointPositionB(relativeJointPositionB) {}
         ~ConstraintPosition() {}
 
-        void UpdateConstraint(EntityManager& ecs, const float deltaTime) const override;
+        ConstraintType Type() const override { return CONSTRAINT_POSITION; }
+
+        // Fill in the row for this step from the bodies' current transforms. Returns false if there is nothing to solve
+        bool PreStep(const ConstraintBody& bodyA, const ConstraintBody& bodyB, const float deltaTime, PositionConstraintRow& out_row) const;
+
+        // Apply one iteration of a pre-stepped row
+        static void Solve(const PositionConstraintRow& row, ConstraintBody& bodyA, ConstraintBody& bodyB);
 
         float Distance() const { return distance; }
         void SetDistance(const float newDistance) { this->distance = newDistance; }
@@ -1,106 +1,68 @@
 #include "ConstraintRotation.h"
 namespace Engine {
-	void ConstraintRotation::UpdateConstraint(EntityManager& ecs, const float deltaTime) const
+	bool ConstraintRotation::PreStep(const ConstraintBody& bodyA, const ConstraintBody& bodyB, const float deltaTime, RotationConstraintRow& out_row) const
 	{
-		const ComponentTransform* transformA = ecs.GetComponent<ComponentTransform>(entityIDA);
-		const ComponentTransform* transformB = ecs.GetComponent<ComponentTransform>(entityIDB);
-
-		ComponentPhysics* physicsA = ecs.GetComponent<ComponentPhysics>(entityIDA);
-		ComponentPhysics* physicsB = ecs.GetComponent<ComponentPhysics>(entityIDA);
-
 		// At least one of the constrained objects must have a physics component
-		if (!physicsA && !physicsB) { return; }
+		if (!bodyA.physics && !bodyB.physics) { return false; }
 
-		glm::vec3 currentOffset = glm::vec3(0.0f);
+		const float constraintMass = bodyA.inverseMass + bodyB.inverseMass;
+		if (!(constraintMass > 0.0f)) { return false; }
 
-		glm::vec3 currentRotationA = glm::eulerAngles(transformA->GetOrientation());
+		glm::vec3 currentRotationA = glm::eulerAngles(bodyA.transform->GetOrientation());
 		currentRotationA.x = glm::degrees(currentRotationA.x);
 		currentRotationA.y = glm::degrees(currentRotationA.y);
 		currentRotationA.z = glm::degrees(currentRotationA.z);
 
-		glm::vec3 currentRotationB = glm::eulerAngles(transformB->GetOrientation());
+		glm::vec3 currentRotationB = glm::eulerAngles(bodyB.transform->GetOrientation());
 		currentRotationB.x = glm::degrees(currentRotationB.x);
 		currentRotationB.y = glm::degrees(currentRotationB.y);
 		currentRotationB.z = glm::degrees(currentRotationB.z);
 
-		currentOffset = currentRotationB - currentRotationA;
-		const glm::vec3 offset = maxRotationOffset - currentOffset;
-
-		const glm::vec3 relativePosition = transformA->GetWorldPosition() - transformB->GetWorldPosition();
-
-		glm::vec3 angularVelocityA = glm::vec3(0.0f);
-		glm::vec3 angularVelocityB = glm::vec3(0.0f);
-		float inverseMassA = 0.0f;
-		float inverseMassB = 0.0f;
-
-		if (physicsA) {
-			angularVelocityA = physicsA->AngularVelocity();
-			inverseMassA = physicsA->InverseMass();
-		}
-		if (physicsB) {
-			angularVelocityB = physicsB->AngularVelocity();
-			inverseMassB = physicsB->InverseMass();
-		}
-
-		const float constraintMass = inverseMassA + inverseMassB;
-
-		if (constraintMass > 0.0f) {
-			glm::vec3 angularImpulse = glm::vec3(0.0f);
-			const glm::vec3 direction = glm::normalize(relativePosition);
-			const float constraintStress = glm::dot((angularVelocityB - angularVelocityA), direction);
-;			if (abs(currentOffset.x) > abs(maxRotationOffset.x) && controlXRotation) {
-				const float biasFactor = this->bias;
-				const float bias = -(biasFactor / deltaTime) * currentOffset.x;
-
-				const float lambda = -(constraintStress + bias) / constraintMass;
-				angularImpulse.x = lambda;
-			}
-
-			if (abs(currentOffset.y) > abs(maxRotationOffset.y) && controlYRotation) {
-				const float biasFactor = this->bias;
-				const float bias = -(biasFactor / deltaTime) * currentOffset.y;
-
-				const float lambda = -(constraintStress + bias) / constraintMass;
-				angularImpulse.y = lambda;
-			}
-
-			if (abs(currentOffset.z) > abs(maxRotationOffset.z) && controlZRotation) {
-				const float biasFactor = this->bias;
-				const float bias = -(biasFactor / deltaTime) * currentOffset.z;
-
-				const float lambda = -(constraintStress + bias) / constraintMass;
-				angularImpulse.z = lambda;
-			}
-
-			if (physicsA != nullptr) {
-				const glm::vec3 impulseA = angularImpulse;
-				physicsA->AddTorque(impulseA);
-			}
-			if (physicsB != nullptr) {
-				const glm::vec3 impulseB = -angularImpulse;
-				const glm::vec3 torqueImpulseB = impulseB;
-				physicsB->AddTorque(impulseB);
-
-				// Angular
-				/*
-				physicsB->UpdateInertiaTensor(objectB.GetTransformComponent()->GetOrientation());
-
-				glm::vec3 angularAcceleration = physicsB->InverseInertiaTensor() * torqueImpulseB;
-				glm::vec3 angularVelocity = physicsB->AngularVelocity();
-
-				angularVelocity += angularAcceleration * deltaTime;
-				physicsB->SetAngularVelocity(angularVelocity);
-
-				// Angular velocity
-				glm::quat orientation = objectB.GetTransformComponent()->GetOrientation();
-				angularVelocity = physicsB->AngularVelocity();
-
-				orientation = orientation + (glm::quat(glm::vec3(angularVelocity * deltaTime * 0.5f)) * orientation);
-				orientation = glm::normalize(orientation);
-
-				objectB.GetTransformComponent()->SetOrientation(orientation);
-				*/
-			}
-		}
+		const glm::vec3 currentOffset = currentRotationB - currentRotationA;
+
+		out_row.axisMask = glm::vec3(0.0f);
+		if (abs(currentOffset.x) > abs(maxRotationOffset.x) && controlXRotation) { out_row.axisMask.x = 1.0f; }
+		if (abs(currentOffset.y) > abs(maxRotationOffset.y) && controlYRotation) { out_row.axisMask.y = 1.0f; }
+		if (abs(currentOffset.z) > abs(maxRotationOffset.z) && controlZRotation) { out_row.axisMask.z = 1.0f; }
+
+		// Nothing past its limit, the constraint would only add zero torque
+		if (out_row.axisMask == glm::vec3(0.0f)) { return false; }
+
+		const glm::vec3 relativePosition = bodyA.transform->GetWorldPosition() - bodyB.transform->GetWorldPosition();
+
+		out_row.direction = glm::normalize(relativePosition);
+		out_row.bias = -(this->bias / deltaTime) * currentOffset;
+		out_row.inverseConstraintMass = 1.0f / constraintMass;
+
+		// Angular
+		/*
+		physicsB->UpdateInertiaTensor(objectB.GetTransformComponent()->GetOrientation());
+
+		glm::vec3 angularAcceleration = physicsB->InverseInertiaTensor() * torqueImpulseB;
+		glm::vec3 angularVelocity = physicsB->AngularVelocity();
+
+		angularVelocity += angularAcceleration * deltaTime;
+		physicsB->SetAngularVelocity(angularVelocity);
+
+		// Angular velocity
+		glm::quat orientation = objectB.GetTransformComponent()->GetOrientation();
+		angularVelocity = physicsB->AngularVelocity();
+
+		orientation = orientation + (glm::quat(glm::vec3(angularVelocity * deltaTime * 0.5f)) * orientation);
+		orientation = glm::normalize(orientation);
+
+		objectB.GetTransformComponent()->SetOrientation(orientation);
+		*/
+
+		return true;
+	}
+
+	void ConstraintRotation::Solve(const RotationConstraintRow& row, ConstraintBody& bodyA, ConstraintBody& bodyB)
+	{
+		const float constraintStress = glm::dot((bodyB.angularVelocity - bodyA.angularVelocity), row.direction);
+		const glm::vec3 angularImpulse = row.axisMask * (-(glm::vec3(constraintStress) + row.bias) * row.inverseConstraintMass);
+
+		if (bodyA.physics) { bodyA.torque += angularImpulse; }
+		if (bodyB.physics) { bodyB.torque -= angularImpulse; }
 	}
-}
\ No newline at end of file
+}
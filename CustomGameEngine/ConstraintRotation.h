@@ -8,7 +8,13 @@ namespace Engine {
 			controlXRotation(controlXRotation), controlYRotation(controlYRotation), controlZRotation(controlZRotation), maxRotationOffset(maxRotationOffset) {}
 		~ConstraintRotation() {}
 
-		void UpdateConstraint(EntityManager& ecs, const float deltaTime) const override;
+		ConstraintType Type() const override { return CONSTRAINT_ROTATION; }
+
+		// Fill in the row for this step from the bodies' current orientations. Returns false if there is nothing to solve
+		bool PreStep(const ConstraintBody& bodyA, const ConstraintBody& bodyB, const float deltaTime, RotationConstraintRow& out_row) const;
+
+		// Apply one iteration of a pre-stepped row, the result is accumulated as torque on both bodies
+		static void Solve(const RotationConstraintRow& row, ConstraintBody& bodyA, ConstraintBody& bodyB);
 
 		bool ControlXRotation() const { return controlXRotation; }
 		bool ControlYRotation() const { return controlYRotation; }
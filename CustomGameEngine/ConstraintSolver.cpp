@@ -1,23 +1,185 @@
 #include "ConstraintSolver.h"
+#include "ThreadPool.h"
 #include "Scene.h"
+#include <bit>
 namespace Engine {
 	void ConstraintSolver::Run(EntityManager& ecs)
 	{
 		SCOPE_TIMER("ConstraintSolver::Run");
-		const std::vector<Constraint*>& constraints = constraintManager->GetConstraints();
 		float dividedDeltaTime = Scene::dt / float(numIterations);
 
+		PreStep(ecs, dividedDeltaTime);
+		if (positionRows.empty() && rotationRows.empty()) { return; }
+
 		for (int i = 0; i < numIterations; i++) {
-			for (const Constraint* c : constraints) {
-				if (c->IsActive()) {
-					c->UpdateConstraint(ecs, dividedDeltaTime);
-				}
+			for (unsigned int color = 0; color < numColors; color++) {
+				SolveColor(color);
 			}
 		}
+
+		WriteBack();
 	}
 
 	void ConstraintSolver::AfterAction()
 	{
 
 	}
-}
\ No newline at end of file
+
+	unsigned int ConstraintSolver::GetConstraintBody(EntityManager& ecs, const unsigned int entityID)
+	{
+		std::unordered_map<unsigned int, unsigned int>::iterator it = entityToBody.find(entityID);
+		if (it != entityToBody.end()) {
+			return it->second;
+		}
+
+		ConstraintBody body;
+		body.transform = ecs.GetComponent<ComponentTransform>(entityID);
+		body.physics = ecs.GetComponent<ComponentPhysics>(entityID);
+
+		body.inverseMass = body.physics ? body.physics->InverseMass() : 0.0f;
+		body.inverseInertia = body.physics ? body.physics->InverseInertiaTensor() : glm::mat3(0.0f);
+		body.linearVelocity = body.physics ? body.physics->Velocity() : glm::vec3(0.0f);
+		body.angularVelocity = body.physics ? body.physics->AngularVelocity() : glm::vec3(0.0f);
+		body.torque = glm::vec3(0.0f);
+
+		const unsigned int index = bodies.size();
+		bodies.push_back(body);
+		bodyColorMasks.push_back(0ull);
+		entityToBody[entityID] = index;
+		return index;
+	}
+
+	void ConstraintSolver::PreStep(EntityManager& ecs, const float deltaTime)
+	{
+		bodies.clear();
+		entityToBody.clear();
+		bodyColorMasks.clear();
+		unsortedPositionRows.clear();
+		unsortedRotationRows.clear();
+		positionRowColors.clear();
+		rotationRowColors.clear();
+		positionRows.clear();
+		rotationRows.clear();
+		numColors = 0;
+
+		for (const Constraint* c : constraintManager->GetConstraints()) {
+			if (!c->IsActive()) { continue; }
+
+			const unsigned int bodyA = GetConstraintBody(ecs, c->EntityIDA());
+			const unsigned int bodyB = GetConstraintBody(ecs, c->EntityIDB());
+			const ConstraintBody& a = bodies[bodyA];
+			const ConstraintBody& b = bodies[bodyB];
+			if (!a.transform || !b.transform) { continue; }
+
+			// Constraints with no awake body attached are left alone so they don't keep nudging sleeping islands
+			if (!(a.physics && !a.physics->IsAsleep()) && !(b.physics && !b.physics->IsAsleep())) { continue; }
+
+			switch (c->Type()) {
+			case CONSTRAINT_POSITION: {
+				PositionConstraintRow row;
+				if (static_cast<const ConstraintPosition*>(c)->PreStep(a, b, deltaTime, row)) {
+					row.bodyA = bodyA;
+					row.bodyB = bodyB;
+					unsortedPositionRows.push_back(row);
+					positionRowColors.push_back(ColorRow(bodyA, bodyB));
+				}
+				break;
+			}
+			case CONSTRAINT_ROTATION: {
+				RotationConstraintRow row;
+				if (static_cast<const ConstraintRotation*>(c)->PreStep(a, b, deltaTime, row)) {
+					row.bodyA = bodyA;
+					row.bodyB = bodyB;
+					unsortedRotationRows.push_back(row);
+					rotationRowColors.push_back(ColorRow(bodyA, bodyB));
+				}
+				break;
+			}
+			}
+		}
+
+		SortRowsByColor();
+	}
+
+	unsigned int ConstraintSolver::ColorRow(const unsigned int bodyA, const unsigned int bodyB)
+	{
+		// Only bodies with physics are written to by a row, anything else can be shared freely between rows of one colour
+		const bool writesA = bodies[bodyA].physics != nullptr;
+		const bool writesB = bodies[bodyB].physics != nullptr;
+		const unsigned long long used = (writesA ? bodyColorMasks[bodyA] : 0ull) | (writesB ? bodyColorMasks[bodyB] : 0ull);
+
+		// Lowest colour neither body has been given yet
+		const unsigned int color = (unsigned int)std::countr_zero(~used);
+		if (color >= MAX_PARALLEL_COLORS) {
+			numColors = MAX_PARALLEL_COLORS + 1;
+			return MAX_PARALLEL_COLORS;
+		}
+
+		if (writesA) { bodyColorMasks[bodyA] |= (1ull << color); }
+		if (writesB) { bodyColorMasks[bodyB] |= (1ull << color); }
+		numColors = std::max(numColors, color + 1);
+		return color;
+	}
+
+	void ConstraintSolver::SortRowsByColor()
+	{
+		// Counting sort keeps rows of the same colour in constraint order, so the result doesn't depend on thread count
+		positionColorStart.assign(numColors + 1, 0);
+		rotationColorStart.assign(numColors + 1, 0);
+		for (const unsigned int color : positionRowColors) { positionColorStart[color + 1]++; }
+		for (const unsigned int color : rotationRowColors) { rotationColorStart[color + 1]++; }
+		for (unsigned int color = 0; color < numColors; color++) {
+			positionColorStart[color + 1] += positionColorStart[color];
+			rotationColorStart[color + 1] += rotationColorStart[color];
+		}
+
+		std::vector<unsigned int> positionNext(positionColorStart.begin(), positionColorStart.end() - 1);
+		std::vector<unsigned int> rotationNext(rotationColorStart.begin(), rotationColorStart.end() - 1);
+
+		positionRows.resize(unsortedPositionRows.size());
+		for (unsigned int i = 0; i < unsortedPositionRows.size(); i++) {
+			positionRows[positionNext[positionRowColors[i]]++] = unsortedPositionRows[i];
+		}
+		rotationRows.resize(unsortedRotationRows.size());
+		for (unsigned int i = 0; i < unsortedRotationRows.size(); i++) {
+			rotationRows[rotationNext[rotationRowColors[i]]++] = unsortedRotationRows[i];
+		}
+	}
+
+	void ConstraintSolver::SolveColor(const unsigned int color)
+	{
+		// The overflow colour may contain rows sharing a body, so it is never split across threads
+		const bool singleThreaded = color == MAX_PARALLEL_COLORS;
+
+		const unsigned int positionBegin = positionColorStart[color];
+		ThreadPool::GetInstance()->ParallelFor(positionColorStart[color + 1] - positionBegin, ROWS_PER_CHUNK, [this, positionBegin](const unsigned int chunkIndex, const unsigned int begin, const unsigned int end) {
+			for (unsigned int i = positionBegin + begin; i < positionBegin + end; i++) {
+				const PositionConstraintRow& row = positionRows[i];
+				ConstraintPosition::Solve(row, bodies[row.bodyA], bodies[row.bodyB]);
+			}
+		}, singleThreaded);
+
+		const unsigned int rotationBegin = rotationColorStart[color];
+		ThreadPool::GetInstance()->ParallelFor(rotationColorStart[color + 1] - rotationBegin, ROWS_PER_CHUNK, [this, rotationBegin](const unsigned int chunkIndex, const unsigned int begin, const unsigned int end) {
+			for (unsigned int i = rotationBegin + begin; i < rotationBegin + end; i++) {
+				const RotationConstraintRow& row = rotationRows[i];
+				ConstraintRotation::Solve(row, bodies[row.bodyA], bodies[row.bodyB]);
+			}
+		}, singleThreaded);
+	}
+
+	void ConstraintSolver::WriteBack()
+	{
+		for (const ConstraintBody& body : bodies) {
+			if (!body.physics) { continue; }
+
+			body.physics->SetVelocity(body.linearVelocity);
+			body.physics->SetAngularVelocity(body.angularVelocity);
+
+			// Torque is integrated with the rest of the body's forces this step
+			if (body.torque != glm::vec3(0.0f)) {
+				body.physics->AddTorque(body.torque);
+			}
+		}
+	}
+}
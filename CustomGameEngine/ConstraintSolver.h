@@ -1,11 +1,17 @@
 #pragma once
 #include "ConstraintManager.h"
+#include "ConstraintPosition.h"
+#include "ConstraintRotation.h"
 #include "EntityManager.h"
+#include <unordered_map>
 namespace Engine {
+	// Iterative solver for every active constraint with at least one awake body
+	// Each step the constraints are pre-stepped into contiguous per type rows that reference bodies by index, then coloured so that no two rows of the same colour share a body with physics.
+	// Rows within a colour are independent and are solved in parallel, colours are solved one after another every iteration
 	class ConstraintSolver
 	{
 	public:
-		ConstraintSolver(ConstraintManager* constraintManager, const int numIterations = 4) : constraintManager(constraintManager), numIterations(numIterations) {}
+		ConstraintSolver(ConstraintManager* constraintManager, const int numIterations = 4) : constraintManager(constraintManager), numIterations(numIterations), numColors(0) {}
 		~ConstraintSolver() {}
 
 		void Run(EntityManager& ecs);
@@ -13,8 +19,40 @@ namespace Engine {
 
 		void SetNumberOfIterations(const int newIterations) { numIterations = newIterations; }
 		int NumberOfIterations() const { return numIterations; }
+
+		unsigned int NumSolvedConstraints() const { return positionRows.size() + rotationRows.size(); }
+		unsigned int NumColors() const { return numColors; }
+
 	private:
+		// Rows that can't be given one of the first MAX_PARALLEL_COLORS colours end up in one final colour which is solved on a single thread
+		static constexpr unsigned int MAX_PARALLEL_COLORS = 64;
+		static constexpr unsigned int ROWS_PER_CHUNK = 64;
+
+		unsigned int GetConstraintBody(EntityManager& ecs, const unsigned int entityID);
+		void PreStep(EntityManager& ecs, const float deltaTime);
+		unsigned int ColorRow(const unsigned int bodyA, const unsigned int bodyB);
+		void SortRowsByColor();
+		void SolveColor(const unsigned int color);
+		void WriteBack();
+
 		ConstraintManager* constraintManager;
+
+		std::vector<ConstraintBody> bodies;
+		std::unordered_map<unsigned int, unsigned int> entityToBody;
+		std::vector<unsigned long long> bodyColorMasks;
+
+		// Rows in constraint order while colouring, then sorted so each colour is a contiguous range
+		std::vector<PositionConstraintRow> unsortedPositionRows;
+		std::vector<RotationConstraintRow> unsortedRotationRows;
+		std::vector<unsigned int> positionRowColors;
+		std::vector<unsigned int> rotationRowColors;
+
+		std::vector<PositionConstraintRow> positionRows;
+		std::vector<RotationConstraintRow> rotationRows;
+		std::vector<unsigned int> positionColorStart; // rows of colour c are [start[c], start[c + 1])
+		std::vector<unsigned int> rotationColorStart;
+
 		int numIterations;
+		unsigned int numColors;
 	};
-}
\ No newline at end of file
+}
@@ -0,0 +1,110 @@
+#include "ContactCache.h"
+#include "PairKey.h"
+#include <glm/gtx/norm.hpp>
+#include "ScopeTimer.h"
+namespace Engine {
+	void ContactCache::BeginFrame()
+	{
+		currentFrame++;
+		warmStartedContacts = 0;
+	}
+
+	void ContactCache::Match(CollisionData& collision)
+	{
+		const unsigned long long key = MakePairKey(collision.entityIDA, collision.entityIDB);
+		std::unordered_map<unsigned long long, unsigned int>::iterator it = pairToManifold.find(key);
+
+		if (it == pairToManifold.end()) { return; }
+
+		const CachedManifold& manifold = manifolds[it->second];
+
+		// A pair may be reported in the opposite order to last frame depending on which system found it
+		const bool swapped = (manifold.entityIDA != collision.entityIDA);
+
+		for (ContactPoint& contact : collision.contactPoints) {
+			const ContactPoint* match = FindMatchingContact(manifold, contact, swapped);
+			if (match) {
+				contact.sumImpulseContact = match->sumImpulseContact;
+				contact.sumImpulseFriction = swapped ? -match->sumImpulseFriction : match->sumImpulseFriction;
+				warmStartedContacts++;
+			}
+		}
+	}
+
+	void ContactCache::Store(const CollisionData& collision)
+	{
+		const unsigned long long key = MakePairKey(collision.entityIDA, collision.entityIDB);
+		std::unordered_map<unsigned long long, unsigned int>::iterator it = pairToManifold.find(key);
+
+		if (it == pairToManifold.end()) {
+			pairToManifold[key] = manifolds.size();
+			manifolds.push_back(CachedManifold());
+			it = pairToManifold.find(key);
+		}
+
+		CachedManifold& manifold = manifolds[it->second];
+		manifold.entityIDA = collision.entityIDA;
+		manifold.entityIDB = collision.entityIDB;
+		manifold.lastFrameTouched = currentFrame;
+		manifold.contactPoints = collision.contactPoints;
+	}
+
+	void ContactCache::EndFrame()
+	{
+		SCOPE_TIMER("ContactCache::EndFrame()");
+		unsigned int i = 0;
+		while (i < manifolds.size()) {
+			if (manifolds[i].lastFrameTouched != currentFrame) {
+				RemoveManifold(i);
+			}
+			else {
+				i++;
+			}
+		}
+	}
+
+	void ContactCache::Clear()
+	{
+		manifolds.clear();
+		pairToManifold.clear();
+	}
+
+	const ContactPoint* ContactCache::FindMatchingContact(const CachedManifold& manifold, const ContactPoint& contact, const bool swapped) const
+	{
+		// Feature IDs are generated from the reference / incident faces, so they are only comparable when the pair order matches
+		if (!swapped && contact.featureID != 0) {
+			for (const ContactPoint& cached : manifold.contactPoints) {
+				if (cached.featureID == contact.featureID) {
+					return &cached;
+				}
+			}
+		}
+
+		// Fall back to closest cached contact within match distance
+		const ContactPoint* closest = nullptr;
+		float closestDistanceSqr = matchDistanceSqr;
+		for (const ContactPoint& cached : manifold.contactPoints) {
+			const glm::vec3& cachedPointA = swapped ? cached.contactPointB : cached.contactPointA;
+			const float distanceSqr = glm::distance2(cachedPointA, contact.contactPointA);
+			if (distanceSqr <= closestDistanceSqr) {
+				closestDistanceSqr = distanceSqr;
+				closest = &cached;
+			}
+		}
+
+		return closest;
+	}
+
+	void ContactCache::RemoveManifold(const unsigned int index)
+	{
+		const unsigned int lastIndex = manifolds.size() - 1;
+		pairToManifold.erase(MakePairKey(manifolds[index].entityIDA, manifolds[index].entityIDB));
+
+		// Swap with last manifold and pop
+		if (index != lastIndex) {
+			manifolds[index] = std::move(manifolds[lastIndex]);
+			pairToManifold[MakePairKey(manifolds[index].entityIDA, manifolds[index].entityIDB)] = index;
+		}
+		manifolds.pop_back();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+#include "CollisionManager.h"
+#include <unordered_map>
+namespace Engine {
+	struct CachedManifold {
+		unsigned int entityIDA;
+		unsigned int entityIDB;
+		unsigned int lastFrameTouched;
+		std::vector<ContactPoint> contactPoints;
+	};
+
+	// Persistent store of last frame's contact manifolds, keyed by entity pair
+	// New contacts are matched against cached contacts by feature ID (falling back to proximity) so that accumulated impulses can be carried across frames
+	// Begin, stay and end events for gameplay come from CollisionManager::GetCollisionEvents, the cache only follows pairs that reach the solver
+	class ContactCache
+	{
+	public:
+		ContactCache(const float matchDistance = 0.05f) : currentFrame(0), warmStartedContacts(0), matchDistanceSqr(matchDistance * matchDistance) {}
+		~ContactCache() {}
+
+		// Start a new frame of contacts
+		void BeginFrame();
+
+		// Find last frame's manifold for this pair and copy accumulated impulses onto matching contacts
+		void Match(CollisionData& collision);
+
+		// Write the solved contact points back into the cache
+		void Store(const CollisionData& collision);
+
+		// Evict every pair that wasn't touched this frame
+		void EndFrame();
+
+		void Clear();
+
+		unsigned int NumCachedPairs() const { return manifolds.size(); }
+		unsigned int NumWarmStartedContacts() const { return warmStartedContacts; }
+
+		float MatchDistance() const { return sqrt(matchDistanceSqr); }
+		void SetMatchDistance(const float newDistance) { matchDistanceSqr = newDistance * newDistance; }
+
+	private:
+		const ContactPoint* FindMatchingContact(const CachedManifold& manifold, const ContactPoint& contact, const bool swapped) const;
+		void RemoveManifold(const unsigned int index);
+
+		std::vector<CachedManifold> manifolds;
+		std::unordered_map<unsigned long long, unsigned int> pairToManifold;
+
+		unsigned int currentFrame;
+		unsigned int warmStartedContacts;
+		float matchDistanceSqr;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,355 @@
+#include "ConvexHull.h"
+#include "ScopeTimer.h"
+#include <algorithm>
+#include <cfloat>
+#include <cstdint>
+#include <unordered_map>
+#include <glm/glm.hpp>
+#include <glm/gtx/norm.hpp>
+namespace Engine {
+	namespace {
+		// Face of the hull while it is being built, with the points still outside it
+		struct BuildFace {
+			unsigned int vertices[3];
+			glm::vec3 normal;
+			float distance;
+			std::vector<unsigned int> outside;
+			unsigned int furthest;
+			float furthestDistance;
+			bool alive;
+		};
+
+		uint64_t EdgeKey(const unsigned int from, const unsigned int to) {
+			return ((uint64_t)from << 32) | to;
+		}
+	}
+
+	bool ConvexHull::Build(const std::vector<glm::vec3>& points, const unsigned int maxVertices)
+	{
+		SCOPE_TIMER("ConvexHull::Build()");
+		vertices.clear();
+		faces.clear();
+		adjacencyStart.clear();
+		adjacency.clear();
+		boundsMin = glm::vec3(0.0f);
+		boundsMax = glm::vec3(0.0f);
+		if (points.size() < 4) { return false; }
+
+		// Extreme points along each axis seed the initial tetrahedron
+		unsigned int extremes[6] = { 0, 0, 0, 0, 0, 0 };
+		for (unsigned int i = 1; i < points.size(); i++) {
+			for (int axis = 0; axis < 3; axis++) {
+				if (points[i][axis] < points[extremes[axis * 2]][axis]) { extremes[axis * 2] = i; }
+				if (points[i][axis] > points[extremes[axis * 2 + 1]][axis]) { extremes[axis * 2 + 1] = i; }
+			}
+		}
+
+		// Tolerance scales with the size of the input so large and small models behave the same
+		const glm::vec3 size = glm::vec3(points[extremes[1]].x - points[extremes[0]].x, points[extremes[3]].y - points[extremes[2]].y, points[extremes[5]].z - points[extremes[4]].z);
+		const float epsilon = 1e-5f * (size.x + size.y + size.z);
+		if (epsilon <= 0.0f) { return false; }
+
+		unsigned int initial[4] = { extremes[0], extremes[1], 0, 0 };
+		float best = -1.0f;
+		for (unsigned int i = 0; i < 6; i++) {
+			for (unsigned int j = i + 1; j < 6; j++) {
+				const float distanceSqr = glm::distance2(points[extremes[i]], points[extremes[j]]);
+				if (distanceSqr > best) {
+					best = distanceSqr;
+					initial[0] = extremes[i];
+					initial[1] = extremes[j];
+				}
+			}
+		}
+
+		// Furthest from the line through the first two, then furthest from the plane through all three
+		const glm::vec3 lineDirection = glm::normalize(points[initial[1]] - points[initial[0]]);
+		best = -1.0f;
+		for (unsigned int i = 0; i < points.size(); i++) {
+			const float distanceSqr = glm::length2(glm::cross(points[i] - points[initial[0]], lineDirection));
+			if (distanceSqr > best) {
+				best = distanceSqr;
+				initial[2] = i;
+			}
+		}
+		if (glm::sqrt(best) < epsilon) { return false; }
+
+		const glm::vec3 planeNormal = glm::normalize(glm::cross(points[initial[1]] - points[initial[0]], points[initial[2]] - points[initial[0]]));
+		best = -1.0f;
+		for (unsigned int i = 0; i < points.size(); i++) {
+			const float distance = fabs(glm::dot(points[i] - points[initial[0]], planeNormal));
+			if (distance > best) {
+				best = distance;
+				initial[3] = i;
+			}
+		}
+		if (best < epsilon) { return false; }
+
+		std::vector<BuildFace> buildFaces;
+		std::unordered_map<uint64_t, unsigned int> edgeFaces; // directed edge to the face it belongs to
+
+		auto addFace = [&](const unsigned int a, const unsigned int b, const unsigned int c) {
+			BuildFace face;
+			face.vertices[0] = a;
+			face.vertices[1] = b;
+			face.vertices[2] = c;
+			face.normal = glm::cross(points[b] - points[a], points[c] - points[a]);
+			const float length = glm::length(face.normal);
+			face.normal = (length > 1e-20f) ? face.normal / length : glm::vec3(0.0f);
+			face.distance = glm::dot(face.normal, points[a]);
+			face.furthest = 0;
+			face.furthestDistance = 0.0f;
+			face.alive = true;
+
+			const unsigned int index = buildFaces.size();
+			edgeFaces[EdgeKey(a, b)] = index;
+			edgeFaces[EdgeKey(b, c)] = index;
+			edgeFaces[EdgeKey(c, a)] = index;
+			buildFaces.push_back(std::move(face));
+			return index;
+		};
+
+		// Points are given to the first face they are in front of
+		auto assignPoint = [&](const unsigned int point, const unsigned int firstFace) {
+			for (unsigned int f = firstFace; f < buildFaces.size(); f++) {
+				BuildFace& face = buildFaces[f];
+				if (!face.alive) { continue; }
+				const float distance = glm::dot(face.normal, points[point]) - face.distance;
+				if (distance > epsilon) {
+					face.outside.push_back(point);
+					if (distance > face.furthestDistance) {
+						face.furthestDistance = distance;
+						face.furthest = point;
+					}
+					return;
+				}
+			}
+		};
+
+		// Tetrahedron wound so every face points away from the fourth vertex
+		const glm::vec3 centroid = (points[initial[0]] + points[initial[1]] + points[initial[2]] + points[initial[3]]) * 0.25f;
+		const unsigned int tetrahedron[4][3] = { { initial[0], initial[1], initial[2] }, { initial[0], initial[1], initial[3] }, { initial[0], initial[2], initial[3] }, { initial[1], initial[2], initial[3] } };
+		for (const unsigned int* face : tetrahedron) {
+			const glm::vec3 normal = glm::cross(points[face[1]] - points[face[0]], points[face[2]] - points[face[0]]);
+			if (glm::dot(normal, centroid - points[face[0]]) > 0.0f) { addFace(face[0], face[2], face[1]); }
+			else { addFace(face[0], face[1], face[2]); }
+		}
+
+		for (unsigned int i = 0; i < points.size(); i++) {
+			if (i == initial[0] || i == initial[1] || i == initial[2] || i == initial[3]) { continue; }
+			assignPoint(i, 0);
+		}
+
+		std::vector<unsigned char> faceState; // 0 unvisited, 1 visible, 2 facing away
+		std::vector<unsigned int> visible;
+		std::vector<uint64_t> horizon;
+		std::vector<unsigned int> orphans;
+
+		unsigned int numAdded = 4;
+		while (numAdded < maxVertices) {
+			// The furthest outside point anywhere adds the most volume, which matters when the vertex limit stops the build early
+			unsigned int eyeFace = buildFaces.size();
+			float eyeDistance = 0.0f;
+			for (unsigned int f = 0; f < buildFaces.size(); f++) {
+				if (buildFaces[f].alive && buildFaces[f].outside.size() > 0 && buildFaces[f].furthestDistance > eyeDistance) {
+					eyeDistance = buildFaces[f].furthestDistance;
+					eyeFace = f;
+				}
+			}
+			if (eyeFace == buildFaces.size()) { break; }
+
+			const unsigned int eye = buildFaces[eyeFace].furthest;
+			const glm::vec3& eyePoint = points[eye];
+
+			// Flood out from the eye's face over every face the eye can see, the edges where that stops form the horizon
+			faceState.assign(buildFaces.size(), 0);
+			visible.clear();
+			horizon.clear();
+			visible.push_back(eyeFace);
+			faceState[eyeFace] = 1;
+			for (unsigned int v = 0; v < visible.size(); v++) {
+				const BuildFace& face = buildFaces[visible[v]];
+				for (unsigned int e = 0; e < 3; e++) {
+					const unsigned int from = face.vertices[e];
+					const unsigned int to = face.vertices[(e + 1) % 3];
+					const std::unordered_map<uint64_t, unsigned int>::const_iterator twin = edgeFaces.find(EdgeKey(to, from));
+					if (twin == edgeFaces.end()) { continue; }
+					const unsigned int neighbour = twin->second;
+
+					if (faceState[neighbour] == 0) {
+						const BuildFace& other = buildFaces[neighbour];
+						faceState[neighbour] = (glm::dot(other.normal, eyePoint) - other.distance > epsilon) ? 1 : 2;
+						if (faceState[neighbour] == 1) { visible.push_back(neighbour); }
+					}
+					if (faceState[neighbour] == 2) { horizon.push_back(EdgeKey(from, to)); }
+				}
+			}
+
+			orphans.clear();
+			for (const unsigned int f : visible) {
+				BuildFace& face = buildFaces[f];
+				for (const unsigned int point : face.outside) {
+					if (point != eye) { orphans.push_back(point); }
+				}
+				face.outside.clear();
+				face.outside.shrink_to_fit();
+				face.alive = false;
+				for (unsigned int e = 0; e < 3; e++) {
+					edgeFaces.erase(EdgeKey(face.vertices[e], face.vertices[(e + 1) % 3]));
+				}
+			}
+
+			// A fan from the eye to the horizon keeps the winding of the faces it replaces
+			const unsigned int firstNewFace = buildFaces.size();
+			for (const uint64_t edge : horizon) {
+				addFace((unsigned int)(edge >> 32), (unsigned int)(edge & 0xFFFFFFFFu), eye);
+			}
+			for (const unsigned int point : orphans) {
+				assignPoint(point, firstNewFace);
+			}
+
+			numAdded++;
+		}
+
+		// Adding points can leave earlier ones inside the hull, only vertices still used by a face are kept
+		std::vector<unsigned int> remap(points.size(), UINT32_MAX);
+		for (const BuildFace& buildFace : buildFaces) {
+			if (!buildFace.alive) { continue; }
+			Face face;
+			for (unsigned int i = 0; i < 3; i++) {
+				const unsigned int point = buildFace.vertices[i];
+				if (remap[point] == UINT32_MAX) {
+					remap[point] = vertices.size();
+					vertices.push_back(points[point]);
+				}
+				face.vertices[i] = remap[point];
+			}
+			face.normal = buildFace.normal;
+			face.distance = buildFace.distance;
+			faces.push_back(face);
+		}
+
+		boundsMin = vertices[0];
+		boundsMax = vertices[0];
+		for (const glm::vec3& vertex : vertices) {
+			boundsMin = glm::min(boundsMin, vertex);
+			boundsMax = glm::max(boundsMax, vertex);
+		}
+
+		BuildAdjacency();
+		return true;
+	}
+
+	void ConvexHull::BuildAdjacency()
+	{
+		// Every undirected edge once, as (lower, higher)
+		std::vector<uint64_t> edges;
+		edges.reserve(faces.size() * 3);
+		for (const Face& face : faces) {
+			for (unsigned int e = 0; e < 3; e++) {
+				const unsigned int a = face.vertices[e];
+				const unsigned int b = face.vertices[(e + 1) % 3];
+				edges.push_back(EdgeKey(std::min(a, b), std::max(a, b)));
+			}
+		}
+		std::sort(edges.begin(), edges.end());
+		edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+		adjacencyStart.assign(vertices.size() + 1, 0);
+		for (const uint64_t edge : edges) {
+			adjacencyStart[(edge >> 32) + 1]++;
+			adjacencyStart[(edge & 0xFFFFFFFFu) + 1]++;
+		}
+		for (unsigned int v = 0; v < vertices.size(); v++) {
+			adjacencyStart[v + 1] += adjacencyStart[v];
+		}
+
+		adjacency.resize(adjacencyStart.back());
+		std::vector<unsigned int> cursor(adjacencyStart.begin(), adjacencyStart.end() - 1);
+		for (const uint64_t edge : edges) {
+			const unsigned int a = (unsigned int)(edge >> 32);
+			const unsigned int b = (unsigned int)(edge & 0xFFFFFFFFu);
+			adjacency[cursor[a]++] = b;
+			adjacency[cursor[b]++] = a;
+		}
+	}
+
+	unsigned int ConvexHull::Support(const glm::vec3& localDirection, const unsigned int startVertex) const
+	{
+		if (vertices.size() < HILL_CLIMB_MIN_VERTICES) {
+			unsigned int best = 0;
+			float bestDot = -FLT_MAX;
+			for (unsigned int v = 0; v < vertices.size(); v++) {
+				const float dot = glm::dot(vertices[v], localDirection);
+				if (dot > bestDot) {
+					bestDot = dot;
+					best = v;
+				}
+			}
+			return best;
+		}
+
+		// A vertex with no neighbour further along the direction is the furthest vertex of the whole hull
+		unsigned int current = (startVertex < vertices.size()) ? startVertex : 0;
+		float currentDot = glm::dot(vertices[current], localDirection);
+		while (true) {
+			unsigned int next = current;
+			for (unsigned int i = adjacencyStart[current]; i < adjacencyStart[current + 1]; i++) {
+				const float dot = glm::dot(vertices[adjacency[i]], localDirection);
+				if (dot > currentDot) {
+					currentDot = dot;
+					next = adjacency[i];
+				}
+			}
+			if (next == current) { return current; }
+			current = next;
+		}
+	}
+
+	bool ConvexHull::Cast(const glm::mat4& model, const glm::mat4& inverseModel, const glm::vec3& origin, const glm::vec3& direction, const float radius, const float maxDistance, float& out_distance, glm::vec3& out_normal, const bool reportInitialOverlap) const
+	{
+		if (faces.size() == 0) { return false; }
+
+		// Clip the ray against every face plane in world space, the hit is the last plane it enters through
+		const glm::mat3 normalMatrix = glm::transpose(glm::mat3(inverseModel));
+		float enter = 0.0f;
+		float exit = maxDistance;
+		bool entered = false;
+
+		for (const Face& face : faces) {
+			glm::vec3 normal = normalMatrix * face.normal;
+			const float length = glm::length(normal);
+			if (length < 1e-12f) { continue; }
+			normal /= length;
+
+			const glm::vec3 pointOnFace = glm::vec3(model * glm::vec4(vertices[face.vertices[0]], 1.0f));
+			const float offset = glm::dot(normal, origin - pointOnFace) - radius;
+			const float denominator = glm::dot(normal, direction);
+
+			if (fabs(denominator) < 1e-12f) {
+				if (offset > 0.0f) { return false; }
+				continue;
+			}
+
+			const float t = -offset / denominator;
+			if (denominator < 0.0f) {
+				if (t > enter) {
+					enter = t;
+					out_normal = normal;
+					entered = true;
+				}
+			}
+			else {
+				exit = std::min(exit, t);
+			}
+			if (enter > exit) { return false; }
+		}
+
+		if (!entered) {
+			if (!reportInitialOverlap) { return false; }
+			out_normal = -direction;
+		}
+		out_distance = enter;
+		return true;
+	}
+}
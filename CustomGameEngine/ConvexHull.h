@@ -0,0 +1,59 @@
+#pragma once
+#include <vector>
+#include <glm/ext/vector_float3.hpp>
+#include <glm/ext/matrix_float4x4.hpp>
+namespace Engine {
+	// Convex hull of a point cloud, used by convex colliders in place of several primitive colliders per prop
+	// Everything is stored in the source mesh's local space. Hulls are built once per model, see ResourceManager::LoadConvexHull
+	class ConvexHull
+	{
+	public:
+		static constexpr unsigned int DEFAULT_MAX_VERTICES = 32;
+
+		ConvexHull() : boundsMin(0.0f), boundsMax(0.0f) {}
+		~ConvexHull() {}
+
+		// Quickhull over the points, adding the furthest remaining point each step. Stops once maxVertices points have been added,
+		// which keeps the most extreme points and leaves a hull slightly inside the full one. Fails on flat or degenerate input
+		bool Build(const std::vector<glm::vec3>& points, const unsigned int maxVertices = DEFAULT_MAX_VERTICES);
+
+		struct Face {
+			unsigned int vertices[3]; // counter clockwise seen from outside
+			glm::vec3 normal;
+			float distance; // plane offset along the normal
+		};
+
+		unsigned int NumVertices() const { return vertices.size(); }
+		unsigned int NumFaces() const { return faces.size(); }
+		const std::vector<glm::vec3>& Vertices() const { return vertices; }
+		const std::vector<Face>& Faces() const { return faces; }
+
+		const glm::vec3& BoundsMin() const { return boundsMin; }
+		const glm::vec3& BoundsMax() const { return boundsMax; }
+
+		// Index of the vertex furthest along a local direction. Hill climbs over the vertex adjacency from startVertex,
+		// so passing the previous result makes repeated queries with slowly changing directions close to constant time
+		unsigned int Support(const glm::vec3& localDirection, const unsigned int startVertex = 0) const;
+
+		// Nearest hit of a ray (radius 0) or swept sphere against the hull under a model matrix, all in world space. The direction must be normalised
+		// Sphere casts use the faces pushed out by the radius, which slightly overestimates around edges and corners
+		// With reportInitialOverlap false, a cast starting inside the hull is not a hit
+		bool Cast(const glm::mat4& model, const glm::mat4& inverseModel, const glm::vec3& origin, const glm::vec3& direction, const float radius, const float maxDistance, float& out_distance, glm::vec3& out_normal, const bool reportInitialOverlap = true) const;
+
+	private:
+		// Small hulls are cheaper to scan than to walk
+		static constexpr unsigned int HILL_CLIMB_MIN_VERTICES = 12;
+
+		void BuildAdjacency();
+
+		std::vector<glm::vec3> vertices;
+		std::vector<Face> faces;
+
+		// Neighbours of vertex v are adjacency[adjacencyStart[v]] to adjacency[adjacencyStart[v + 1]]
+		std::vector<unsigned int> adjacencyStart;
+		std::vector<unsigned int> adjacency;
+
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+	};
+}
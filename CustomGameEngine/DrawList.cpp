@@ -0,0 +1,55 @@
+#include "DrawList.h"
+#include "ScopeTimer.h"
+#include <algorithm>
+#include <cstring>
+namespace Engine {
+	unsigned long long DrawList::MakeSortKey(const float distanceSquared, const unsigned int entityID)
+	{
+		// -0.0 and negative values can't come from a squared distance but would sort after everything else, so clamp them to 0
+		const float distance = (distanceSquared > 0.0f) ? distanceSquared : 0.0f;
+		unsigned int distanceBits;
+		std::memcpy(&distanceBits, &distance, sizeof(float));
+		return (static_cast<unsigned long long>(distanceBits) << 32) | entityID;
+	}
+
+	void DrawList::Sort()
+	{
+		SCOPE_TIMER("DrawList::Sort");
+		const unsigned int count = items.size();
+		// Meshes of one entity share a key, a stable sort keeps them in the order they were added just like the radix sort does
+		if (count < RADIX_SORT_MIN_ITEMS) {
+			std::stable_sort(items.begin(), items.end(), [](const DrawItem& a, const DrawItem& b) { return a.sortKey < b.sortKey; });
+			return;
+		}
+
+		// Histogram every digit in one read of the keys
+		unsigned int histograms[RADIX_PASSES][RADIX_BUCKETS] = {};
+		for (const DrawItem& item : items) {
+			for (unsigned int pass = 0; pass < RADIX_PASSES; pass++) {
+				histograms[pass][(item.sortKey >> (pass * RADIX_BITS)) & (RADIX_BUCKETS - 1)]++;
+			}
+		}
+
+		// Least significant digit first, each pass is stable so the order from earlier passes holds within a bucket
+		scratch.resize(count);
+		for (unsigned int pass = 0; pass < RADIX_PASSES; pass++) {
+			unsigned int* histogram = histograms[pass];
+			const unsigned int shift = pass * RADIX_BITS;
+
+			// A digit every key shares can't change the order, which skips most of the entity ID passes
+			if (histogram[(items[0].sortKey >> shift) & (RADIX_BUCKETS - 1)] == count) { continue; }
+
+			unsigned int offset = 0;
+			for (unsigned int bucket = 0; bucket < RADIX_BUCKETS; bucket++) {
+				const unsigned int bucketCount = histogram[bucket];
+				histogram[bucket] = offset;
+				offset += bucketCount;
+			}
+
+			for (const DrawItem& item : items) {
+				scratch[histogram[(item.sortKey >> shift) & (RADIX_BUCKETS - 1)]++] = item;
+			}
+			items.swap(scratch);
+		}
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <vector>
+namespace Engine {
+	class Mesh;
+
+	// Squared camera distance in the high 32 bits and entity ID in the low 32, so items sort near to far with ties always broken the same way
+	// Non negative floats order the same as their bit patterns, so the key sorts as a plain unsigned integer
+	struct DrawItem {
+		unsigned long long sortKey;
+		Mesh* mesh;
+		unsigned int entityID;
+		unsigned int lod; // level of detail of the mesh data to draw, 0 is full resolution
+	};
+
+	// Flat list of meshes to draw, appended to unordered and sorted once per frame by key with a radix sort
+	class DrawList
+	{
+	public:
+		DrawList() {}
+		~DrawList() {}
+
+		void Clear() { items.clear(); }
+		void Reserve(const unsigned int count) { items.reserve(count); scratch.reserve(count); }
+
+		void Add(Mesh* mesh, const unsigned int entityID, const float distanceSquared, const unsigned int lod = 0) { items.push_back({ MakeSortKey(distanceSquared, entityID), mesh, entityID, lod }); }
+
+		// Keeps an item's key from another list, appending in order to a sorted list keeps it sorted
+		void Add(const DrawItem& item) { items.push_back(item); }
+
+		void Sort();
+
+		unsigned int Size() const { return items.size(); }
+		bool IsEmpty() const { return items.empty(); }
+		const DrawItem& operator[](const unsigned int index) const { return items[index]; }
+		std::vector<DrawItem>::const_iterator begin() const { return items.begin(); }
+		std::vector<DrawItem>::const_iterator end() const { return items.end(); }
+
+		static unsigned long long MakeSortKey(const float distanceSquared, const unsigned int entityID);
+
+	private:
+		// Below this many items a comparison sort beats the radix passes' fixed cost
+		static constexpr unsigned int RADIX_SORT_MIN_ITEMS = 64;
+		static constexpr unsigned int RADIX_BITS = 8;
+		static constexpr unsigned int RADIX_BUCKETS = 1u << RADIX_BITS;
+		static constexpr unsigned int RADIX_PASSES = 64 / RADIX_BITS;
+
+		std::vector<DrawItem> items;
+		std::vector<DrawItem> scratch; // radix sort ping pong buffer, kept between frames to avoid reallocating
+	};
+}
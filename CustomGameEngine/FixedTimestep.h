@@ -0,0 +1,52 @@
+#pragma once
+#include <algorithm>
+namespace Engine {
+	// Accumulates frame time and hands it out in steps of a fixed size
+	// Anything left over after the last step carries into the next frame and is exposed as an interpolation factor
+	class FixedTimestep
+	{
+	public:
+		FixedTimestep(const float stepsPerSecond = 60.0f, const unsigned int maxSubsteps = 8) : stepSize(1.0f / stepsPerSecond), maxSubsteps(std::max(maxSubsteps, 1u)), accumulator(0.0f), droppedTime(0.0f) {}
+		~FixedTimestep() {}
+
+		// Add a frame's worth of time and return how many steps should be run this frame
+		// If more than maxSubsteps steps are owed the excess time is dropped, so a long frame can't cause an ever growing backlog
+		unsigned int Advance(const float frameDelta) {
+			accumulator += std::max(frameDelta, 0.0f);
+
+			unsigned int steps = (unsigned int)(accumulator / stepSize);
+			if (steps > maxSubsteps) {
+				const float excess = (float)(steps - maxSubsteps) * stepSize;
+				droppedTime += excess;
+				accumulator -= excess;
+				steps = maxSubsteps;
+			}
+			accumulator = std::max(accumulator - (float)steps * stepSize, 0.0f);
+			return steps;
+		}
+
+		void Reset() {
+			accumulator = 0.0f;
+			droppedTime = 0.0f;
+		}
+
+		void SetStepsPerSecond(const float stepsPerSecond) { stepSize = 1.0f / stepsPerSecond; }
+		float StepsPerSecond() const { return 1.0f / stepSize; }
+		float StepSize() const { return stepSize; }
+
+		void SetMaxSubsteps(const unsigned int newMax) { maxSubsteps = std::max(newMax, 1u); }
+		unsigned int MaxSubsteps() const { return maxSubsteps; }
+
+		// How far between the previous and current step the leftover time is, 0 to 1
+		float Alpha() const { return std::min(accumulator / stepSize, 1.0f); }
+
+		// Total simulation time thrown away by the substep clamp
+		float DroppedTime() const { return droppedTime; }
+
+	private:
+		float stepSize;
+		unsigned int maxSubsteps;
+		float accumulator;
+		float droppedTime;
+	};
+}
@@ -0,0 +1,482 @@
+#include "GJK.h"
+#include <algorithm>
+#include <cfloat>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtx/norm.hpp>
+namespace Engine {
+	namespace {
+		// Origins closer than this to a simplex feature count as lying on it
+		constexpr float SIMPLEX_EPSILON = 1e-6f;
+
+		// Tangent offset of the tilted normals used to find manifold corners, about six degrees
+		constexpr float MANIFOLD_TILT = 0.1f;
+
+		// Manifold points closer than this fraction of the smaller footprint are treated as the same corner
+		constexpr float MANIFOLD_MERGE_FRACTION = 0.02f;
+
+		// Manifold corners within this fraction of the deepest penetration count as equally deep
+		constexpr float MANIFOLD_DEPTH_TOLERANCE = 0.05f;
+
+		// Slack when testing whether a corner lies over the other shape's footprint
+		constexpr float FOOTPRINT_SLOP = 1e-4f;
+	}
+
+	glm::vec3 SphereSupport::Support(const glm::vec3& direction) const
+	{
+		const float length = glm::length(direction);
+		if (length < 1e-12f) { return centre + glm::vec3(radius, 0.0f, 0.0f); }
+		return centre + direction * (radius / length);
+	}
+
+	glm::vec3 BoxSupport::Support(const glm::vec3& direction) const
+	{
+		glm::vec3 point = centre;
+		for (int i = 0; i < 3; i++) {
+			point += (glm::dot(direction, halfAxes[i]) >= 0.0f) ? halfAxes[i] : -halfAxes[i];
+		}
+		return point;
+	}
+
+	glm::vec3 TriangleSupport::Support(const glm::vec3& direction) const
+	{
+		const float da = glm::dot(vertices[0], direction);
+		const float db = glm::dot(vertices[1], direction);
+		const float dc = glm::dot(vertices[2], direction);
+		if (da >= db && da >= dc) { return vertices[0]; }
+		return (db >= dc) ? vertices[1] : vertices[2];
+	}
+
+	glm::vec3 HullSupport::Support(const glm::vec3& direction) const
+	{
+		lastVertex = hull.Support(transposedLinear * direction, lastVertex);
+		return glm::vec3(model * glm::vec4(hull.Vertices()[lastVertex], 1.0f));
+	}
+
+	glm::vec3 HullSupport::Centre() const
+	{
+		return glm::vec3(model * glm::vec4((hull.BoundsMin() + hull.BoundsMax()) * 0.5f, 1.0f));
+	}
+
+	GJK::SupportPoint GJK::MinkowskiSupport(const ConvexSupport& a, const ConvexSupport& b, const glm::vec3& direction)
+	{
+		SupportPoint support;
+		support.a = a.Support(direction);
+		support.b = b.Support(-direction);
+		support.point = support.a - support.b;
+		return support;
+	}
+
+	bool GJK::Intersect(const ConvexSupport& a, const ConvexSupport& b)
+	{
+		Simplex simplex;
+		return RunGJK(a, b, simplex);
+	}
+
+	bool GJK::Penetration(const ConvexSupport& a, const ConvexSupport& b, ConvexContact& out_contact)
+	{
+		Simplex simplex;
+		if (!RunGJK(a, b, simplex)) { return false; }
+		if (!CompleteTetrahedron(a, b, simplex)) { return false; }
+		if (!EPA(a, b, simplex, out_contact)) { return false; }
+		return out_contact.depth > 0.0f;
+	}
+
+	bool GJK::RunGJK(const ConvexSupport& a, const ConvexSupport& b, Simplex& out_simplex)
+	{
+		glm::vec3 direction = a.Centre() - b.Centre();
+		if (glm::length2(direction) < 1e-12f) { direction = glm::vec3(1.0f, 0.0f, 0.0f); }
+
+		out_simplex.points[0] = MinkowskiSupport(a, b, direction);
+		out_simplex.size = 1;
+		direction = -out_simplex.points[0].point;
+
+		for (unsigned int iteration = 0; iteration < MAX_GJK_ITERATIONS; iteration++) {
+			// The origin is on the simplex itself, the shapes are touching
+			if (glm::length2(direction) < SIMPLEX_EPSILON * SIMPLEX_EPSILON) { return true; }
+
+			const SupportPoint next = MinkowskiSupport(a, b, direction);
+			if (glm::dot(next.point, direction) <= 0.0f) { return false; }
+
+			for (unsigned int i = out_simplex.size; i > 0; i--) {
+				out_simplex.points[i] = out_simplex.points[i - 1];
+			}
+			out_simplex.points[0] = next;
+			out_simplex.size++;
+
+			bool containsOrigin = false;
+			switch (out_simplex.size) {
+			case 2: containsOrigin = Line(out_simplex, direction); break;
+			case 3: containsOrigin = Triangle(out_simplex, direction); break;
+			case 4: containsOrigin = Tetrahedron(out_simplex, direction); break;
+			}
+			if (containsOrigin) { return true; }
+		}
+		return false;
+	}
+
+	bool GJK::Line(Simplex& simplex, glm::vec3& direction)
+	{
+		const glm::vec3 ab = simplex.points[1].point - simplex.points[0].point;
+		const glm::vec3 ao = -simplex.points[0].point;
+
+		if (glm::dot(ab, ao) > 0.0f) {
+			const glm::vec3 abo = glm::cross(ab, ao);
+			if (glm::length2(abo) <= SIMPLEX_EPSILON * SIMPLEX_EPSILON * glm::length2(ab)) { return true; }
+			direction = glm::cross(abo, ab);
+		}
+		else {
+			simplex.size = 1;
+			direction = ao;
+		}
+		return false;
+	}
+
+	bool GJK::Triangle(Simplex& simplex, glm::vec3& direction)
+	{
+		const SupportPoint a = simplex.points[0];
+		const SupportPoint b = simplex.points[1];
+		const SupportPoint c = simplex.points[2];
+		const glm::vec3 ab = b.point - a.point;
+		const glm::vec3 ac = c.point - a.point;
+		const glm::vec3 ao = -a.point;
+		const glm::vec3 abc = glm::cross(ab, ac);
+
+		if (glm::dot(glm::cross(abc, ac), ao) > 0.0f) {
+			if (glm::dot(ac, ao) > 0.0f) {
+				simplex.points[1] = c;
+				simplex.size = 2;
+				const glm::vec3 aco = glm::cross(ac, ao);
+				if (glm::length2(aco) <= SIMPLEX_EPSILON * SIMPLEX_EPSILON * glm::length2(ac)) { return true; }
+				direction = glm::cross(aco, ac);
+				return false;
+			}
+			simplex.size = 2;
+			return Line(simplex, direction);
+		}
+
+		if (glm::dot(glm::cross(ab, abc), ao) > 0.0f) {
+			simplex.size = 2;
+			return Line(simplex, direction);
+		}
+
+		const float side = glm::dot(abc, ao);
+		if (side * side <= SIMPLEX_EPSILON * SIMPLEX_EPSILON * glm::length2(abc)) { return true; }
+		if (side > 0.0f) {
+			direction = abc;
+		}
+		else {
+			simplex.points[1] = c;
+			simplex.points[2] = b;
+			direction = -abc;
+		}
+		return false;
+	}
+
+	bool GJK::Tetrahedron(Simplex& simplex, glm::vec3& direction)
+	{
+		const SupportPoint a = simplex.points[0];
+		const SupportPoint b = simplex.points[1];
+		const SupportPoint c = simplex.points[2];
+		const SupportPoint d = simplex.points[3];
+		const glm::vec3 ab = b.point - a.point;
+		const glm::vec3 ac = c.point - a.point;
+		const glm::vec3 ad = d.point - a.point;
+		const glm::vec3 ao = -a.point;
+
+		// The face opposite the newest point was already checked on the previous iteration
+		if (glm::dot(glm::cross(ab, ac), ao) > 0.0f) {
+			simplex.size = 3;
+			return Triangle(simplex, direction);
+		}
+		if (glm::dot(glm::cross(ac, ad), ao) > 0.0f) {
+			simplex.points[1] = c;
+			simplex.points[2] = d;
+			simplex.size = 3;
+			return Triangle(simplex, direction);
+		}
+		if (glm::dot(glm::cross(ad, ab), ao) > 0.0f) {
+			simplex.points[1] = d;
+			simplex.points[2] = b;
+			simplex.size = 3;
+			return Triangle(simplex, direction);
+		}
+		return true;
+	}
+
+	bool GJK::CompleteTetrahedron(const ConvexSupport& a, const ConvexSupport& b, Simplex& simplex)
+	{
+		if (simplex.size == 1) {
+			const glm::vec3 axes[6] = { glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f) };
+			for (const glm::vec3& axis : axes) {
+				const SupportPoint next = MinkowskiSupport(a, b, axis);
+				if (glm::distance2(next.point, simplex.points[0].point) > SIMPLEX_EPSILON * SIMPLEX_EPSILON) {
+					simplex.points[simplex.size++] = next;
+					break;
+				}
+			}
+			if (simplex.size < 2) { return false; }
+		}
+
+		if (simplex.size == 2) {
+			const glm::vec3 line = glm::normalize(simplex.points[1].point - simplex.points[0].point);
+			const glm::vec3 absolute = glm::abs(line);
+			const glm::vec3 axis = (absolute.x <= absolute.y && absolute.x <= absolute.z) ? glm::vec3(1.0f, 0.0f, 0.0f) : ((absolute.y <= absolute.z) ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(0.0f, 0.0f, 1.0f));
+			const glm::vec3 perpendicular = glm::normalize(glm::cross(line, axis));
+			const glm::vec3 directions[4] = { perpendicular, -perpendicular, glm::cross(line, perpendicular), -glm::cross(line, perpendicular) };
+			for (const glm::vec3& direction : directions) {
+				const SupportPoint next = MinkowskiSupport(a, b, direction);
+				if (glm::length2(glm::cross(next.point - simplex.points[0].point, line)) > SIMPLEX_EPSILON * SIMPLEX_EPSILON) {
+					simplex.points[simplex.size++] = next;
+					break;
+				}
+			}
+			if (simplex.size < 3) { return false; }
+		}
+
+		if (simplex.size == 3) {
+			const glm::vec3 normal = glm::normalize(glm::cross(simplex.points[1].point - simplex.points[0].point, simplex.points[2].point - simplex.points[0].point));
+			for (const glm::vec3& direction : { normal, -normal }) {
+				const SupportPoint next = MinkowskiSupport(a, b, direction);
+				if (fabs(glm::dot(next.point - simplex.points[0].point, normal)) > SIMPLEX_EPSILON) {
+					simplex.points[simplex.size++] = next;
+					break;
+				}
+			}
+			if (simplex.size < 4) { return false; }
+		}
+
+		// Flat tetrahedra give EPA no interior to expand from
+		const glm::vec3& origin = simplex.points[0].point;
+		const float volume = glm::dot(simplex.points[1].point - origin, glm::cross(simplex.points[2].point - origin, simplex.points[3].point - origin));
+		return fabs(volume) > SIMPLEX_EPSILON * SIMPLEX_EPSILON * SIMPLEX_EPSILON;
+	}
+
+	bool GJK::EPA(const ConvexSupport& a, const ConvexSupport& b, const Simplex& simplex, ConvexContact& out_contact)
+	{
+		struct Face {
+			unsigned int a, b, c;
+			glm::vec3 normal;
+			float distance;
+		};
+
+		std::vector<SupportPoint> polytope(simplex.points, simplex.points + 4);
+		std::vector<Face> faces;
+		faces.reserve(32);
+
+		// Degenerate faces get an infinite distance so they are never picked as the closest
+		auto makeFace = [&polytope](const unsigned int a, const unsigned int b, const unsigned int c) {
+			Face face = { a, b, c, glm::cross(polytope[b].point - polytope[a].point, polytope[c].point - polytope[a].point), FLT_MAX };
+			const float length = glm::length(face.normal);
+			if (length > 1e-12f) {
+				face.normal /= length;
+				face.distance = glm::dot(face.normal, polytope[a].point);
+			}
+			else {
+				face.normal = glm::vec3(0.0f);
+			}
+			return face;
+		};
+
+		// Tetrahedron faces wound away from the vertex opposite each
+		const unsigned int tetrahedron[4][4] = { { 0, 1, 2, 3 }, { 0, 1, 3, 2 }, { 0, 2, 3, 1 }, { 1, 2, 3, 0 } };
+		for (const unsigned int* face : tetrahedron) {
+			Face candidate = makeFace(face[0], face[1], face[2]);
+			if (glm::dot(candidate.normal, polytope[face[3]].point - polytope[face[0]].point) > 0.0f) {
+				candidate = makeFace(face[0], face[2], face[1]);
+			}
+			faces.push_back(candidate);
+		}
+
+		std::vector<std::pair<unsigned int, unsigned int>> horizon;
+		unsigned int closest = 0;
+		for (unsigned int iteration = 0; iteration < MAX_EPA_ITERATIONS; iteration++) {
+			closest = 0;
+			for (unsigned int f = 1; f < faces.size(); f++) {
+				if (faces[f].distance < faces[closest].distance) { closest = f; }
+			}
+			if (faces[closest].distance == FLT_MAX) { return false; }
+
+			// Done once the polytope can't be pushed any further towards the closest face
+			const SupportPoint next = MinkowskiSupport(a, b, faces[closest].normal);
+			if (glm::dot(next.point, faces[closest].normal) - faces[closest].distance < EPA_TOLERANCE) { break; }
+
+			// Remove every face the new point can see, keeping the edges that aren't shared between two removed faces
+			horizon.clear();
+			auto addEdge = [&horizon](const unsigned int from, const unsigned int to) {
+				for (unsigned int e = 0; e < horizon.size(); e++) {
+					if (horizon[e].first == to && horizon[e].second == from) {
+						horizon[e] = horizon.back();
+						horizon.pop_back();
+						return;
+					}
+				}
+				horizon.push_back({ from, to });
+			};
+
+			for (unsigned int f = faces.size(); f-- > 0;) {
+				if (glm::dot(faces[f].normal, next.point - polytope[faces[f].a].point) > 0.0f) {
+					addEdge(faces[f].a, faces[f].b);
+					addEdge(faces[f].b, faces[f].c);
+					addEdge(faces[f].c, faces[f].a);
+					faces[f] = faces.back();
+					faces.pop_back();
+				}
+			}
+
+			const unsigned int nextIndex = polytope.size();
+			polytope.push_back(next);
+			for (const std::pair<unsigned int, unsigned int>& edge : horizon) {
+				faces.push_back(makeFace(edge.first, edge.second, nextIndex));
+			}
+			if (faces.size() == 0) { return false; }
+		}
+
+		closest = 0;
+		for (unsigned int f = 1; f < faces.size(); f++) {
+			if (faces[f].distance < faces[closest].distance) { closest = f; }
+		}
+		const Face& face = faces[closest];
+		if (face.distance == FLT_MAX) { return false; }
+
+		// Barycentric coordinates of the origin's projection onto the closest face give the matching points on each shape
+		const glm::vec3 projection = face.normal * face.distance;
+		const glm::vec3 v0 = polytope[face.b].point - polytope[face.a].point;
+		const glm::vec3 v1 = polytope[face.c].point - polytope[face.a].point;
+		const glm::vec3 v2 = projection - polytope[face.a].point;
+		const float d00 = glm::dot(v0, v0);
+		const float d01 = glm::dot(v0, v1);
+		const float d11 = glm::dot(v1, v1);
+		const float d20 = glm::dot(v2, v0);
+		const float d21 = glm::dot(v2, v1);
+		const float denominator = d00 * d11 - d01 * d01;
+
+		float v = 0.0f;
+		float w = 0.0f;
+		if (fabs(denominator) > 1e-20f) {
+			v = (d11 * d20 - d01 * d21) / denominator;
+			w = (d00 * d21 - d01 * d20) / denominator;
+		}
+		const float u = 1.0f - v - w;
+
+		out_contact.normal = -face.normal;
+		out_contact.depth = face.distance;
+		out_contact.pointA = polytope[face.a].a * u + polytope[face.b].a * v + polytope[face.c].a * w;
+		out_contact.pointB = polytope[face.a].b * u + polytope[face.b].b * v + polytope[face.c].b * w;
+		return true;
+	}
+
+	unsigned int GJK::ContactManifold(const ConvexSupport& a, const ConvexSupport& b, const ConvexContact& deepest, ConvexContact out_contacts[MAX_MANIFOLD_CONTACTS])
+	{
+		out_contacts[0] = deepest;
+		if (!a.IsPolyhedral() || !b.IsPolyhedral()) { return 1; }
+
+		const glm::vec3& normal = deepest.normal;
+		const glm::vec3 tangent = glm::normalize(glm::cross(normal, (fabs(normal.x) < 0.57f) ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f)));
+		const glm::vec3 bitangent = glm::cross(normal, tangent);
+		const float diagonal = 0.70710678f;
+		const glm::vec3 directions[8] = {
+			(tangent + bitangent) * diagonal, (tangent - bitangent) * diagonal, (-tangent + bitangent) * diagonal, (-tangent - bitangent) * diagonal,
+			tangent, -tangent, bitangent, -bitangent
+		};
+
+		// Each shape's footprint on the contact plane, as its extent along each tangent direction
+		float extentA[8], extentB[8];
+		for (unsigned int i = 0; i < 8; i++) {
+			extentA[i] = glm::dot(a.Support(directions[i]), directions[i]);
+			extentB[i] = glm::dot(b.Support(directions[i]), directions[i]);
+		}
+		auto insideFootprint = [&directions](const glm::vec3& point, const float extent[8]) {
+			for (unsigned int i = 0; i < 8; i++) {
+				if (glm::dot(point, directions[i]) > extent[i] + FOOTPRINT_SLOP) { return false; }
+			}
+			return true;
+		};
+
+		const float widthA = std::max(extentA[4] + extentA[5], extentA[6] + extentA[7]);
+		const float widthB = std::max(extentB[4] + extentB[5], extentB[6] + extentB[7]);
+		const float mergeDistance = MANIFOLD_MERGE_FRACTION * std::min(widthA, widthB);
+
+		// Corners of A below B's contact plane and corners of B above A's, each only where it lies over the other shape
+		ConvexContact candidates[16];
+		unsigned int numCandidates = 0;
+		for (unsigned int i = 0; i < 8; i++) {
+			const glm::vec3 cornerA = a.Support(-normal + directions[i] * MANIFOLD_TILT);
+			const float depthA = glm::dot(deepest.pointB - cornerA, normal);
+			if (depthA > 0.0f && insideFootprint(cornerA + normal * depthA, extentB)) {
+				candidates[numCandidates++] = { normal, depthA, cornerA, cornerA + normal * depthA };
+			}
+
+			const glm::vec3 cornerB = b.Support(normal + directions[i] * MANIFOLD_TILT);
+			const float depthB = glm::dot(cornerB - deepest.pointA, normal);
+			if (depthB > 0.0f && insideFootprint(cornerB - normal * depthB, extentA)) {
+				candidates[numCandidates++] = { normal, depthB, cornerB - normal * depthB, cornerB };
+			}
+		}
+
+		// Distinct points only, measured on the contact plane. The deepest point from EPA is kept in the pool
+		auto planar = [&normal](const glm::vec3& offset) { return offset - normal * glm::dot(offset, normal); };
+		ConvexContact pool[17];
+		pool[0] = deepest;
+		unsigned int poolSize = 1;
+		for (unsigned int i = 0; i < numCandidates; i++) {
+			bool duplicate = false;
+			for (unsigned int j = 0; j < poolSize && !duplicate; j++) {
+				duplicate = glm::length(planar(candidates[i].pointA - pool[j].pointA)) <= mergeDistance;
+			}
+			if (!duplicate) { pool[poolSize++] = candidates[i]; }
+		}
+		if (poolSize == 1) { return 1; }
+
+		// Start from the deepest point. When faces rest on each other a corner as deep as the EPA point is preferred, as that point can be anywhere on the face
+		unsigned int first = 0;
+		float firstDepth = deepest.depth * (1.0f - MANIFOLD_DEPTH_TOLERANCE);
+		for (unsigned int i = 1; i < poolSize; i++) {
+			if (pool[i].depth > firstDepth) {
+				first = i;
+				firstDepth = pool[i].depth;
+			}
+		}
+
+		// Then whichever points spread the manifold the most
+		unsigned int count = 1;
+		bool used[17] = {};
+		used[first] = true;
+		out_contacts[0] = pool[first];
+		auto pick = [&](auto&& score) {
+			float bestScore = 0.0f;
+			unsigned int best = poolSize;
+			for (unsigned int i = 0; i < poolSize; i++) {
+				if (used[i]) { continue; }
+				const float candidateScore = score(pool[i].pointA);
+				if (candidateScore > bestScore) {
+					bestScore = candidateScore;
+					best = i;
+				}
+			}
+			if (best == poolSize) { return false; }
+			used[best] = true;
+			out_contacts[count++] = pool[best];
+			return true;
+		};
+
+		// Furthest from the first point
+		if (!pick([&](const glm::vec3& point) { return glm::length2(planar(point - out_contacts[0].pointA)); })) { return count; }
+
+		// Largest triangle with the first two
+		if (!pick([&](const glm::vec3& point) { return fabs(glm::dot(glm::cross(out_contacts[1].pointA - out_contacts[0].pointA, point - out_contacts[0].pointA), normal)); })) { return count; }
+
+		// Most area added outside that triangle
+		const glm::vec3 p0 = out_contacts[0].pointA;
+		const glm::vec3 p1 = out_contacts[1].pointA;
+		const glm::vec3 p2 = out_contacts[2].pointA;
+		const float winding = (glm::dot(glm::cross(p1 - p0, p2 - p0), normal) >= 0.0f) ? 1.0f : -1.0f;
+		pick([&](const glm::vec3& point) {
+			const float outside01 = -winding * glm::dot(glm::cross(p1 - p0, point - p0), normal);
+			const float outside12 = -winding * glm::dot(glm::cross(p2 - p1, point - p1), normal);
+			const float outside20 = -winding * glm::dot(glm::cross(p0 - p2, point - p2), normal);
+			return std::max(outside01, std::max(outside12, outside20));
+		});
+		return count;
+	}
+}
@@ -0,0 +1,130 @@
+#pragma once
+#include "ConvexHull.h"
+#include <glm/ext/vector_float3.hpp>
+#include <glm/ext/matrix_float3x3.hpp>
+#include <glm/ext/matrix_float4x4.hpp>
+namespace Engine {
+	// World space support mapping of a convex shape, the furthest point of the shape along a direction
+	class ConvexSupport
+	{
+	public:
+		virtual ~ConvexSupport() {}
+
+		virtual glm::vec3 Support(const glm::vec3& direction) const = 0;
+		virtual glm::vec3 Centre() const = 0;
+
+		// Curved shapes have no corners to build a contact manifold from
+		virtual bool IsPolyhedral() const { return true; }
+	};
+
+	class SphereSupport : public ConvexSupport
+	{
+	public:
+		SphereSupport(const glm::vec3& centre, const float radius) : centre(centre), radius(radius) {}
+
+		glm::vec3 Support(const glm::vec3& direction) const override;
+		glm::vec3 Centre() const override { return centre; }
+		bool IsPolyhedral() const override { return false; }
+
+	private:
+		glm::vec3 centre;
+		float radius;
+	};
+
+	// Box given by its centre and three half axes, each scaled by the box's half extent along it
+	class BoxSupport : public ConvexSupport
+	{
+	public:
+		BoxSupport(const glm::vec3& centre, const glm::vec3& halfAxisX, const glm::vec3& halfAxisY, const glm::vec3& halfAxisZ) : centre(centre), halfAxes{ halfAxisX, halfAxisY, halfAxisZ } {}
+
+		glm::vec3 Support(const glm::vec3& direction) const override;
+		glm::vec3 Centre() const override { return centre; }
+
+	private:
+		glm::vec3 centre;
+		glm::vec3 halfAxes[3];
+	};
+
+	class TriangleSupport : public ConvexSupport
+	{
+	public:
+		TriangleSupport(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) : vertices{ a, b, c } {}
+
+		glm::vec3 Support(const glm::vec3& direction) const override;
+		glm::vec3 Centre() const override { return (vertices[0] + vertices[1] + vertices[2]) / 3.0f; }
+
+	private:
+		glm::vec3 vertices[3];
+	};
+
+	// Hull under a model matrix. Each query starts hill climbing from the previous result, as GJK and EPA directions change gradually
+	// Keeps that state between calls, so an instance must not be shared between threads
+	class HullSupport : public ConvexSupport
+	{
+	public:
+		HullSupport(const ConvexHull& hull, const glm::mat4& model) : hull(hull), model(model), transposedLinear(glm::transpose(glm::mat3(model))), lastVertex(0) {}
+
+		glm::vec3 Support(const glm::vec3& direction) const override;
+		glm::vec3 Centre() const override;
+
+	private:
+		const ConvexHull& hull;
+		glm::mat4 model;
+		glm::mat3 transposedLinear; // takes world directions into local space without normalising
+		mutable unsigned int lastVertex;
+	};
+
+	// Deepest point of each shape inside the other. The normal points from B to A, moving A by normal * depth separates the shapes
+	struct ConvexContact {
+		glm::vec3 normal;
+		float depth;
+		glm::vec3 pointA;
+		glm::vec3 pointB;
+	};
+
+	// GJK overlap test and EPA penetration depth between any two convex shapes given as support mappings
+	class GJK
+	{
+	public:
+		static constexpr unsigned int MAX_MANIFOLD_CONTACTS = 4;
+
+		static bool Intersect(const ConvexSupport& a, const ConvexSupport& b);
+
+		// GJK then EPA. Returns false when the shapes are apart or only just touching
+		static bool Penetration(const ConvexSupport& a, const ConvexSupport& b, ConvexContact& out_contact);
+
+		// Extends a penetration result to a manifold of up to MAX_MANIFOLD_CONTACTS points, so a flat face resting on another doesn't rock
+		// Corners of either shape past the other's contact plane are found by querying the supports along normals tilted around the deepest one
+		// Pairs with a curved shape always touch at a single point and keep just the deepest contact. Returns the number of contacts written
+		static unsigned int ContactManifold(const ConvexSupport& a, const ConvexSupport& b, const ConvexContact& deepest, ConvexContact out_contacts[MAX_MANIFOLD_CONTACTS]);
+
+	private:
+		static constexpr unsigned int MAX_GJK_ITERATIONS = 64;
+		static constexpr unsigned int MAX_EPA_ITERATIONS = 64;
+		static constexpr float EPA_TOLERANCE = 1e-4f;
+
+		// Point of the Minkowski difference A - B along with the support points on each shape it came from
+		struct SupportPoint {
+			glm::vec3 point;
+			glm::vec3 a;
+			glm::vec3 b;
+		};
+
+		// Newest point first
+		struct Simplex {
+			SupportPoint points[4];
+			unsigned int size = 0;
+		};
+
+		static SupportPoint MinkowskiSupport(const ConvexSupport& a, const ConvexSupport& b, const glm::vec3& direction);
+
+		static bool RunGJK(const ConvexSupport& a, const ConvexSupport& b, Simplex& out_simplex);
+		static bool Line(Simplex& simplex, glm::vec3& direction);
+		static bool Triangle(Simplex& simplex, glm::vec3& direction);
+		static bool Tetrahedron(Simplex& simplex, glm::vec3& direction);
+
+		// GJK can stop on a point, segment or triangle when the origin lies on its boundary, EPA needs a full tetrahedron to start from
+		static bool CompleteTetrahedron(const ConvexSupport& a, const ConvexSupport& b, Simplex& simplex);
+		static bool EPA(const ConvexSupport& a, const ConvexSupport& b, const Simplex& simplex, ConvexContact& out_contact);
+	};
+}
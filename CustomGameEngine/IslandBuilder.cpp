@@ -0,0 +1,163 @@
+#include "IslandBuilder.h"
+#include "Scene.h"
+#include <glm/gtx/norm.hpp>
+namespace Engine {
+	void IslandBuilder::Run(EntityManager& ecs)
+	{
+		SCOPE_TIMER("IslandBuilder::Run");
+		bodies.clear();
+		entityToNode.clear();
+
+		ecs.View<ComponentPhysics>().ForEach([this](const unsigned int entityID, ComponentPhysics& physics) {
+			entityToNode[entityID] = bodies.size();
+			bodies.push_back({ entityID, &physics });
+		});
+
+		const unsigned int numBodies = bodies.size();
+		parent.resize(numBodies);
+		rank.assign(numBodies, 0);
+		for (unsigned int i = 0; i < numBodies; i++) {
+			parent[i] = i;
+		}
+
+		// Contacts
+		std::vector<unsigned int> sleepingTouched;
+		for (const CollisionData& collision : collisionManager->GetUnresolvedCollisions()) {
+			const int nodeA = GetNode(collision.entityIDA);
+			const int nodeB = GetNode(collision.entityIDB);
+
+			if (nodeA >= 0 && nodeB >= 0) { Union(nodeA, nodeB); }
+
+			// Narrowphase only reports a sleeping body when something awake and movable has touched it
+			if (nodeA >= 0 && bodies[nodeA].physics->IsAsleep()) { sleepingTouched.push_back(nodeA); }
+			if (nodeB >= 0 && bodies[nodeB].physics->IsAsleep()) { sleepingTouched.push_back(nodeB); }
+		}
+
+		// Constraints
+		for (const Constraint* c : constraintManager->GetConstraints()) {
+			if (c->IsActive()) {
+				const int nodeA = GetNode(c->EntityIDA());
+				const int nodeB = GetNode(c->EntityIDB());
+				if (nodeA >= 0 && nodeB >= 0) { Union(nodeA, nodeB); }
+			}
+		}
+
+		islandSleepTimer.assign(numBodies, FLT_MAX);
+		islandHasAwake.assign(numBodies, false);
+		islandHasSleeping.assign(numBodies, false);
+		islandWake.assign(numBodies, false);
+
+		const float linearThresholdSqr = linearSleepThreshold * linearSleepThreshold;
+		const float angularThresholdSqr = angularSleepThreshold * angularSleepThreshold;
+
+		numIslands = 0;
+		for (unsigned int i = 0; i < numBodies; i++) {
+			ComponentPhysics* physics = bodies[i].physics;
+			const unsigned int root = FindRoot(i);
+			if (root == i) { numIslands++; }
+
+			if (physics->IsAsleep()) {
+				islandHasSleeping[root] = true;
+				continue;
+			}
+
+			// Bodies accumulate time spent at rest, any movement resets it
+			if (physics->AllowSleep() && glm::length2(physics->Velocity()) < linearThresholdSqr && glm::length2(physics->AngularVelocity()) < angularThresholdSqr) {
+				physics->SetSleepTimer(physics->SleepTimer() + Scene::dt);
+			}
+			else {
+				physics->SetSleepTimer(0.0f);
+			}
+
+			islandHasAwake[root] = true;
+			islandSleepTimer[root] = std::min(islandSleepTimer[root], physics->SleepTimer());
+		}
+
+		for (const unsigned int node : sleepingTouched) {
+			islandWake[FindRoot(node)] = true;
+		}
+
+		// Islands sleep and wake as a whole
+		numSleepingBodies = 0;
+		for (unsigned int i = 0; i < numBodies; i++) {
+			const IslandBody& body = bodies[i];
+			const unsigned int root = FindRoot(i);
+
+			if (body.physics->IsAsleep()) {
+				const bool wake = !sleepingEnabled || islandWake[root] || islandHasAwake[root];
+				if (wake) {
+					SetAsleep(ecs, body, false);
+				}
+				else {
+					numSleepingBodies++;
+				}
+			}
+			else if (sleepingEnabled && !islandWake[root] && !islandHasSleeping[root] && islandSleepTimer[root] >= timeToSleep) {
+				SetAsleep(ecs, body, true);
+				numSleepingBodies++;
+			}
+		}
+	}
+
+	void IslandBuilder::WakeAll(EntityManager& ecs)
+	{
+		ecs.View<ComponentPhysics>().ForEach([this, &ecs](const unsigned int entityID, ComponentPhysics& physics) {
+			if (physics.IsAsleep()) {
+				SetAsleep(ecs, { entityID, &physics }, false);
+			}
+		});
+		numSleepingBodies = 0;
+	}
+
+	unsigned int IslandBuilder::FindRoot(unsigned int node)
+	{
+		// Path halving
+		while (parent[node] != node) {
+			parent[node] = parent[parent[node]];
+			node = parent[node];
+		}
+		return node;
+	}
+
+	void IslandBuilder::Union(const unsigned int nodeA, const unsigned int nodeB)
+	{
+		const unsigned int rootA = FindRoot(nodeA);
+		const unsigned int rootB = FindRoot(nodeB);
+		if (rootA == rootB) { return; }
+
+		if (rank[rootA] < rank[rootB]) {
+			parent[rootA] = rootB;
+		}
+		else if (rank[rootA] > rank[rootB]) {
+			parent[rootB] = rootA;
+		}
+		else {
+			parent[rootB] = rootA;
+			rank[rootA]++;
+		}
+	}
+
+	int IslandBuilder::GetNode(const unsigned int entityID) const
+	{
+		std::unordered_map<unsigned int, unsigned int>::const_iterator it = entityToNode.find(entityID);
+		return (it != entityToNode.end()) ? (int)it->second : -1;
+	}
+
+	void IslandBuilder::SetAsleep(EntityManager& ecs, const IslandBody& body, const bool asleep) const
+	{
+		if (asleep) { body.physics->Sleep(); }
+		else { body.physics->Wake(); }
+
+		// Mirror the state onto every collider the body has so the broadphase can cheaply skip sleeping pairs
+		ComponentCollision* colliders[] = {
+			ecs.GetComponent<ComponentCollisionSphere>(body.entityID),
+			ecs.GetComponent<ComponentCollisionAABB>(body.entityID),
+			ecs.GetComponent<ComponentCollisionBox>(body.entityID),
+			ecs.GetComponent<ComponentCollisionConvex>(body.entityID),
+			ecs.GetComponent<ComponentCollisionMesh>(body.entityID)
+		};
+		for (ComponentCollision* collider : colliders) {
+			if (collider) { collider->SetAsleep(asleep); }
+		}
+	}
+}
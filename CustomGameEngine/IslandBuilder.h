@@ -0,0 +1,73 @@
+#pragma once
+#include "EntityManager.h"
+#include "CollisionManager.h"
+#include "ConstraintManager.h"
+#include "ComponentPhysics.h"
+#include <unordered_map>
+namespace Engine {
+	// Groups physics bodies into simulation islands connected by contacts and constraints, then puts islands to sleep once every body in them has been at rest for long enough
+	// Must run after narrowphase and before collision resolution, as it reads this frame's unresolved collisions
+	class IslandBuilder
+	{
+	public:
+		IslandBuilder(CollisionManager* collisionManager, ConstraintManager* constraintManager, const float linearSleepThreshold = 0.05f, const float angularSleepThreshold = 0.05f, const float timeToSleep = 0.5f) : collisionManager(collisionManager), constraintManager(constraintManager), linearSleepThreshold(linearSleepThreshold), angularSleepThreshold(angularSleepThreshold), timeToSleep(timeToSleep), numIslands(0), numSleepingBodies(0), sleepingEnabled(true) {}
+		~IslandBuilder() {}
+
+		void Run(EntityManager& ecs);
+
+		// Wake every sleeping body in the scene
+		void WakeAll(EntityManager& ecs);
+
+		void SetSleepingEnabled(const bool enabled) { sleepingEnabled = enabled; }
+		bool SleepingEnabled() const { return sleepingEnabled; }
+
+		void SetLinearSleepThreshold(const float newThreshold) { linearSleepThreshold = newThreshold; }
+		float LinearSleepThreshold() const { return linearSleepThreshold; }
+
+		void SetAngularSleepThreshold(const float newThreshold) { angularSleepThreshold = newThreshold; }
+		float AngularSleepThreshold() const { return angularSleepThreshold; }
+
+		// Seconds an island has to stay below both thresholds before it goes to sleep
+		void SetTimeToSleep(const float newTime) { timeToSleep = newTime; }
+		float TimeToSleep() const { return timeToSleep; }
+
+		unsigned int NumBodies() const { return bodies.size(); }
+		unsigned int NumIslands() const { return numIslands; }
+		unsigned int NumSleepingBodies() const { return numSleepingBodies; }
+
+	private:
+		struct IslandBody {
+			unsigned int entityID;
+			ComponentPhysics* physics;
+		};
+
+		unsigned int FindRoot(unsigned int node);
+		void Union(const unsigned int nodeA, const unsigned int nodeB);
+		int GetNode(const unsigned int entityID) const;
+		void SetAsleep(EntityManager& ecs, const IslandBody& body, const bool asleep) const;
+
+		CollisionManager* collisionManager;
+		ConstraintManager* constraintManager;
+
+		std::vector<IslandBody> bodies;
+		std::unordered_map<unsigned int, unsigned int> entityToNode;
+
+		// Union-find forest over bodies
+		std::vector<unsigned int> parent;
+		std::vector<unsigned int> rank;
+
+		// Per island state, indexed by root node
+		std::vector<float> islandSleepTimer;
+		std::vector<bool> islandHasAwake;
+		std::vector<bool> islandHasSleeping;
+		std::vector<bool> islandWake;
+
+		float linearSleepThreshold;
+		float angularSleepThreshold;
+		float timeToSleep;
+
+		unsigned int numIslands;
+		unsigned int numSleepingBodies;
+		bool sleepingEnabled;
+	};
+}
@@ -1,6 +1,22 @@
 #include "LightManager.h"
 #include "RenderManager.h"
 namespace Engine {
+	glm::mat4 LightManager::DirectionalLightSpaceMatrix(const ComponentLight& light)
+	{
+		const glm::vec3 lightPos = -light.Direction * light.DirectionalLightDistance; // negative of the directional light's direction
+		const float orthoSize = light.ShadowProjectionSize;
+		const glm::mat4 lightProjection = glm::ortho(-orthoSize, orthoSize, -orthoSize, orthoSize, light.Near, light.Far);
+		const glm::mat4 lightView = glm::lookAt(lightPos, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		return lightProjection * lightView;
+	}
+
+	glm::mat4 LightManager::SpotLightSpaceMatrix(const ComponentLight& light, const glm::vec3& lightPos, const glm::vec3& lightDirection, const float aspect)
+	{
+		const glm::mat4 lightProjection = glm::perspective(glm::radians(90.0f), aspect, light.Near, light.Far);
+		const glm::mat4 lightView = glm::lookAt(lightPos, lightPos + lightDirection, glm::vec3(0.0f, 1.0f, 0.0f));
+		return lightProjection * lightView;
+	}
+
 	void LightManager::SetDirectionalLightUniforms(EntityManager& ecs, Shader* shader)
 	{
 		RenderManager* renderInstance = RenderManager::GetInstance();
@@ -23,13 +39,7 @@ namespace Engine {
 		shader->setFloat("dirLight.MaxShadowBias", directional->MaxShadowBias);
 		shader->setBool("dirLight.Active", directional->Active);
 
-		glm::vec3 lightPos = -directional->Direction * directional->DirectionalLightDistance; // negative of the directional light's direction
-
-		glm::mat4 lightProjection = glm::ortho(-directional->ShadowProjectionSize, directional->ShadowProjectionSize, -directional->ShadowProjectionSize, directional->ShadowProjectionSize, directional->Near, directional->Far);
-		glm::mat4 lightView = glm::lookAt(lightPos, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-		glm::mat4 lightSpaceMatrix = lightProjection * lightView;
-
-		shader->setMat4("dirLight.LightSpaceMatrix", lightSpaceMatrix);
+		shader->setMat4("dirLight.LightSpaceMatrix", DirectionalLightSpaceMatrix(*directional));
 		shader->setVec2(std::string("dirLight.shadowResolution"), glm::vec2(renderInstance->ShadowWidth(), renderInstance->ShadowHeight()));
 
 		glActiveTexture(GL_TEXTURE0 + textureSlots->at("dirLight.ShadowMap"));
@@ -151,10 +161,7 @@ namespace Engine {
 			}
 			else if (lightComponent->GetLightType() == SPOT) {
 				const float aspect = (float)renderInstance->ShadowWidth() / (float)renderInstance->ShadowHeight();
-				const glm::vec3& lightPos = transformComponent->GetWorldPosition();
-				const glm::mat4 lightProjection = glm::perspective(glm::radians(90.0f), aspect, lightComponent->Near, lightComponent->Far);
-				const glm::mat4 lightView = glm::lookAt(lightPos, lightPos + lightComponent->WorldDirection, glm::vec3(0.0f, 1.0f, 0.0f));
-				const glm::mat4 lightSpaceMatrix = lightProjection * lightView;
+				const glm::mat4 lightSpaceMatrix = SpotLightSpaceMatrix(*lightComponent, transformComponent->GetWorldPosition(), lightComponent->WorldDirection, aspect);
 
 				if (i < numFlatShadowColumns) {
 					slotRow = 0;
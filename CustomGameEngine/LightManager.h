@@ -43,6 +43,10 @@ namespace Engine {
 		}
 
 		const std::vector<unsigned int>& GetDirectionalLightEntities() const { return directionalLightEntities; }
+
+		// Matrices the shadow maps are rendered with, shared with culling so both agree on what each shadow map can see
+		static glm::mat4 DirectionalLightSpaceMatrix(const ComponentLight& light);
+		static glm::mat4 SpotLightSpaceMatrix(const ComponentLight& light, const glm::vec3& lightPos, const glm::vec3& lightDirection, const float aspect);
 		const std::map<float, unsigned int>& GetLightEntities() const { return lightEntities; }
 
 	private:
@@ -1,7 +1,16 @@
 #include "GameSceneManager.h"
+#include "RigidBodyStore.h"
+#include <cstring>
 //#include "EntityManagerNew.h"
-int main()
+int main(int argc, char** argv)
 {
+	// Headless benchmarks, no window is created
+	if (argc > 1 && std::strcmp(argv[1], "--benchmark-integration") == 0) {
+		Engine::RigidBodyStore::Benchmark(10000);
+		Engine::RigidBodyStore::Benchmark(100000);
+		return 0;
+	}
+
 	Engine::GameSceneManager game = Engine::GameSceneManager(2560, 1440, 200, 80);
 	game.Run();
 	//Engine::EntityManagerNew ecs;
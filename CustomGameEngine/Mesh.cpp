@@ -73,7 +73,7 @@ namespace Engine {
 		}
 	}
 
-	void Mesh::Draw(Shader& shader, bool pbr, int instanceNum, const unsigned int instanceVAO)
+	void Mesh::Draw(Shader& shader, bool pbr, int instanceNum, const unsigned int instanceVAO, const unsigned int lod)
 	{
 		SCOPE_TIMER("Mesh::Draw");
 
@@ -284,16 +284,16 @@ namespace Engine {
 		}
 
 		// draw
-		meshData->DrawMeshData(instanceNum, drawPrimitive, instanceVAO);
+		meshData->DrawMeshData(instanceNum, drawPrimitive, instanceVAO, lod);
 		glActiveTexture(GL_TEXTURE0);
 	}
 
-	void Mesh::DrawWithNoMaterial(int instanceNum, const unsigned int instanceVAO)
+	void Mesh::DrawWithNoMaterial(int instanceNum, const unsigned int instanceVAO, const unsigned int lod)
 	{
 		SCOPE_TIMER("Mesh::DrawWithNoMaterial");
 
 		// draw
-		meshData->DrawMeshData(instanceNum, drawPrimitive, instanceVAO);
+		meshData->DrawMeshData(instanceNum, drawPrimitive, instanceVAO, lod);
 		glActiveTexture(GL_TEXTURE0);
 	}
 
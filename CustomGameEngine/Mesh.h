@@ -157,9 +157,11 @@ namespace Engine {
 		void SetMaterials(const std::vector<AbstractMaterial*>& materials) { this->meshMaterials = materials; }
 
 		void SetDrawPrimitive(GLenum drawPrimitive) { this->drawPrimitive = drawPrimitive; }
+		GLenum GetDrawPrimitive() const { return drawPrimitive; }
 
-		void Draw(Shader& shader, bool pbr, int instanceNum = 0, const unsigned int instanceVAO = 0);
-		void DrawWithNoMaterial(int instanceNum = 0, const unsigned int instanceVAO = 0);
+		// lod picks one of the mesh data's levels of detail, 0 is the full resolution mesh
+		void Draw(Shader& shader, bool pbr, int instanceNum = 0, const unsigned int instanceVAO = 0, const unsigned int lod = 0);
+		void DrawWithNoMaterial(int instanceNum = 0, const unsigned int instanceVAO = 0, const unsigned int lod = 0);
 
 		AABBPoints& GetGeometryAABB() { return geometryAABB; }
 		const AABBPoints& GetGeometryAABB() const { return geometryAABB; }
@@ -1,10 +1,17 @@
 #include "MeshData.h"
 namespace Engine {
-	MeshData::MeshData(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices)
+	MeshData::MeshData(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, const MeshLODChain& lodChain)
 	{
 		this->vertices = vertices;
 		this->indices = indices;
-		SetupMesh();
+		lodChainIndices = lodChain.indices;
+
+		lods.reserve(lodChain.lods.size() + 1);
+		lods.push_back({ 0, static_cast<unsigned int>(indices.size()), 0.0f });
+		for (const MeshLOD& lod : lodChain.lods) {
+			lods.push_back({ static_cast<unsigned int>(indices.size()) + lod.indexOffset, lod.indexCount, lod.error });
+		}
+		SetupMesh(lodChain.indices);
 	}
 
 	MeshData::~MeshData()
@@ -15,7 +22,7 @@ namespace Engine {
 		glDeleteBuffers(1, &SSBO);
 	}
 
-	void MeshData::SetupMesh()
+	void MeshData::SetupMesh(const std::vector<unsigned int>& lodIndices)
 	{
 		glGenVertexArrays(1, &VAO);
 		glGenBuffers(1, &VBO);
@@ -27,7 +34,9 @@ namespace Engine {
 		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
 
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, (indices.size() + lodIndices.size()) * sizeof(unsigned int), nullptr, GL_STATIC_DRAW);
+		glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, indices.size() * sizeof(unsigned int), &indices[0]);
+		if (!lodIndices.empty()) { glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), lodIndices.size() * sizeof(unsigned int), &lodIndices[0]); }
 
 		// vertex positions
 		glEnableVertexAttribArray(0);
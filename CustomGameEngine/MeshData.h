@@ -49,34 +49,59 @@ namespace Engine {
 		}
 	};
 
+	// Range of the index buffer one level of detail is drawn from. Error bounds how far any point of the level is from the full mesh, relative to the mesh's bounding radius
+	struct MeshLOD {
+		unsigned int indexOffset;
+		unsigned int indexCount;
+		float error;
+	};
+
+	// Coarser levels of detail built from a mesh's indices, each level's range is into this chain's indices
+	struct MeshLODChain {
+		std::vector<unsigned int> indices;
+		std::vector<MeshLOD> lods;
+	};
+
 	class MeshData
 	{
 	public:
-		MeshData(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices);
+		// The chain's indices are stored after the full mesh's in the same index buffer, all levels share the vertices
+		MeshData(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, const MeshLODChain& lodChain = MeshLODChain());
 		~MeshData();
 
-		void DrawMeshData(const unsigned int instanceNum, const GLenum drawPrimitive, const unsigned int instanceVAO = 0) {
+		void DrawMeshData(const unsigned int instanceNum, const GLenum drawPrimitive, const unsigned int instanceVAO = 0, const unsigned int lod = 0) {
+			const MeshLOD& range = lods[(lod < lods.size()) ? lod : lods.size() - 1];
+			const void* offset = (const void*)(range.indexOffset * sizeof(unsigned int));
 			if (instanceNum == 0) {
 				glBindVertexArray(VAO);
-				glDrawElements(drawPrimitive, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
+				glDrawElements(drawPrimitive, range.indexCount, GL_UNSIGNED_INT, offset);
 			}
 			else if (instanceNum > 0) {
 				glBindVertexArray(instanceVAO);
-				glDrawElementsInstanced(drawPrimitive, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0, instanceNum);
+				glDrawElementsInstanced(drawPrimitive, range.indexCount, GL_UNSIGNED_INT, offset, instanceNum);
 			}
 			glBindVertexArray(0);
 		}
 
 		const std::vector<Vertex>& GetVertices() const { return vertices; }
+		// Indices of the full resolution mesh
+		const std::vector<unsigned int>& GetIndices() const { return indices; }
+		// Level 0 is the full resolution mesh, every level after is coarser
+		unsigned int GetNumLODs() const { return lods.size(); }
+		const MeshLOD& GetLOD(const unsigned int lod) const { return lods[lod]; }
+		// First of a level's indexCount indices, level 0's are GetIndices()
+		const unsigned int* GetLODIndices(const unsigned int lod) const { return (lod == 0) ? indices.data() : &lodChainIndices[lods[lod].indexOffset - indices.size()]; }
 		const unsigned int GetVAO() const { return VAO; }
 		const unsigned int GetVBO() const { return VBO; }
 		const unsigned int GetEBO() const { return EBO; }
 		const unsigned int GetSSBO() const { return SSBO; }
 	private:
-		void SetupMesh();
+		void SetupMesh(const std::vector<unsigned int>& lodIndices);
 
 		std::vector<Vertex> vertices;
 		std::vector<unsigned int> indices;
+		std::vector<MeshLOD> lods;
+		std::vector<unsigned int> lodChainIndices; // kept for CPU side use such as occluders, the GPU copy follows indices in the same buffer
 		unsigned int VAO, VBO, EBO;
 		unsigned int SSBO;
 	};
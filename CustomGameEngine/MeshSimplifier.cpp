@@ -0,0 +1,254 @@
+#include "MeshSimplifier.h"
+#include "ScopeTimer.h"
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+namespace Engine {
+	void MeshSimplifier::Quadric::AddPlane(const glm::dvec3& normal, const double distance, const double area)
+	{
+		a2 += normal.x * normal.x * area; ab += normal.x * normal.y * area; ac += normal.x * normal.z * area; ad += normal.x * distance * area;
+		b2 += normal.y * normal.y * area; bc += normal.y * normal.z * area; bd += normal.y * distance * area;
+		c2 += normal.z * normal.z * area; cd += normal.z * distance * area;
+		d2 += distance * distance * area;
+		weight += area;
+	}
+
+	void MeshSimplifier::Quadric::Add(const Quadric& other)
+	{
+		a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad;
+		b2 += other.b2; bc += other.bc; bd += other.bd;
+		c2 += other.c2; cd += other.cd;
+		d2 += other.d2;
+		weight += other.weight;
+	}
+
+	double MeshSimplifier::Quadric::Evaluate(const glm::dvec3& p) const
+	{
+		return a2 * p.x * p.x + b2 * p.y * p.y + c2 * p.z * p.z + 2.0 * (ab * p.x * p.y + ac * p.x * p.z + bc * p.y * p.z + ad * p.x + bd * p.y + cd * p.z) + d2;
+	}
+
+	MeshSimplifier::MeshSimplifier(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices) : indices(indices), largestDeviation(0.0)
+	{
+		const unsigned int numVertices = vertices.size();
+
+		glm::dvec3 boundsMin = glm::dvec3(DBL_MAX);
+		glm::dvec3 boundsMax = glm::dvec3(-DBL_MAX);
+		for (const Vertex& vertex : vertices) {
+			boundsMin = glm::min(boundsMin, glm::dvec3(vertex.Position));
+			boundsMax = glm::max(boundsMax, glm::dvec3(vertex.Position));
+		}
+		const glm::dvec3 centre = (boundsMin + boundsMax) * 0.5;
+		const double radius = std::max(glm::length(boundsMax - boundsMin) * 0.5, DBL_EPSILON);
+
+		positions.resize(numVertices);
+		for (unsigned int i = 0; i < numVertices; i++) {
+			positions[i] = (glm::dvec3(vertices[i].Position) - centre) / radius;
+		}
+
+		// Each vertex starts with the planes of the triangles around it
+		quadrics.assign(numVertices, Quadric());
+		deviations.assign(numVertices, 0.0);
+		mergedNext.assign(numVertices, UINT_MAX);
+		mergedTail.resize(numVertices);
+		for (unsigned int i = 0; i < numVertices; i++) { mergedTail[i] = i; }
+		for (unsigned int i = 0; i + 2 < this->indices.size(); i += 3) {
+			const glm::dvec3& p0 = positions[this->indices[i]];
+			const glm::dvec3 cross = glm::cross(positions[this->indices[i + 1]] - p0, positions[this->indices[i + 2]] - p0);
+			const double length = glm::length(cross);
+			if (length == 0.0) { continue; }
+
+			const glm::dvec3 normal = cross / length;
+			const double distance = -glm::dot(normal, p0);
+			for (unsigned int j = 0; j < 3; j++) { quadrics[this->indices[i + j]].AddPlane(normal, distance, length * 0.5); }
+		}
+
+		// Lock both ends of every edge that isn't shared by exactly two triangles
+		std::vector<unsigned long long> edges;
+		edges.reserve(this->indices.size());
+		for (unsigned int i = 0; i + 2 < this->indices.size(); i += 3) {
+			for (unsigned int j = 0; j < 3; j++) {
+				const unsigned int a = this->indices[i + j];
+				const unsigned int b = this->indices[i + (j + 1) % 3];
+				edges.push_back(((unsigned long long)std::min(a, b) << 32) | std::max(a, b));
+			}
+		}
+		std::sort(edges.begin(), edges.end());
+
+		lockedVertices.assign(numVertices, 0);
+		for (unsigned int i = 0; i < edges.size();) {
+			unsigned int end = i + 1;
+			while (end < edges.size() && edges[end] == edges[i]) { end++; }
+			if (end - i != 2) {
+				lockedVertices[edges[i] >> 32] = 1;
+				lockedVertices[edges[i] & 0xFFFFFFFFull] = 1;
+			}
+			i = end;
+		}
+	}
+
+	float MeshSimplifier::Simplify(const unsigned int targetIndexCount, const float maxError)
+	{
+		SCOPE_TIMER("MeshSimplifier::Simplify");
+		const double maxCost = (double)maxError * maxError;
+		const unsigned int targetTriangles = targetIndexCount / 3;
+
+		// Each pass collapses a set of edges that don't share any vertex, then the adjacency is rebuilt for the next
+		while (indices.size() / 3 > targetTriangles) {
+			BuildAdjacency();
+
+			collapses.clear();
+			for (unsigned int i = 0; i + 2 < indices.size(); i += 3) {
+				for (unsigned int j = 0; j < 3; j++) {
+					const unsigned int a = indices[i + j];
+					const unsigned int b = indices[i + (j + 1) % 3];
+					// Edges between two triangles are met once each way round, only take them once
+					if (a > b || (lockedVertices[a] && lockedVertices[b])) { continue; }
+
+					const double costAToB = lockedVertices[a] ? DBL_MAX : CollapseCost(a, b);
+					const double costBToA = lockedVertices[b] ? DBL_MAX : CollapseCost(b, a);
+					if (costAToB <= costBToA) { collapses.push_back({ costAToB, a, b }); }
+					else { collapses.push_back({ costBToA, b, a }); }
+				}
+			}
+			if (collapses.empty()) { break; }
+			std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+			// Each collapse removes about two triangles. Only let through collapses a little dearer than the last one the target needs, cheaper ones may turn up next pass
+			const unsigned int currentTriangles = indices.size() / 3;
+			const unsigned int collapseGoal = std::max(1u, (currentTriangles - targetTriangles) / 2);
+			double passLimit = std::min(maxCost, collapses[std::min(collapseGoal, (unsigned int)collapses.size()) - 1].cost * 1.5);
+
+			touchedVertices.assign(positions.size(), 0);
+			unsigned int removedTriangles = 0;
+			unsigned int performed = 0;
+			for (const Collapse& collapse : collapses) {
+				if (currentTriangles - removedTriangles <= targetTriangles) { break; }
+				if (collapse.cost > passLimit) {
+					// Nothing cheap enough could be collapsed, let the rest of the pass go up to the error limit
+					if (performed > 0 || passLimit >= maxCost || collapse.cost > maxCost) { break; }
+					passLimit = maxCost;
+				}
+				if (touchedVertices[collapse.from] || touchedVertices[collapse.to]) { continue; }
+				// The cost is a mean over the surrounding planes and can hide one vertex moving a long way, the deviation bound can't
+				const double deviation = CollapseDeviation(collapse.from, collapse.to);
+				if (deviation > maxError) { continue; }
+				if (CollapseFlipsTriangle(collapse.from, collapse.to)) { continue; }
+
+				removedTriangles += ApplyCollapse(collapse.from, collapse.to);
+				touchedVertices[collapse.from] = 1;
+				touchedVertices[collapse.to] = 1;
+				deviations[collapse.to] = deviation;
+				largestDeviation = std::max(largestDeviation, deviation);
+				performed++;
+			}
+
+			RemoveDegenerateTriangles();
+			if (performed == 0) { break; }
+		}
+
+		return (float)largestDeviation;
+	}
+
+	void MeshSimplifier::BuildAdjacency()
+	{
+		adjacencyOffsets.assign(positions.size() + 1, 0);
+		for (const unsigned int index : indices) { adjacencyOffsets[index + 1]++; }
+		for (unsigned int i = 0; i < positions.size(); i++) { adjacencyOffsets[i + 1] += adjacencyOffsets[i]; }
+
+		adjacentTriangles.resize(indices.size());
+		std::vector<unsigned int> next(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (unsigned int i = 0; i < indices.size(); i++) { adjacentTriangles[next[indices[i]]++] = i / 3; }
+	}
+
+	double MeshSimplifier::CollapseCost(const unsigned int from, const unsigned int to) const
+	{
+		Quadric combined = quadrics[from];
+		combined.Add(quadrics[to]);
+		if (combined.weight <= 0.0) { return 0.0; }
+
+		// Mean squared distance from the planes of both vertices to where they meet
+		return std::max(0.0, combined.Evaluate(positions[to]) / combined.weight);
+	}
+
+	double MeshSimplifier::CollapseDeviation(const unsigned int from, const unsigned int to) const
+	{
+		double deviation = deviations[to];
+		for (unsigned int vertex = from; vertex != UINT_MAX; vertex = mergedNext[vertex]) {
+			deviation = std::max(deviation, glm::distance(positions[vertex], positions[to]));
+		}
+		return deviation;
+	}
+
+	bool MeshSimplifier::CollapseFlipsTriangle(const unsigned int from, const unsigned int to) const
+	{
+		for (unsigned int i = adjacencyOffsets[from]; i < adjacencyOffsets[from + 1]; i++) {
+			const unsigned int* triangle = &indices[adjacentTriangles[i] * 3];
+			if (triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[0] == triangle[2]) { continue; }
+			// Triangles on the collapsed edge disappear
+			if (triangle[0] == to || triangle[1] == to || triangle[2] == to) { continue; }
+
+			glm::dvec3 before[3];
+			glm::dvec3 after[3];
+			for (unsigned int j = 0; j < 3; j++) {
+				before[j] = positions[triangle[j]];
+				after[j] = positions[(triangle[j] == from) ? to : triangle[j]];
+			}
+			const glm::dvec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+			const glm::dvec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+			if (glm::dot(normalBefore, normalAfter) <= 0.0) { return true; }
+		}
+		return false;
+	}
+
+	unsigned int MeshSimplifier::ApplyCollapse(const unsigned int from, const unsigned int to)
+	{
+		unsigned int removedTriangles = 0;
+		for (unsigned int i = adjacencyOffsets[from]; i < adjacencyOffsets[from + 1]; i++) {
+			unsigned int* triangle = &indices[adjacentTriangles[i] * 3];
+			const bool wasDegenerate = triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[0] == triangle[2];
+			for (unsigned int j = 0; j < 3; j++) {
+				if (triangle[j] == from) { triangle[j] = to; }
+			}
+			if (!wasDegenerate && (triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[0] == triangle[2])) { removedTriangles++; }
+		}
+		quadrics[to].Add(quadrics[from]);
+		mergedNext[mergedTail[to]] = from;
+		mergedTail[to] = mergedTail[from];
+		return removedTriangles;
+	}
+
+	void MeshSimplifier::RemoveDegenerateTriangles()
+	{
+		unsigned int kept = 0;
+		for (unsigned int i = 0; i + 2 < indices.size(); i += 3) {
+			const unsigned int a = indices[i], b = indices[i + 1], c = indices[i + 2];
+			if (a == b || b == c || a == c) { continue; }
+			indices[kept++] = a;
+			indices[kept++] = b;
+			indices[kept++] = c;
+		}
+		indices.resize(kept);
+	}
+
+	MeshLODChain MeshSimplifier::BuildLODChain(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices)
+	{
+		SCOPE_TIMER("MeshSimplifier::BuildLODChain");
+		MeshLODChain chain;
+		if (indices.size() % 3 != 0 || indices.size() / 3 < MIN_SOURCE_TRIANGLES) { return chain; }
+
+		MeshSimplifier simplifier(vertices, indices);
+		unsigned int previousCount = indices.size();
+		for (unsigned int lod = 1; lod < MAX_LODS; lod++) {
+			const float error = simplifier.Simplify((previousCount / 6) * 3, MAX_LOD_ERROR);
+			const std::vector<unsigned int>& lodIndices = simplifier.GetIndices();
+			if (lodIndices.empty() || lodIndices.size() > previousCount - previousCount / 4) { break; }
+
+			chain.lods.push_back({ (unsigned int)chain.indices.size(), (unsigned int)lodIndices.size(), error });
+			chain.indices.insert(chain.indices.end(), lodIndices.begin(), lodIndices.end());
+			previousCount = lodIndices.size();
+			if (previousCount / 3 <= MIN_LOD_TRIANGLES) { break; }
+		}
+		return chain;
+	}
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include "MeshData.h"
+#include <glm/glm.hpp>
+#include <vector>
+namespace Engine {
+	// Quadric error edge collapse simplification (Garland and Heckbert). A vertex is only ever collapsed onto one of its neighbours, so every simplified index list still indexes the original vertices
+	// Vertices on an edge without exactly two triangles never move. That keeps mesh borders, and the texture and normal seams where the importer split vertices, from opening up
+	class MeshSimplifier
+	{
+	public:
+		// Levels of detail stop once another level would remove less than a quarter of the triangles, or the mesh gets down to a handful of triangles
+		static constexpr unsigned int MAX_LODS = 5;
+		static constexpr unsigned int MIN_LOD_TRIANGLES = 32;
+		// Meshes smaller than this aren't worth simplifying
+		static constexpr unsigned int MIN_SOURCE_TRIANGLES = 128;
+		// Furthest a level may move the surface, relative to the mesh's bounding radius
+		static constexpr float MAX_LOD_ERROR = 0.25f;
+
+		// Indices must be a triangle list
+		MeshSimplifier(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices);
+		~MeshSimplifier() {}
+
+		// Collapses edges cheapest first until no more than targetIndexCount indices are left or every remaining collapse would move the surface further than maxError
+		// Carries on from the previous call. Returns a bound on how far any point of the simplified surface is from the original, relative to the mesh's bounding radius
+		float Simplify(const unsigned int targetIndexCount, const float maxError);
+		const std::vector<unsigned int>& GetIndices() const { return indices; }
+
+		// Coarser versions of a triangle mesh, each roughly half the triangles of the one before. Empty if the mesh is too small to be worth it
+		static MeshLODChain BuildLODChain(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices);
+
+	private:
+		// Sum of squared distances to a set of planes, weighted by the area of the triangle each plane came from
+		struct Quadric {
+			double a2, ab, ac, ad;
+			double b2, bc, bd;
+			double c2, cd;
+			double d2;
+			double weight;
+
+			void AddPlane(const glm::dvec3& normal, const double distance, const double area);
+			void Add(const Quadric& other);
+			double Evaluate(const glm::dvec3& p) const;
+		};
+
+		struct Collapse {
+			double cost;
+			unsigned int from;
+			unsigned int to;
+		};
+
+		void BuildAdjacency();
+		double CollapseCost(const unsigned int from, const unsigned int to) const;
+		double CollapseDeviation(const unsigned int from, const unsigned int to) const;
+		bool CollapseFlipsTriangle(const unsigned int from, const unsigned int to) const;
+		unsigned int ApplyCollapse(const unsigned int from, const unsigned int to);
+		void RemoveDegenerateTriangles();
+
+		std::vector<glm::dvec3> positions; // centred on the mesh and scaled to a unit bounding radius so errors come out relative
+		std::vector<unsigned int> indices;
+		std::vector<Quadric> quadrics;
+		std::vector<unsigned char> lockedVertices; // on a border, seam or non manifold edge
+		std::vector<unsigned char> touchedVertices; // moved or collapsed onto this pass
+
+		// Triangles around each vertex, rebuilt at the start of each pass
+		std::vector<unsigned int> adjacencyOffsets;
+		std::vector<unsigned int> adjacentTriangles;
+
+		// Furthest any original vertex collapsed onto this one has moved. Every point of a triangle moves no further than its corners, so this bounds how far the surface around the vertex has moved
+		std::vector<double> deviations;
+		// Original vertices collapsed onto each vertex as a linked list, starting with the vertex itself
+		std::vector<unsigned int> mergedNext;
+		std::vector<unsigned int> mergedTail;
+
+		std::vector<Collapse> collapses;
+		double largestDeviation;
+	};
+}
@@ -0,0 +1,215 @@
+#include "OcclusionBuffer.h"
+#include "ScopeTimer.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+namespace Engine {
+	OcclusionBuffer::OcclusionBuffer(const unsigned int width, const unsigned int height) : viewProjection(1.0f), rasterizedTriangles(0)
+	{
+		unsigned int levelWidth = std::max(1u, (width + MAX_LANE_WIDTH - 1) / MAX_LANE_WIDTH) * MAX_LANE_WIDTH;
+		unsigned int levelHeight = std::max(1u, height);
+		while (true) {
+			levels.push_back(std::vector<float>(levelWidth * levelHeight, 0.0f));
+			levelWidths.push_back(levelWidth);
+			levelHeights.push_back(levelHeight);
+			if (levelWidth == 1 && levelHeight == 1) { break; }
+			levelWidth = (levelWidth + 1) / 2;
+			levelHeight = (levelHeight + 1) / 2;
+		}
+	}
+
+	void OcclusionBuffer::Clear(const glm::mat4& viewProjection)
+	{
+		this->viewProjection = viewProjection;
+		std::fill(levels[0].begin(), levels[0].end(), 0.0f);
+		rasterizedTriangles = 0;
+	}
+
+	void OcclusionBuffer::RasterizeTriangles(const glm::mat4& model, const std::vector<Vertex>& vertices, const unsigned int* indices, const unsigned int indexCount)
+	{
+		SCOPE_TIMER("OcclusionBuffer::RasterizeTriangles");
+		const glm::mat4 modelViewProjection = viewProjection * model;
+		clipVertices.resize(vertices.size());
+		for (unsigned int i = 0; i < vertices.size(); i++) {
+			clipVertices[i] = modelViewProjection * glm::vec4(vertices[i].Position, 1.0f);
+		}
+
+		for (unsigned int i = 0; i + 2 < indexCount; i += 3) {
+			const glm::vec4& a = clipVertices[indices[i]];
+			const glm::vec4& b = clipVertices[indices[i + 1]];
+			const glm::vec4& c = clipVertices[indices[i + 2]];
+
+			// Skip triangles entirely outside one of the side planes
+			if (a.x > a.w && b.x > b.w && c.x > c.w) { continue; }
+			if (a.x < -a.w && b.x < -b.w && c.x < -c.w) { continue; }
+			if (a.y > a.w && b.y > b.w && c.y > c.w) { continue; }
+			if (a.y < -a.w && b.y < -b.w && c.y < -c.w) { continue; }
+
+			RasterizeClipTriangle(a, b, c);
+		}
+	}
+
+	OcclusionBuffer::ScreenVertex OcclusionBuffer::ToScreen(const glm::vec4& clip) const
+	{
+		const float inverseW = 1.0f / clip.w;
+		return { (clip.x * inverseW * 0.5f + 0.5f) * levelWidths[0], (clip.y * inverseW * 0.5f + 0.5f) * levelHeights[0], inverseW };
+	}
+
+	void OcclusionBuffer::RasterizeClipTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c)
+	{
+		// Clip against the near plane (z >= -w), which can turn the triangle into a quad
+		const glm::vec4 in[3] = { a, b, c };
+		glm::vec4 out[4];
+		unsigned int numOut = 0;
+		for (unsigned int i = 0; i < 3; i++) {
+			const glm::vec4& current = in[i];
+			const glm::vec4& next = in[(i + 1) % 3];
+			const float currentDistance = current.z + current.w;
+			const float nextDistance = next.z + next.w;
+
+			if (currentDistance >= 0.0f) { out[numOut++] = current; }
+			if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f)) {
+				out[numOut++] = current + (next - current) * (currentDistance / (currentDistance - nextDistance));
+			}
+		}
+		if (numOut < 3) { return; }
+
+		const ScreenVertex v0 = ToScreen(out[0]);
+		ScreenVertex v1 = ToScreen(out[1]);
+		for (unsigned int i = 2; i < numOut; i++) {
+			const ScreenVertex v2 = ToScreen(out[i]);
+			RasterizeScreenTriangle<WideLanes>(v0, v1, v2);
+			v1 = v2;
+		}
+		rasterizedTriangles++;
+	}
+
+	template <typename Lanes>
+	void OcclusionBuffer::RasterizeScreenTriangle(const ScreenVertex& v0, const ScreenVertex& in_v1, const ScreenVertex& in_v2)
+	{
+		using Float = typename Lanes::Float;
+		static const float pixelCentreOffsets[MAX_LANE_WIDTH] = { 0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f };
+
+		// Both faces are drawn, wind every triangle the same way so the inside of each edge is positive
+		float area = (in_v1.x - v0.x) * (in_v2.y - v0.y) - (in_v1.y - v0.y) * (in_v2.x - v0.x);
+		if (area == 0.0f) { return; }
+		const ScreenVertex& v1 = (area > 0.0f) ? in_v1 : in_v2;
+		const ScreenVertex& v2 = (area > 0.0f) ? in_v2 : in_v1;
+		area = std::abs(area);
+
+		// Pixels whose centres can fall inside the triangle
+		const unsigned int width = levelWidths[0];
+		const unsigned int height = levelHeights[0];
+		const float minX = std::min({ v0.x, v1.x, v2.x }), maxX = std::max({ v0.x, v1.x, v2.x });
+		const float minY = std::min({ v0.y, v1.y, v2.y }), maxY = std::max({ v0.y, v1.y, v2.y });
+		const int startX = std::max(0, (int)std::ceil(minX - 0.5f));
+		const int endX = std::min((int)width - 1, (int)std::floor(maxX - 0.5f));
+		const int startY = std::max(0, (int)std::ceil(minY - 0.5f));
+		const int endY = std::min((int)height - 1, (int)std::floor(maxY - 0.5f));
+		if (startX > endX || startY > endY) { return; }
+
+		// Edge functions as a*x + b*y + c, each is the barycentric weight of the opposite vertex scaled by the area
+		const float a0 = v1.y - v2.y, b0 = v2.x - v1.x, c0 = v1.x * v2.y - v1.y * v2.x;
+		const float a1 = v2.y - v0.y, b1 = v0.x - v2.x, c1 = v2.x * v0.y - v2.y * v0.x;
+		const float a2 = v0.y - v1.y, b2 = v1.x - v0.x, c2 = v0.x * v1.y - v0.y * v1.x;
+
+		// 1/w is linear in screen space, so depth is a plane over the same weights. Each pixel stores the farthest depth of the plane across its square
+		const float inverseArea = 1.0f / area;
+		const float az = (a0 * v0.inverseW + a1 * v1.inverseW + a2 * v2.inverseW) * inverseArea;
+		const float bz = (b0 * v0.inverseW + b1 * v1.inverseW + b2 * v2.inverseW) * inverseArea;
+		const float cz = (c0 * v0.inverseW + c1 * v1.inverseW + c2 * v2.inverseW) * inverseArea - 0.5f * (std::abs(az) + std::abs(bz));
+
+		const Float zero = Lanes::Set(0.0f);
+		const Float a0Lanes = Lanes::Set(a0), a1Lanes = Lanes::Set(a1), a2Lanes = Lanes::Set(a2), azLanes = Lanes::Set(az);
+		const Float laneOffsets = Lanes::Load(pixelCentreOffsets);
+		const int alignedStartX = startX - (startX % (int)Lanes::width);
+
+		std::vector<float>& depth = levels[0];
+		for (int y = startY; y <= endY; y++) {
+			const float pixelY = y + 0.5f;
+			const Float rowEdge0 = Lanes::Set(b0 * pixelY + c0), rowEdge1 = Lanes::Set(b1 * pixelY + c1), rowEdge2 = Lanes::Set(b2 * pixelY + c2);
+			const Float rowDepth = Lanes::Set(bz * pixelY + cz);
+			float* row = &depth[y * width];
+
+			for (int x = alignedStartX; x <= endX; x += Lanes::width) {
+				const Float pixelX = Lanes::Add(Lanes::Set((float)x), laneOffsets);
+				const Float edge0 = Lanes::Add(Lanes::Mul(a0Lanes, pixelX), rowEdge0);
+				const Float edge1 = Lanes::Add(Lanes::Mul(a1Lanes, pixelX), rowEdge1);
+				const Float edge2 = Lanes::Add(Lanes::Mul(a2Lanes, pixelX), rowEdge2);
+				const Float pixelDepth = Lanes::Add(Lanes::Mul(azLanes, pixelX), rowDepth);
+
+				// Pixels outside any edge keep their depth, inside ones keep whichever of the two is nearest
+				const Float minEdge = Lanes::Min(Lanes::Min(edge0, edge1), edge2);
+				const Float covered = Lanes::SelectLess(minEdge, zero, zero, pixelDepth);
+				Lanes::Store(&row[x], Lanes::Max(Lanes::Load(&row[x]), covered));
+			}
+		}
+	}
+
+	void OcclusionBuffer::BuildPyramid()
+	{
+		SCOPE_TIMER("OcclusionBuffer::BuildPyramid");
+		for (unsigned int level = 1; level < levels.size(); level++) {
+			const std::vector<float>& source = levels[level - 1];
+			const unsigned int sourceWidth = levelWidths[level - 1];
+			const unsigned int sourceHeight = levelHeights[level - 1];
+			std::vector<float>& destination = levels[level];
+
+			for (unsigned int y = 0; y < levelHeights[level]; y++) {
+				// Odd sized levels repeat their last row and column
+				const unsigned int y0 = y * 2;
+				const unsigned int y1 = std::min(y0 + 1, sourceHeight - 1);
+				for (unsigned int x = 0; x < levelWidths[level]; x++) {
+					const unsigned int x0 = x * 2;
+					const unsigned int x1 = std::min(x0 + 1, sourceWidth - 1);
+					destination[y * levelWidths[level] + x] = std::min(std::min(source[y0 * sourceWidth + x0], source[y0 * sourceWidth + x1]),
+						std::min(source[y1 * sourceWidth + x0], source[y1 * sourceWidth + x1]));
+				}
+			}
+		}
+	}
+
+	bool OcclusionBuffer::IsOccluded(const glm::vec3& boundsMin, const glm::vec3& boundsMax) const
+	{
+		float minX = FLT_MAX, minY = FLT_MAX;
+		float maxX = -FLT_MAX, maxY = -FLT_MAX;
+		float nearestInverseW = 0.0f;
+		for (unsigned int corner = 0; corner < 8; corner++) {
+			const glm::vec3 position = glm::vec3((corner & 1) ? boundsMax.x : boundsMin.x, (corner & 2) ? boundsMax.y : boundsMin.y, (corner & 4) ? boundsMax.z : boundsMin.z);
+			const glm::vec4 clip = viewProjection * glm::vec4(position, 1.0f);
+			if (clip.w <= 0.0f || clip.z < -clip.w) { return false; }
+
+			const ScreenVertex screen = ToScreen(clip);
+			minX = std::min(minX, screen.x);
+			maxX = std::max(maxX, screen.x);
+			minY = std::min(minY, screen.y);
+			maxY = std::max(maxY, screen.y);
+			nearestInverseW = std::max(nearestInverseW, screen.inverseW);
+		}
+
+		// Pixels the box's screen rectangle touches, plus one either side. Occluders only cover the pixels whose centres they contain, so part of an edge pixel can be left uncovered
+		const int startX = std::max(0, (int)std::floor(minX) - 1);
+		const int endX = std::min((int)levelWidths[0] - 1, (int)std::floor(maxX) + 1);
+		const int startY = std::max(0, (int)std::floor(minY) - 1);
+		const int endY = std::min((int)levelHeights[0] - 1, (int)std::floor(maxY) + 1);
+		if (startX > endX || startY > endY) { return false; }
+
+		// Coarsest level where the rectangle spans no more than a couple of texels each way
+		unsigned int level = 0;
+		unsigned int span = std::max(endX - startX, endY - startY) + 1;
+		while (span > 2 && level + 1 < levels.size()) {
+			span = (span + 1) / 2;
+			level++;
+		}
+
+		const std::vector<float>& depth = levels[level];
+		const unsigned int levelWidth = levelWidths[level];
+		for (unsigned int y = startY >> level; y <= ((unsigned int)endY >> level); y++) {
+			for (unsigned int x = startX >> level; x <= ((unsigned int)endX >> level); x++) {
+				// Visible as soon as the farthest occluder depth in any texel is no nearer than the box
+				if (depth[y * levelWidth + x] <= nearestInverseW) { return false; }
+			}
+		}
+		return true;
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include "MeshData.h"
+#include "SIMDLanes.h"
+#include <glm/glm.hpp>
+#include <vector>
+namespace Engine {
+	// Low resolution depth buffer rasterised on the CPU, used to cull meshes hidden behind large occluders without any GPU work
+	// Depth is stored as 1/w, which interpolates linearly across the screen, so a texel nothing was drawn to (0) can never hide anything
+	class OcclusionBuffer
+	{
+	public:
+		static constexpr unsigned int DEFAULT_WIDTH = 256;
+		static constexpr unsigned int DEFAULT_HEIGHT = 128;
+
+		// Width is rounded up to a whole number of lanes
+		OcclusionBuffer(const unsigned int width = DEFAULT_WIDTH, const unsigned int height = DEFAULT_HEIGHT);
+		~OcclusionBuffer() {}
+
+		// Empties the buffer and sets the view projection occluders and boxes are projected with
+		void Clear(const glm::mat4& viewProjection);
+
+		// Draws both faces of every triangle, vertex positions are in model space
+		void RasterizeTriangles(const glm::mat4& model, const std::vector<Vertex>& vertices, const unsigned int* indices, const unsigned int indexCount);
+
+		// Reduces the depth buffer into a pyramid where each texel holds the farthest depth beneath it. Call after the last occluder and before testing
+		void BuildPyramid();
+
+		// True if the box is entirely behind the occluders, boxes crossing the near plane or leaving the screen are never occluded
+		bool IsOccluded(const glm::vec3& boundsMin, const glm::vec3& boundsMax) const;
+
+		unsigned int GetWidth() const { return levelWidths[0]; }
+		unsigned int GetHeight() const { return levelHeights[0]; }
+		unsigned int GetNumLevels() const { return levels.size(); }
+		const std::vector<float>& GetLevel(const unsigned int level) const { return levels[level]; }
+		unsigned int GetRasterizedTriangles() const { return rasterizedTriangles; }
+
+	private:
+		struct ScreenVertex {
+			float x;
+			float y;
+			float inverseW;
+		};
+
+		ScreenVertex ToScreen(const glm::vec4& clip) const;
+		void RasterizeClipTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c);
+
+		// Tests the pixel centres of a row across the lanes
+		template <typename Lanes>
+		void RasterizeScreenTriangle(const ScreenVertex& v0, const ScreenVertex& v1, const ScreenVertex& v2);
+
+		glm::mat4 viewProjection;
+		std::vector<std::vector<float>> levels; // Level 0 is the full resolution depth buffer
+		std::vector<unsigned int> levelWidths;
+		std::vector<unsigned int> levelHeights;
+		std::vector<glm::vec4> clipVertices;
+		unsigned int rasterizedTriangles;
+	};
+}
@@ -0,0 +1,9 @@
+#pragma once
+namespace Engine {
+	// Build an order independent key for a pair of entities
+	inline unsigned long long MakePairKey(const unsigned int entityIDA, const unsigned int entityIDB) {
+		const unsigned long long low = (entityIDA < entityIDB) ? entityIDA : entityIDB;
+		const unsigned long long high = (entityIDA < entityIDB) ? entityIDB : entityIDA;
+		return (high << 32) | low;
+	}
+}
@@ -190,6 +190,7 @@ namespace Engine {
 		ecs.AddComponent(physicsBall->ID(), ComponentGeometry(MODEL_SPHERE));
 		ecs.AddComponent(physicsBall->ID(), ComponentCollisionSphere(1.0f));
 		ecs.AddComponent(physicsBall->ID(), ComponentPhysics(30.0f, 0.47f, 0.5f, true)); // drag coefficient of a sphere, surface area = 0.5
+		ecs.GetComponent<ComponentPhysics>(physicsBall->ID())->SetContinuousCollision(true);
 
 		Entity* physicsBall2 = ecs.New("Ball");
 		transform = ecs.GetComponent<ComponentTransform>(physicsBall2->ID());
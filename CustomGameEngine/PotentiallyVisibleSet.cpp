@@ -0,0 +1,224 @@
+#include "PotentiallyVisibleSet.h"
+#include <algorithm>
+#include <cstdint>
+#include <climits>
+#include <fstream>
+#include <iostream>
+namespace Engine {
+	namespace {
+		constexpr char PVS_MAGIC[4] = { 'P', 'V', 'S', ' ' };
+		constexpr uint32_t PVS_VERSION = 1;
+
+		struct PVSHeader {
+			char magic[4];
+			uint32_t version;
+			float boundsMin[3];
+			float cellSize[3];
+			uint32_t dimensions[3];
+			uint32_t numObjects;
+			uint32_t numRunBytes;
+			uint32_t padding;
+		};
+
+		unsigned int nextVersion = 1;
+	}
+
+	void PotentiallyVisibleSet::Initialise(const glm::vec3& boundsMin, const glm::vec3& cellSize, const glm::uvec3& dimensions, const std::vector<PVSObjectKey>& objects)
+	{
+		this->boundsMin = boundsMin;
+		this->cellSize = cellSize;
+		this->dimensions = dimensions;
+		this->objects = objects;
+		cellOffsets.clear();
+		cellOffsets.reserve(NumCells() + 1);
+		cellOffsets.push_back(0);
+		runData.clear();
+		version = nextVersion++;
+	}
+
+	void PotentiallyVisibleSet::Clear()
+	{
+		dimensions = glm::uvec3(0);
+		objects.clear();
+		cellOffsets.clear();
+		runData.clear();
+		version = nextVersion++;
+	}
+
+	void PotentiallyVisibleSet::AddCell(const std::vector<unsigned char>& visibleObjects)
+	{
+		// Runs alternate hidden then visible. A trailing hidden run is left off, decoding fills the rest as hidden
+		unsigned int index = 0;
+		const unsigned int numObjects = objects.size();
+		while (index < numObjects) {
+			const unsigned int hiddenStart = index;
+			while (index < numObjects && !visibleObjects[index]) { index++; }
+			if (index == numObjects) { break; }
+			WriteRun(runData, index - hiddenStart);
+
+			const unsigned int visibleStart = index;
+			while (index < numObjects && visibleObjects[index]) { index++; }
+			WriteRun(runData, index - visibleStart);
+		}
+		cellOffsets.push_back(runData.size());
+	}
+
+	int PotentiallyVisibleSet::CellAt(const glm::vec3& position) const
+	{
+		if (IsEmpty()) { return -1; }
+		const glm::vec3 local = (position - boundsMin) / cellSize;
+		if (local.x < 0.0f || local.y < 0.0f || local.z < 0.0f) { return -1; }
+
+		const glm::uvec3 cell = glm::uvec3(local);
+		if (cell.x >= dimensions.x || cell.y >= dimensions.y || cell.z >= dimensions.z) { return -1; }
+		return (int)(cell.x + dimensions.x * (cell.y + dimensions.y * cell.z));
+	}
+
+	glm::vec3 PotentiallyVisibleSet::CellMin(const unsigned int cell) const
+	{
+		const unsigned int x = cell % dimensions.x;
+		const unsigned int y = (cell / dimensions.x) % dimensions.y;
+		const unsigned int z = cell / (dimensions.x * dimensions.y);
+		return boundsMin + glm::vec3(x, y, z) * cellSize;
+	}
+
+	void PotentiallyVisibleSet::DecodeCell(const unsigned int cell, std::vector<unsigned char>& out_visibleObjects) const
+	{
+		out_visibleObjects.assign(objects.size(), 0);
+		unsigned int offset = cellOffsets[cell];
+		unsigned int index = 0;
+		while (offset < cellOffsets[cell + 1]) {
+			index = std::min(index + ReadRun(runData, offset), (unsigned int)objects.size());
+			const unsigned int visibleEnd = std::min(index + ReadRun(runData, offset), (unsigned int)objects.size());
+			std::fill(out_visibleObjects.begin() + index, out_visibleObjects.begin() + visibleEnd, 1);
+			index = visibleEnd;
+		}
+	}
+
+	int PotentiallyVisibleSet::FindObject(const PVSObjectKey& key) const
+	{
+		std::vector<PVSObjectKey>::const_iterator it = std::lower_bound(objects.begin(), objects.end(), key);
+		return (it != objects.end() && *it == key) ? (int)(it - objects.begin()) : -1;
+	}
+
+	void PotentiallyVisibleSet::WriteRun(std::vector<unsigned char>& data, unsigned int length)
+	{
+		while (length >= 0x80) {
+			data.push_back((unsigned char)(length & 0x7F) | 0x80);
+			length >>= 7;
+		}
+		data.push_back((unsigned char)length);
+	}
+
+	unsigned int PotentiallyVisibleSet::ReadRun(const std::vector<unsigned char>& data, unsigned int& inout_offset)
+	{
+		unsigned int length = 0;
+		unsigned int shift = 0;
+		while (true) {
+			const unsigned char byte = data[inout_offset++];
+			length |= (unsigned int)(byte & 0x7F) << shift;
+			if (!(byte & 0x80)) { break; }
+			shift += 7;
+		}
+		return length;
+	}
+
+	bool PotentiallyVisibleSet::WriteToFile(const std::string& filepath) const
+	{
+		std::ofstream file(filepath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) {
+			std::cout << "ERROR::POTENTIALLYVISIBLESET::WriteToFile::Unable to open " << filepath << std::endl;
+			return false;
+		}
+
+		PVSHeader header;
+		std::copy(PVS_MAGIC, PVS_MAGIC + 4, header.magic);
+		header.version = PVS_VERSION;
+		for (unsigned int i = 0; i < 3; i++) {
+			header.boundsMin[i] = boundsMin[i];
+			header.cellSize[i] = cellSize[i];
+			header.dimensions[i] = dimensions[i];
+		}
+		header.numObjects = objects.size();
+		header.numRunBytes = runData.size();
+		header.padding = 0;
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(objects.data()), objects.size() * sizeof(PVSObjectKey));
+		file.write(reinterpret_cast<const char*>(cellOffsets.data()), cellOffsets.size() * sizeof(unsigned int));
+		file.write(reinterpret_cast<const char*>(runData.data()), runData.size());
+		return file.good();
+	}
+
+	bool PotentiallyVisibleSet::LoadFromFile(const std::string& filepath)
+	{
+		std::ifstream file(filepath, std::ios::binary);
+		if (!file.is_open()) { return false; }
+
+		PVSHeader header;
+		file.read(reinterpret_cast<char*>(&header), sizeof(header));
+		if (!file || !std::equal(PVS_MAGIC, PVS_MAGIC + 4, header.magic) || header.version != PVS_VERSION) { return false; }
+
+		// A truncated file is caught before anything is allocated from the header's counts
+		const uint64_t numCells = (uint64_t)header.dimensions[0] * header.dimensions[1] * header.dimensions[2];
+		const std::streamoff dataStart = file.tellg();
+		file.seekg(0, std::ios::end);
+		const uint64_t dataSize = (uint64_t)(file.tellg() - dataStart);
+		file.seekg(dataStart);
+		if (numCells >= UINT_MAX || dataSize != ((uint64_t)header.numObjects * sizeof(PVSObjectKey)) + ((numCells + 1) * sizeof(unsigned int)) + header.numRunBytes) {
+			std::cout << "ERROR::POTENTIALLYVISIBLESET::LoadFromFile::Size of " << filepath << " doesn't match its header" << std::endl;
+			return false;
+		}
+
+		std::vector<PVSObjectKey> loadedObjects(header.numObjects);
+		std::vector<unsigned int> loadedOffsets(numCells + 1);
+		std::vector<unsigned char> loadedRuns(header.numRunBytes);
+		file.read(reinterpret_cast<char*>(loadedObjects.data()), loadedObjects.size() * sizeof(PVSObjectKey));
+		file.read(reinterpret_cast<char*>(loadedOffsets.data()), loadedOffsets.size() * sizeof(unsigned int));
+		file.read(reinterpret_cast<char*>(loadedRuns.data()), loadedRuns.size());
+		if (!file) { return false; }
+
+		boundsMin = glm::vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+		cellSize = glm::vec3(header.cellSize[0], header.cellSize[1], header.cellSize[2]);
+		dimensions = glm::uvec3(header.dimensions[0], header.dimensions[1], header.dimensions[2]);
+		objects = std::move(loadedObjects);
+		cellOffsets = std::move(loadedOffsets);
+		runData = std::move(loadedRuns);
+		if (!ValidateCells()) {
+			std::cout << "ERROR::POTENTIALLYVISIBLESET::LoadFromFile::Invalid cells in " << filepath << std::endl;
+			Clear();
+			return false;
+		}
+
+		version = nextVersion++;
+		return true;
+	}
+
+	bool PotentiallyVisibleSet::ValidateCells() const
+	{
+		if (!(cellSize.x > 0.0f && cellSize.y > 0.0f && cellSize.z > 0.0f)) { return false; }
+
+		// FindObject searches the objects, so they must be sorted with no repeats
+		for (unsigned int i = 1; i < objects.size(); i++) {
+			if (!(objects[i - 1] < objects[i])) { return false; }
+		}
+
+		if (cellOffsets.size() != (uint64_t)NumCells() + 1 || cellOffsets.front() != 0 || cellOffsets.back() != runData.size()) { return false; }
+		for (unsigned int cell = 0; cell < NumCells(); cell++) {
+			const unsigned int cellEnd = cellOffsets[cell + 1];
+			if (cellOffsets[cell] > cellEnd || cellEnd > runData.size()) { return false; }
+
+			// Every run must end inside its own cell and fit in 32 bits, and the runs can't cover more objects than there are
+			uint64_t index = 0;
+			unsigned int offset = cellOffsets[cell];
+			while (offset < cellEnd) {
+				unsigned int runEnd = offset;
+				while (runEnd < cellEnd && (runData[runEnd] & 0x80)) { runEnd++; }
+				if (runEnd == cellEnd || runEnd - offset > 4 || (runEnd - offset == 4 && runData[runEnd] > 0x0F)) { return false; }
+				index += ReadRun(runData, offset);
+			}
+			if (index > objects.size()) { return false; }
+		}
+		return true;
+	}
+}
\ No newline at end of file
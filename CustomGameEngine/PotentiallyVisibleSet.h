@@ -0,0 +1,65 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+namespace Engine {
+	// A static mesh the set tracks, meshes are matched up again at runtime by entity and the mesh's index in its model
+	struct PVSObjectKey {
+		unsigned int entityID;
+		unsigned int localMeshID;
+
+		bool operator<(const PVSObjectKey& other) const { return (entityID != other.entityID) ? entityID < other.entityID : localMeshID < other.localMeshID; }
+		bool operator==(const PVSObjectKey& other) const { return entityID == other.entityID && localMeshID == other.localMeshID; }
+	};
+
+	// Static meshes that can be seen from inside each cell of a uniform grid, baked offline by SystemPVSBaking from points sampled over each cell
+	// Each cell's set is stored as alternating run lengths of hidden and visible objects, starting with hidden, each run a variable length integer of 7 bits per byte
+	class PotentiallyVisibleSet
+	{
+	public:
+		PotentiallyVisibleSet() : boundsMin(0.0f), cellSize(1.0f), dimensions(0), version(0) {}
+		~PotentiallyVisibleSet() {}
+
+		// Objects must be sorted, a cell's visibility flags are in the same order
+		void Initialise(const glm::vec3& boundsMin, const glm::vec3& cellSize, const glm::uvec3& dimensions, const std::vector<PVSObjectKey>& objects);
+		void Clear();
+
+		// Cells must be added in order, x fastest then y then z
+		void AddCell(const std::vector<unsigned char>& visibleObjects);
+
+		// Index of the cell holding the position, -1 outside the grid
+		int CellAt(const glm::vec3& position) const;
+		glm::vec3 CellMin(const unsigned int cell) const;
+		void DecodeCell(const unsigned int cell, std::vector<unsigned char>& out_visibleObjects) const;
+
+		// Index into the object list, -1 if the object isn't part of the set
+		int FindObject(const PVSObjectKey& key) const;
+
+		bool IsEmpty() const { return objects.empty() || cellOffsets.size() != NumCells() + 1; }
+		unsigned int NumCells() const { return dimensions.x * dimensions.y * dimensions.z; }
+		const glm::vec3& GetCellSize() const { return cellSize; }
+		const std::vector<PVSObjectKey>& GetObjects() const { return objects; }
+		unsigned int GetEncodedSize() const { return runData.size(); }
+
+		// Changes every time the set is rebuilt or loaded, so anything mapping objects to the set knows to redo it
+		unsigned int GetVersion() const { return version; }
+
+		bool WriteToFile(const std::string& filepath) const;
+		bool LoadFromFile(const std::string& filepath);
+
+	private:
+		static void WriteRun(std::vector<unsigned char>& data, unsigned int length);
+		static unsigned int ReadRun(const std::vector<unsigned char>& data, unsigned int& inout_offset);
+
+		// Objects are sorted, every cell's offsets are in order and inside the run data, and every cell's runs decode without leaving the cell
+		bool ValidateCells() const;
+
+		glm::vec3 boundsMin;
+		glm::vec3 cellSize;
+		glm::uvec3 dimensions;
+		std::vector<PVSObjectKey> objects;
+		std::vector<unsigned int> cellOffsets; // start of each cell's runs, one past the end for the last
+		std::vector<unsigned char> runData;
+		unsigned int version;
+	};
+}
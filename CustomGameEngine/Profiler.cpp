@@ -90,6 +90,7 @@ namespace Engine::Profiling {
 	void Profiler::WriteProfile(const ProfileResult& profile)
 	{
 		if (activeSession) {
+			std::lock_guard<std::mutex> lock(writeMutex);
 			if (profileCount > 0) { outputStream << ","; }
 			profileCount++;
 
@@ -6,6 +6,7 @@
 #include <filesystem>
 #include <chrono>
 #include <ctime>
+#include <mutex>
 namespace Engine::Profiling {
 	struct ProfileResult {
 		ProfileResult(const char* name, const long long start, const long long end, const uint32_t threadID) : profileName(name), start(start), end(end), threadID(threadID) {}
@@ -41,6 +42,8 @@ namespace Engine::Profiling {
 
 		std::chrono::time_point<std::chrono::high_resolution_clock> sessionStart;
 
+		// Scope timers can be written from worker threads
+		std::mutex writeMutex;
 		std::ofstream outputStream;
 		std::string sessionName;
 		unsigned int profileCount;
@@ -34,13 +34,7 @@ namespace Engine {
 			ComponentLight* dirLight = ecs->GetComponent<ComponentLight>(dirLightEntityIDs[0]);
 
 			if (dirLight->CastShadows) {
-				const glm::vec3 lightPos = -dirLight->Direction * dirLight->DirectionalLightDistance; // negative of the directional light's direction
-				const float orthoSize = dirLight->ShadowProjectionSize;
-				const float near = dirLight->Near;
-				const float far = dirLight->Far;
-				const glm::mat4 lightProjection = glm::ortho(-orthoSize, orthoSize, -orthoSize, orthoSize, near, far);
-				const glm::mat4 lightView = glm::lookAt(lightPos, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-				const glm::mat4 lightSpaceMatrix = lightProjection * lightView;
+				const glm::mat4 lightSpaceMatrix = LightManager::DirectionalLightSpaceMatrix(*dirLight);
 
 				depthShader->Use();
 				depthShader->setMat4("lightSpaceMatrix", lightSpaceMatrix);
@@ -51,8 +45,7 @@ namespace Engine {
 				glClear(GL_DEPTH_BUFFER_BIT);
 
 				shadowmapSystem.SetDepthMapType(MAP_2D);
-				View<ComponentTransform, ComponentGeometry> geometryView = ecs->View<ComponentTransform, ComponentGeometry>();
-				geometryView.ForEach(std::function<void(const unsigned int, ComponentTransform&, ComponentGeometry&)>(std::bind(&SystemShadowMapping::OnAction, &shadowmapSystem, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3)));
+				RenderShadowCasters(dirLightEntityIDs[0]);
 			}
 		}
 	}
@@ -93,10 +86,7 @@ namespace Engine {
 					glDrawBuffer(GL_NONE);
 					glReadBuffer(GL_NONE);
 
-					const glm::vec3& lightPos = transformComponent->GetWorldPosition();
-					const glm::mat4 lightProjection = glm::perspective(glm::radians(90.0f), aspect, lightComponent->Near, lightComponent->Far);
-					const glm::mat4 lightView = glm::lookAt(lightPos, lightPos + lightComponent->WorldDirection, glm::vec3(0.0f, 1.0f, 0.0f));
-					const glm::mat4 lightSpaceMatrix = lightProjection * lightView;
+					const glm::mat4 lightSpaceMatrix = LightManager::SpotLightSpaceMatrix(*lightComponent, transformComponent->GetWorldPosition(), lightComponent->WorldDirection, aspect);
 
 					depthShader->Use();
 					depthShader->setMat4("lightSpaceMatrix", lightSpaceMatrix);
@@ -115,8 +105,7 @@ namespace Engine {
 					glViewport(startXY.x, startXY.y, shadowWidth, shadowHeight);
 
 					shadowmapSystem.SetDepthMapType(MAP_2D);
-					View<ComponentTransform, ComponentGeometry> geometryView = ecs->View<ComponentTransform, ComponentGeometry>();
-					geometryView.ForEach(std::function<void(const unsigned int, ComponentTransform&, ComponentGeometry&)>(std::bind(&SystemShadowMapping::OnAction, &shadowmapSystem, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3)));
+					RenderShadowCasters(lightEntitiesIt->second);
 					glBindFramebuffer(GL_FRAMEBUFFER, 0);
 				}
 				else if (lightComponent->GetLightType() == POINT) {
@@ -147,8 +136,7 @@ namespace Engine {
 					glViewport(0, 0, shadowWidth, shadowHeight);
 
 					shadowmapSystem.SetDepthMapType(MAP_CUBE);
-					View<ComponentTransform, ComponentGeometry> geometryView = ecs->View<ComponentTransform, ComponentGeometry>();
-					geometryView.ForEach(std::function<void(const unsigned int, ComponentTransform&, ComponentGeometry&)>(std::bind(&SystemShadowMapping::OnAction, &shadowmapSystem, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3)));
+					RenderShadowCasters(lightEntitiesIt->second);
 					glBindFramebuffer(GL_FRAMEBUFFER, 0);
 				}
 			}
@@ -156,6 +144,19 @@ namespace Engine {
 		}
 	}
 
+	void RenderPipeline::RenderShadowCasters(const unsigned int lightEntityID)
+	{
+		// Lights culled this frame only draw the casters their shadow map can see
+		const DrawList* casters = SystemFrustumCulling::GetShadowCasters(lightEntityID);
+		if (casters) {
+			shadowmapSystem.RenderMeshes(*casters);
+			return;
+		}
+
+		View<ComponentTransform, ComponentGeometry> geometryView = ecs->View<ComponentTransform, ComponentGeometry>();
+		geometryView.ForEach(std::function<void(const unsigned int, ComponentTransform&, ComponentGeometry&)>(std::bind(&SystemShadowMapping::OnAction, &shadowmapSystem, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3)));
+	}
+
 	void RenderPipeline::RunShadowMapSteps()
 	{
 		SCOPE_TIMER("RenderPipeline::RunShadowMapSteps");
@@ -38,6 +38,7 @@ namespace Engine {
 		void virtual DirLightShadowStep();
 		void virtual ActiveLightsShadowStep();
 		void virtual RunShadowMapSteps();
+		void RenderShadowCasters(const unsigned int lightEntityID);
 		void virtual BloomStep(const unsigned int activeBloomTexture);
 		void virtual UIRenderStep();
 		void virtual ForwardParticleRenderStep();
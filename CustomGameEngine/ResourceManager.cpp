@@ -2,6 +2,8 @@
 #include "RenderManager.h"
 #include "AudioManager.h"
 #include "ASSIMPModelLoader.h"
+#include <filesystem>
+#include <algorithm>
 namespace Engine {
 
 	ResourceManager* ResourceManager::instance = nullptr;
@@ -776,6 +778,21 @@ namespace Engine {
 			skeletonsIt++;
 		}
 		resources.animationSkeletons.clear();
+
+		// delete collision meshes
+		std::unordered_map<std::string, TriangleMeshBVH*>::iterator collisionMeshesIt = resources.collisionMeshes.begin();
+		while (collisionMeshesIt != resources.collisionMeshes.end()) {
+			delete collisionMeshesIt->second;
+			collisionMeshesIt++;
+		}
+		resources.collisionMeshes.clear();
+
+		std::unordered_map<std::string, ConvexHull*>::iterator convexHullsIt = resources.convexHulls.begin();
+		while (convexHullsIt != resources.convexHulls.end()) {
+			delete convexHullsIt->second;
+			convexHullsIt++;
+		}
+		resources.convexHulls.clear();
 	}
 
 
@@ -1445,6 +1462,114 @@ namespace Engine {
 		return it->second;
 	}
 
+	TriangleMeshBVH* ResourceManager::LoadCollisionMesh(const std::string& cacheName, const std::vector<Mesh*>& meshes, bool loadInPersistentResources)
+	{
+		TriangleMeshBVH* existing = GetCollisionMesh(cacheName);
+		if (existing) { return existing; }
+
+		// Gather every mesh into one triangle list
+		std::vector<glm::vec3> positions;
+		std::vector<unsigned int> indices;
+		for (const Mesh* mesh : meshes) {
+			const MeshData& meshData = mesh->GetMeshData();
+			const unsigned int baseVertex = positions.size();
+			for (const Vertex& vertex : meshData.GetVertices()) {
+				positions.push_back(vertex.Position);
+			}
+			for (const unsigned int index : meshData.GetIndices()) {
+				indices.push_back(baseVertex + index);
+			}
+		}
+
+		// Cache file names can't contain path separators
+		std::string filename = cacheName;
+		std::replace_if(filename.begin(), filename.end(), [](const char c) { return c == '/' || c == '\\' || c == ':' || c == '.'; }, '_');
+		const std::string directory = "Data/CollisionMesh/";
+		const std::string filepath = directory + filename + ".bvh";
+
+		TriangleMeshBVH* collisionMesh = new TriangleMeshBVH();
+		if (collisionMesh->LoadFromFile(filepath, TriangleMeshBVH::HashSource(positions, indices))) {
+			std::cout << "RESOURCEMANAGER::Loaded cooked collision mesh " << cacheName << std::endl;
+		}
+		else {
+			std::cout << "RESOURCEMANAGER::Cooking collision mesh " << cacheName << std::endl;
+			collisionMesh->Build(positions, indices);
+
+			std::error_code error;
+			std::filesystem::create_directories(directory, error);
+			if (!collisionMesh->WriteToFile(filepath)) {
+				std::cout << "ERROR::RESOURCEMANAGER::LoadCollisionMesh::Unable to cache collision mesh " << cacheName << std::endl;
+			}
+		}
+
+		if (loadInPersistentResources) {
+			persistentResources.collisionMeshes[cacheName] = collisionMesh;
+		}
+		else {
+			tempResources.collisionMeshes[cacheName] = collisionMesh;
+		}
+		return collisionMesh;
+	}
+
+	TriangleMeshBVH* ResourceManager::GetCollisionMesh(const std::string& cacheName)
+	{
+		std::unordered_map<std::string, TriangleMeshBVH*>::iterator persistentIt = persistentResources.collisionMeshes.find(cacheName);
+		std::unordered_map<std::string, TriangleMeshBVH*>::iterator tempIt = tempResources.collisionMeshes.find(cacheName);
+
+		if (persistentIt != persistentResources.collisionMeshes.end()) {
+			return persistentIt->second;
+		}
+		else if (tempIt != tempResources.collisionMeshes.end()) {
+			return tempIt->second;
+		}
+		else {
+			return nullptr;
+		}
+	}
+
+	ConvexHull* ResourceManager::LoadConvexHull(const std::string& hullName, const std::vector<Mesh*>& meshes, const unsigned int maxVertices, bool loadInPersistentResources)
+	{
+		ConvexHull* existing = GetConvexHull(hullName);
+		if (existing) { return existing; }
+
+		std::vector<glm::vec3> positions;
+		for (const Mesh* mesh : meshes) {
+			for (const Vertex& vertex : mesh->GetMeshData().GetVertices()) {
+				positions.push_back(vertex.Position);
+			}
+		}
+
+		// A failed build leaves the hull empty, colliders using it are skipped
+		ConvexHull* hull = new ConvexHull();
+		if (!hull->Build(positions, maxVertices)) {
+			std::cout << "ERROR::RESOURCEMANAGER::LoadConvexHull::Unable to build convex hull " << hullName << ", the meshes are flat or empty" << std::endl;
+		}
+
+		if (loadInPersistentResources) {
+			persistentResources.convexHulls[hullName] = hull;
+		}
+		else {
+			tempResources.convexHulls[hullName] = hull;
+		}
+		return hull;
+	}
+
+	ConvexHull* ResourceManager::GetConvexHull(const std::string& hullName)
+	{
+		std::unordered_map<std::string, ConvexHull*>::iterator persistentIt = persistentResources.convexHulls.find(hullName);
+		std::unordered_map<std::string, ConvexHull*>::iterator tempIt = tempResources.convexHulls.find(hullName);
+
+		if (persistentIt != persistentResources.convexHulls.end()) {
+			return persistentIt->second;
+		}
+		else if (tempIt != tempResources.convexHulls.end()) {
+			return tempIt->second;
+		}
+		else {
+			return nullptr;
+		}
+	}
+
 	AbstractMaterial* ResourceManager::GetMaterial(const std::string& materialName)
 	{
 		std::unordered_map<std::string, AbstractMaterial*>::iterator persistentIt = persistentResources.materials.find(materialName);
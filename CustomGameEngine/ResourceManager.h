@@ -8,6 +8,8 @@
 #include "SkeletalAnimation.h"
 #include "AudioFile.h"
 #include FT_FREETYPE_H
+#include "TriangleMeshBVH.h"
+#include "ConvexHull.h"
 namespace Engine {
 	struct Cubemap {
 		unsigned int id;
@@ -42,6 +44,8 @@ namespace Engine {
 		std::unordered_map<std::string, AudioFile*> audioFiles;
 		std::unordered_map<std::string, AbstractMaterial*> materials;
 		std::unordered_map<std::string, AnimationSkeleton*> animationSkeletons;
+		std::unordered_map<std::string, TriangleMeshBVH*> collisionMeshes;
+		std::unordered_map<std::string, ConvexHull*> convexHulls;
 	};
 
 	enum AnisotropicFiltering;
@@ -153,6 +157,11 @@ namespace Engine {
 		SkeletalAnimation* LoadAnimation(std::string filepath, int fileAnimationIndex = 0, bool loadInPersistentResources = false);
 		AudioFile* LoadAudio(std::string filepath, float defaultVolume = 1.0f, float defaultPan = 0.0f, float defaultMinAttenuationDistance = 1.0f, float defaultMaxAttenuationDistance = FLT_MAX, bool loadInPersistentResources = false);
 
+		// Triangle tree over every mesh's vertices, in the meshes' local space. Cooked trees are cached in Data/CollisionMesh/ and reused while the source data is unchanged
+		TriangleMeshBVH* LoadCollisionMesh(const std::string& cacheName, const std::vector<Mesh*>& meshes, bool loadInPersistentResources = false);
+		// One hull around every mesh's vertices, in the meshes' local space. Built the first time a model asks for it and shared by every collider after that
+		ConvexHull* LoadConvexHull(const std::string& hullName, const std::vector<Mesh*>& meshes, const unsigned int maxVertices = ConvexHull::DEFAULT_MAX_VERTICES, bool loadInPersistentResources = false);
+
 		bool AddMeshData(const std::string& fileNamePlusMeshName, MeshData* meshData, bool persistentResources = false) {
 			std::unordered_map<std::string, MeshData*>::iterator persistentIt = this->persistentResources.meshes.find(fileNamePlusMeshName);
 			std::unordered_map<std::string, MeshData*>::iterator tempIt = this->tempResources.meshes.find(fileNamePlusMeshName);
@@ -194,6 +203,8 @@ namespace Engine {
 		AudioFile* GetAudio(const std::string& filepath);
 		AbstractMaterial* GetMaterial(const std::string& materialName);
 		AnimationSkeleton* GetAnimationSkeleton(const std::string& filename);
+		TriangleMeshBVH* GetCollisionMesh(const std::string& cacheName);
+		ConvexHull* GetConvexHull(const std::string& hullName);
 		bool AddMaterial(const std::string& materialName, AbstractMaterial* material, bool persistentResources = false) {
 			std::unordered_map<std::string, AbstractMaterial*>::iterator persistentIt = this->persistentResources.materials.find(materialName);
 			std::unordered_map<std::string, AbstractMaterial*>::iterator tempIt = this->tempResources.materials.find(materialName);
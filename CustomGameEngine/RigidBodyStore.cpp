@@ -0,0 +1,282 @@
+#include "RigidBodyStore.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include "SIMDLanes.h"
+namespace Engine {
+	namespace {
+		// Arrays are padded to the widest lane count so a batch loop never reads past the end
+		constexpr unsigned int BATCH_ALIGNMENT = MAX_LANE_WIDTH;
+
+		unsigned int RoundUpToBatch(const unsigned int count) {
+			return (count + BATCH_ALIGNMENT - 1) & ~(BATCH_ALIGNMENT - 1);
+		}
+	}
+
+	unsigned int RigidBodyStore::SimdWidth()
+	{
+		return WideLanes::width;
+	}
+
+	void RigidBodyStore::Reserve(const unsigned int newCount)
+	{
+		if (newCount <= positionX.size()) { return; }
+		const unsigned int capacity = RoundUpToBatch(std::max(newCount, (unsigned int)positionX.size() * 2));
+
+		for (std::vector<float>* array : { &positionX, &positionY, &positionZ, &orientationX, &orientationY, &orientationZ, &velocityX, &velocityY, &velocityZ, &angularVelocityX, &angularVelocityY, &angularVelocityZ,
+			&forceX, &forceY, &forceZ, &torqueX, &torqueY, &torqueZ, &inverseMass, &gravityScale, &dragFactor, &localInverseInertiaX, &localInverseInertiaY, &localInverseInertiaZ,
+			&inverseInertiaXX, &inverseInertiaXY, &inverseInertiaXZ, &inverseInertiaYY, &inverseInertiaYZ, &inverseInertiaZZ }) {
+			array->resize(capacity, 0.0f);
+		}
+
+		// Padding lanes are static bodies with an identity orientation so normalising them stays finite
+		orientationW.resize(capacity, 1.0f);
+	}
+
+	void RigidBodyStore::Add(const unsigned int entityID, ComponentTransform* transform, ComponentPhysics* physics)
+	{
+		Add(transform->Position(), transform->GetOrientation(), physics->Velocity(), physics->AngularVelocity(), physics->InverseMass(), physics->InverseInertia(), physics->DragCoefficient(), physics->SurfaceArea(), physics->Gravity());
+
+		const unsigned int index = count - 1;
+		entities.push_back({ entityID, transform, physics });
+
+		const glm::vec3& force = physics->Force();
+		forceX[index] = force.x;
+		forceY[index] = force.y;
+		forceZ[index] = force.z;
+
+		const glm::vec3& torque = physics->Torque();
+		torqueX[index] = torque.x;
+		torqueY[index] = torque.y;
+		torqueZ[index] = torque.z;
+	}
+
+	void RigidBodyStore::Add(const glm::vec3& position, const glm::quat& orientation, const glm::vec3& velocity, const glm::vec3& angularVelocity, const float inverseMass, const glm::vec3& localInverseInertia, const float dragCoefficient, const float surfaceArea, const bool gravity)
+	{
+		const unsigned int index = count;
+		Reserve(count + 1);
+		count++;
+
+		positionX[index] = position.x;
+		positionY[index] = position.y;
+		positionZ[index] = position.z;
+
+		orientationX[index] = orientation.x;
+		orientationY[index] = orientation.y;
+		orientationZ[index] = orientation.z;
+		orientationW[index] = orientation.w;
+
+		velocityX[index] = velocity.x;
+		velocityY[index] = velocity.y;
+		velocityZ[index] = velocity.z;
+
+		angularVelocityX[index] = angularVelocity.x;
+		angularVelocityY[index] = angularVelocity.y;
+		angularVelocityZ[index] = angularVelocity.z;
+
+		forceX[index] = 0.0f;
+		forceY[index] = 0.0f;
+		forceZ[index] = 0.0f;
+		torqueX[index] = 0.0f;
+		torqueY[index] = 0.0f;
+		torqueZ[index] = 0.0f;
+
+		this->inverseMass[index] = inverseMass;
+		gravityScale[index] = (gravity && inverseMass > 0.0f) ? 1.0f : 0.0f;
+		dragFactor[index] = 0.5f * dragCoefficient * surfaceArea;
+
+		localInverseInertiaX[index] = localInverseInertia.x;
+		localInverseInertiaY[index] = localInverseInertia.y;
+		localInverseInertiaZ[index] = localInverseInertia.z;
+	}
+
+	void RigidBodyStore::SetPosition(const unsigned int index, const glm::vec3& position)
+	{
+		positionX[index] = position.x;
+		positionY[index] = position.y;
+		positionZ[index] = position.z;
+	}
+
+	void RigidBodyStore::SetVelocity(const unsigned int index, const glm::vec3& velocity)
+	{
+		velocityX[index] = velocity.x;
+		velocityY[index] = velocity.y;
+		velocityZ[index] = velocity.z;
+	}
+
+	void RigidBodyStore::Integrate(const float dt, const glm::vec3& gravityAcceleration, const float airDensity)
+	{
+		IntegrateWith<WideLanes>(dt, gravityAcceleration, airDensity);
+	}
+
+	void RigidBodyStore::IntegrateScalar(const float dt, const glm::vec3& gravityAcceleration, const float airDensity)
+	{
+		IntegrateWith<ScalarLanes>(dt, gravityAcceleration, airDensity);
+	}
+
+	template <typename Lanes>
+	void RigidBodyStore::IntegrateWith(const float dt, const glm::vec3& gravityAcceleration, const float airDensity)
+	{
+		using F = typename Lanes::Float;
+		const F deltaTime = Lanes::Set(dt);
+		const F halfDeltaTime = Lanes::Set(0.5f * dt);
+		const F one = Lanes::Set(1.0f);
+		const F two = Lanes::Set(2.0f);
+		const F density = Lanes::Set(airDensity);
+		const F gravityX = Lanes::Set(gravityAcceleration.x);
+		const F gravityY = Lanes::Set(gravityAcceleration.y);
+		const F gravityZ = Lanes::Set(gravityAcceleration.z);
+
+		const unsigned int end = RoundUpToBatch(count);
+		for (unsigned int i = 0; i < end; i += Lanes::width) {
+			F vx = Lanes::Load(&velocityX[i]);
+			F vy = Lanes::Load(&velocityY[i]);
+			F vz = Lanes::Load(&velocityZ[i]);
+			const F invMass = Lanes::Load(&inverseMass[i]);
+			const F gravityOn = Lanes::Load(&gravityScale[i]);
+
+			// Drag opposes velocity with magnitude 0.5 * Cd * rho * A * |v|^2, so per unit of velocity it scales with |v|
+			const F speed = Lanes::Sqrt(Lanes::Add(Lanes::Add(Lanes::Mul(vx, vx), Lanes::Mul(vy, vy)), Lanes::Mul(vz, vz)));
+			const F drag = Lanes::Mul(Lanes::Mul(Lanes::Mul(Lanes::Load(&dragFactor[i]), density), speed), invMass);
+
+			const F ax = Lanes::Sub(Lanes::Add(Lanes::Mul(Lanes::Load(&forceX[i]), invMass), Lanes::Mul(gravityX, gravityOn)), Lanes::Mul(vx, drag));
+			const F ay = Lanes::Sub(Lanes::Add(Lanes::Mul(Lanes::Load(&forceY[i]), invMass), Lanes::Mul(gravityY, gravityOn)), Lanes::Mul(vy, drag));
+			const F az = Lanes::Sub(Lanes::Add(Lanes::Mul(Lanes::Load(&forceZ[i]), invMass), Lanes::Mul(gravityZ, gravityOn)), Lanes::Mul(vz, drag));
+
+			vx = Lanes::Add(vx, Lanes::Mul(ax, deltaTime));
+			vy = Lanes::Add(vy, Lanes::Mul(ay, deltaTime));
+			vz = Lanes::Add(vz, Lanes::Mul(az, deltaTime));
+			Lanes::Store(&velocityX[i], vx);
+			Lanes::Store(&velocityY[i], vy);
+			Lanes::Store(&velocityZ[i], vz);
+
+			Lanes::Store(&positionX[i], Lanes::Add(Lanes::Load(&positionX[i]), Lanes::Mul(vx, deltaTime)));
+			Lanes::Store(&positionY[i], Lanes::Add(Lanes::Load(&positionY[i]), Lanes::Mul(vy, deltaTime)));
+			Lanes::Store(&positionZ[i], Lanes::Add(Lanes::Load(&positionZ[i]), Lanes::Mul(vz, deltaTime)));
+
+			// World inverse inertia R * D * R^T from the start of step orientation
+			F qx = Lanes::Load(&orientationX[i]);
+			F qy = Lanes::Load(&orientationY[i]);
+			F qz = Lanes::Load(&orientationZ[i]);
+			F qw = Lanes::Load(&orientationW[i]);
+
+			const F xx = Lanes::Mul(qx, qx), yy = Lanes::Mul(qy, qy), zz = Lanes::Mul(qz, qz);
+			const F xy = Lanes::Mul(qx, qy), xz = Lanes::Mul(qx, qz), yz = Lanes::Mul(qy, qz);
+			const F wx = Lanes::Mul(qw, qx), wy = Lanes::Mul(qw, qy), wz = Lanes::Mul(qw, qz);
+
+			const F r00 = Lanes::Sub(one, Lanes::Mul(two, Lanes::Add(yy, zz)));
+			const F r01 = Lanes::Mul(two, Lanes::Sub(xy, wz));
+			const F r02 = Lanes::Mul(two, Lanes::Add(xz, wy));
+			const F r10 = Lanes::Mul(two, Lanes::Add(xy, wz));
+			const F r11 = Lanes::Sub(one, Lanes::Mul(two, Lanes::Add(xx, zz)));
+			const F r12 = Lanes::Mul(two, Lanes::Sub(yz, wx));
+			const F r20 = Lanes::Mul(two, Lanes::Sub(xz, wy));
+			const F r21 = Lanes::Mul(two, Lanes::Add(yz, wx));
+			const F r22 = Lanes::Sub(one, Lanes::Mul(two, Lanes::Add(xx, yy)));
+
+			const F dx = Lanes::Load(&localInverseInertiaX[i]);
+			const F dy = Lanes::Load(&localInverseInertiaY[i]);
+			const F dz = Lanes::Load(&localInverseInertiaZ[i]);
+
+			// Row i of R scaled by D, dotted with row j of R
+			const F r0x = Lanes::Mul(r00, dx), r0y = Lanes::Mul(r01, dy), r0z = Lanes::Mul(r02, dz);
+			const F r1x = Lanes::Mul(r10, dx), r1y = Lanes::Mul(r11, dy), r1z = Lanes::Mul(r12, dz);
+			const F ixx = Lanes::Add(Lanes::Add(Lanes::Mul(r0x, r00), Lanes::Mul(r0y, r01)), Lanes::Mul(r0z, r02));
+			const F ixy = Lanes::Add(Lanes::Add(Lanes::Mul(r0x, r10), Lanes::Mul(r0y, r11)), Lanes::Mul(r0z, r12));
+			const F ixz = Lanes::Add(Lanes::Add(Lanes::Mul(r0x, r20), Lanes::Mul(r0y, r21)), Lanes::Mul(r0z, r22));
+			const F iyy = Lanes::Add(Lanes::Add(Lanes::Mul(r1x, r10), Lanes::Mul(r1y, r11)), Lanes::Mul(r1z, r12));
+			const F iyz = Lanes::Add(Lanes::Add(Lanes::Mul(r1x, r20), Lanes::Mul(r1y, r21)), Lanes::Mul(r1z, r22));
+			const F izz = Lanes::Add(Lanes::Add(Lanes::Mul(Lanes::Mul(r20, dx), r20), Lanes::Mul(Lanes::Mul(r21, dy), r21)), Lanes::Mul(Lanes::Mul(r22, dz), r22));
+			Lanes::Store(&inverseInertiaXX[i], ixx);
+			Lanes::Store(&inverseInertiaXY[i], ixy);
+			Lanes::Store(&inverseInertiaXZ[i], ixz);
+			Lanes::Store(&inverseInertiaYY[i], iyy);
+			Lanes::Store(&inverseInertiaYZ[i], iyz);
+			Lanes::Store(&inverseInertiaZZ[i], izz);
+
+			// Angular velocity from torque
+			const F tx = Lanes::Load(&torqueX[i]);
+			const F ty = Lanes::Load(&torqueY[i]);
+			const F tz = Lanes::Load(&torqueZ[i]);
+			const F wvx = Lanes::Add(Lanes::Load(&angularVelocityX[i]), Lanes::Mul(Lanes::Add(Lanes::Add(Lanes::Mul(ixx, tx), Lanes::Mul(ixy, ty)), Lanes::Mul(ixz, tz)), deltaTime));
+			const F wvy = Lanes::Add(Lanes::Load(&angularVelocityY[i]), Lanes::Mul(Lanes::Add(Lanes::Add(Lanes::Mul(ixy, tx), Lanes::Mul(iyy, ty)), Lanes::Mul(iyz, tz)), deltaTime));
+			const F wvz = Lanes::Add(Lanes::Load(&angularVelocityZ[i]), Lanes::Mul(Lanes::Add(Lanes::Add(Lanes::Mul(ixz, tx), Lanes::Mul(iyz, ty)), Lanes::Mul(izz, tz)), deltaTime));
+			Lanes::Store(&angularVelocityX[i], wvx);
+			Lanes::Store(&angularVelocityY[i], wvy);
+			Lanes::Store(&angularVelocityZ[i], wvz);
+
+			// q += 0.5 * dt * (w, 0) * q, then renormalise
+			const F dqx = Lanes::Mul(halfDeltaTime, Lanes::Sub(Lanes::Add(Lanes::Mul(qw, wvx), Lanes::Mul(wvy, qz)), Lanes::Mul(wvz, qy)));
+			const F dqy = Lanes::Mul(halfDeltaTime, Lanes::Sub(Lanes::Add(Lanes::Mul(qw, wvy), Lanes::Mul(wvz, qx)), Lanes::Mul(wvx, qz)));
+			const F dqz = Lanes::Mul(halfDeltaTime, Lanes::Sub(Lanes::Add(Lanes::Mul(qw, wvz), Lanes::Mul(wvx, qy)), Lanes::Mul(wvy, qx)));
+			const F dqw = Lanes::Mul(halfDeltaTime, Lanes::Add(Lanes::Add(Lanes::Mul(wvx, qx), Lanes::Mul(wvy, qy)), Lanes::Mul(wvz, qz)));
+			qx = Lanes::Add(qx, dqx);
+			qy = Lanes::Add(qy, dqy);
+			qz = Lanes::Add(qz, dqz);
+			qw = Lanes::Sub(qw, dqw);
+
+			const F inverseLength = Lanes::Rsqrt(Lanes::Add(Lanes::Add(Lanes::Mul(qx, qx), Lanes::Mul(qy, qy)), Lanes::Add(Lanes::Mul(qz, qz), Lanes::Mul(qw, qw))));
+			Lanes::Store(&orientationX[i], Lanes::Mul(qx, inverseLength));
+			Lanes::Store(&orientationY[i], Lanes::Mul(qy, inverseLength));
+			Lanes::Store(&orientationZ[i], Lanes::Mul(qz, inverseLength));
+			Lanes::Store(&orientationW[i], Lanes::Mul(qw, inverseLength));
+		}
+	}
+
+	void RigidBodyStore::WriteBack()
+	{
+		for (unsigned int i = 0; i < count; i++) {
+			const BodyComponents& body = entities[i];
+
+			glm::mat3 inverseInertiaTensor;
+			inverseInertiaTensor[0] = glm::vec3(inverseInertiaXX[i], inverseInertiaXY[i], inverseInertiaXZ[i]);
+			inverseInertiaTensor[1] = glm::vec3(inverseInertiaXY[i], inverseInertiaYY[i], inverseInertiaYZ[i]);
+			inverseInertiaTensor[2] = glm::vec3(inverseInertiaXZ[i], inverseInertiaYZ[i], inverseInertiaZZ[i]);
+
+			body.physics->SetVelocity(glm::vec3(velocityX[i], velocityY[i], velocityZ[i]));
+			body.physics->SetAngularVelocity(glm::vec3(angularVelocityX[i], angularVelocityY[i], angularVelocityZ[i]));
+			body.physics->SetInverseInertiaTensor(inverseInertiaTensor);
+			body.physics->ClearForces();
+			body.physics->SetTorque(glm::vec3(0.0f));
+
+			// glm::quat takes w first
+			body.transform->SetPositionAndOrientation(glm::vec3(positionX[i], positionY[i], positionZ[i]), glm::quat(orientationW[i], orientationX[i], orientationY[i], orientationZ[i]));
+		}
+	}
+
+	void RigidBodyStore::Benchmark(const unsigned int numBodies, const unsigned int numSteps)
+	{
+		RigidBodyStore scalarStore;
+		for (unsigned int i = 0; i < numBodies; i++) {
+			const float f = (float)i;
+			scalarStore.Add(glm::vec3(f, f * 0.5f, -f), glm::normalize(glm::quat(1.0f, 0.01f * f, 0.0f, 0.0f)), glm::vec3(1.0f, 2.0f, 0.5f), glm::vec3(0.1f, 0.2f, 0.3f), 0.1f, glm::vec3(0.25f), 1.05f, 1.0f, true);
+		}
+		RigidBodyStore wideStore = scalarStore;
+
+		const glm::vec3 gravity = glm::vec3(0.0f, -9.8f, 0.0f);
+		const float dt = 1.0f / 120.0f;
+
+		auto time = [&](RigidBodyStore& store, void (RigidBodyStore::*integrate)(const float, const glm::vec3&, const float)) {
+			const std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+			for (unsigned int step = 0; step < numSteps; step++) {
+				(store.*integrate)(dt, gravity, 1.225f);
+			}
+			const std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+			return elapsed.count() / numSteps;
+		};
+
+		const double scalarMs = time(scalarStore, &RigidBodyStore::IntegrateScalar);
+		const double wideMs = time(wideStore, &RigidBodyStore::Integrate);
+
+		// Both paths do the same operations in the same order, anything beyond rounding means the wide path is broken
+		float maxDifference = 0.0f;
+		for (unsigned int i = 0; i < numBodies; i++) {
+			maxDifference = std::max(maxDifference, glm::length(scalarStore.Position(i) - wideStore.Position(i)));
+		}
+
+		std::cout << "RIGIDBODYSTORE::BENCHMARK::" << numBodies << " bodies, " << numSteps << " steps" << std::endl;
+		std::cout << "    Scalar:           " << scalarMs << "ms per step" << std::endl;
+		std::cout << "    Wide (" << SimdWidth() << " lanes):   " << wideMs << "ms per step (" << (scalarMs / wideMs) << "x)" << std::endl;
+		std::cout << "    Largest position difference: " << maxDifference << std::endl;
+	}
+}
\ No newline at end of file
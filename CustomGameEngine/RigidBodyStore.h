@@ -0,0 +1,77 @@
+#pragma once
+#include "ComponentTransform.h"
+#include "ComponentPhysics.h"
+#include <vector>
+namespace Engine {
+	// Awake rigid bodies gathered into structure of arrays form so integration can run several bodies per instruction
+	// Filled from components at the start of a physics step, integrated in one pass, then written back to the components
+	class RigidBodyStore
+	{
+	public:
+		RigidBodyStore() : count(0) {}
+		~RigidBodyStore() {}
+
+		// Bodies processed per SIMD instruction, 8 with AVX, 4 with SSE and 1 otherwise
+		static unsigned int SimdWidth();
+
+		void Clear() { count = 0; entities.clear(); }
+		unsigned int Size() const { return count; }
+
+		void Add(const unsigned int entityID, ComponentTransform* transform, ComponentPhysics* physics);
+
+		// Semi-implicit Euler over every body: forces, gravity and drag into velocity, velocity into position and orientation
+		// gravityAcceleration is the full gravity vector, airDensity is in kg/m3
+		void Integrate(const float dt, const glm::vec3& gravityAcceleration, const float airDensity);
+		void IntegrateScalar(const float dt, const glm::vec3& gravityAcceleration, const float airDensity);
+
+		// Integrated position of a body, the transform keeps the start of step position until write back
+		glm::vec3 Position(const unsigned int index) const { return glm::vec3(positionX[index], positionY[index], positionZ[index]); }
+		void SetPosition(const unsigned int index, const glm::vec3& position);
+		glm::vec3 Velocity(const unsigned int index) const { return glm::vec3(velocityX[index], velocityY[index], velocityZ[index]); }
+		void SetVelocity(const unsigned int index, const glm::vec3& velocity);
+
+		unsigned int EntityID(const unsigned int index) const { return entities[index].entityID; }
+		ComponentTransform* Transform(const unsigned int index) const { return entities[index].transform; }
+		ComponentPhysics* Physics(const unsigned int index) const { return entities[index].physics; }
+
+		// Copy results back to the gathered components and clear their accumulated force and torque
+		void WriteBack();
+
+		// Times the scalar and wide integration paths over numBodies synthetic bodies and prints both, along with how far apart their results ended up
+		// Run headless with the --benchmark-integration command line argument
+		static void Benchmark(const unsigned int numBodies, const unsigned int numSteps = 100);
+
+	private:
+		struct BodyComponents {
+			unsigned int entityID;
+			ComponentTransform* transform;
+			ComponentPhysics* physics;
+		};
+
+		// Appends the body's state to the arrays, the components are recorded by the caller
+		void Add(const glm::vec3& position, const glm::quat& orientation, const glm::vec3& velocity, const glm::vec3& angularVelocity, const float inverseMass, const glm::vec3& localInverseInertia, const float dragCoefficient, const float surfaceArea, const bool gravity);
+
+		// Arrays are kept padded to a whole number of SIMD batches with harmless bodies, so kernels never need a remainder loop
+		void Reserve(const unsigned int newCount);
+
+		template <typename Kernel>
+		void IntegrateWith(const float dt, const glm::vec3& gravityAcceleration, const float airDensity);
+
+		unsigned int count;
+		std::vector<BodyComponents> entities;
+
+		std::vector<float> positionX, positionY, positionZ;
+		std::vector<float> orientationX, orientationY, orientationZ, orientationW;
+		std::vector<float> velocityX, velocityY, velocityZ;
+		std::vector<float> angularVelocityX, angularVelocityY, angularVelocityZ;
+		std::vector<float> forceX, forceY, forceZ;
+		std::vector<float> torqueX, torqueY, torqueZ;
+		std::vector<float> inverseMass;
+		std::vector<float> gravityScale; // 1 for bodies affected by gravity, 0 otherwise
+		std::vector<float> dragFactor; // 0.5 * drag coefficient * surface area, air density is applied per step
+		std::vector<float> localInverseInertiaX, localInverseInertiaY, localInverseInertiaZ;
+
+		// Symmetric world space inverse inertia tensor at the start of the step, only the upper triangle is stored
+		std::vector<float> inverseInertiaXX, inverseInertiaXY, inverseInertiaXZ, inverseInertiaYY, inverseInertiaYZ, inverseInertiaZZ;
+	};
+}
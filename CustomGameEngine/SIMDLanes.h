@@ -0,0 +1,81 @@
+#pragma once
+#include <cmath>
+#if defined(__AVX__) || defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+namespace Engine {
+	// Float lane wrappers so structure of arrays loops can be written once as a template over the lane type
+	// WideLanes is AVX (8 lanes) when the build enables it, SSE (4 lanes) on any x64 target and falls back to ScalarLanes otherwise
+
+	// Plain float operations in the same order as the wide versions, so code written over lanes gives the same results as the equivalent scalar code
+	struct ScalarLanes {
+		using Float = float;
+		static constexpr unsigned int width = 1;
+		static Float Load(const float* p) { return *p; }
+		static void Store(float* p, const Float a) { *p = a; }
+		static Float Set(const float a) { return a; }
+		static Float Add(const Float a, const Float b) { return a + b; }
+		static Float Sub(const Float a, const Float b) { return a - b; }
+		static Float Mul(const Float a, const Float b) { return a * b; }
+		static Float Min(const Float a, const Float b) { return (b < a) ? b : a; }
+		static Float Max(const Float a, const Float b) { return (a < b) ? b : a; }
+		static Float Sqrt(const Float a) { return std::sqrt(a); }
+		static Float Rsqrt(const Float a) { return 1.0f / std::sqrt(a); }
+		static unsigned int LessMask(const Float a, const Float b) { return (a < b) ? 1u : 0u; }
+		static void StoreLess(unsigned char* out, const Float a, const Float b) { out[0] = (a < b) ? 1 : 0; }
+		// Picks ifLess where a < b and otherwise elsewhere
+		static Float SelectLess(const Float a, const Float b, const Float ifLess, const Float otherwise) { return (a < b) ? ifLess : otherwise; }
+	};
+
+#if defined(__AVX__)
+	struct WideLanes {
+		using Float = __m256;
+		static constexpr unsigned int width = 8;
+		static Float Load(const float* p) { return _mm256_loadu_ps(p); }
+		static void Store(float* p, const Float a) { _mm256_storeu_ps(p, a); }
+		static Float Set(const float a) { return _mm256_set1_ps(a); }
+		static Float Add(const Float a, const Float b) { return _mm256_add_ps(a, b); }
+		static Float Sub(const Float a, const Float b) { return _mm256_sub_ps(a, b); }
+		static Float Mul(const Float a, const Float b) { return _mm256_mul_ps(a, b); }
+		static Float Min(const Float a, const Float b) { return _mm256_min_ps(a, b); }
+		static Float Max(const Float a, const Float b) { return _mm256_max_ps(a, b); }
+		static Float Sqrt(const Float a) { return _mm256_sqrt_ps(a); }
+		static Float Rsqrt(const Float a) { return _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(a)); }
+		static unsigned int LessMask(const Float a, const Float b) { return (unsigned int)_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_LT_OQ)); }
+		static void StoreLess(unsigned char* out, const Float a, const Float b) {
+			const unsigned int bits = LessMask(a, b);
+			for (unsigned int i = 0; i < width; i++) { out[i] = (bits >> i) & 1; }
+		}
+		static Float SelectLess(const Float a, const Float b, const Float ifLess, const Float otherwise) { return _mm256_blendv_ps(otherwise, ifLess, _mm256_cmp_ps(a, b, _CMP_LT_OQ)); }
+	};
+#elif defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+	struct WideLanes {
+		using Float = __m128;
+		static constexpr unsigned int width = 4;
+		static Float Load(const float* p) { return _mm_loadu_ps(p); }
+		static void Store(float* p, const Float a) { _mm_storeu_ps(p, a); }
+		static Float Set(const float a) { return _mm_set1_ps(a); }
+		static Float Add(const Float a, const Float b) { return _mm_add_ps(a, b); }
+		static Float Sub(const Float a, const Float b) { return _mm_sub_ps(a, b); }
+		static Float Mul(const Float a, const Float b) { return _mm_mul_ps(a, b); }
+		static Float Min(const Float a, const Float b) { return _mm_min_ps(a, b); }
+		static Float Max(const Float a, const Float b) { return _mm_max_ps(a, b); }
+		static Float Sqrt(const Float a) { return _mm_sqrt_ps(a); }
+		static Float Rsqrt(const Float a) { return _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(a)); }
+		static unsigned int LessMask(const Float a, const Float b) { return (unsigned int)_mm_movemask_ps(_mm_cmplt_ps(a, b)); }
+		static void StoreLess(unsigned char* out, const Float a, const Float b) {
+			const unsigned int bits = LessMask(a, b);
+			for (unsigned int i = 0; i < width; i++) { out[i] = (bits >> i) & 1; }
+		}
+		static Float SelectLess(const Float a, const Float b, const Float ifLess, const Float otherwise) {
+			const Float less = _mm_cmplt_ps(a, b);
+			return _mm_or_ps(_mm_and_ps(less, ifLess), _mm_andnot_ps(less, otherwise));
+		}
+	};
+#else
+	using WideLanes = ScalarLanes;
+#endif
+
+	// Widest lane count any WideLanes can have, structure of arrays data padded to a multiple of this can always be read in whole batches
+	constexpr unsigned int MAX_LANE_WIDTH = 8;
+}
@@ -5,11 +5,12 @@ namespace Engine
 {
 	float Scene::dt;
 
-	Scene::Scene(SceneManager* sceneManager, const std::string& name) : rebuildBVHOnUpdate(false), SCR_WIDTH(sceneManager->GetWindowWidth()), SCR_HEIGHT(sceneManager->GetWindowHeight()), camera(new Camera(SCR_WIDTH, SCR_HEIGHT, glm::vec3(0.0f, 0.0f, 5.0f))), collisionManager(new CollisionManager()), constraintManager(new ConstraintManager()), systemManager(&ecs),
+	Scene::Scene(SceneManager* sceneManager, const std::string& name) : rebuildBVHOnUpdate(false), interpolatePhysicsBodies(true), SCR_WIDTH(sceneManager->GetWindowWidth()), SCR_HEIGHT(sceneManager->GetWindowHeight()), camera(new Camera(SCR_WIDTH, SCR_HEIGHT, glm::vec3(0.0f, 0.0f, 5.0f))), collisionManager(new CollisionManager()), constraintManager(new ConstraintManager()), systemManager(&ecs, &dt),
+		islandBuilder(collisionManager, constraintManager),
 		collisionResolver(collisionManager),
 		constraintSolver(constraintManager),
 		audioSystem(&ecs),
-		physicsSystem(&ecs),
+		physicsSystem(&ecs, collisionManager),
 		pathfindingSystem(&ecs),
 		particleUpdater(&ecs),
 		stateUpdater(&ecs),
@@ -17,12 +18,7 @@ namespace Engine
 		meshListSystem(&ecs),
 		animAABBSystem(&ecs),
 
-		aabbSystem(&ecs, collisionManager),
-		boxSystem(&ecs, collisionManager),
-		boxAABBSystem(&ecs, collisionManager),
-		sphereSystem(&ecs, collisionManager),
-		sphereAABBSystem(&ecs, collisionManager),
-		sphereBoxSystem(&ecs, collisionManager),
+		collisionSystem(&ecs, collisionManager),
 
 		lightingSystem(&ecs, &lightManager, camera),
 
@@ -46,6 +42,7 @@ namespace Engine
 	{
 		systemManager.ActionPreUpdateSystems();
 		collisionManager->ConstructBVHTree();
+		collisionManager->BuildQueryBVH(ecs);
 	}
 
 	void Scene::Update()
@@ -55,9 +52,24 @@ namespace Engine
 		glm::vec3 forward = camera->GetFront();
 		AudioManager::GetInstance()->GetSoundEngine()->setListenerPosition(irrklang::vec3df(position.x, position.y, position.z), irrklang::vec3df(forward.x, forward.y, forward.z));
 
-		if (rebuildBVHOnUpdate) { collisionManager->ConstructBVHTree(); }
-		frustumCulling.Run(camera, collisionManager);
+		if (rebuildBVHOnUpdate) { collisionManager->UpdateBVHTree(); }
+		frustumCulling.Run(camera, collisionManager, &ecs, &lightManager);
 
+		// Collision detection, resolution and integration run at a fixed rate, independent of frame rate
+		systemManager.ActionFixedStepSystems();
+
+		// Scene logic and other systems query colliders where they ended up after the simulation
+		collisionManager->UpdateQueryBVH(ecs);
+	}
+
+	void Scene::PrePhysicsStep()
+	{
+		SCOPE_TIMER("Scene::PrePhysicsStep()");
+		ecs.View<ComponentTransform, ComponentPhysics>().ForEach([](const unsigned int entityID, ComponentTransform& transform, ComponentPhysics& physics) {
+			transform.StorePreviousState();
+		});
+
+		islandBuilder.Run(ecs);
 		collisionResolver.Run(ecs);
 		constraintSolver.Run(ecs);
 	}
@@ -73,7 +85,24 @@ namespace Engine
 		glBufferSubData(GL_UNIFORM_BUFFER, 2 * sizeof(glm::mat4), sizeof(glm::vec3), glm::value_ptr(camera->GetPosition()));
 		glBindBuffer(GL_UNIFORM_BUFFER, 0);
 
+		// Draw physics bodies between their previous and current step state by however much time is left over in the fixed step
+		interpolatedBodies.clear();
+		if (interpolatePhysicsBodies) {
+			const float alpha = systemManager.GetFixedStep().Alpha();
+			ecs.View<ComponentTransform, ComponentPhysics>().ForEach([this, alpha](const unsigned int entityID, ComponentTransform& transform, ComponentPhysics& physics) {
+				if (physics.IsAsleep()) { return; }
+				interpolatedBodies.push_back({ &transform, transform.Position(), transform.GetOrientation() });
+				transform.SetPosition(glm::mix(transform.PreviousPosition(), transform.Position(), alpha));
+				transform.SetOrientation(glm::slerp(transform.PreviousOrientation(), transform.GetOrientation(), alpha));
+			});
+		}
+
 		renderManager->GetRenderPipeline()->Run(&ecs, &lightManager, collisionManager, camera);
+
+		for (const InterpolatedBody& body : interpolatedBodies) {
+			body.transform->SetPosition(body.position);
+			body.transform->SetOrientation(body.orientation);
+		}
 	}
 
 	InputManager* Scene::GetInputManager() const
@@ -34,14 +34,11 @@
 #include "SystemAnimatedGeometryAABBGeneration.h"
 #include "SystemLighting.h"
 #include "SystemReflectionBaking.h"
+#include "SystemPVSBaking.h"
 
-#include "SystemCollisionAABB.h"
-#include "SystemCollisionBox.h"
-#include "SystemCollisionBoxAABB.h"
-#include "SystemCollisionSphere.h"
-#include "SystemCollisionSphereAABB.h"
-#include "SystemCollisionsphereBox.h"
+#include "SystemCollision.h"
 
+#include "IslandBuilder.h"
 #include "CollisionResolver.h"
 #include "ConstraintSolver.h"
 
@@ -50,12 +47,7 @@ namespace Engine
 	enum DefaultSystemType {
 		SYSTEM_ANIMATED_GEOBOUNDS,
 		SYSTEM_BUILD_MESH_LIST,
-		SYSTEM_COLLISION_AABB,
-		SYSTEM_COLLISION_BOX,
-		SYSTEM_COLLISION_BOX_AABB,
-		SYSTEM_COLLISION_SPHERE,
-		SYSTEM_COLLISION_SPHERE_AABB,
-		SYSTEM_COLLISION_SPHERE_BOX,
+		SYSTEM_COLLISION,
 		SYSTEM_AUDIO,
 		SYSTEM_PHYSICS,
 		SYSTEM_PATHFINDING,
@@ -98,6 +90,11 @@ namespace Engine
 		LightManager* GetLightManager() { return &lightManager; }
 		CollisionManager* GetCollisionManager() { return collisionManager; }
 		ConstraintManager* GetConstraintManager() { return constraintManager; }
+		SystemCollision& GetCollisionSystem() { return collisionSystem; }
+		IslandBuilder& GetIslandBuilder() { return islandBuilder; }
+		CollisionResolver& GetCollisionResolver() { return collisionResolver; }
+		ConstraintSolver& GetConstraintSolver() { return constraintSolver; }
+		FixedTimestep& GetPhysicsStep() { return systemManager.GetFixedStep(); }
 		const EntityManager& GetECS() const { return ecs; }
 		EntityManager& GetECS() { return ecs; }
 		const SystemManager& GetSystemManager() const { return systemManager; }
@@ -106,6 +103,12 @@ namespace Engine
 		const Camera* GetCamera() const { return camera; }
 
 	protected:
+		struct InterpolatedBody {
+			ComponentTransform* transform;
+			glm::vec3 position;
+			glm::quat orientation;
+		};
+
 		SceneManager* sceneManager;
 		InputManager* inputManager;
 		RenderManager* renderManager;
@@ -116,6 +119,7 @@ namespace Engine
 		EntityManager ecs;
 		LightManager lightManager;
 		SystemFrustumCulling frustumCulling;
+		IslandBuilder islandBuilder;
 		CollisionResolver collisionResolver;
 		ConstraintSolver constraintSolver;
 
@@ -132,14 +136,13 @@ namespace Engine
 		SystemAnimatedGeometryAABBGeneration animAABBSystem;
 		SystemLighting lightingSystem;
 
-		SystemCollisionAABB aabbSystem;
-		SystemCollisionBox boxSystem;
-		SystemCollisionBoxAABB boxAABBSystem;
-		SystemCollisionSphere sphereSystem;
-		SystemCollisionSphereAABB sphereAABBSystem;
-		SystemCollisionSphereBox sphereBoxSystem;
+		SystemCollision collisionSystem;
 
 		SystemReflectionBaking reflectionBakingSystem;
+		SystemPVSBaking pvsBakingSystem;
+
+		// Physics bodies whose transform has been moved to the interpolated state for rendering, with their real state
+		std::vector<InterpolatedBody> interpolatedBodies;
 
 		int SCR_WIDTH;
 		int SCR_HEIGHT;
@@ -148,28 +151,37 @@ namespace Engine
 
 		Camera* camera;
 
+		// Refit the geometry BVH to moving meshes every frame, see CollisionManager::UpdateBVHTree
 		bool rebuildBVHOnUpdate;
 
+		// Draw physics bodies part way between their last two fixed step states
+		bool interpolatePhysicsBodies;
+
+		// Runs every fixed step, between narrowphase and integration
+		void PrePhysicsStep();
+
 		void BakeReflectionProbes(const bool discardUnfilteredCapture = true) { reflectionBakingSystem.Run(&ecs, &lightManager, discardUnfilteredCapture); }
+		// Bounds should cover everywhere the camera can go, only geometry flagged static is baked
+		void BakePVS(const glm::vec3& boundsMin, const glm::vec3& boundsMax, const float cellSize) { pvsBakingSystem.Run(&ecs, name, boundsMin, boundsMax, cellSize); }
+		void BakePVS(const float cellSize) { pvsBakingSystem.Run(&ecs, name, cellSize); }
 
 		void RegisterAllDefaultSystems() {
 			RegisterSystemToPreUpdate(SYSTEM_ANIMATED_GEOBOUNDS);
 			RegisterSystemToPreUpdate(SYSTEM_BUILD_MESH_LIST);
-			RegisterSystemToPreUpdate(SYSTEM_COLLISION_AABB);
-			RegisterSystemToPreUpdate(SYSTEM_COLLISION_BOX);
-			RegisterSystemToPreUpdate(SYSTEM_COLLISION_BOX_AABB);
-			RegisterSystemToPreUpdate(SYSTEM_COLLISION_SPHERE);
-			RegisterSystemToPreUpdate(SYSTEM_COLLISION_SPHERE_AABB);
-			RegisterSystemToPreUpdate(SYSTEM_COLLISION_SPHERE_BOX);
+
+			RegisterSystemToFixedStep(SYSTEM_COLLISION);
+			RegisterSystemToFixedStep(SYSTEM_PHYSICS);
 
 			RegisterSystem(SYSTEM_AUDIO);
-			RegisterSystem(SYSTEM_PHYSICS);
 			RegisterSystem(SYSTEM_PATHFINDING);
 			RegisterSystem(SYSTEM_PARTICLE_UPDATE);
 			RegisterSystem(SYSTEM_UI_INTERACT);
 			RegisterSystem(SYSTEM_STATE_MACHINE_UPDATE);
 			RegisterSystem(SYSTEM_ANIMATION);
 			RegisterSystem(SYSTEM_LIGHTING);
+
+			// AI decisions don't need to be made every frame, scenes that want smoother state driven movement can set the rate back to 0
+			systemManager.SetSystemStepRate(stateUpdater.SystemName(), 10.0f);
 		}
 
 		void RegisterSystemToPreUpdate(const DefaultSystemType systemType) {
@@ -180,23 +192,8 @@ namespace Engine
 			case SYSTEM_BUILD_MESH_LIST:
 				systemManager.RegisterPreUpdateSystem(meshListSystem.SystemName(), std::function<void(const unsigned int, ComponentTransform&, ComponentGeometry&)>(std::bind(&SystemBuildMeshList::OnAction, &meshListSystem, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3)), std::bind(&SystemBuildMeshList::PreAction, &meshListSystem));
 				break;
-			case SYSTEM_COLLISION_AABB:
-				systemManager.RegisterPreUpdateSystem(aabbSystem.SystemName(), std::function<void(const unsigned int, ComponentTransform&, ComponentCollisionAABB&)>(std::bind(&SystemCollisionAABB::OnAction, &aabbSystem, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3)), []() {}, std::bind(&SystemCollisionAABB::AfterAction, &aabbSystem));
-				break;
-			case SYSTEM_COLLISION_BOX:
-				systemManager.RegisterPreUpdateSystem(boxSystem.SystemName(), std::function<void(const unsigned int, ComponentTransform&, ComponentCollisionBox&)>(std::bind(&SystemCollisionBox::OnAction, &boxSystem, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3)), []() {}, std::bind(&SystemCollisionBox::AfterAction, &boxSystem));
-				break;
-			case SYSTEM_COLLISION_BOX_AABB:
-				systemManager.RegisterPreUpdateSystem(boxAABBSystem.SystemName(), std::function<void(const unsigned int, ComponentTransform&, ComponentCollisionBox&)>(std::bind(&SystemCollisionBoxAABB::OnAction, &boxAABBSystem, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3)), []() {}, std::bind(&SystemCollisionBoxAABB::AfterAction, &boxAABBSystem));
-				break;
-			case SYSTEM_COLLISION_SPHERE:
-				systemManager.RegisterPreUpdateSystem(sphereSystem.SystemName(), std::function<void(const unsigned int, ComponentTransform&, ComponentCollisionSphere&)>(std::bind(&SystemCollisionSphere::OnAction, &sphereSystem, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3)), []() {}, std::bind(&SystemCollisionSphere::AfterAction, &sphereSystem));
-				break;
-			case SYSTEM_COLLISION_SPHERE_AABB:
-				systemManager.RegisterPreUpdateSystem(sphereAABBSystem.SystemName(), std::function<void(const unsigned int, ComponentTransform&, ComponentCollisionSphere&)>(std::bind(&SystemCollisionSphereAABB::OnAction, &sphereAABBSystem, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3)), []() {}, std::bind(&SystemCollisionSphereAABB::AfterAction, &sphereAABBSystem));
-				break;
-			case SYSTEM_COLLISION_SPHERE_BOX:
-				systemManager.RegisterPreUpdateSystem(sphereBoxSystem.SystemName(), std::function<void(const unsigned int, ComponentTransform&, ComponentCollisionSphere&)>(std::bind(&SystemCollisionSphereBox::OnAction, &sphereBoxSystem, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3)), []() {}, std::bind(&SystemCollisionSphereBox::AfterAction, &sphereBoxSystem));
+			case SYSTEM_COLLISION:
+				systemManager.RegisterPreUpdateSystem(collisionSystem.SystemName(), std::bind(&SystemCollision::Run, &collisionSystem));
 				break;
 			case SYSTEM_AUDIO:
 				systemManager.RegisterPreUpdateSystem(audioSystem.SystemName(), std::function<void(const unsigned int, ComponentTransform&, ComponentAudioSource&)>(std::bind(&SystemAudio::OnAction, &audioSystem, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3)), []() {}, std::bind(&SystemAudio::AfterAction, &audioSystem));
@@ -224,6 +221,21 @@ namespace Engine
 				break;
 			}
 		}
+		// Only the simulation systems can run at the fixed step, anything else is registered as a normal update system
+		void RegisterSystemToFixedStep(const DefaultSystemType systemType) {
+			switch (systemType) {
+			case SYSTEM_COLLISION:
+				systemManager.RegisterFixedStepSystem(collisionSystem.SystemName(), std::bind(&SystemCollision::Run, &collisionSystem));
+				break;
+			case SYSTEM_PHYSICS:
+				// Contacts and constraints are solved in the pre action so they see this step's narrowphase results
+				systemManager.RegisterFixedStepSystem(physicsSystem.SystemName(), std::function<void(const unsigned int, ComponentTransform&, ComponentPhysics&)>(std::bind(&SystemPhysics::OnAction, &physicsSystem, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3)), std::bind(&Scene::PrePhysicsStep, this), std::bind(&SystemPhysics::AfterAction, &physicsSystem));
+				break;
+			default:
+				RegisterSystem(systemType);
+				break;
+			}
+		}
 		void RegisterSystem(const DefaultSystemType systemType) {
 			switch (systemType) {
 			case SYSTEM_ANIMATED_GEOBOUNDS:
@@ -232,23 +244,8 @@ namespace Engine
 			case SYSTEM_BUILD_MESH_LIST:
 				systemManager.RegisterSystem(meshListSystem.SystemName(), std::function<void(const unsigned int, ComponentTransform&, ComponentGeometry&)>(std::bind(&SystemBuildMeshList::OnAction, &meshListSystem, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3)), std::bind(&SystemBuildMeshList::PreAction, &meshListSystem));
 				break;
-			case SYSTEM_COLLISION_AABB:
-				systemManager.RegisterSystem(aabbSystem.SystemName(), std::function<void(const unsigned int, ComponentTransform&, ComponentCollisionAABB&)>(std::bind(&SystemCollisionAABB::OnAction, &aabbSystem, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3)), []() {}, std::bind(&SystemCollisionAABB::AfterAction, &aabbSystem));
-				break;
-			case SYSTEM_COLLISION_BOX:
-				systemManager.RegisterSystem(boxSystem.SystemName(), std::function<void(const unsigned int, ComponentTransform&, ComponentCollisionBox&)>(std::bind(&SystemCollisionBox::OnAction, &boxSystem, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3)), []() {}, std::bind(&SystemCollisionBox::AfterAction, &boxSystem));
-				break;
-			case SYSTEM_COLLISION_BOX_AABB:
-				systemManager.RegisterSystem(boxAABBSystem.SystemName(), std::function<void(const unsigned int, ComponentTransform&, ComponentCollisionBox&)>(std::bind(&SystemCollisionBoxAABB::OnAction, &boxAABBSystem, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3)), []() {}, std::bind(&SystemCollisionBoxAABB::AfterAction, &boxAABBSystem));
-				break;
-			case SYSTEM_COLLISION_SPHERE:
-				systemManager.RegisterSystem(sphereSystem.SystemName(), std::function<void(const unsigned int, ComponentTransform&, ComponentCollisionSphere&)>(std::bind(&SystemCollisionSphere::OnAction, &sphereSystem, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3)), []() {}, std::bind(&SystemCollisionSphere::AfterAction, &sphereSystem));
-				break;
-			case SYSTEM_COLLISION_SPHERE_AABB:
-				systemManager.RegisterSystem(sphereAABBSystem.SystemName(), std::function<void(const unsigned int, ComponentTransform&, ComponentCollisionSphere&)>(std::bind(&SystemCollisionSphereAABB::OnAction, &sphereAABBSystem, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3)), []() {}, std::bind(&SystemCollisionSphereAABB::AfterAction, &sphereAABBSystem));
-				break;
-			case SYSTEM_COLLISION_SPHERE_BOX:
-				systemManager.RegisterSystem(sphereBoxSystem.SystemName(), std::function<void(const unsigned int, ComponentTransform&, ComponentCollisionSphere&)>(std::bind(&SystemCollisionSphereBox::OnAction, &sphereBoxSystem, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3)), []() {}, std::bind(&SystemCollisionSphereBox::AfterAction, &sphereBoxSystem));
+			case SYSTEM_COLLISION:
+				systemManager.RegisterSystem(collisionSystem.SystemName(), std::bind(&SystemCollision::Run, &collisionSystem));
 				break;
 			case SYSTEM_AUDIO:
 				systemManager.RegisterSystem(audioSystem.SystemName(), std::function<void(const unsigned int, ComponentTransform&, ComponentAudioSource&)>(std::bind(&SystemAudio::OnAction, &audioSystem, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3)), []() {}, std::bind(&SystemAudio::AfterAction, &audioSystem));
@@ -10,6 +10,7 @@ namespace Engine
 		this->windowXPos = windowXPos;
 		this->windowYPos = windowYPos;
 		changeSceneAtEndOfFrame = SCENE_NONE;
+		maxFrameTime = 0.25f;
 		OnLoad();
 	}
 
@@ -157,7 +158,7 @@ namespace Engine
 		{
 			SCOPE_TIMER("SceneManager::Run::Frame");
 			currentFrame = static_cast<float>(glfwGetTime()) + 0.0001f;
-			Scene::dt = currentFrame - lastFrame;
+			Scene::dt = std::min(currentFrame - lastFrame, maxFrameTime);
 			lastFrame = currentFrame;
 			//Scene::dt = std::chrono::duration_cast<std::chrono::milliseconds>(timeStep).count() / 1000.0;
 			//Scene::dt = 0.0066f;
@@ -49,6 +49,8 @@ namespace Engine
 		virtual void ChangeScene(SceneTypes sceneType) = 0;
 
 		GLFWwindow* window;
+
+		float maxFrameTime;
 	public:
 		SceneManager(int width, int height, int windowXPos, int windowYPos);
 		~SceneManager();
@@ -68,6 +70,10 @@ namespace Engine
 
 		const GLFWwindow* GetWindow() const { return window; }
 
+		// Longest frame time handed to the scene, stops a stall (loading, breakpoints, window drag) from being simulated all at once
+		void SetMaxFrameTime(const float seconds) { maxFrameTime = seconds; }
+		float MaxFrameTime() const { return maxFrameTime; }
+
 		void Run();
 	};
 }
@@ -18,6 +18,9 @@ namespace Engine {
 		renderManager->SetAdvBloomLensDirtTexture("Textures/LensEffects/dirtmask.jpg");
 
 		SetupScene();
+
+		// Bake with P, the set is only used once it exists
+		renderManager->GetBakedData().LoadPVSFromFile(name);
 	}
 
 	SponzaScene::~SponzaScene() {}
@@ -46,6 +49,9 @@ namespace Engine {
 			canvas->UIElements()[8]->SetActive(!renderGeometryColliders);
 			canvas->UIElements()[9]->SetActive(!renderGeometryColliders);
 		}
+		if (key == GLFW_KEY_P) {
+			BakePVS(4.0f);
+		}
 	}
 
 	void SponzaScene::keyDown(int key)
@@ -79,17 +85,23 @@ namespace Engine {
 
 		Entity* sponza = ecs.New("Sponza");
 		ecs.AddComponent(sponza->ID(), ComponentGeometry("Models/PBR/newSponza/base/NewSponza_Main_glTF_003.gltf", true, false, false, defaultAssimpPostProcess | aiProcess_PreTransformVertices));
+		// One triangle mesh collider for the whole level, cooked on first load and read from Data/CollisionMesh/ after that
+		ecs.AddComponent(sponza->ID(), ComponentCollisionMesh("NewSponza_Main", ecs.GetComponent<ComponentGeometry>(sponza->ID())->GetModel()->meshes));
+		ecs.GetComponent<ComponentGeometry>(sponza->ID())->SetIsStatic(true);
 
 		Entity* curtains = ecs.New("Curtains");
 		ecs.AddComponent(curtains->ID(), ComponentGeometry("Models/PBR/newSponza/curtains/NewSponza_Curtains_glTF.gltf", true, false, false, defaultAssimpPostProcess | aiProcess_PreTransformVertices));
+		ecs.GetComponent<ComponentGeometry>(curtains->ID())->SetIsStatic(true);
 
 		Entity* ivy = ecs.New("Ivy");
 		ecs.AddComponent(ivy->ID(), ComponentGeometry("Models/PBR/newSponza/ivy/NewSponza_IvyGrowth_glTF.gltf", true, false, false, defaultAssimpPostProcess | aiProcess_PreTransformVertices));
+		ecs.GetComponent<ComponentGeometry>(ivy->ID())->SetIsStatic(true);
 
 		Entity* trees = ecs.New("Trees");
 		ecs.AddComponent(trees->ID(), ComponentGeometry("Models/PBR/newSponza/trees/NewSponza_CypressTree_glTF.gltf", true, false, false, defaultAssimpPostProcess | aiProcess_PreTransformVertices));
 		ComponentGeometry* geometry = ecs.GetComponent<ComponentGeometry>(trees->ID());
 		geometry->SetCulling(false, GL_BACK);
+		geometry->SetIsStatic(true);
 		geometry->GetModel()->meshes[0]->GetMaterial()->SetUseColourMapAsAlpha(false);
 		geometry->GetModel()->meshes[1]->GetMaterial()->SetUseColourMapAsAlpha(true);
 		geometry->GetModel()->meshes[2]->GetMaterial()->SetUseColourMapAsAlpha(false);
@@ -182,6 +194,9 @@ namespace Engine {
 	void SponzaScene::CreateSystems()
 	{
 		RegisterAllDefaultSystems();
+
+		// Interior walls hide most of the scene from any one viewpoint
+		frustumCulling.SetOcclusionCulling(true);
 	}
 
 	void SponzaScene::Update()
@@ -206,11 +221,14 @@ namespace Engine {
 
 		const unsigned int meshCount = frustumCulling.GetTotalMeshes();
 		const unsigned int visibleMeshes = frustumCulling.GetVisibleMeshes();
+		const unsigned int occludedMeshes = frustumCulling.GetOccludedMeshes();
+		const unsigned int reducedLODMeshes = frustumCulling.GetReducedLODMeshes();
+		const unsigned int pvsCulledMeshes = frustumCulling.GetPVSCulledMeshes();
 		const unsigned int nodeCount = geometryBVH->GetNodeCount();
 		const unsigned int aabbTests = frustumCulling.GetTotalAABBTests();
 
 		dynamic_cast<UIText*>(canvas->UIElements()[6])->SetText("Mesh count: " + std::to_string(meshCount));
-		dynamic_cast<UIText*>(canvas->UIElements()[7])->SetText("     - Visible: " + std::to_string(visibleMeshes));
+		dynamic_cast<UIText*>(canvas->UIElements()[7])->SetText("     - Visible: " + std::to_string(visibleMeshes) + " (PVS: " + std::to_string(pvsCulledMeshes) + ", Occluded: " + std::to_string(occludedMeshes) + ", Reduced LOD: " + std::to_string(reducedLODMeshes) + ")");
 		dynamic_cast<UIText*>(canvas->UIElements()[8])->SetText("BVHN count: " + std::to_string(nodeCount));
 		dynamic_cast<UIText*>(canvas->UIElements()[9])->SetText("AABB Tests: " + std::to_string(aabbTests));
 
@@ -1,6 +1,925 @@
 #include "SystemCollision.h"
+#include "ThreadPool.h"
+#include "PairKey.h"
+#include <algorithm>
 #include <glm/gtx/norm.hpp>
 namespace Engine {
+	bool SystemCollision::forceSingleThreaded = false;
+	unsigned int SystemCollision::pairsPerChunk = 64;
+
+	namespace {
+		// Bounds are grown slightly so pairs that are exactly touching aren't lost to rounding between the sweep and the narrowphase
+		constexpr float BROADPHASE_MARGIN = 0.001f;
+
+		// Bucket for each pair of collider types, indexed by ColliderType with the lower type first
+		// Static meshes never collide with each other, NUM_SHAPE_PAIR_TYPES marks a pair that is never tested
+		constexpr ShapePairType SHAPE_PAIR_TABLE[5][5] = {
+			{ SHAPE_PAIR_SPHERE_SPHERE, SHAPE_PAIR_SPHERE_BOX, SHAPE_PAIR_SPHERE_AABB, SHAPE_PAIR_SPHERE_CONVEX, SHAPE_PAIR_SPHERE_MESH },
+			{ SHAPE_PAIR_SPHERE_BOX, SHAPE_PAIR_BOX_BOX, SHAPE_PAIR_BOX_AABB, SHAPE_PAIR_BOX_CONVEX, SHAPE_PAIR_BOX_MESH },
+			{ SHAPE_PAIR_SPHERE_AABB, SHAPE_PAIR_BOX_AABB, SHAPE_PAIR_AABB_AABB, SHAPE_PAIR_AABB_CONVEX, SHAPE_PAIR_AABB_MESH },
+			{ SHAPE_PAIR_SPHERE_CONVEX, SHAPE_PAIR_BOX_CONVEX, SHAPE_PAIR_AABB_CONVEX, SHAPE_PAIR_CONVEX_CONVEX, SHAPE_PAIR_CONVEX_MESH },
+			{ SHAPE_PAIR_SPHERE_MESH, SHAPE_PAIR_BOX_MESH, SHAPE_PAIR_AABB_MESH, SHAPE_PAIR_CONVEX_MESH, NUM_SHAPE_PAIR_TYPES }
+		};
+
+		// Most contacts kept between one collider and a mesh
+		constexpr unsigned int MAX_MESH_CONTACTS = 8;
+
+		// Contacts of a hull against neighbouring triangles closer than this fraction of the hull's size are the same corner
+		constexpr float MESH_CONTACT_MERGE_FRACTION = 0.02f;
+
+		// World space bounds of a local box under a model matrix, including any rotation
+		void OrientedBoxBounds(const glm::mat4& model, const glm::vec3& localMin, const glm::vec3& localMax, glm::vec3& out_min, glm::vec3& out_max) {
+			const glm::vec3 centre = glm::vec3(model * glm::vec4((localMin + localMax) * 0.5f, 1.0f));
+			const glm::vec3 halfExtents = (localMax - localMin) * 0.5f;
+			const glm::mat3 absolute = glm::mat3(glm::abs(glm::vec3(model[0])), glm::abs(glm::vec3(model[1])), glm::abs(glm::vec3(model[2])));
+			const glm::vec3 worldHalfExtents = absolute * halfExtents;
+			out_min = centre - worldHalfExtents;
+			out_max = centre + worldHalfExtents;
+		}
+
+		// Support mappings of the primitive colliders, for pairs with a convex hull
+		SphereSupport MakeSphereSupport(const ComponentTransform& transform, const ComponentCollisionSphere& collider) {
+			return SphereSupport(transform.GetWorldPosition(), collider.CollisionRadius() * transform.GetBiggestScaleFactor());
+		}
+
+		BoxSupport MakeBoxSupport(const ComponentTransform& transform, const ComponentCollisionBox& collider) {
+			const glm::mat4& model = transform.GetWorldModelMatrix();
+			const BoxExtents& extents = collider.GetLocalPoints();
+			const glm::vec3 localMin = glm::vec3(extents.minX, extents.minY, extents.minZ);
+			const glm::vec3 localMax = glm::vec3(extents.maxX, extents.maxY, extents.maxZ);
+			const glm::vec3 halfExtents = (localMax - localMin) * 0.5f;
+			const glm::vec3 centre = glm::vec3(model * glm::vec4((localMin + localMax) * 0.5f, 1.0f));
+			return BoxSupport(centre, glm::vec3(model[0]) * halfExtents.x, glm::vec3(model[1]) * halfExtents.y, glm::vec3(model[2]) * halfExtents.z);
+		}
+
+		BoxSupport MakeAABBSupport(const ComponentTransform& transform, const ComponentCollisionAABB& collider) {
+			const AABBPoints bounds = collider.GetWorldSpaceBounds(transform.GetWorldModelMatrix());
+			const glm::vec3 boundsMin = glm::vec3(bounds.minX, bounds.minY, bounds.minZ);
+			const glm::vec3 boundsMax = glm::vec3(bounds.maxX, bounds.maxY, bounds.maxZ);
+			const glm::vec3 halfExtents = (boundsMax - boundsMin) * 0.5f;
+			return BoxSupport((boundsMin + boundsMax) * 0.5f, glm::vec3(halfExtents.x, 0.0f, 0.0f), glm::vec3(0.0f, halfExtents.y, 0.0f), glm::vec3(0.0f, 0.0f, halfExtents.z));
+		}
+
+		// Cuts a contact list down to maxContacts, keeping the deepest and then repeatedly the one furthest from those already kept
+		// so the survivors still span the whole area of contact rather than whichever triangles were visited first
+		void ReduceContacts(std::vector<ContactPoint>& contacts, const unsigned int maxContacts) {
+			if (contacts.size() <= maxContacts) { return; }
+
+			unsigned int deepest = 0;
+			for (unsigned int i = 1; i < contacts.size(); i++) {
+				if (contacts[i].penetration > contacts[deepest].penetration) { deepest = i; }
+			}
+			std::swap(contacts[0], contacts[deepest]);
+
+			std::vector<float> nearestKept(contacts.size());
+			for (unsigned int i = 1; i < contacts.size(); i++) { nearestKept[i] = glm::distance2(contacts[i].contactPointA, contacts[0].contactPointA); }
+
+			for (unsigned int kept = 1; kept < maxContacts; kept++) {
+				unsigned int furthest = kept;
+				for (unsigned int i = kept + 1; i < contacts.size(); i++) {
+					if (nearestKept[i] > nearestKept[furthest]) { furthest = i; }
+				}
+				std::swap(contacts[kept], contacts[furthest]);
+				std::swap(nearestKept[kept], nearestKept[furthest]);
+
+				for (unsigned int i = kept + 1; i < contacts.size(); i++) {
+					nearestKept[i] = std::min(nearestKept[i], glm::distance2(contacts[i].contactPointA, contacts[kept].contactPointA));
+				}
+			}
+			contacts.erase(contacts.begin() + maxContacts, contacts.end());
+		}
+	}
+
+	void SystemCollision::Run()
+	{
+		SCOPE_TIMER("SystemCollision::Run()");
+		GatherColliders();
+		Broadphase();
+		RunBatchKernels();
+		RunNarrowphase();
+		UpdateCollisionLists();
+	}
+
+	void SystemCollision::GatherColliders()
+	{
+		SCOPE_TIMER("SystemCollision::GatherColliders()");
+		proxies.clear();
+
+		active_ecs->View<ComponentTransform, ComponentCollisionSphere>().ForEach([this](const unsigned int entityID, ComponentTransform& transform, ComponentCollisionSphere& collider) {
+			const glm::vec3 centre = transform.GetWorldPosition();
+			const float radius = collider.CollisionRadius() * transform.GetBiggestScaleFactor();
+			AddProxy(entityID, COLLISION_SPHERE, transform, collider, centre - glm::vec3(radius), centre + glm::vec3(radius));
+			proxies.back().centre = centre;
+			proxies.back().radius = radius;
+		});
+
+		active_ecs->View<ComponentTransform, ComponentCollisionBox>().ForEach([this](const unsigned int entityID, ComponentTransform& transform, ComponentCollisionBox& collider) {
+			const BoxExtents& extents = collider.GetLocalPoints();
+			glm::vec3 boundsMin, boundsMax;
+			OrientedBoxBounds(transform.GetWorldModelMatrix(), glm::vec3(extents.minX, extents.minY, extents.minZ), glm::vec3(extents.maxX, extents.maxY, extents.maxZ), boundsMin, boundsMax);
+			AddProxy(entityID, COLLISION_BOX, transform, collider, boundsMin, boundsMax);
+		});
+
+		active_ecs->View<ComponentTransform, ComponentCollisionAABB>().ForEach([this](const unsigned int entityID, ComponentTransform& transform, ComponentCollisionAABB& collider) {
+			const glm::mat4& model = transform.GetWorldModelMatrix();
+			const AABBPoints& local = collider.GetBoundary();
+			const AABBPoints world = collider.GetWorldSpaceBounds(model);
+			const glm::vec3 aabbMin = glm::vec3(world.minX, world.minY, world.minZ);
+			const glm::vec3 aabbMax = glm::vec3(world.maxX, world.maxY, world.maxZ);
+
+			// Tests against boxes use the collider's corners under the full model matrix, so the sweep bounds cover both forms
+			glm::vec3 orientedMin, orientedMax;
+			OrientedBoxBounds(model, glm::vec3(local.minX, local.minY, local.minZ), glm::vec3(local.maxX, local.maxY, local.maxZ), orientedMin, orientedMax);
+			AddProxy(entityID, COLLISION_AABB, transform, collider, glm::min(aabbMin, orientedMin), glm::max(aabbMax, orientedMax));
+			proxies.back().aabbMin = aabbMin;
+			proxies.back().aabbMax = aabbMax;
+		});
+
+		active_ecs->View<ComponentTransform, ComponentCollisionConvex>().ForEach([this](const unsigned int entityID, ComponentTransform& transform, ComponentCollisionConvex& collider) {
+			if (!collider.GetHull() || collider.GetHull()->NumVertices() == 0) { return; }
+			glm::vec3 boundsMin, boundsMax;
+			collider.GetWorldSpaceBounds(transform.GetWorldModelMatrix(), boundsMin, boundsMax);
+			AddProxy(entityID, COLLISION_CONVEX, transform, collider, boundsMin, boundsMax);
+		});
+
+		active_ecs->View<ComponentTransform, ComponentCollisionMesh>().ForEach([this](const unsigned int entityID, ComponentTransform& transform, ComponentCollisionMesh& collider) {
+			if (!collider.GetMesh() || collider.GetMesh()->NumTriangles() == 0) { return; }
+			glm::vec3 boundsMin, boundsMax;
+			collider.GetWorldSpaceBounds(transform.GetWorldModelMatrix(), boundsMin, boundsMax);
+			AddProxy(entityID, COLLISION_MESH, transform, collider, boundsMin, boundsMax);
+		});
+	}
+
+	void SystemCollision::AddProxy(const unsigned int entityID, const ColliderType shape, ComponentTransform& transform, ComponentCollision& collider, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+	{
+		ColliderProxy proxy;
+		proxy.entityID = entityID;
+		proxy.shape = shape;
+		proxy.transform = &transform;
+		proxy.collider = &collider;
+		proxy.layer = collider.CollisionLayer();
+		proxy.mask = collider.CollisionMask();
+		proxy.acceptedLayers = collisionManager->AcceptedLayers(proxy.layer, proxy.mask);
+		proxy.movable = collider.IsMovedByCollisions();
+
+		// The collider flag is only a hint, the physics component has the final say as forces can wake a body at any time
+		proxy.sleeping = false;
+		if (collider.IsAsleep()) {
+			const ComponentPhysics* physics = active_ecs->GetComponent<ComponentPhysics>(entityID);
+			proxy.sleeping = physics && physics->IsAsleep();
+		}
+
+		proxy.boundsMin = boundsMin - glm::vec3(BROADPHASE_MARGIN);
+		proxy.boundsMax = boundsMax + glm::vec3(BROADPHASE_MARGIN);
+		proxy.centre = transform.GetWorldPosition();
+		proxy.radius = 0.0f;
+		proxy.aabbMin = boundsMin;
+		proxy.aabbMax = boundsMax;
+		proxies.push_back(proxy);
+	}
+
+	void SystemCollision::Broadphase()
+	{
+		SCOPE_TIMER("SystemCollision::Broadphase()");
+		activePairs.clear();
+		sleepingPairs.clear();
+		for (std::vector<NarrowphasePair>& bucket : bucketPairs) { bucket.clear(); }
+
+		// Sweep and prune along x. Ties are broken by entity and shape so the pair order never depends on view order
+		std::sort(proxies.begin(), proxies.end(), [](const ColliderProxy& a, const ColliderProxy& b) {
+			if (a.boundsMin.x != b.boundsMin.x) { return a.boundsMin.x < b.boundsMin.x; }
+			if (a.entityID != b.entityID) { return a.entityID < b.entityID; }
+			return a.shape < b.shape;
+		});
+
+		const unsigned int numProxies = proxies.size();
+		for (unsigned int i = 0; i < numProxies; i++) {
+			const ColliderProxy& a = proxies[i];
+			for (unsigned int j = i + 1; j < numProxies && proxies[j].boundsMin.x <= a.boundsMax.x; j++) {
+				const ColliderProxy& b = proxies[j];
+				if (a.entityID == b.entityID) { continue; }
+				if (a.boundsMin.y > b.boundsMax.y || a.boundsMax.y < b.boundsMin.y || a.boundsMin.z > b.boundsMax.z || a.boundsMax.z < b.boundsMin.z) { continue; }
+				if (!LayersCollide(a, b)) { continue; }
+
+				// Sleeping pairs keep whatever contact state they had when they went to sleep
+				if (IsPairAsleep(a, b)) {
+					sleepingPairs.push_back(MakePairKey(a.entityID, b.entityID));
+					continue;
+				}
+
+				AddPair(i, j);
+			}
+		}
+
+		pairs.clear();
+		for (unsigned int type = 0; type < NUM_SHAPE_PAIR_TYPES; type++) {
+			bucketStart[type] = pairs.size();
+			pairs.insert(pairs.end(), bucketPairs[type].begin(), bucketPairs[type].end());
+		}
+		bucketStart[NUM_SHAPE_PAIR_TYPES] = pairs.size();
+	}
+
+	void SystemCollision::AddPair(const unsigned int proxyA, const unsigned int proxyB)
+	{
+		const ColliderProxy& a = proxies[proxyA];
+		const ColliderProxy& b = proxies[proxyB];
+
+		// ColliderType is ordered sphere, box, AABB, convex, mesh which is the order each bucket expects
+		const ShapePairType type = SHAPE_PAIR_TABLE[a.shape][b.shape];
+		if (type == NUM_SHAPE_PAIR_TYPES) { return; }
+
+		const bool swap = (a.shape > b.shape) || (a.shape == b.shape && a.entityID > b.entityID);
+		bucketPairs[type].push_back({ type, swap ? proxyB : proxyA, swap ? proxyA : proxyB });
+	}
+
+	void SystemCollision::RunBatchKernels()
+	{
+		SCOPE_TIMER("SystemCollision::RunBatchKernels()");
+		pairColliding.assign(pairs.size(), 1);
+
+		// Cheap overlap tests for the sphere buckets, anything ruled out here is never passed to the full narrowphase
+		sphereSphereBatch.Clear();
+		for (unsigned int i = bucketStart[SHAPE_PAIR_SPHERE_SPHERE]; i < bucketStart[SHAPE_PAIR_SPHERE_SPHERE + 1]; i++) {
+			const ColliderProxy& a = proxies[pairs[i].proxyA];
+			const ColliderProxy& b = proxies[pairs[i].proxyB];
+			sphereSphereBatch.Add(a.centre, a.radius, b.centre, b.radius);
+		}
+		if (sphereSphereBatch.Size() > 0) {
+			sphereSphereBatch.Test(&pairColliding[bucketStart[SHAPE_PAIR_SPHERE_SPHERE]]);
+		}
+
+		sphereAABBBatch.Clear();
+		for (unsigned int i = bucketStart[SHAPE_PAIR_SPHERE_AABB]; i < bucketStart[SHAPE_PAIR_SPHERE_AABB + 1]; i++) {
+			const ColliderProxy& a = proxies[pairs[i].proxyA];
+			const ColliderProxy& b = proxies[pairs[i].proxyB];
+			sphereAABBBatch.Add(a.centre, a.radius, b.aabbMin, b.aabbMax);
+		}
+		if (sphereAABBBatch.Size() > 0) {
+			sphereAABBBatch.Test(&pairColliding[bucketStart[SHAPE_PAIR_SPHERE_AABB]]);
+		}
+	}
+
+	void SystemCollision::RunNarrowphase()
+	{
+		SCOPE_TIMER("SystemCollision::RunNarrowphase()");
+		numCollidingPairs = 0;
+		const unsigned int numPairs = pairs.size();
+		if (numPairs == 0) { return; }
+
+		const unsigned int numChunks = ThreadPool::NumChunks(numPairs, pairsPerChunk);
+		if (chunkContacts.size() < numChunks) { chunkContacts.resize(numChunks); }
+
+		ThreadPool::GetInstance()->ParallelFor(numPairs, pairsPerChunk, [this](const unsigned int chunkIndex, const unsigned int begin, const unsigned int end) {
+			std::vector<CollisionData>& contacts = chunkContacts[chunkIndex];
+			contacts.clear();
+			for (unsigned int i = begin; i < end; i++) {
+				if (!pairColliding[i]) { continue; }
+
+				const NarrowphasePair& pair = pairs[i];
+				CollisionData collision = IntersectPair(pair);
+				pairColliding[i] = collision.isColliding;
+				if (collision.isColliding) {
+					const ColliderProxy& a = proxies[pair.proxyA];
+					const ColliderProxy& b = proxies[pair.proxyB];
+					collision.colliderA = a.collider;
+					collision.colliderB = b.collider;
+					collision.shapeA = a.shape;
+					collision.shapeB = b.shape;
+					contacts.push_back(std::move(collision));
+				}
+			}
+		}, forceSingleThreaded);
+
+		// Merge chunk by chunk in pair order so the collision list doesn't depend on thread count or scheduling
+		for (unsigned int chunk = 0; chunk < numChunks; chunk++) {
+			for (const CollisionData& collision : chunkContacts[chunk]) {
+				collisionManager->AddToCollisionList(collision);
+				activePairs.push_back(MakePairKey(collision.entityIDA, collision.entityIDB));
+				numCollidingPairs++;
+			}
+		}
+	}
+
+	void SystemCollision::UpdateCollisionLists()
+	{
+		SCOPE_TIMER("SystemCollision::UpdateCollisionLists()");
+		// Entities with several colliders can report the same pair more than once
+		std::sort(activePairs.begin(), activePairs.end());
+		activePairs.erase(std::unique(activePairs.begin(), activePairs.end()), activePairs.end());
+
+		if (!sleepingPairs.empty()) {
+			const unsigned int numTouching = activePairs.size();
+			for (const unsigned long long key : sleepingPairs) {
+				if (std::binary_search(previousActivePairs.begin(), previousActivePairs.end(), key)) { activePairs.push_back(key); }
+			}
+			std::inplace_merge(activePairs.begin(), activePairs.begin() + numTouching, activePairs.end());
+			activePairs.erase(std::unique(activePairs.begin(), activePairs.end()), activePairs.end());
+		}
+
+		// Both lists are sorted, so one merge pass finds every pair that began, stayed or ended
+		CollisionEventBuffer& events = collisionManager->GetCollisionEvents();
+		events.BeginFrame();
+		proxiesByEntity.clear();
+
+		unsigned int current = 0;
+		unsigned int previous = 0;
+		while (current < activePairs.size() || previous < previousActivePairs.size()) {
+			unsigned long long key;
+			CollisionEventType type;
+			if (previous == previousActivePairs.size() || (current < activePairs.size() && activePairs[current] < previousActivePairs[previous])) {
+				key = activePairs[current++];
+				type = COLLISION_BEGIN;
+			}
+			else if (current == activePairs.size() || previousActivePairs[previous] < activePairs[current]) {
+				key = previousActivePairs[previous++];
+				type = COLLISION_END;
+			}
+			else {
+				key = activePairs[current++];
+				previous++;
+				type = COLLISION_STAY;
+			}
+
+			const unsigned int entityIDA = static_cast<unsigned int>(key & 0xFFFFFFFFull);
+			const unsigned int entityIDB = static_cast<unsigned int>(key >> 32);
+			events.Push({ entityIDA, entityIDB, type });
+			if (type != COLLISION_STAY) { UpdateColliderLists(entityIDA, entityIDB, type == COLLISION_BEGIN); }
+		}
+
+		previousActivePairs.swap(activePairs);
+	}
+
+	void SystemCollision::UpdateColliderLists(const unsigned int entityIDA, const unsigned int entityIDB, const bool touching)
+	{
+		// Colliders are found through this run's proxies, an entity whose colliders have since been removed has no list left to update
+		if (proxiesByEntity.empty()) {
+			proxiesByEntity.resize(proxies.size());
+			for (unsigned int i = 0; i < proxies.size(); i++) { proxiesByEntity[i] = i; }
+			std::sort(proxiesByEntity.begin(), proxiesByEntity.end(), [this](const unsigned int a, const unsigned int b) { return proxies[a].entityID < proxies[b].entityID; });
+		}
+
+		const unsigned int entityIDs[2] = { entityIDA, entityIDB };
+		for (unsigned int side = 0; side < 2; side++) {
+			const unsigned int entityID = entityIDs[side];
+			const unsigned int otherID = entityIDs[1 - side];
+
+			std::vector<unsigned int>::const_iterator it = std::lower_bound(proxiesByEntity.begin(), proxiesByEntity.end(), entityID, [this](const unsigned int proxy, const unsigned int id) { return proxies[proxy].entityID < id; });
+			for (; it != proxiesByEntity.end() && proxies[*it].entityID == entityID; ++it) {
+				if (touching) { proxies[*it].collider->AddToCollisions(otherID); }
+				else { proxies[*it].collider->RemoveFromCollisions(otherID); }
+			}
+		}
+	}
+
+	CollisionData SystemCollision::IntersectPair(const NarrowphasePair& pair) const
+	{
+		const ColliderProxy& a = proxies[pair.proxyA];
+		const ColliderProxy& b = proxies[pair.proxyB];
+
+		switch (pair.type) {
+		case SHAPE_PAIR_SPHERE_SPHERE:
+			return IntersectSphereSphere(a.entityID, b.entityID, *a.transform, *static_cast<const ComponentCollisionSphere*>(a.collider), *b.transform, *static_cast<const ComponentCollisionSphere*>(b.collider));
+		case SHAPE_PAIR_SPHERE_BOX:
+			return IntersectSphereBox(a.entityID, b.entityID, *a.transform, *static_cast<const ComponentCollisionSphere*>(a.collider), *b.transform, *static_cast<const ComponentCollisionBox*>(b.collider));
+		case SHAPE_PAIR_SPHERE_AABB:
+			return IntersectSphereAABB(a.entityID, b.entityID, *a.transform, *static_cast<const ComponentCollisionSphere*>(a.collider), *b.transform, *static_cast<const ComponentCollisionAABB*>(b.collider));
+		case SHAPE_PAIR_BOX_BOX:
+			return IntersectBoxBox(a.entityID, b.entityID, *a.transform, *static_cast<const ComponentCollisionBox*>(a.collider), *b.transform, *static_cast<const ComponentCollisionBox*>(b.collider));
+		case SHAPE_PAIR_BOX_AABB:
+			return IntersectBoxAABB(a.entityID, b.entityID, *a.transform, *static_cast<const ComponentCollisionBox*>(a.collider), *b.transform, *static_cast<const ComponentCollisionAABB*>(b.collider));
+		case SHAPE_PAIR_SPHERE_CONVEX:
+			return IntersectSphereConvex(a.entityID, b.entityID, *a.transform, *static_cast<const ComponentCollisionSphere*>(a.collider), *b.transform, *static_cast<const ComponentCollisionConvex*>(b.collider));
+		case SHAPE_PAIR_BOX_CONVEX:
+			return IntersectBoxConvex(a.entityID, b.entityID, *a.transform, *static_cast<const ComponentCollisionBox*>(a.collider), *b.transform, *static_cast<const ComponentCollisionConvex*>(b.collider));
+		case SHAPE_PAIR_AABB_CONVEX:
+			return IntersectAABBConvex(a.entityID, b.entityID, *a.transform, *static_cast<const ComponentCollisionAABB*>(a.collider), *b.transform, *static_cast<const ComponentCollisionConvex*>(b.collider));
+		case SHAPE_PAIR_CONVEX_CONVEX:
+			return IntersectConvexConvex(a.entityID, b.entityID, *a.transform, *static_cast<const ComponentCollisionConvex*>(a.collider), *b.transform, *static_cast<const ComponentCollisionConvex*>(b.collider));
+		case SHAPE_PAIR_SPHERE_MESH:
+			return IntersectSphereMesh(a.entityID, b.entityID, *a.transform, *static_cast<const ComponentCollisionSphere*>(a.collider), *b.transform, *static_cast<const ComponentCollisionMesh*>(b.collider));
+		case SHAPE_PAIR_BOX_MESH:
+			return IntersectBoxMesh(a.entityID, b.entityID, *a.transform, *static_cast<const ComponentCollisionBox*>(a.collider), *b.transform, *static_cast<const ComponentCollisionMesh*>(b.collider));
+		case SHAPE_PAIR_AABB_MESH:
+			return IntersectAABBMesh(a.entityID, b.entityID, *a.transform, *static_cast<const ComponentCollisionAABB*>(a.collider), *b.transform, *static_cast<const ComponentCollisionMesh*>(b.collider));
+		case SHAPE_PAIR_CONVEX_MESH:
+			return IntersectConvexMesh(a.entityID, b.entityID, *a.transform, *static_cast<const ComponentCollisionConvex*>(a.collider), *b.transform, *static_cast<const ComponentCollisionMesh*>(b.collider));
+		case SHAPE_PAIR_AABB_AABB:
+		default:
+			return IntersectAABBAABB(a.entityID, b.entityID, *a.transform, *static_cast<const ComponentCollisionAABB*>(a.collider), *b.transform, *static_cast<const ComponentCollisionAABB*>(b.collider));
+		}
+	}
+
+	CollisionData SystemCollision::IntersectSphereSphere(const unsigned int entityIDA, const unsigned int entityIDB, const ComponentTransform& transformA, const ComponentCollisionSphere& colliderA, const ComponentTransform& transformB, const ComponentCollisionSphere& colliderB) const
+	{
+		SCOPE_TIMER("SystemCollision::IntersectSphereSphere()");
+		const float scaledRadius1 = colliderA.CollisionRadius() * transformA.GetBiggestScaleFactor();
+		const float scaledRadius2 = colliderB.CollisionRadius() * transformB.GetBiggestScaleFactor();
+
+		const float distanceSqr = glm::distance2(transformA.GetWorldPosition(), transformB.GetWorldPosition());
+
+		const float combinedRadius = scaledRadius1 + scaledRadius2;
+		const float combinedRadiusSqr = combinedRadius * combinedRadius;
+
+		CollisionData collision;
+		if (distanceSqr < combinedRadiusSqr) {
+			collision.isColliding = true;
+			const float distance = glm::sqrt(distanceSqr);
+			const float collisionPenetration = combinedRadius - distance;
+			const glm::vec3 collisionNormal = -glm::normalize(transformB.GetWorldPosition() - transformA.GetWorldPosition());
+			const glm::vec3 localCollisionPoint = collisionNormal * colliderA.CollisionRadius();
+			const glm::vec3 otherLocalCollisionPoint = -collisionNormal * colliderB.CollisionRadius();
+			collision.AddContactPoint(localCollisionPoint, otherLocalCollisionPoint, collisionNormal, collisionPenetration);
+
+			collision.entityIDA = entityIDA;
+			collision.entityIDB = entityIDB;
+		}
+		else {
+			collision.isColliding = false;
+		}
+
+		return collision;
+	}
+
+	CollisionData SystemCollision::IntersectSphereBox(const unsigned int entityIDA, const unsigned int entityIDB, const ComponentTransform& transformA, const ComponentCollisionSphere& colliderA, const ComponentTransform& transformB, const ComponentCollisionBox& colliderB) const
+	{
+		SCOPE_TIMER("SystemCollision::IntersectSphereBox()");
+		// Transform sphere into oriented box's local space
+		const glm::vec3& worldSpaceSpherePosition = transformA.GetWorldPosition();
+		const glm::mat4& boxTransform = transformB.GetWorldModelMatrix();
+
+		const glm::vec3 transformedSherePosition = glm::vec3(glm::inverse(boxTransform) * glm::vec4(worldSpaceSpherePosition, 1.0f));
+
+		// Find closest point on box to sphere position
+		const BoxExtents& localMinMax = colliderB.GetLocalPoints();
+		glm::vec3 closestPoint = glm::vec3();
+		closestPoint.x = std::max(localMinMax.minX, std::min(transformedSherePosition.x, localMinMax.maxX));
+		closestPoint.y = std::max(localMinMax.minY, std::min(transformedSherePosition.y, localMinMax.maxY));
+		closestPoint.z = std::max(localMinMax.minZ, std::min(transformedSherePosition.z, localMinMax.maxZ));
+
+		// Transform closest point into world space
+		const glm::vec3 closestPointWorldSpace = glm::vec3(boxTransform * glm::vec4(closestPoint, 1.0f));
+
+		const float distance = glm::distance(closestPointWorldSpace, worldSpaceSpherePosition);
+		const float scaledRadius = colliderA.CollisionRadius() * transformA.GetBiggestScaleFactor();
+
+		CollisionData collision;
+		if (distance < scaledRadius) {
+			collision.isColliding = true;
+
+			const float collisionPenetration = scaledRadius - distance;
+			const glm::vec3 collisionNormal = glm::normalize(worldSpaceSpherePosition - closestPointWorldSpace);
+			const glm::vec3 localCollisionPoint = -collisionNormal * scaledRadius;
+			const glm::vec3 otherLocalCollisionPoint = closestPoint;
+			collision.AddContactPoint(localCollisionPoint, otherLocalCollisionPoint, collisionNormal, collisionPenetration);
+
+			collision.entityIDA = entityIDA;
+			collision.entityIDB = entityIDB;
+		}
+		else {
+			collision.isColliding = false;
+		}
+
+		return collision;
+	}
+
+	CollisionData SystemCollision::IntersectSphereAABB(const unsigned int entityIDA, const unsigned int entityIDB, const ComponentTransform& transformA, const ComponentCollisionSphere& colliderA, const ComponentTransform& transformB, const ComponentCollisionAABB& colliderB) const
+	{
+		SCOPE_TIMER("SystemCollision::IntersectSphereAABB()");
+		// collider = sphere
+		// collider2 = AABB
+		const AABBPoints worldSpaceBounds = colliderB.GetWorldSpaceBounds(transformB.GetWorldModelMatrix());
+		const float scaledRadius = colliderA.CollisionRadius() * transformA.GetBiggestScaleFactor();
+
+		const glm::vec3& worldPosA = transformA.GetWorldPosition();
+		const glm::vec3& worldPosB = transformB.GetWorldPosition();
+
+		// get closest point of AABB
+		glm::vec3 closestPoint = glm::vec3();
+		closestPoint.x = std::max(worldSpaceBounds.minX, std::min(worldPosA.x, worldSpaceBounds.maxX));
+		closestPoint.y = std::max(worldSpaceBounds.minY, std::min(worldPosA.y, worldSpaceBounds.maxY));
+		closestPoint.z = std::max(worldSpaceBounds.minZ, std::min(worldPosA.z, worldSpaceBounds.maxZ));
+
+		const float distance = glm::distance(closestPoint, worldPosA);
+
+		const glm::vec3 delta = worldPosA - worldPosB;
+		const glm::vec3 localPoint = delta - closestPoint;
+
+		CollisionData collision;
+		if (distance < scaledRadius) {
+			collision.isColliding = true;
+
+			const float collisionPenetration = scaledRadius - distance;
+			const glm::vec3 collisionNormal = glm::normalize(worldPosA - closestPoint);
+			const glm::vec3 localCollisionPoint = -collisionNormal * scaledRadius;
+			const glm::vec3 otherLocalCollisionPoint = glm::vec3();
+			collision.AddContactPoint(localCollisionPoint, otherLocalCollisionPoint, collisionNormal, collisionPenetration);
+
+			collision.entityIDA = entityIDA;
+			collision.entityIDB = entityIDB;
+		}
+		else {
+			collision.isColliding = false;
+		}
+
+		return collision;
+	}
+
+	CollisionData SystemCollision::IntersectBoxBox(const unsigned int entityIDA, const unsigned int entityIDB, const ComponentTransform& transformA, const ComponentCollisionBox& colliderA, const ComponentTransform& transformB, const ComponentCollisionBox& colliderB) const
+	{
+		SCOPE_TIMER("SystemCollision::IntersectBoxBox()");
+		CollisionData collision;
+		if (colliderA.CheckBroadPhaseFirst() && colliderB.CheckBroadPhaseFirst()) {
+			if (!BroadPhaseSphereSphere(transformA, colliderA, transformB, colliderB)) {
+				collision.entityIDA = entityIDA;
+				collision.entityIDB = entityIDB;
+				collision.isColliding = false;
+				return collision;
+			}
+		}
+
+		const std::vector<glm::vec3> axes = GetAllCollisionAxis(transformA, transformB);
+
+		CollisionData bestCollision;
+		bestCollision.AddContactPoint(glm::vec3(), glm::vec3(), glm::vec3(), -FLT_MAX);
+		for (glm::vec3 axis : axes) {
+			if (axis != glm::vec3(0.0f, 0.0f, 0.0f)) {
+				collision.entityIDA = entityIDA;
+				collision.entityIDB = entityIDB;
+				if (!CheckForCollisionOnAxis(axis, transformA, colliderA, transformB, colliderB, collision)) {
+					collision.isColliding = false;
+					return collision;
+				}
+
+				if (collision.contactPoints[0].penetration >= bestCollision.contactPoints[0].penetration) {
+					bestCollision = collision;
+				}
+				collision = CollisionData();
+			}
+		}
+
+		bestCollision.isColliding = true;
+
+		GetContactPoints(bestCollision, transformA, colliderA.GetBoundingBox(), transformB, colliderB.GetBoundingBox());
+
+		return bestCollision;
+	}
+
+	CollisionData SystemCollision::IntersectBoxAABB(const unsigned int entityIDA, const unsigned int entityIDB, const ComponentTransform& transformA, const ComponentCollisionBox& colliderA, const ComponentTransform& transformB, const ComponentCollisionAABB& colliderB) const
+	{
+		SCOPE_TIMER("SystemCollision::IntersectBoxAABB()");
+		CollisionData collision;
+		if (colliderA.CheckBroadPhaseFirst()) {
+			if (!BroadPhaseSphereSphere(transformA, colliderA, transformB, colliderB)) {
+				collision.entityIDA = entityIDA;
+				collision.entityIDB = entityIDB;
+				collision.isColliding = false;
+				return collision;
+			}
+		}
+
+		std::vector<glm::vec3> axes = GetAllCollisionAxis(transformA, transformB);
+
+		CollisionData bestCollision;
+		bestCollision.AddContactPoint(glm::vec3(), glm::vec3(), glm::vec3(), -FLT_MAX);
+		float penetration = -FLT_MAX;
+		for (glm::vec3 axis : axes) {
+			collision.entityIDA = entityIDA;
+			collision.entityIDB = entityIDB;
+			if (!CheckForCollisionOnAxis(axis, transformA, colliderA, transformB, colliderB, collision)) {
+				collision.isColliding = false;
+				return collision;
+			}
+
+			if (collision.contactPoints[0].penetration >= bestCollision.contactPoints[0].penetration) {
+				bestCollision = collision;
+			}
+			collision = CollisionData();
+		}
+
+		bestCollision.isColliding = true;
+
+		GetContactPoints(bestCollision, transformA, colliderA.GetBoundingBox(), transformB, colliderB.GetBoundingBox());
+
+		return bestCollision;
+	}
+
+	CollisionData SystemCollision::IntersectAABBAABB(const unsigned int entityIDA, const unsigned int entityIDB, const ComponentTransform& transformA, const ComponentCollisionAABB& colliderA, const ComponentTransform& transformB, const ComponentCollisionAABB& colliderB) const
+	{
+		SCOPE_TIMER("SystemCollision::IntersectAABBAABB()");
+		const AABBPoints bounds1 = colliderA.GetWorldSpaceBounds(transformA.GetWorldModelMatrix());
+		const AABBPoints bounds2 = colliderB.GetWorldSpaceBounds(transformB.GetWorldModelMatrix());
+
+		CollisionData collision;
+		if (bounds1.minX <= bounds2.maxX && bounds1.maxX >= bounds2.minX && bounds1.minY <= bounds2.maxY && bounds1.maxY >= bounds2.minY && bounds1.minZ <= bounds2.maxZ && bounds1.maxZ >= bounds2.minZ) {
+			const glm::vec3 faces[6] = {
+				glm::vec3(-1.0f, 0.0f, 0.0f),
+				glm::vec3(1.0f, 0.0f, 0.0f),
+				glm::vec3(0.0f, -1.0f, 0.0f),
+				glm::vec3(0.0f, 1.0f, 0.0f),
+				glm::vec3(0.0f, 0.0f, -1.0f),
+				glm::vec3(0.0f, 0.0f, 1.0f)
+			};
+			
+			const float distances[6] = {
+				(bounds2.maxX - bounds1.minX),
+				(bounds1.maxX - bounds2.minX),
+				(bounds2.maxY - bounds1.minY),
+				(bounds1.maxY - bounds2.minY),
+				(bounds2.maxZ - bounds1.minZ),
+				(bounds1.maxZ - bounds2.minZ)
+			};
+
+			float penetration = FLT_MAX;
+			glm::vec3 bestAxis;
+			for (int i = 0; i < 6; i++) {
+				if (distances[i] < penetration) {
+					penetration = distances[i];
+					bestAxis = faces[i];
+				}
+			}
+
+			collision.isColliding = true;
+
+			collision.AddContactPoint(glm::vec3(), glm::vec3(), bestAxis, penetration);
+
+			collision.entityIDA = entityIDA;
+			collision.entityIDB = entityIDB;
+
+			GetContactPoints(collision, transformA, colliderA.GetBoundingBox(), transformB, colliderB.GetBoundingBox());
+		}
+		else {
+			collision.isColliding = false;
+		}
+
+		return collision;
+	}
+
+	CollisionData SystemCollision::IntersectSphereConvex(const unsigned int entityIDA, const unsigned int entityIDB, const ComponentTransform& transformA, const ComponentCollisionSphere& colliderA, const ComponentTransform& transformB, const ComponentCollisionConvex& colliderB) const
+	{
+		SCOPE_TIMER("SystemCollision::IntersectSphereConvex()");
+		return IntersectConvexShapes(entityIDA, entityIDB, transformA, MakeSphereSupport(transformA, colliderA), transformB, HullSupport(*colliderB.GetHull(), transformB.GetWorldModelMatrix()));
+	}
+
+	CollisionData SystemCollision::IntersectBoxConvex(const unsigned int entityIDA, const unsigned int entityIDB, const ComponentTransform& transformA, const ComponentCollisionBox& colliderA, const ComponentTransform& transformB, const ComponentCollisionConvex& colliderB) const
+	{
+		SCOPE_TIMER("SystemCollision::IntersectBoxConvex()");
+		return IntersectConvexShapes(entityIDA, entityIDB, transformA, MakeBoxSupport(transformA, colliderA), transformB, HullSupport(*colliderB.GetHull(), transformB.GetWorldModelMatrix()));
+	}
+
+	CollisionData SystemCollision::IntersectAABBConvex(const unsigned int entityIDA, const unsigned int entityIDB, const ComponentTransform& transformA, const ComponentCollisionAABB& colliderA, const ComponentTransform& transformB, const ComponentCollisionConvex& colliderB) const
+	{
+		SCOPE_TIMER("SystemCollision::IntersectAABBConvex()");
+		return IntersectConvexShapes(entityIDA, entityIDB, transformA, MakeAABBSupport(transformA, colliderA), transformB, HullSupport(*colliderB.GetHull(), transformB.GetWorldModelMatrix()));
+	}
+
+	CollisionData SystemCollision::IntersectConvexConvex(const unsigned int entityIDA, const unsigned int entityIDB, const ComponentTransform& transformA, const ComponentCollisionConvex& colliderA, const ComponentTransform& transformB, const ComponentCollisionConvex& colliderB) const
+	{
+		SCOPE_TIMER("SystemCollision::IntersectConvexConvex()");
+		return IntersectConvexShapes(entityIDA, entityIDB, transformA, HullSupport(*colliderA.GetHull(), transformA.GetWorldModelMatrix()), transformB, HullSupport(*colliderB.GetHull(), transformB.GetWorldModelMatrix()));
+	}
+
+	CollisionData SystemCollision::IntersectConvexShapes(const unsigned int entityIDA, const unsigned int entityIDB, const ComponentTransform& transformA, const ConvexSupport& shapeA, const ComponentTransform& transformB, const ConvexSupport& shapeB) const
+	{
+		CollisionData collision;
+		collision.entityIDA = entityIDA;
+		collision.entityIDB = entityIDB;
+
+		ConvexContact deepest;
+		if (!GJK::Penetration(shapeA, shapeB, deepest)) {
+			collision.isColliding = false;
+			return collision;
+		}
+
+		ConvexContact manifold[GJK::MAX_MANIFOLD_CONTACTS];
+		const unsigned int numContacts = GJK::ContactManifold(shapeA, shapeB, deepest, manifold);
+		const glm::vec3& positionA = transformA.GetWorldPosition();
+		const glm::vec3& positionB = transformB.GetWorldPosition();
+		for (unsigned int i = 0; i < numContacts; i++) {
+			collision.AddContactPoint(manifold[i].pointA - positionA, manifold[i].pointB - positionB, manifold[i].normal, manifold[i].depth);
+		}
+
+		collision.isColliding = true;
+		return collision;
+	}
+
+	CollisionData SystemCollision::IntersectSphereMesh(const unsigned int entityIDA, const unsigned int entityIDB, const ComponentTransform& transformA, const ComponentCollisionSphere& colliderA, const ComponentTransform& transformB, const ComponentCollisionMesh& colliderB) const
+	{
+		SCOPE_TIMER("SystemCollision::IntersectSphereMesh()");
+		const glm::vec3& centre = transformA.GetWorldPosition();
+		const float scaledRadius = colliderA.CollisionRadius() * transformA.GetBiggestScaleFactor();
+		const glm::mat4& meshTransform = transformB.GetWorldModelMatrix();
+		const glm::vec3& meshPosition = transformB.GetWorldPosition();
+
+		CollisionData collision;
+		collision.entityIDA = entityIDA;
+		collision.entityIDB = entityIDB;
+
+		// Only triangles under the sphere's bounds, taken into the mesh's local space, are tested
+		glm::vec3 localMin, localMax;
+		OrientedBoxBounds(glm::inverse(meshTransform), centre - glm::vec3(scaledRadius), centre + glm::vec3(scaledRadius), localMin, localMax);
+
+		colliderB.GetMesh()->ForEachTriangle(localMin, localMax, [&](const unsigned int triangle) {
+			const glm::vec3* local = colliderB.GetMesh()->TriangleVertices(triangle);
+			const glm::vec3 a = glm::vec3(meshTransform * glm::vec4(local[0], 1.0f));
+			const glm::vec3 b = glm::vec3(meshTransform * glm::vec4(local[1], 1.0f));
+			const glm::vec3 c = glm::vec3(meshTransform * glm::vec4(local[2], 1.0f));
+
+			const glm::vec3 closestPoint = TriangleMeshBVH::ClosestPointOnTriangle(centre, a, b, c);
+			const glm::vec3 offset = centre - closestPoint;
+			const float distanceSqr = glm::dot(offset, offset);
+			if (distanceSqr >= scaledRadius * scaledRadius) { return; }
+
+			const float distance = sqrt(distanceSqr);
+			const glm::vec3 collisionNormal = (distance > 1e-6f) ? offset / distance : glm::normalize(glm::cross(b - a, c - a));
+			const float collisionPenetration = scaledRadius - distance;
+
+			// Neighbouring triangles report the same contact along a shared edge or vertex, only the deepest of each direction is kept
+			for (ContactPoint& contact : collision.contactPoints) {
+				if (glm::dot(contact.normal, collisionNormal) > 0.999f) {
+					if (collisionPenetration > contact.penetration) {
+						contact = ContactPoint(-collisionNormal * scaledRadius, closestPoint - meshPosition, collisionNormal, collisionPenetration);
+					}
+					return;
+				}
+			}
+
+			if (collision.contactPoints.size() < MAX_MESH_CONTACTS) {
+				collision.AddContactPoint(-collisionNormal * scaledRadius, closestPoint - meshPosition, collisionNormal, collisionPenetration);
+			}
+		});
+
+		collision.isColliding = collision.contactPoints.size() > 0;
+		return collision;
+	}
+
+	CollisionData SystemCollision::IntersectBoxMesh(const unsigned int entityIDA, const unsigned int entityIDB, const ComponentTransform& transformA, const ComponentCollisionBox& colliderA, const ComponentTransform& transformB, const ComponentCollisionMesh& colliderB) const
+	{
+		SCOPE_TIMER("SystemCollision::IntersectBoxMesh()");
+		const glm::mat4& boxTransform = transformA.GetWorldModelMatrix();
+		const BoxExtents& extents = colliderA.GetLocalPoints();
+		const glm::vec3 localMin = glm::vec3(extents.minX, extents.minY, extents.minZ);
+		const glm::vec3 localMax = glm::vec3(extents.maxX, extents.maxY, extents.maxZ);
+
+		const glm::vec3 scale = glm::vec3(glm::length(glm::vec3(boxTransform[0])), glm::length(glm::vec3(boxTransform[1])), glm::length(glm::vec3(boxTransform[2])));
+		const glm::vec3 boxAxes[3] = { glm::vec3(boxTransform[0]) / scale.x, glm::vec3(boxTransform[1]) / scale.y, glm::vec3(boxTransform[2]) / scale.z };
+		const glm::vec3 boxCentre = glm::vec3(boxTransform * glm::vec4((localMin + localMax) * 0.5f, 1.0f));
+		const glm::vec3 boxHalfExtents = (localMax - localMin) * 0.5f * scale;
+
+		return IntersectOrientedBoxMesh(entityIDA, entityIDB, transformA, boxCentre, boxAxes, boxHalfExtents, transformB, colliderB);
+	}
+
+	CollisionData SystemCollision::IntersectAABBMesh(const unsigned int entityIDA, const unsigned int entityIDB, const ComponentTransform& transformA, const ComponentCollisionAABB& colliderA, const ComponentTransform& transformB, const ComponentCollisionMesh& colliderB) const
+	{
+		SCOPE_TIMER("SystemCollision::IntersectAABBMesh()");
+		const AABBPoints worldSpaceBounds = colliderA.GetWorldSpaceBounds(transformA.GetWorldModelMatrix());
+		const glm::vec3 boundsMin = glm::vec3(worldSpaceBounds.minX, worldSpaceBounds.minY, worldSpaceBounds.minZ);
+		const glm::vec3 boundsMax = glm::vec3(worldSpaceBounds.maxX, worldSpaceBounds.maxY, worldSpaceBounds.maxZ);
+		const glm::vec3 boxAxes[3] = { glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f) };
+
+		return IntersectOrientedBoxMesh(entityIDA, entityIDB, transformA, (boundsMin + boundsMax) * 0.5f, boxAxes, (boundsMax - boundsMin) * 0.5f, transformB, colliderB);
+	}
+
+	CollisionData SystemCollision::IntersectConvexMesh(const unsigned int entityIDA, const unsigned int entityIDB, const ComponentTransform& transformA, const ComponentCollisionConvex& colliderA, const ComponentTransform& transformB, const ComponentCollisionMesh& colliderB) const
+	{
+		SCOPE_TIMER("SystemCollision::IntersectConvexMesh()");
+		const glm::mat4& hullTransform = transformA.GetWorldModelMatrix();
+		const glm::mat4& meshTransform = transformB.GetWorldModelMatrix();
+		const glm::vec3& hullPosition = transformA.GetWorldPosition();
+		const glm::vec3& meshPosition = transformB.GetWorldPosition();
+		const HullSupport hull(*colliderA.GetHull(), hullTransform);
+
+		glm::vec3 boundsMin, boundsMax;
+		colliderA.GetWorldSpaceBounds(hullTransform, boundsMin, boundsMax);
+		const float mergeDistance = MESH_CONTACT_MERGE_FRACTION * glm::length(boundsMax - boundsMin);
+
+		glm::vec3 localMin, localMax;
+		OrientedBoxBounds(glm::inverse(meshTransform), boundsMin, boundsMax, localMin, localMax);
+
+		CollisionData collision;
+		collision.entityIDA = entityIDA;
+		collision.entityIDB = entityIDB;
+
+		// Each triangle is a convex shape of its own, tested against the hull with the same GJK and EPA as every other convex pair
+		colliderB.GetMesh()->ForEachTriangle(localMin, localMax, [&](const unsigned int triangle) {
+			const glm::vec3* local = colliderB.GetMesh()->TriangleVertices(triangle);
+			const TriangleSupport triangleSupport(glm::vec3(meshTransform * glm::vec4(local[0], 1.0f)), glm::vec3(meshTransform * glm::vec4(local[1], 1.0f)), glm::vec3(meshTransform * glm::vec4(local[2], 1.0f)));
+
+			ConvexContact deepest;
+			if (!GJK::Penetration(hull, triangleSupport, deepest)) { return; }
+
+			ConvexContact manifold[GJK::MAX_MANIFOLD_CONTACTS];
+			const unsigned int numContacts = GJK::ContactManifold(hull, triangleSupport, deepest, manifold);
+			for (unsigned int i = 0; i < numContacts; i++) {
+				const ConvexContact& contact = manifold[i];
+
+				// Neighbouring triangles find the same hull corners, only the deepest of each is kept
+				bool merged = false;
+				for (ContactPoint& existing : collision.contactPoints) {
+					if (glm::distance(existing.contactPointA + hullPosition, contact.pointA) <= mergeDistance) {
+						if (contact.depth > existing.penetration) {
+							existing = ContactPoint(contact.pointA - hullPosition, contact.pointB - meshPosition, contact.normal, contact.depth);
+						}
+						merged = true;
+						break;
+					}
+				}
+
+				if (!merged) {
+					collision.AddContactPoint(contact.pointA - hullPosition, contact.pointB - meshPosition, contact.normal, contact.depth);
+				}
+			}
+		});
+
+		ReduceContacts(collision.contactPoints, MAX_MESH_CONTACTS);
+		collision.isColliding = collision.contactPoints.size() > 0;
+		return collision;
+	}
+
+	CollisionData SystemCollision::IntersectOrientedBoxMesh(const unsigned int entityIDA, const unsigned int entityIDB, const ComponentTransform& transformA, const glm::vec3& boxCentre, const glm::vec3 boxAxes[3], const glm::vec3& boxHalfExtents, const ComponentTransform& transformB, const ComponentCollisionMesh& colliderB) const
+	{
+		const glm::mat4& meshTransform = transformB.GetWorldModelMatrix();
+		const glm::vec3& boxPosition = transformA.GetWorldPosition();
+		const glm::vec3& meshPosition = transformB.GetWorldPosition();
+
+		glm::vec3 corners[8];
+		for (unsigned int i = 0; i < 8; i++) {
+			corners[i] = boxCentre
+				+ boxAxes[0] * ((i & 1) ? boxHalfExtents.x : -boxHalfExtents.x)
+				+ boxAxes[1] * ((i & 2) ? boxHalfExtents.y : -boxHalfExtents.y)
+				+ boxAxes[2] * ((i & 4) ? boxHalfExtents.z : -boxHalfExtents.z);
+		}
+
+		const glm::vec3 worldHalfExtents = glm::abs(boxAxes[0]) * boxHalfExtents.x + glm::abs(boxAxes[1]) * boxHalfExtents.y + glm::abs(boxAxes[2]) * boxHalfExtents.z;
+		glm::vec3 localMin, localMax;
+		OrientedBoxBounds(glm::inverse(meshTransform), boxCentre - worldHalfExtents, boxCentre + worldHalfExtents, localMin, localMax);
+
+		// Box corners pushed through a triangle's face give stable manifolds, each corner keeps its deepest triangle
+		// Corners are measured against the triangle's plane whichever axis the overlap test settled on, as on uneven ground that is often one of the box's own axes
+		float cornerDepth[8] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+		glm::vec3 cornerNormal[8];
+
+		// Edge and vertex overlaps that no corner accounts for fall back to a single contact between the two support points
+		float fallbackDepth = 0.0f;
+		glm::vec3 fallbackNormal, fallbackPoint;
+
+		colliderB.GetMesh()->ForEachTriangle(localMin, localMax, [&](const unsigned int triangle) {
+			const glm::vec3* local = colliderB.GetMesh()->TriangleVertices(triangle);
+			const glm::vec3 a = glm::vec3(meshTransform * glm::vec4(local[0], 1.0f));
+			const glm::vec3 b = glm::vec3(meshTransform * glm::vec4(local[1], 1.0f));
+			const glm::vec3 c = glm::vec3(meshTransform * glm::vec4(local[2], 1.0f));
+
+			glm::vec3 axis;
+			float depth;
+			if (!TriangleMeshBVH::BoxTriangleOverlap(boxCentre, boxAxes, boxHalfExtents, a, b, c, axis, depth)) { return; }
+
+			// Face normal on the side of the box's centre
+			glm::vec3 faceNormal = glm::normalize(glm::cross(b - a, c - a));
+			if (glm::dot(boxCentre - a, faceNormal) < 0.0f) { faceNormal = -faceNormal; }
+
+			bool cornerFound = false;
+			for (unsigned int i = 0; i < 8; i++) {
+				const float height = glm::dot(corners[i] - a, faceNormal);
+				if (height >= 0.0f || !TriangleMeshBVH::PointInTriangle(corners[i] - faceNormal * height, a, b, c)) { continue; }
+
+				cornerFound = true;
+				if (-height > cornerDepth[i]) {
+					cornerDepth[i] = -height;
+					cornerNormal[i] = faceNormal;
+				}
+			}
+
+			if (!cornerFound && depth > fallbackDepth) {
+				glm::vec3 boxSupport = corners[0];
+				for (unsigned int i = 1; i < 8; i++) {
+					if (glm::dot(corners[i], axis) < glm::dot(boxSupport, axis)) { boxSupport = corners[i]; }
+				}
+				glm::vec3 triangleSupport = a;
+				if (glm::dot(b, axis) > glm::dot(triangleSupport, axis)) { triangleSupport = b; }
+				if (glm::dot(c, axis) > glm::dot(triangleSupport, axis)) { triangleSupport = c; }
+
+				fallbackDepth = depth;
+				fallbackNormal = axis;
+				fallbackPoint = (boxSupport + triangleSupport) * 0.5f;
+			}
+		});
+
+		CollisionData collision;
+		collision.entityIDA = entityIDA;
+		collision.entityIDB = entityIDB;
+
+		for (unsigned int i = 0; i < 8; i++) {
+			if (cornerDepth[i] > 0.0f) {
+				collision.AddContactPoint(corners[i] - boxPosition, corners[i] - meshPosition, cornerNormal[i], cornerDepth[i], i + 1u);
+			}
+		}
+		if (collision.contactPoints.size() == 0 && fallbackDepth > 0.0f) {
+			collision.AddContactPoint(fallbackPoint - boxPosition, fallbackPoint - meshPosition, fallbackNormal, fallbackDepth);
+		}
+
+		collision.isColliding = collision.contactPoints.size() > 0;
+		return collision;
+	}
+
 	void SystemCollision::GetMinMaxOnAxis(const std::vector<glm::vec3>& worldSpacePoints, const glm::vec3& worldSpaceAxis, float& out_min, float& out_max) const
 	{
 		if (worldSpacePoints.size() < 1) {
@@ -397,17 +1316,18 @@ namespace Engine {
 		return (distanceSqr < combinedRadiusSqr) ? true : false;
 	}
 
-	void SystemCollision::GetContactPoints(CollisionData& out_collisionInfo) const
+	void SystemCollision::GetContactPoints(CollisionData& out_collisionInfo, const ComponentTransform& transformA, const BoundingBox& boxA, const ComponentTransform& transformB, const BoundingBox& boxB) const
 	{
 		std::vector<glm::vec3> poly1, poly2;
 		glm::vec3 normal1, normal2;
 		std::vector<ClippingPlane> adjPlanes1, adjPlanes2;
+		unsigned int faceID1 = 0, faceID2 = 0;
 
 		// Get incident reference polygon 1
-		GetIncidentReferencePolygon(out_collisionInfo.contactPoints[0].normal, poly1, normal1, adjPlanes1, out_collisionInfo.entityIDA);
+		GetIncidentReferencePolygon(out_collisionInfo.contactPoints[0].normal, poly1, normal1, adjPlanes1, faceID1, transformA, boxA);
 
 		// Get incident reference polygon 2
-		GetIncidentReferencePolygon(-out_collisionInfo.contactPoints[0].normal, poly2, normal2, adjPlanes2, out_collisionInfo.entityIDB);
+		GetIncidentReferencePolygon(-out_collisionInfo.contactPoints[0].normal, poly2, normal2, adjPlanes2, faceID2, transformB, boxB);
 
 		const float penatration = out_collisionInfo.contactPoints[0].penetration;
 		const glm::vec3 normal = out_collisionInfo.contactPoints[0].normal;
@@ -417,11 +1337,11 @@ namespace Engine {
 		}
 		else if (poly1.size() == 1) {
 			out_collisionInfo.contactPoints.clear();
-			out_collisionInfo.AddContactPoint(poly1.front(), poly1.front() + normal * penatration, normal, penatration);
+			out_collisionInfo.AddContactPoint(poly1.front(), poly1.front() + normal * penatration, normal, penatration, MakeContactFeatureID(faceID1, faceID2, 0));
 		}
 		else if (poly2.size() == 1) {
 			out_collisionInfo.contactPoints.clear();
-			out_collisionInfo.AddContactPoint(poly2.front() - normal * penatration, poly2.front(), normal, penatration);
+			out_collisionInfo.AddContactPoint(poly2.front() - normal * penatration, poly2.front(), normal, penatration, MakeContactFeatureID(faceID2, faceID1, 0));
 		}
 		else {
 			// Clipping method
@@ -431,6 +1351,7 @@ namespace Engine {
 				std::swap(poly1, poly2);
 				std::swap(normal1, normal2);
 				std::swap(adjPlanes1, adjPlanes2);
+				std::swap(faceID1, faceID2);
 			}
 
 			// Clip incident face to adjacent edges of reference face
@@ -444,6 +1365,7 @@ namespace Engine {
 
 			// Now left with selection of valid contact points to be used for collision manifold
 			bool first = true;
+			unsigned int pointIndex = 0;
 			for (const glm::vec3& point : poly2) {
 				// Get distance to reference plane
 				const glm::vec3 pointDiff = point - GetClosestPointPolygon(point, poly1);
@@ -464,19 +1386,19 @@ namespace Engine {
 						out_collisionInfo.contactPoints.clear();
 						first = false;
 					}
-					const glm::vec3 localA = globalOnA - active_ecs->GetComponent<ComponentTransform>(out_collisionInfo.entityIDA)->GetWorldPosition();
-					const glm::vec3 localB = globalOnB - active_ecs->GetComponent<ComponentTransform>(out_collisionInfo.entityIDB)->GetWorldPosition();
+					const glm::vec3 localA = globalOnA - transformA.GetWorldPosition();
+					const glm::vec3 localB = globalOnB - transformB.GetWorldPosition();
 					//glm::vec3 newNormal = glm::normalize(-normal1 + normal2);
-					out_collisionInfo.AddContactPoint(localA, localB, normal, contact_penetration);
+					out_collisionInfo.AddContactPoint(localA, localB, normal, contact_penetration, MakeContactFeatureID(faceID1, faceID2, pointIndex));
 				}
+				pointIndex++;
 			}
 		}
 	}
 
-	void SystemCollision::GetIncidentReferencePolygon(const glm::vec3& axis, std::vector<glm::vec3>& out_face, glm::vec3& out_normal, std::vector<ClippingPlane>& out_adjPlanes, const unsigned int entityID) const
+	void SystemCollision::GetIncidentReferencePolygon(const glm::vec3& axis, std::vector<glm::vec3>& out_face, glm::vec3& out_normal, std::vector<ClippingPlane>& out_adjPlanes, unsigned int& out_faceID, const ComponentTransform& transform, const BoundingBox& cube) const
 	{
-		const ComponentTransform* transform = active_ecs->GetComponent<ComponentTransform>(entityID);
-		const glm::mat4& modelMatrix = transform->GetWorldModelMatrix();
+		const glm::mat4& modelMatrix = transform.GetWorldModelMatrix();
 		const glm::mat3 inverseNormalMatrix = glm::inverse(glm::mat3(modelMatrix));
 		const glm::mat3 normalMatrix = glm::inverse(inverseNormalMatrix);
 
@@ -484,13 +1406,6 @@ namespace Engine {
 
 		// Get furthest vertex along axis - furthest face
 		int minVertexId, maxVertexId;
-		BoundingBox cube;
-		const ComponentCollisionBox* boxCollider = active_ecs->GetComponent<ComponentCollisionBox>(entityID);
-		const ComponentCollisionAABB* aabbCollider = active_ecs->GetComponent<ComponentCollisionAABB>(entityID);
-		if (boxCollider) { cube = boxCollider->GetBoundingBox(); }
-		else if (aabbCollider) { cube = aabbCollider->GetBoundingBox(); }
-		else { throw std::invalid_argument("Incident refernc polygon can only be retrieved on objects with either an AABB collider or box collider"); }
-
 		cube.GetMinMaxVerticesOnAxis(localAxis, minVertexId, maxVertexId);
 		const BoxVertex& vertex = cube.vertices[maxVertexId];
 
@@ -508,6 +1423,7 @@ namespace Engine {
 		}
 
 		if (bestFace == nullptr) { return; }
+		out_faceID = bestFace->id;
 
 		// Output face normal
 		out_normal = glm::normalize((normalMatrix * bestFace->normal));
@@ -5,7 +5,12 @@
 #include "ComponentCollisionAABB.h"
 #include "ComponentCollisionBox.h"
 #include "ComponentCollisionSphere.h"
+#include "ComponentCollisionMesh.h"
+#include "ComponentCollisionConvex.h"
+#include "ComponentPhysics.h"
 #include "CollisionManager.h"
+#include "CollisionBatch.h"
+#include "GJK.h"
 namespace Engine {
 	struct Edge {
 		Edge(const glm::vec3& start = glm::vec3(0.0f), const glm::vec3& end = glm::vec3(0.0f)) : start(start), end(end) {}
@@ -14,40 +19,143 @@ namespace Engine {
 		glm::vec3 end;
 	};
 
+	// Contact feature ID made from the reference face, incident face and clipped point index. Offset by one so that 0 remains "unknown"
+	inline unsigned int MakeContactFeatureID(const unsigned int referenceFaceID, const unsigned int incidentFaceID, const unsigned int pointIndex) {
+		return ((referenceFaceID + 1u) << 16) | ((incidentFaceID + 1u) << 8) | (pointIndex + 1u);
+	}
+
+	// Narrowphase routines are grouped by the pair of shapes they handle
+	// Pairs are always ordered sphere, box, AABB, convex, mesh so each bucket has one fixed order, same shape pairs put the lower entity ID first
+	enum ShapePairType {
+		SHAPE_PAIR_SPHERE_SPHERE,
+		SHAPE_PAIR_SPHERE_BOX,
+		SHAPE_PAIR_SPHERE_AABB,
+		SHAPE_PAIR_BOX_BOX,
+		SHAPE_PAIR_BOX_AABB,
+		SHAPE_PAIR_AABB_AABB,
+		SHAPE_PAIR_SPHERE_CONVEX,
+		SHAPE_PAIR_BOX_CONVEX,
+		SHAPE_PAIR_AABB_CONVEX,
+		SHAPE_PAIR_CONVEX_CONVEX,
+		SHAPE_PAIR_SPHERE_MESH,
+		SHAPE_PAIR_BOX_MESH,
+		SHAPE_PAIR_AABB_MESH,
+		SHAPE_PAIR_CONVEX_MESH,
+		NUM_SHAPE_PAIR_TYPES
+	};
+
+	// Collider gathered at the start of a run with everything the broadphase filters need, so no pair has to look anything up
+	struct ColliderProxy {
+		unsigned int entityID;
+		ColliderType shape;
+		ComponentTransform* transform;
+		ComponentCollision* collider;
+
+		unsigned int layer;
+		unsigned int mask;
+		unsigned int acceptedLayers; // see CollisionManager::AcceptedLayers
+		bool sleeping;
+		bool movable;
+
+		// Conservative world bounds used by the sweep
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+
+		// Shape data used by the batch kernels
+		glm::vec3 centre;
+		float radius; // spheres only, scaled
+		glm::vec3 aabbMin; // AABBs only, as used by the AABB narrowphase
+		glm::vec3 aabbMax;
+	};
+
+	// Candidate pair produced by the broadphase, tested later by the narrowphase
+	struct NarrowphasePair {
+		ShapePairType type;
+		unsigned int proxyA;
+		unsigned int proxyB;
+	};
+
+	// Collision detection for every collider in the scene, replacing a system per shape pair
+	// A sweep and prune broadphase over world bounds produces candidate pairs, filtered by layer and sleep state, which are bucketed by shape pair.
+	// Sphere buckets are tested in SIMD batches first, then every remaining candidate is tested in parallel chunks and the results are merged in bucket and pair order.
+	// The touching pairs are then diffed against the last run's to write begin, stay and end events, see CollisionManager::GetCollisionEvents
 	class SystemCollision : public System
 	{
 	public:
 		SystemCollision(EntityManager* ecs, CollisionManager* collisionManager) : System(ecs), collisionManager(collisionManager) {}
 		~SystemCollision() {}
 
+		constexpr const char* SystemName() override { return "SYSTEM_COLLISION"; }
+
+		void Run();
+
 		void GetMinMaxOnAxis(const std::vector<glm::vec3>& worldSpacePoints, const glm::vec3& worldSpaceAxis, float& out_min, float& out_max) const;
 		void GetMinMaxOnAxis(const std::vector<glm::vec3>& worldSpacePoints, const glm::vec3& worldSpaceAxis, float& out_min, float& out_max, int& out_minIndex, int& out_maxIndex) const;
 
-		virtual constexpr const char* SystemName() override = 0;
+		// Run the narrowphase on the calling thread only, for debugging. Results are identical either way
+		static void SetForceSingleThreaded(const bool singleThreaded) { forceSingleThreaded = singleThreaded; }
+		static bool ForceSingleThreaded() { return forceSingleThreaded; }
+
+		static void SetPairsPerChunk(const unsigned int newPairsPerChunk) { pairsPerChunk = std::max(newPairsPerChunk, 1u); }
+		static unsigned int PairsPerChunk() { return pairsPerChunk; }
+
+		// Counts from the last run
+		unsigned int NumColliders() const { return proxies.size(); }
+		unsigned int NumCandidatePairs() const { return pairs.size(); }
+		unsigned int NumCandidatePairs(const ShapePairType type) const { return bucketStart[type + 1] - bucketStart[type]; }
+		unsigned int NumCollidingPairs() const { return numCollidingPairs; }
 
 	protected:
 		CollisionManager* collisionManager;
 
-		void CollisionPreCheck(const unsigned int entityIDA, ComponentCollision* colliderA, const unsigned int entityIDB, ComponentCollision* colliderB) const {
-			colliderA->AddToEntitiesCheckedThisFrame(entityIDB, active_ecs->Find(entityIDB)->Name());
-			colliderB->AddToEntitiesCheckedThisFrame(entityIDA, active_ecs->Find(entityIDA)->Name());
+	private:
+		void GatherColliders();
+		void Broadphase();
+		void RunBatchKernels();
+		void RunNarrowphase();
+		void UpdateCollisionLists();
+		void UpdateColliderLists(const unsigned int entityIDA, const unsigned int entityIDB, const bool touching);
+
+		void AddProxy(const unsigned int entityID, const ColliderType shape, ComponentTransform& transform, ComponentCollision& collider, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+		void AddPair(const unsigned int proxyA, const unsigned int proxyB);
+
+		// Both sides must be willing to collide with the other's layer
+		static bool LayersCollide(const ColliderProxy& a, const ColliderProxy& b) {
+			return (b.layer & a.acceptedLayers) && (a.layer & b.mask);
 		}
 
-		void CollisionPostCheck(const CollisionData& collision, const unsigned int entityIDA, ComponentCollision* colliderA, const unsigned int entityIDB, ComponentCollision* colliderB) {
-			if (collision.isColliding) {
-				collisionManager->AddToCollisionList(collision);
-
-				colliderA->AddToCollisions(entityIDB, active_ecs->Find(entityIDB)->Name());
-				colliderB->AddToCollisions(entityIDA, active_ecs->Find(entityIDA)->Name());
-			}
-			else {
-				colliderA->RemoveFromCollisions(entityIDB);
-				colliderB->RemoveFromCollisions(entityIDA);
-			}
+		// A pair is skipped when one side is asleep and the other is either asleep or immovable, as nothing in it can have changed
+		static bool IsPairAsleep(const ColliderProxy& a, const ColliderProxy& b) {
+			return (a.sleeping || b.sleeping) && (a.sleeping || !a.movable) && (b.sleeping || !b.movable);
 		}
 
-		void GetContactPoints(CollisionData& out_collisionInfo) const;
-		void GetIncidentReferencePolygon(const glm::vec3& axis, std::vector<glm::vec3>& out_face, glm::vec3& out_normal, std::vector<ClippingPlane>& out_adjPlanes, const unsigned int entityID) const;
+		// Must be thread safe, pairs are tested concurrently
+		CollisionData IntersectPair(const NarrowphasePair& pair) const;
+
+		CollisionData IntersectSphereSphere(const unsigned int entityIDA, const unsigned int entityIDB, const ComponentTransform& transformA, const ComponentCollisionSphere& colliderA, const ComponentTransform& transformB, const ComponentCollisionSphere& colliderB) const;
+		CollisionData IntersectSphereBox(const unsigned int entityIDA, const unsigned int entityIDB, const ComponentTransform& transformA, const ComponentCollisionSphere& colliderA, const ComponentTransform& transformB, const ComponentCollisionBox& colliderB) const;
+		CollisionData IntersectSphereAABB(const unsigned int entityIDA, const unsigned int entityIDB, const ComponentTransform& transformA, const ComponentCollisionSphere& colliderA, const ComponentTransform& transformB, const ComponentCollisionAABB& colliderB) const;
+		CollisionData IntersectBoxBox(const unsigned int entityIDA, const unsigned int entityIDB, const ComponentTransform& transformA, const ComponentCollisionBox& colliderA, const ComponentTransform& transformB, const ComponentCollisionBox& colliderB) const;
+		CollisionData IntersectBoxAABB(const unsigned int entityIDA, const unsigned int entityIDB, const ComponentTransform& transformA, const ComponentCollisionBox& colliderA, const ComponentTransform& transformB, const ComponentCollisionAABB& colliderB) const;
+		CollisionData IntersectAABBAABB(const unsigned int entityIDA, const unsigned int entityIDB, const ComponentTransform& transformA, const ComponentCollisionAABB& colliderA, const ComponentTransform& transformB, const ComponentCollisionAABB& colliderB) const;
+		CollisionData IntersectSphereConvex(const unsigned int entityIDA, const unsigned int entityIDB, const ComponentTransform& transformA, const ComponentCollisionSphere& colliderA, const ComponentTransform& transformB, const ComponentCollisionConvex& colliderB) const;
+		CollisionData IntersectBoxConvex(const unsigned int entityIDA, const unsigned int entityIDB, const ComponentTransform& transformA, const ComponentCollisionBox& colliderA, const ComponentTransform& transformB, const ComponentCollisionConvex& colliderB) const;
+		CollisionData IntersectAABBConvex(const unsigned int entityIDA, const unsigned int entityIDB, const ComponentTransform& transformA, const ComponentCollisionAABB& colliderA, const ComponentTransform& transformB, const ComponentCollisionConvex& colliderB) const;
+		CollisionData IntersectConvexConvex(const unsigned int entityIDA, const unsigned int entityIDB, const ComponentTransform& transformA, const ComponentCollisionConvex& colliderA, const ComponentTransform& transformB, const ComponentCollisionConvex& colliderB) const;
+		CollisionData IntersectSphereMesh(const unsigned int entityIDA, const unsigned int entityIDB, const ComponentTransform& transformA, const ComponentCollisionSphere& colliderA, const ComponentTransform& transformB, const ComponentCollisionMesh& colliderB) const;
+		CollisionData IntersectBoxMesh(const unsigned int entityIDA, const unsigned int entityIDB, const ComponentTransform& transformA, const ComponentCollisionBox& colliderA, const ComponentTransform& transformB, const ComponentCollisionMesh& colliderB) const;
+		CollisionData IntersectAABBMesh(const unsigned int entityIDA, const unsigned int entityIDB, const ComponentTransform& transformA, const ComponentCollisionAABB& colliderA, const ComponentTransform& transformB, const ComponentCollisionMesh& colliderB) const;
+		CollisionData IntersectConvexMesh(const unsigned int entityIDA, const unsigned int entityIDB, const ComponentTransform& transformA, const ComponentCollisionConvex& colliderA, const ComponentTransform& transformB, const ComponentCollisionMesh& colliderB) const;
+
+		// GJK and EPA between any two shapes given as support mappings, with a contact manifold when both are polyhedral
+		CollisionData IntersectConvexShapes(const unsigned int entityIDA, const unsigned int entityIDB, const ComponentTransform& transformA, const ConvexSupport& shapeA, const ComponentTransform& transformB, const ConvexSupport& shapeB) const;
+
+		// Box given by its world centre, unit axes and scaled half extents against every triangle it may touch. Shared by boxes and AABBs
+		CollisionData IntersectOrientedBoxMesh(const unsigned int entityIDA, const unsigned int entityIDB, const ComponentTransform& transformA, const glm::vec3& boxCentre, const glm::vec3 boxAxes[3], const glm::vec3& boxHalfExtents, const ComponentTransform& transformB, const ComponentCollisionMesh& colliderB) const;
+
+		// Clips the two boxes' faces against each other, boxes are the pair's own box or AABB collider shapes
+		void GetContactPoints(CollisionData& out_collisionInfo, const ComponentTransform& transformA, const BoundingBox& boxA, const ComponentTransform& transformB, const BoundingBox& boxB) const;
+		void GetIncidentReferencePolygon(const glm::vec3& axis, std::vector<glm::vec3>& out_face, glm::vec3& out_normal, std::vector<ClippingPlane>& out_adjPlanes, unsigned int& out_faceID, const ComponentTransform& transform, const BoundingBox& cube) const;
 		bool CheckForCollisionOnAxis(const glm::vec3& axis, const ComponentTransform& transform, const ComponentCollisionBox& collider, const ComponentTransform& transform2, const ComponentCollisionBox& collider2, CollisionData& collision) const;
 		bool CheckForCollisionOnAxis(const glm::vec3& axis, const ComponentTransform& transform, const ComponentCollisionBox& collider, const ComponentTransform& transform2, const ComponentCollisionAABB& collider2, CollisionData& collision) const;
 		std::vector<glm::vec3> GetCubeNormals(const ComponentTransform& transform) const;
@@ -62,5 +170,36 @@ namespace Engine {
 		bool BroadPhaseSphereSphere(const ComponentTransform& transform, const ComponentCollisionBox& collider, const ComponentTransform& transform2, const ComponentCollisionBox& collider2) const;
 		bool BroadPhaseSphereSphere(const ComponentTransform& transform, const ComponentCollisionBox& collider, const ComponentTransform& transform2, const ComponentCollisionAABB& collider2) const;
 		bool BroadPhaseSphereSphere(const ComponentTransform& transform, const ComponentCollisionAABB& collider, const ComponentTransform& transform2, const ComponentCollisionAABB& collider2) const;
+
+		std::vector<ColliderProxy> proxies;
+		std::vector<NarrowphasePair> bucketPairs[NUM_SHAPE_PAIR_TYPES];
+
+		// Every bucket's pairs back to back, bucket t is [bucketStart[t], bucketStart[t + 1])
+		std::vector<NarrowphasePair> pairs;
+		unsigned int bucketStart[NUM_SHAPE_PAIR_TYPES + 1] = {};
+
+		// 1 while a pair may still be colliding, cleared by the batch kernels for pairs they rule out, then set to the narrowphase result
+		std::vector<unsigned char> pairColliding;
+
+		SphereSphereBatch sphereSphereBatch;
+		SphereAABBBatch sphereAABBBatch;
+
+		// One contact buffer per chunk so worker threads never share output
+		std::vector<std::vector<CollisionData>> chunkContacts;
+
+		// Pair keys (see MakePairKey) of every pair of entities touching this run and the last, sorted and unique once the run is over
+		// Diffing the two gives the collision events, and only the pairs that began or ended touch the colliders' collision lists
+		std::vector<unsigned long long> activePairs;
+		std::vector<unsigned long long> previousActivePairs;
+
+		// Sleeping pairs keep whatever contact state they had when they went to sleep, so they stay active only if they were last run
+		std::vector<unsigned long long> sleepingPairs;
+
+		// Proxies ordered by entity, built only on runs where a pair begins or ends touching
+		std::vector<unsigned int> proxiesByEntity;
+		unsigned int numCollidingPairs = 0;
+
+		static bool forceSingleThreaded;
+		static unsigned int pairsPerChunk;
 	};
 }
\ No newline at end of file
@@ -1,74 +1,250 @@
 #include "SystemFrustumCulling.h"
 #include <glm/gtx/norm.hpp>
+#include <algorithm>
+#include <bit>
+#include <cfloat>
+#include <cmath>
 namespace Engine {
-	std::map<float, std::pair<Mesh*, unsigned int>> SystemFrustumCulling::culledMeshList = std::map<float, std::pair<Mesh*, unsigned int>>();
+	DrawList SystemFrustumCulling::culledMeshList = DrawList();
+	std::vector<ShadowCasterList> SystemFrustumCulling::shadowCasterLists = std::vector<ShadowCasterList>();
+	unsigned int SystemFrustumCulling::numShadowCasterLists = 0;
 
-	void SystemFrustumCulling::Run(Camera* activeCamera, CollisionManager* collisionManager)
+	void SystemFrustumCulling::Run(Camera* activeCamera, CollisionManager* collisionManager, EntityManager* ecs, LightManager* lightManager)
 	{
 		SCOPE_TIMER("SystemFrustumCulling::Run");
 		this->activeCamera = activeCamera;
 		this->collisionManager = collisionManager;
+		this->ecs = ecs;
 		viewFrustum = activeCamera->GetViewFrustum();
 		totalMeshes = 0;
 		visibleMeshes = 0;
+		occludedMeshes = 0;
+		pvsCulledMeshes = 0;
+		reducedLODMeshes = 0;
 		geometryAABBTests = 0;
 
+		views.clear();
+		numShadowCasterLists = 0;
+		culledMeshList.Clear();
+		AddFrustumView(viewFrustum, activeCamera->GetPosition(), &culledMeshList);
+
+		const RenderOptions renderOptions = RenderManager::GetInstance()->GetRenderParams()->GetRenderOptions();
+		if (ecs && lightManager && (renderOptions & RENDER_SHADOWS) != 0) { AddShadowViews(*ecs, *lightManager); }
+
 		CullMeshes();
 		CullReflectionProbes();
 	}
 
-	FrustumIntersection SystemFrustumCulling::AABBIsOnOrInFrontOfPlane(const AABBPoints& aabb, const glm::vec3& boxWorldOrigin, const ViewPlane& plane)
+	const DrawList* SystemFrustumCulling::GetShadowCasters(const unsigned int lightEntityID)
+	{
+		for (unsigned int i = 0; i < numShadowCasterLists; i++) {
+			if (shadowCasterLists[i].lightEntityID == lightEntityID) { return &shadowCasterLists[i].casters; }
+		}
+		return nullptr;
+	}
+
+	DrawList* SystemFrustumCulling::NextShadowCasterList(const unsigned int lightEntityID)
+	{
+		// Views point into these lists so they must never reallocate mid frame
+		if (shadowCasterLists.capacity() < MAX_SHADOW_LIGHTS + 1) { shadowCasterLists.reserve(MAX_SHADOW_LIGHTS + 1); }
+		if (numShadowCasterLists == shadowCasterLists.size()) { shadowCasterLists.push_back(ShadowCasterList()); }
+
+		ShadowCasterList& list = shadowCasterLists[numShadowCasterLists++];
+		list.lightEntityID = lightEntityID;
+		list.casters.Clear();
+		return &list.casters;
+	}
+
+	void SystemFrustumCulling::AddFrustumView(const ViewFrustum& frustum, const glm::vec3& origin, DrawList* drawList)
 	{
-		// Convert min / max structuer to world space centre and centre to edge extents
-		const glm::vec3 worldMin = boxWorldOrigin + glm::vec3(aabb.minX, aabb.minY, aabb.minZ);
-		const glm::vec3 worldMax = boxWorldOrigin + glm::vec3(aabb.maxX, aabb.maxY, aabb.maxZ);
+		CullingView view;
+		view.type = CULLING_VIEW_FRUSTUM;
+		view.centre = glm::vec3(0.0f);
+		view.radius = 0.0f;
+		view.origin = origin;
+		view.drawList = drawList;
 
-		const glm::vec3 c = (worldMax + worldMin) * 0.5f; // world space centre
-		const glm::vec3 e = worldMax - c; // Positive extents x, y, z axis from centre
+		const ViewPlane* planes[NUM_FRUSTUM_PLANES] = { &frustum.left, &frustum.right, &frustum.far, &frustum.near, &frustum.top, &frustum.bottom };
+		for (unsigned int i = 0; i < MAX_LANE_WIDTH; i++) {
+			// Padding planes face nowhere and sit infinitely far behind every box
+			const glm::vec3 normal = (i < NUM_FRUSTUM_PLANES) ? planes[i]->normal : glm::vec3(0.0f);
+			view.planes.normalX[i] = normal.x;
+			view.planes.normalY[i] = normal.y;
+			view.planes.normalZ[i] = normal.z;
+			view.planes.absNormalX[i] = glm::abs(normal.x);
+			view.planes.absNormalY[i] = glm::abs(normal.y);
+			view.planes.absNormalZ[i] = glm::abs(normal.z);
+			view.planes.distance[i] = (i < NUM_FRUSTUM_PLANES) ? planes[i]->distance : -FLT_MAX;
+		}
+		views.push_back(view);
+	}
 
-		// Compute projection interval radius of aabb onto L(t)
-		const float r = e.x * glm::abs(plane.normal.x) + e.y * glm::abs(plane.normal.y) + e.z * glm::abs(plane.normal.z);
+	void SystemFrustumCulling::AddSphereView(const glm::vec3& centre, const float radius, DrawList* drawList)
+	{
+		CullingView view;
+		view.type = CULLING_VIEW_SPHERE;
+		view.planes = FrustumPlanes();
+		view.centre = centre;
+		view.radius = radius;
+		view.origin = centre;
+		view.drawList = drawList;
+		views.push_back(view);
+	}
+
+	void SystemFrustumCulling::AddShadowViews(EntityManager& ecs, LightManager& lightManager)
+	{
+		// Same lights and matrices the render pipeline draws shadow maps with
+		const std::vector<unsigned int>& dirLightEntities = lightManager.GetDirectionalLightEntities();
+		if (dirLightEntities.size() > 0) {
+			const ComponentLight* dirLight = ecs.GetComponent<ComponentLight>(dirLightEntities[0]);
+			if (dirLight && dirLight->CastShadows) {
+				const glm::vec3 lightPos = -dirLight->Direction * dirLight->DirectionalLightDistance;
+				AddFrustumView(ViewFrustum::FromViewProjection(LightManager::DirectionalLightSpaceMatrix(*dirLight)), lightPos, NextShadowCasterList(dirLightEntities[0]));
+			}
+		}
 
-		// Find distance of box centre from plane
-		const float distanceToPlane = glm::dot(plane.normal, c) - plane.distance;
+		RenderManager* renderManager = RenderManager::GetInstance();
+		const float aspect = (float)renderManager->ShadowWidth() / (float)renderManager->ShadowHeight();
+		const std::map<float, unsigned int>& lightEntities = lightManager.GetLightEntities();
+		std::map<float, unsigned int>::const_iterator lightEntitiesIt = lightEntities.begin();
+		for (unsigned int i = 0; i < lightEntities.size() && i < MAX_SHADOW_LIGHTS; i++, lightEntitiesIt++) {
+			const unsigned int entityID = lightEntitiesIt->second;
+			const ComponentTransform* transform = ecs.GetComponent<ComponentTransform>(entityID);
+			const ComponentLight* light = ecs.GetComponent<ComponentLight>(entityID);
+			if (!transform || !light || !light->CastShadows) { continue; }
 
-		if (-r > distanceToPlane) { return OUTSIDE_FRUSTUM; }
-		else if (r >= distanceToPlane) { return PARTIAL_FRUSTUM; }
-		else { return INSIDE_FRUSTUM; }
+			const glm::vec3 lightPos = transform->GetWorldPosition();
+			if (light->GetLightType() == SPOT) {
+				// Lighting runs after culling so the light's world direction could be a frame old, rotate it here instead
+				const glm::vec3 lightDirection = glm::normalize(glm::mat3(transform->GetWorldModelMatrix()) * light->Direction);
+				AddFrustumView(ViewFrustum::FromViewProjection(LightManager::SpotLightSpaceMatrix(*light, lightPos, lightDirection, aspect)), lightPos, NextShadowCasterList(entityID));
+			}
+			else if (light->GetLightType() == POINT) {
+				// Cube shadow maps see everything within the far plane in every direction
+				AddSphereView(lightPos, light->Far, NextShadowCasterList(entityID));
+			}
+		}
 	}
 
-	bool SystemFrustumCulling::TestAABBAndViewPlane(const AABBPoints& aabb, const glm::vec3& boxWorldOrigin, const ViewPlane& plane)
+	template <typename Lanes>
+	FrustumIntersection SystemFrustumCulling::TestNodeFrustum(const FrustumPlanes& planes, const BVHNode& node, unsigned int& inout_partialPlanes) const
 	{
-		// Convert min / max structuer to world space centre and centre to edge extents
-		const glm::vec3 worldMin = boxWorldOrigin + glm::vec3(aabb.minX, aabb.minY, aabb.minZ);
-		const glm::vec3 worldMax = boxWorldOrigin + glm::vec3(aabb.maxX, aabb.maxY, aabb.maxZ);
+		using Float = typename Lanes::Float;
+		const glm::vec3 centre = (node.boundsMin + node.boundsMax) * 0.5f;
+		const glm::vec3 extent = node.boundsMax - centre;
+		const Float cx = Lanes::Set(centre.x), cy = Lanes::Set(centre.y), cz = Lanes::Set(centre.z);
+		const Float ex = Lanes::Set(extent.x), ey = Lanes::Set(extent.y), ez = Lanes::Set(extent.z);
+		const Float zero = Lanes::Set(0.0f);
+
+		unsigned int outsidePlanes = 0;
+		unsigned int insidePlanes = 0;
+		for (unsigned int p = 0; p < NUM_FRUSTUM_PLANES; p += Lanes::width) {
+			// Distance of the box centre from each plane, against the projection radius of the box onto the plane normal
+			const Float distanceToPlane = Lanes::Sub(Lanes::Add(Lanes::Add(Lanes::Mul(Lanes::Load(&planes.normalX[p]), cx), Lanes::Mul(Lanes::Load(&planes.normalY[p]), cy)),
+				Lanes::Mul(Lanes::Load(&planes.normalZ[p]), cz)), Lanes::Load(&planes.distance[p]));
+			const Float r = Lanes::Add(Lanes::Add(Lanes::Mul(Lanes::Load(&planes.absNormalX[p]), ex), Lanes::Mul(Lanes::Load(&planes.absNormalY[p]), ey)),
+				Lanes::Mul(Lanes::Load(&planes.absNormalZ[p]), ez));
+
+			outsidePlanes |= Lanes::LessMask(distanceToPlane, Lanes::Sub(zero, r)) << p;
+			insidePlanes |= Lanes::LessMask(r, distanceToPlane) << p;
+
+			// Most nodes are rejected by the side planes, which come first
+			if (outsidePlanes & inout_partialPlanes) { return OUTSIDE_FRUSTUM; }
+		}
+
+		inout_partialPlanes &= ~insidePlanes;
+		return (inout_partialPlanes == 0) ? INSIDE_FRUSTUM : PARTIAL_FRUSTUM;
+	}
 
-		const glm::vec3 c = (worldMax + worldMin) * 0.5f; // world space centre
-		const glm::vec3 e = worldMax - c; // Positive extents x, y, z axis from centre
+	FrustumIntersection SystemFrustumCulling::TestNodeSphere(const CullingView& view, const BVHNode& node) const
+	{
+		// Outside if the nearest point of the box is beyond the radius, inside if the farthest corner is within it
+		const glm::vec3 nearest = glm::clamp(view.centre, node.boundsMin, node.boundsMax);
+		const float radius2 = view.radius * view.radius;
+		if (glm::distance2(nearest, view.centre) > radius2) { return OUTSIDE_FRUSTUM; }
 
-		// Compute projection interval radius of aabb onto L(t)
-		const float r = e.x * glm::abs(plane.normal.x) + e.y * glm::abs(plane.normal.y) + e.z * glm::abs(plane.normal.z);
+		const glm::vec3 farthest = glm::max(glm::abs(node.boundsMin - view.centre), glm::abs(node.boundsMax - view.centre));
+		return (glm::length2(farthest) <= radius2) ? INSIDE_FRUSTUM : PARTIAL_FRUSTUM;
+	}
 
-		// Find distance of box centre from plane
-		const float distanceToPlane = glm::dot(plane.normal, c) - plane.distance;
+	unsigned char SystemFrustumCulling::MovedPlanes(const CullingView& previous, const CullingView& current)
+	{
+		if (previous.type != current.type) { return ALL_FRUSTUM_PLANES; }
+		if (current.type == CULLING_VIEW_SPHERE) { return (previous.centre == current.centre && previous.radius == current.radius) ? 0 : ALL_FRUSTUM_PLANES; }
 
-		// If distance is within [-r, r] interval, collision is true
-		return glm::abs(distanceToPlane) <= r;
+		unsigned char movedPlanes = 0;
+		for (unsigned int p = 0; p < NUM_FRUSTUM_PLANES; p++) {
+			if (previous.planes.normalX[p] != current.planes.normalX[p] || previous.planes.normalY[p] != current.planes.normalY[p] ||
+				previous.planes.normalZ[p] != current.planes.normalZ[p] || previous.planes.distance[p] != current.planes.distance[p]) {
+				movedPlanes |= 1u << p;
+			}
+		}
+		return movedPlanes;
 	}
 
-	FrustumIntersection SystemFrustumCulling::AABBIsInFrustum(const AABBPoints& aabb, const glm::vec3& boxWorldOrigin)
+	template <typename Lanes>
+	unsigned int SystemFrustumCulling::FrustumOutsideLanes(const FrustumPlanes& planes, const unsigned int partialPlanes, const unsigned int slot) const
 	{
-		SCOPE_TIMER("SystemFrustumCulling::AABBIsInFrustum");
-		geometryAABBTests++;
-		bool fullyInside = true;
-		for (const ViewPlane& plane : { viewFrustum.left, viewFrustum.right, viewFrustum.far, viewFrustum.near, viewFrustum.top, viewFrustum.bottom }) {
-			const FrustumIntersection planeResult = AABBIsOnOrInFrontOfPlane(aabb, boxWorldOrigin, plane);
+		using Float = typename Lanes::Float;
+		const BVHObjectBounds& bounds = *bvhObjectBounds;
+		const Float zero = Lanes::Set(0.0f);
+		const Float cx = Lanes::Load(&bounds.centreX[slot]), cy = Lanes::Load(&bounds.centreY[slot]), cz = Lanes::Load(&bounds.centreZ[slot]);
+		const Float ex = Lanes::Load(&bounds.extentX[slot]), ey = Lanes::Load(&bounds.extentY[slot]), ez = Lanes::Load(&bounds.extentZ[slot]);
+
+		unsigned int outsideObjects = 0;
+		for (unsigned int p = 0; p < NUM_FRUSTUM_PLANES; p++) {
+			if (!(partialPlanes & (1u << p))) { continue; }
 
-			if (planeResult == OUTSIDE_FRUSTUM) { return planeResult; }
-			else if (planeResult == PARTIAL_FRUSTUM) { fullyInside = false; }
+			const Float distanceToPlane = Lanes::Sub(Lanes::Add(Lanes::Add(Lanes::Mul(Lanes::Set(planes.normalX[p]), cx), Lanes::Mul(Lanes::Set(planes.normalY[p]), cy)),
+				Lanes::Mul(Lanes::Set(planes.normalZ[p]), cz)), Lanes::Set(planes.distance[p]));
+			const Float r = Lanes::Add(Lanes::Add(Lanes::Mul(Lanes::Set(planes.absNormalX[p]), ex), Lanes::Mul(Lanes::Set(planes.absNormalY[p]), ey)),
+				Lanes::Mul(Lanes::Set(planes.absNormalZ[p]), ez));
+			outsideObjects |= Lanes::LessMask(distanceToPlane, Lanes::Sub(zero, r));
 		}
+		return outsideObjects;
+	}
+
+	template <typename Lanes>
+	unsigned int SystemFrustumCulling::SphereOutsideLanes(const CullingView& view, const unsigned int slot) const
+	{
+		using Float = typename Lanes::Float;
+		const BVHObjectBounds& bounds = *bvhObjectBounds;
+		const Float zero = Lanes::Set(0.0f);
+		const Float sx = Lanes::Set(view.centre.x), sy = Lanes::Set(view.centre.y), sz = Lanes::Set(view.centre.z);
+		const Float cx = Lanes::Load(&bounds.centreX[slot]), cy = Lanes::Load(&bounds.centreY[slot]), cz = Lanes::Load(&bounds.centreZ[slot]);
+
+		// Distance from the sphere centre to the nearest point of each box along each axis
+		const Float dx = Lanes::Max(Lanes::Sub(Lanes::Max(Lanes::Sub(sx, cx), Lanes::Sub(cx, sx)), Lanes::Load(&bounds.extentX[slot])), zero);
+		const Float dy = Lanes::Max(Lanes::Sub(Lanes::Max(Lanes::Sub(sy, cy), Lanes::Sub(cy, sy)), Lanes::Load(&bounds.extentY[slot])), zero);
+		const Float dz = Lanes::Max(Lanes::Sub(Lanes::Max(Lanes::Sub(sz, cz), Lanes::Sub(cz, sz)), Lanes::Load(&bounds.extentZ[slot])), zero);
+		const Float distance2 = Lanes::Add(Lanes::Add(Lanes::Mul(dx, dx), Lanes::Mul(dy, dy)), Lanes::Mul(dz, dz));
+		return Lanes::LessMask(Lanes::Set(view.radius * view.radius), distance2);
+	}
+
+	template <typename Lanes>
+	void SystemFrustumCulling::TestLeafObjects(const BVHNode& node, const unsigned int partialViews, const unsigned int insideViews, const unsigned char* partialPlanes)
+	{
+		const unsigned int end = node.first + node.count;
+		for (unsigned int i = node.first; i < end; i += Lanes::width) {
+			const unsigned int batchSize = std::min(Lanes::width, end - i);
+			unsigned int laneViews[MAX_LANE_WIDTH];
+			std::fill_n(laneViews, Lanes::width, insideViews);
+
+			for (unsigned int remainingViews = partialViews; remainingViews != 0; remainingViews &= remainingViews - 1) {
+				const unsigned int v = std::countr_zero(remainingViews);
+				const CullingView& view = views[v];
+				const unsigned int outsideObjects = (view.type == CULLING_VIEW_SPHERE) ? SphereOutsideLanes<Lanes>(view, i) : FrustumOutsideLanes<Lanes>(view.planes, partialPlanes[v], i);
+				geometryAABBTests += batchSize;
+
+				for (unsigned int lane = 0; lane < batchSize; lane++) {
+					if (!(outsideObjects & (1u << lane))) { laneViews[lane] |= 1u << v; }
+				}
+			}
 
-		return fullyInside ? INSIDE_FRUSTUM : PARTIAL_FRUSTUM;
+			for (unsigned int lane = 0; lane < batchSize; lane++) {
+				if (laneViews[lane] != 0) { MarkVisible((*bvhObjectIndices)[i + lane], laneViews[lane]); }
+			}
+		}
 	}
 
 	bool SystemFrustumCulling::SphereIsOnOrInFrontOfPlane(const glm::vec3& spherePos, const float sphereRadius, const ViewPlane& plane)
@@ -78,84 +254,396 @@ namespace Engine {
 		return distanceToPlane >= -sphereRadius;
 	}
 
-
 	void SystemFrustumCulling::CullMeshes()
 	{
 		SCOPE_TIMER("SystemFrustumCulling::CullMeshes");
-		culledMeshList.clear();
-		// Traverse BVH tree and check collisions with each node until a leaf node is found or no collision
+		// Traverse BVH tree once for all views, testing each node only against the views it is still partly inside of until a leaf node is found or no view remains
 		BVHTree* geometryBVH = collisionManager->GetBVHTree();
-		BVHNode* rootNode = geometryBVH->GetRootNode();
 		globalBVHObjectList = &geometryBVH->GetGlobalObjects();
+		bvhNodes = &geometryBVH->GetNodes();
+		bvhObjectIndices = &geometryBVH->GetObjectIndices();
+
+		bvhObjectBounds = &geometryBVH->GetLeafObjectBounds();
+
+		// Only the objects visible last frame need their masks cleared
+		if (objectViewMasks.size() != globalBVHObjectList->size()) { objectViewMasks.assign(globalBVHObjectList->size(), 0u); }
+		else {
+			for (const unsigned int objectIndex : visibleObjects) { objectViewMasks[objectIndex] = 0u; }
+		}
+		visibleObjects.clear();
+
+		frameIndex++;
+		if (geometryBVH->IsEmpty()) { visibilityCut.clear(); }
+		else {
+			const unsigned int numViews = views.size();
+			const unsigned int allViews = (numViews == MAX_CULLING_VIEWS) ? ~0u : (1u << numViews) - 1u;
+
+			if (nodeDescendedFrame.size() != bvhNodes->size() || cutStructureVersion != geometryBVH->GetStructureVersion()) {
+				nodeDescendedFrame.assign(bvhNodes->size(), 0u);
+				cutSlots.assign(bvhNodes->size(), 0u);
+				visibilityCut.clear();
+				cutStructureVersion = geometryBVH->GetStructureVersion();
+			}
 
-		TestBVHNodeRecursive(rootNode);
+			// Any plane that moved, or every plane once the tree's bounds change, has to be tested again as the cut's ancestors may have changed sides of it
+			unsigned char movedPlanes[MAX_CULLING_VIEWS];
+			const bool boundsChanged = (cutBoundsVersion != geometryBVH->GetBoundsVersion());
+			for (unsigned int v = 0; v < numViews; v++) {
+				movedPlanes[v] = (boundsChanged || v >= cutViews.size()) ? ALL_FRUSTUM_PLANES : MovedPlanes(cutViews[v], views[v]);
+			}
+
+			// Resume from last frame's cut, each node only tested against the planes it wasn't known to be inside of. Pushed in reverse so they come off in depth first order
+			traversalStack.clear();
+			if (visibilityCut.empty()) { traversalStack.push_back(NodeVisit(0, allViews, 0u)); }
+			for (std::vector<CutNode>::const_reverse_iterator it = visibilityCut.rbegin(); it != visibilityCut.rend(); it++) {
+				NodeVisit visit(it->nodeIndex, 0u, 0u);
+				for (unsigned int v = 0; v < numViews; v++) {
+					if (views[v].type == CULLING_VIEW_FRUSTUM) { visit.partialPlanes[v] = it->partialPlanes[v] | movedPlanes[v]; }
+
+					// Same view over the same bounds, a node that was fully inside or outside still is
+					if (it->terminal && movedPlanes[v] == 0) { visit.insideViews |= it->insideViews & (1u << v); }
+					else if (views[v].type == CULLING_VIEW_FRUSTUM && visit.partialPlanes[v] == 0) { visit.insideViews |= 1u << v; }
+					else { visit.partialViews |= 1u << v; }
+				}
+				traversalStack.push_back(visit);
+			}
+
+			nextCut.clear();
+			while (!traversalStack.empty()) {
+				NodeVisit visit = traversalStack.back();
+				traversalStack.pop_back();
+
+				const BVHNode& node = (*bvhNodes)[visit.nodeIndex];
+				unsigned int partialViews = visit.partialViews;
+				unsigned int insideViews = visit.insideViews;
+				for (unsigned int remainingViews = visit.partialViews; remainingViews != 0; remainingViews &= remainingViews - 1) {
+					const unsigned int v = std::countr_zero(remainingViews);
+					geometryAABBTests++;
+
+					FrustumIntersection nodeIsInView;
+					if (views[v].type == CULLING_VIEW_SPHERE) { nodeIsInView = TestNodeSphere(views[v], node); }
+					else {
+						unsigned int planes = visit.partialPlanes[v];
+						nodeIsInView = TestNodeFrustum<WideLanes>(views[v].planes, node, planes);
+						visit.partialPlanes[v] = (unsigned char)planes;
+					}
+
+					if (nodeIsInView == OUTSIDE_FRUSTUM) { partialViews &= ~(1u << v); }
+					else if (nodeIsInView == INSIDE_FRUSTUM) {
+						partialViews &= ~(1u << v);
+						insideViews |= 1u << v;
+					}
+				}
+
+				if (partialViews == 0) {
+					// Every view either fully contains this node or misses it entirely, all following children are the same
+					if (insideViews != 0) { MarkSubtreeVisible(visit.nodeIndex, insideViews); }
+					nextCut.push_back(CutNode(visit.nodeIndex, insideViews, true, visit.partialPlanes));
+				}
+				else if (node.IsLeaf()) {
+					// A leaf holding a single mesh has the mesh's own bounds which were just tested
+					if (node.count == 1) { MarkVisible((*bvhObjectIndices)[node.first], insideViews | partialViews); }
+					else { TestLeafObjects<WideLanes>(node, partialViews, insideViews, visit.partialPlanes); }
+					nextCut.push_back(CutNode(visit.nodeIndex, 0u, false, visit.partialPlanes));
+				}
+				else {
+					// Partially inside a view, check children. The left child is always the next node and is pushed last to be visited first
+					// Both children start from the planes this node still straddles
+					nodeDescendedFrame[visit.nodeIndex] = frameIndex;
+					const unsigned int nodeIndex = visit.nodeIndex;
+					visit.partialViews = partialViews;
+					visit.insideViews = insideViews;
+					visit.nodeIndex = node.first;
+					traversalStack.push_back(visit);
+					visit.nodeIndex = nodeIndex + 1;
+					traversalStack.push_back(visit);
+				}
+			}
 
-		visibleMeshes = culledMeshList.size();
+			CoarsenCut();
+			cutViews = views;
+			cutBoundsVersion = geometryBVH->GetBoundsVersion();
+		}
+
+		if (pvsCulling && !geometryBVH->IsEmpty()) { CullPotentiallyInvisibleMeshes(); }
+		if (occlusionCulling && ecs && !geometryBVH->IsEmpty()) { CullOccludedMeshes(); }
+
+		BuildDrawLists();
+		visibleMeshes = culledMeshList.Size();
 		totalMeshes = globalBVHObjectList->size();
 	}
 
-	void SystemFrustumCulling::AddMeshToCulledList(const BVHObject& bvhObject)
+	void SystemFrustumCulling::CoarsenCut()
+	{
+		SCOPE_TIMER("SystemFrustumCulling::CoarsenCut");
+		const std::vector<unsigned int>& nodeParents = collisionManager->GetBVHTree()->GetNodeParents();
+		for (unsigned int i = 0; i < nextCut.size(); i++) { cutSlots[nextCut[i].nodeIndex] = i + 1; }
+
+		// Merged nodes are appended and may merge again, so a uniform subtree collapses to its root in one pass
+		for (unsigned int i = 0; i < nextCut.size(); i++) {
+			const CutNode cutNode = nextCut[i];
+			if (!cutNode.terminal || cutSlots[cutNode.nodeIndex] != i + 1) { continue; }
+
+			const unsigned int parent = nodeParents[cutNode.nodeIndex];
+			if (parent == BVHTree::NO_PARENT) { continue; }
+
+			// Merging into a parent that straddled a view this frame or last would only split it again next frame
+			// Its children's plane masks say nothing about the parent, so once a view moves it is tested against every plane
+			if (nodeDescendedFrame[parent] + 1 >= frameIndex) { continue; }
+
+			const unsigned int sibling = (cutNode.nodeIndex == parent + 1) ? (*bvhNodes)[parent].first : parent + 1;
+			const unsigned int siblingSlot = cutSlots[sibling];
+			if (siblingSlot == 0) { continue; }
+			const CutNode& siblingCutNode = nextCut[siblingSlot - 1];
+			if (!siblingCutNode.terminal || siblingCutNode.insideViews != cutNode.insideViews) { continue; }
+
+			cutSlots[cutNode.nodeIndex] = 0;
+			cutSlots[sibling] = 0;
+			nextCut.push_back(CutNode(parent, cutNode.insideViews, true, nullptr));
+			cutSlots[parent] = nextCut.size();
+		}
+
+		// Keep what survived, in depth first order which for this node layout is just node order
+		visibilityCut.clear();
+		for (unsigned int i = 0; i < nextCut.size(); i++) {
+			if (cutSlots[nextCut[i].nodeIndex] == i + 1) { visibilityCut.push_back(nextCut[i]); }
+			cutSlots[nextCut[i].nodeIndex] = 0;
+		}
+		std::sort(visibilityCut.begin(), visibilityCut.end(), [](const CutNode& a, const CutNode& b) { return a.nodeIndex < b.nodeIndex; });
+	}
+
+	void SystemFrustumCulling::MarkVisible(const unsigned int objectIndex, const unsigned int viewMask)
+	{
+		if (objectViewMasks[objectIndex] == 0u) { visibleObjects.push_back(objectIndex); }
+		objectViewMasks[objectIndex] |= viewMask;
+	}
+
+	void SystemFrustumCulling::MarkSubtreeVisible(const unsigned int nodeIndex, const unsigned int viewMask)
+	{
+		// A subtree's objects are one contiguous range, from its leftmost leaf to its rightmost
+		unsigned int leftmost = nodeIndex;
+		while (!(*bvhNodes)[leftmost].IsLeaf()) { leftmost++; }
+		unsigned int rightmost = nodeIndex;
+		while (!(*bvhNodes)[rightmost].IsLeaf()) { rightmost = (*bvhNodes)[rightmost].first; }
+
+		const unsigned int end = (*bvhNodes)[rightmost].first + (*bvhNodes)[rightmost].count;
+		for (unsigned int i = (*bvhNodes)[leftmost].first; i < end; i++) {
+			MarkVisible((*bvhObjectIndices)[i], viewMask);
+		}
+	}
+
+	void SystemFrustumCulling::CullPotentiallyInvisibleMeshes()
 	{
-		SCOPE_TIMER("SystemFrustumCulling::AddMeshToCulledList");
-		const glm::vec3& meshOrigin = bvhObject.worldPosition;
+		SCOPE_TIMER("SystemFrustumCulling::CullPotentiallyInvisibleMeshes");
+		const PotentiallyVisibleSet& pvs = RenderManager::GetInstance()->GetBakedData().GetPotentiallyVisibleSet();
+		const int cell = pvs.CellAt(activeCamera->GetPosition());
+		if (cell < 0) { return; }
 
-		// Get distance to mesh
-		float distanceToCameraSquared = glm::distance2(activeCamera->GetPosition(), meshOrigin);
-		int iterations = 0;
-		while (culledMeshList.find(distanceToCameraSquared) != culledMeshList.end()) {
-			// Distance already exists, increment slightly
-			distanceToCameraSquared += 0.01f;
-			iterations++;
-			if (iterations > 100) {
-				std::cout << "ahhhhhh" << std::endl;
+		// Match objects up with the set again whenever either side changes
+		const unsigned int structureVersion = collisionManager->GetBVHTree()->GetStructureVersion();
+		if (objectPVSVersion != pvs.GetVersion() || objectPVSStructureVersion != structureVersion || objectPVSIndices.size() != globalBVHObjectList->size()) {
+			objectPVSIndices.resize(globalBVHObjectList->size());
+			for (unsigned int i = 0; i < globalBVHObjectList->size(); i++) {
+				const BVHObject& bvhObject = (*globalBVHObjectList)[i];
+				objectPVSIndices[i] = pvs.FindObject({ bvhObject.entityID, bvhObject.mesh->GetLocalMeshID() });
 			}
+			objectPVSVersion = pvs.GetVersion();
+			objectPVSStructureVersion = structureVersion;
+			decodedPVSCell = -1;
+		}
+
+		// The camera's cell is only decoded again once it moves to another
+		if (cell != decodedPVSCell) {
+			pvs.DecodeCell(cell, pvsCellVisibility);
+			decodedPVSCell = cell;
+		}
+
+		const unsigned int cameraBit = 1u << CAMERA_VIEW;
+		for (const unsigned int objectIndex : visibleObjects) {
+			const int pvsIndex = objectPVSIndices[objectIndex];
+			if (pvsIndex < 0 || !(objectViewMasks[objectIndex] & cameraBit) || pvsCellVisibility[pvsIndex]) { continue; }
+
+			// The object stays in visibleObjects so its mask is still reset next frame
+			objectViewMasks[objectIndex] &= ~cameraBit;
+			pvsCulledMeshes++;
 		}
-		culledMeshList[distanceToCameraSquared] = std::make_pair(bvhObject.mesh, bvhObject.entityID);
 	}
 
-	void SystemFrustumCulling::TestBVHNodeRecursive(const BVHNode* node)
+	void SystemFrustumCulling::RasterizeOccluders()
 	{
-		SCOPE_TIMER("SystemFrustumCulling::TestBVHNodeRecursive");
-		const AABBPoints& nodeAABB = node->GetBoundingBox();
+		SCOPE_TIMER("SystemFrustumCulling::RasterizeOccluders");
+		occlusionBuffer.Clear(activeCamera->GetProjection() * activeCamera->GetViewMatrix());
+		occluderObjects.clear();
 
-		const FrustumIntersection nodeIsInFrustum = AABBIsInFrustum(nodeAABB, glm::vec3(0.0f));
-		
-		if (nodeIsInFrustum != OUTSIDE_FRUSTUM) {
-			// Full intersection, all following children will also be inside frustum
-			if (nodeIsInFrustum == INSIDE_FRUSTUM) {
-				// Add all node meshes to culled list
-				const std::vector<unsigned int>& indices = node->GetGlobalObjectIndices();
-				for (unsigned int i : indices) {
-					AddMeshToCulledList(globalBVHObjectList->at(i));
-				}
+		// Only meshes the camera can see can hide anything from it
+		occluderCandidates.clear();
+		const std::vector<unsigned int>& objectSlots = collisionManager->GetBVHTree()->GetObjectSlots();
+		const glm::vec3 cameraPosition = activeCamera->GetPosition();
+		// Texels of the occlusion buffer one unit of error covers at a distance of one
+		const float texelsPerError = occlusionBuffer.GetHeight() * 0.5f / std::tan(glm::radians(activeCamera->GetZoom()) * 0.5f);
+		for (const unsigned int objectIndex : visibleObjects) {
+			if (!(objectViewMasks[objectIndex] & (1u << CAMERA_VIEW))) { continue; }
+
+			const BVHObject& bvhObject = (*globalBVHObjectList)[objectIndex];
+			if (bvhObject.mesh->GetDrawPrimitive() != GL_TRIANGLES) { continue; }
+			ComponentGeometry* geometry = ecs->GetComponent<ComponentGeometry>(bvhObject.entityID);
+			if (!geometry) { continue; }
+
+			// Occluders draw the coarsest level whose error bound projects to under a texel at the near side of their bounds, so the silhouette grows by no more than the texel every test rectangle is padded by
+			// Depth can still come forward by the same distance, which only matters for meshes closer to the occluder's surface than that
+			const unsigned int slot = objectSlots[objectIndex];
+			const glm::vec3 centre = glm::vec3(bvhObjectBounds->centreX[slot], bvhObjectBounds->centreY[slot], bvhObjectBounds->centreZ[slot]);
+			const glm::vec3 extents = glm::vec3(bvhObjectBounds->extentX[slot], bvhObjectBounds->extentY[slot], bvhObjectBounds->extentZ[slot]);
+			const float radius = glm::length(extents);
+			const float distance = std::max(glm::distance(cameraPosition, centre) - radius, activeCamera->GetNearClip());
+			const MeshData& meshData = bvhObject.mesh->GetMeshData();
+			const unsigned int lod = SelectLOD(meshData, radius * texelsPerError / distance, 1.0f, meshData.GetNumLODs() - 1);
+
+			if (geometry->IsOccluder()) {
+				occluderCandidates.push_back({ FLT_MAX, objectIndex, lod });
+				continue;
 			}
-			else {
-				// Partially inside frustum, check children
-				if (node->IsLeaf()) {
-					// Test meshes
-					const std::vector<unsigned int>& indices = node->GetGlobalObjectIndices();
-					for (unsigned int i = 0; i < indices.size(); i++) {
-						const glm::vec3& origin = globalBVHObjectList->at(indices[i]).worldPosition;
-						const BVHObject& bvhObject = globalBVHObjectList->at(indices[i]);
-						const Mesh* mesh = bvhObject.mesh;
-						const AABBPoints& geometryAABB = mesh->GetGeometryAABB();
-
-						if (geometryAABB == nodeAABB || AABBIsInFrustum(geometryAABB, origin)) {
-							AddMeshToCulledList(bvhObject);
-						}
+
+			if (!autoSelectOccluders || meshData.GetLOD(lod).indexCount / 3 > MAX_AUTO_OCCLUDER_TRIANGLES) { continue; }
+			if (bvhObject.mesh->GetMaterial()->GetIsTransparent()) { continue; }
+
+			const float size2 = glm::length2(extents) / std::max(glm::distance2(cameraPosition, bvhObject.worldPosition), 0.0001f);
+			if (size2 >= MIN_AUTO_OCCLUDER_SIZE * MIN_AUTO_OCCLUDER_SIZE) { occluderCandidates.push_back({ size2, objectIndex, lod }); }
+		}
+
+		// Flagged occluders first, then the largest on screen until the budget runs out
+		std::sort(occluderCandidates.begin(), occluderCandidates.end(), [](const OccluderCandidate& a, const OccluderCandidate& b) { return a.size > b.size; });
+		for (const OccluderCandidate& candidate : occluderCandidates) {
+			if (candidate.size != FLT_MAX && occlusionBuffer.GetRasterizedTriangles() >= OCCLUDER_TRIANGLE_BUDGET) { break; }
+
+			const BVHObject& bvhObject = (*globalBVHObjectList)[candidate.objectIndex];
+			const MeshData& meshData = bvhObject.mesh->GetMeshData();
+			occlusionBuffer.RasterizeTriangles(ecs->GetComponent<ComponentTransform>(bvhObject.entityID)->GetWorldModelMatrix(), meshData.GetVertices(), meshData.GetLODIndices(candidate.lod), meshData.GetLOD(candidate.lod).indexCount);
+			occluderObjects.push_back(candidate.objectIndex);
+		}
+		std::sort(occluderObjects.begin(), occluderObjects.end());
+	}
+
+	void SystemFrustumCulling::CullOccludedMeshes()
+	{
+		SCOPE_TIMER("SystemFrustumCulling::CullOccludedMeshes");
+		RasterizeOccluders();
+		if (occlusionBuffer.GetRasterizedTriangles() == 0) { return; }
+		occlusionBuffer.BuildPyramid();
+
+		// Whole subtrees behind the occluders are hidden with one test. Terminal cut nodes the camera sees are fully inside it and the rest are leaves, so no frustum tests are needed
+		const unsigned int cameraBit = 1u << CAMERA_VIEW;
+		for (const CutNode& cutNode : visibilityCut) {
+			if (cutNode.terminal && !(cutNode.insideViews & cameraBit)) { continue; }
+
+			traversalStack.clear();
+			traversalStack.push_back(NodeVisit(cutNode.nodeIndex, 0u, cameraBit));
+			while (!traversalStack.empty()) {
+				const unsigned int nodeIndex = traversalStack.back().nodeIndex;
+				traversalStack.pop_back();
+
+				const BVHNode& node = (*bvhNodes)[nodeIndex];
+				if (occlusionBuffer.IsOccluded(node.boundsMin, node.boundsMax)) { HideSubtreeFromCamera(nodeIndex); }
+				else if (node.IsLeaf()) {
+					if (node.count == 1) { continue; }
+
+					const BVHObjectBounds& bounds = *bvhObjectBounds;
+					for (unsigned int i = node.first; i < node.first + node.count; i++) {
+						const glm::vec3 centre = glm::vec3(bounds.centreX[i], bounds.centreY[i], bounds.centreZ[i]);
+						const glm::vec3 extent = glm::vec3(bounds.extentX[i], bounds.extentY[i], bounds.extentZ[i]);
+						if (occlusionBuffer.IsOccluded(centre - extent, centre + extent)) { HideFromCamera((*bvhObjectIndices)[i]); }
 					}
 				}
 				else {
-					// Test children
-					const BVHNode* leftChild = node->GetLeftChild();
-					const BVHNode* rightChild = node->GetRightChild();
-					if (leftChild) { TestBVHNodeRecursive(leftChild); }
-					if (rightChild) { TestBVHNodeRecursive(rightChild); }
+					traversalStack.push_back(NodeVisit(node.first, 0u, cameraBit));
+					traversalStack.push_back(NodeVisit(nodeIndex + 1, 0u, cameraBit));
 				}
 			}
 		}
 	}
 
+	void SystemFrustumCulling::HideFromCamera(const unsigned int objectIndex)
+	{
+		const unsigned int cameraBit = 1u << CAMERA_VIEW;
+		if (!(objectViewMasks[objectIndex] & cameraBit)) { return; }
+		if (std::binary_search(occluderObjects.begin(), occluderObjects.end(), objectIndex)) { return; }
+
+		// The object stays in visibleObjects so its mask is still reset next frame
+		objectViewMasks[objectIndex] &= ~cameraBit;
+		occludedMeshes++;
+	}
+
+	void SystemFrustumCulling::HideSubtreeFromCamera(const unsigned int nodeIndex)
+	{
+		unsigned int leftmost = nodeIndex;
+		while (!(*bvhNodes)[leftmost].IsLeaf()) { leftmost++; }
+		unsigned int rightmost = nodeIndex;
+		while (!(*bvhNodes)[rightmost].IsLeaf()) { rightmost = (*bvhNodes)[rightmost].first; }
+
+		const unsigned int end = (*bvhNodes)[rightmost].first + (*bvhNodes)[rightmost].count;
+		for (unsigned int i = (*bvhNodes)[leftmost].first; i < end; i++) {
+			HideFromCamera((*bvhObjectIndices)[i]);
+		}
+	}
+
+	void SystemFrustumCulling::BuildDrawLists()
+	{
+		SCOPE_TIMER("SystemFrustumCulling::BuildDrawLists");
+		if (cameraLODs.size() != globalBVHObjectList->size()) {
+			cameraLODs.assign(globalBVHObjectList->size(), 0);
+			shadowLODs.assign(globalBVHObjectList->size(), 0);
+		}
+
+		// Pixels on screen one unit of error covers at a distance of one
+		const float pixelsPerError = activeCamera->GetScreenHeight() * 0.5f / std::tan(glm::radians(activeCamera->GetZoom()) * 0.5f);
+		const glm::vec3 cameraPosition = activeCamera->GetPosition();
+		const std::vector<unsigned int>& objectSlots = collisionManager->GetBVHTree()->GetObjectSlots();
+
+		for (const unsigned int objectIndex : visibleObjects) {
+			const BVHObject& bvhObject = (*globalBVHObjectList)[objectIndex];
+			const unsigned int viewMask = objectViewMasks[objectIndex];
+
+			unsigned int cameraLOD = 0;
+			unsigned int shadowLOD = 0;
+			const MeshData& meshData = bvhObject.mesh->GetMeshData();
+			if (lodSelection && meshData.GetNumLODs() > 1 && bvhObject.mesh->GetDrawPrimitive() == GL_TRIANGLES) {
+				// Level errors are relative to the mesh's bounding radius, the world bounds' radius scales them to world units
+				const unsigned int slot = objectSlots[objectIndex];
+				const glm::vec3 centre = glm::vec3(bvhObjectBounds->centreX[slot], bvhObjectBounds->centreY[slot], bvhObjectBounds->centreZ[slot]);
+				const float radius = glm::length(glm::vec3(bvhObjectBounds->extentX[slot], bvhObjectBounds->extentY[slot], bvhObjectBounds->extentZ[slot]));
+				const float distance = std::max(glm::distance(cameraPosition, centre) - radius, activeCamera->GetNearClip());
+				const float errorScale = radius * pixelsPerError / distance;
+
+				if (viewMask & (1u << CAMERA_VIEW)) {
+					cameraLOD = SelectLOD(meshData, errorScale, LOD_PIXEL_ERROR * cameraLODBias, cameraLODs[objectIndex]);
+					cameraLODs[objectIndex] = cameraLOD;
+					if (cameraLOD > 0) { reducedLODMeshes++; }
+				}
+				if (viewMask & ~(1u << CAMERA_VIEW)) {
+					shadowLOD = SelectLOD(meshData, errorScale, LOD_PIXEL_ERROR * shadowLODBias, shadowLODs[objectIndex]);
+					shadowLODs[objectIndex] = shadowLOD;
+				}
+			}
+
+			for (unsigned int remainingViews = viewMask; remainingViews != 0; remainingViews &= remainingViews - 1) {
+				const unsigned int viewIndex = std::countr_zero(remainingViews);
+				const CullingView& view = views[viewIndex];
+				view.drawList->Add(bvhObject.mesh, bvhObject.entityID, glm::distance2(view.origin, bvhObject.worldPosition), (viewIndex == CAMERA_VIEW) ? cameraLOD : shadowLOD);
+			}
+		}
+
+		for (CullingView& view : views) { view.drawList->Sort(); }
+	}
+
+	unsigned int SystemFrustumCulling::SelectLOD(const MeshData& meshData, const float errorScale, const float allowedError, const unsigned int previousLOD) const
+	{
+		const unsigned int numLODs = meshData.GetNumLODs();
+		unsigned int lod = std::min(previousLOD, numLODs - 1);
+		while (lod > 0 && meshData.GetLOD(lod).error * errorScale > allowedError) { lod--; }
+		while (lod + 1 < numLODs && meshData.GetLOD(lod + 1).error * errorScale <= allowedError * (1.0f - LOD_HYSTERESIS)) { lod++; }
+		return lod;
+	}
+
 	void SystemFrustumCulling::CullReflectionProbes()
 	{
 		SCOPE_TIMER("SystemFrustumCulling::CullReflectionProbes");
@@ -3,6 +3,10 @@
 #include "Camera.h"
 #include "RenderManager.h"
 #include "CollisionManager.h"
+#include "DrawList.h"
+#include "OcclusionBuffer.h"
+#include "LightManager.h"
+#include "EntityManager.h"
 #include <map>
 namespace Engine {
 	enum FrustumIntersection {
@@ -11,42 +15,238 @@ namespace Engine {
 		PARTIAL_FRUSTUM,
 	};
 
+	enum CullingViewType {
+		CULLING_VIEW_FRUSTUM,
+		CULLING_VIEW_SPHERE
+	};
+
+	// Shadow casters one shadow casting light can see this frame
+	struct ShadowCasterList {
+		unsigned int lightEntityID;
+		DrawList casters;
+	};
+
 	// This is a special case system which doesn't operate per entity/component set but on all meshes in the scene. Therefore, this system doesn't get registered to the system manager in the same way as other systems
+	// Culls the camera and every shadow casting light together in one traversal of the geometry BVH, each object ends up with a mask of the views that can see it
 	class SystemFrustumCulling
 	{
 	public:
-		SystemFrustumCulling() : activeCamera(nullptr), collisionManager(nullptr), visibleMeshes(0), totalMeshes(0), geometryAABBTests(0) {}
+		// One bit per view in each object's visibility mask. The camera is always view 0, followed by the directional light and then spot and point lights
+		static constexpr unsigned int MAX_CULLING_VIEWS = 32;
+		static constexpr unsigned int CAMERA_VIEW = 0;
+
+		SystemFrustumCulling() : activeCamera(nullptr), collisionManager(nullptr), ecs(nullptr), occlusionCulling(false), autoSelectOccluders(true), lodSelection(true), cameraLODBias(1.0f), shadowLODBias(2.0f), pvsCulling(true), objectPVSVersion(0), objectPVSStructureVersion(0), decodedPVSCell(-1), globalBVHObjectList(nullptr), bvhNodes(nullptr), bvhObjectIndices(nullptr), bvhObjectBounds(nullptr), cutStructureVersion(0), cutBoundsVersion(0), frameIndex(0), visibleMeshes(0), occludedMeshes(0), pvsCulledMeshes(0), reducedLODMeshes(0), totalMeshes(0), geometryAABBTests(0) {}
 		~SystemFrustumCulling() {}
 
-		void Run(Camera* activeCamera, CollisionManager* collisionManager);
+		// Shadow views are only culled for lights that cast shadows while shadows are enabled, ecs and lightManager can be null to cull the camera alone without occlusion
+		void Run(Camera* activeCamera, CollisionManager* collisionManager, EntityManager* ecs = nullptr, LightManager* lightManager = nullptr);
 
 		const unsigned int GetVisibleMeshes() const { return visibleMeshes; }
+		const unsigned int GetOccludedMeshes() const { return occludedMeshes; }
 		const unsigned int GetTotalMeshes() const { return totalMeshes; }
 		const unsigned int GetTotalAABBTests() const { return geometryAABBTests; }
+		unsigned int GetNumViews() const { return views.size(); }
+
+		// Visibility mask of every object in the geometry BVH's global object list, bit i is set if view i can see it
+		const std::vector<unsigned int>& GetObjectViewMasks() const { return objectViewMasks; }
+
+		// Occlusion culling removes camera visible meshes hidden behind occluders drawn into a CPU depth buffer, shadow views are unaffected
+		// Meshes flagged with ComponentGeometry::SetIsOccluder are always drawn, large nearby opaque meshes with few enough triangles are picked automatically unless turned off
+		void SetOcclusionCulling(const bool enabled) { occlusionCulling = enabled; }
+		const bool GetOcclusionCulling() const { return occlusionCulling; }
+		void SetAutoSelectOccluders(const bool autoSelect) { autoSelectOccluders = autoSelect; }
+		const bool GetAutoSelectOccluders() const { return autoSelectOccluders; }
+		const OcclusionBuffer& GetOcclusionBuffer() const { return occlusionBuffer; }
+
+		// Each mesh draws the coarsest level of detail whose error projects to no more than LOD_PIXEL_ERROR pixels from the camera, scaled by the view's bias
+		// Shadow views measure from the camera too, what matters is how much of a caster's shadow the camera can see. Higher biases drop to coarser levels sooner
+		void SetLODSelection(const bool enabled) { lodSelection = enabled; }
+		const bool GetLODSelection() const { return lodSelection; }
+		void SetCameraLODBias(const float bias) { cameraLODBias = bias; }
+		const float GetCameraLODBias() const { return cameraLODBias; }
+		void SetShadowLODBias(const float bias) { shadowLODBias = bias; }
+		const float GetShadowLODBias() const { return shadowLODBias; }
+		const unsigned int GetReducedLODMeshes() const { return reducedLODMeshes; }
+
+		// Hides static meshes the baked potentially visible set says can't be seen from the camera's cell, see SystemPVSBaking. Does nothing outside the baked cells
+		// Shadow views are unaffected, a caster out of sight can still throw a shadow into view
+		void SetPVSCulling(const bool enabled) { pvsCulling = enabled; }
+		const bool GetPVSCulling() const { return pvsCulling; }
+		const unsigned int GetPVSCulledMeshes() const { return pvsCulledMeshes; }
 
 		//void SetActiveCamera(Camera* newCamera) { this->activeCamera = newCamera; }
 
-		static std::map<float, std::pair<Mesh*, unsigned int>> culledMeshList;
+		// Meshes that passed culling this frame, sorted near to far
+		static DrawList culledMeshList;
+
+		// Casters a light's shadow map can see, sorted near to far from the light. Null if the light wasn't culled this frame
+		static const DrawList* GetShadowCasters(const unsigned int lightEntityID);
 	private:
-		FrustumIntersection AABBIsOnOrInFrontOfPlane(const AABBPoints& aabb, const glm::vec3& boxWorldOrigin, const ViewPlane& plane);
-		bool TestAABBAndViewPlane(const AABBPoints& aabb, const glm::vec3& boxWorldOrigin, const ViewPlane& plane);
-		FrustumIntersection AABBIsInFrustum(const AABBPoints& aabb, const glm::vec3& boxWorldOrigin);
+		static constexpr unsigned int NUM_FRUSTUM_PLANES = 6;
+		static constexpr unsigned int ALL_FRUSTUM_PLANES = (1u << NUM_FRUSTUM_PLANES) - 1u;
+
+		// Automatic occluders must cover at least this much of the view (bounding radius over distance) and have no more triangles than the limit in the level they are drawn at
+		static constexpr float MIN_AUTO_OCCLUDER_SIZE = 0.2f;
+		static constexpr unsigned int MAX_AUTO_OCCLUDER_TRIANGLES = 2048;
+		// Automatic occluders stop being added once this many triangles have been drawn
+		static constexpr unsigned int OCCLUDER_TRIANGLE_BUDGET = 16384;
+
+		static constexpr float LOD_PIXEL_ERROR = 1.0f;
+		// A mesh only drops to a coarser level once that level's error is this much under the limit, so meshes near the limit don't switch every frame
+		static constexpr float LOD_HYSTERESIS = 0.25f;
+
+		// Matches the number of spot and point lights the render pipeline draws shadow maps for
+		static constexpr unsigned int MAX_SHADOW_LIGHTS = 8;
+
+		// View planes in structure of arrays form, padded with planes every box is inside of
+		struct FrustumPlanes {
+			float normalX[MAX_LANE_WIDTH];
+			float normalY[MAX_LANE_WIDTH];
+			float normalZ[MAX_LANE_WIDTH];
+			float absNormalX[MAX_LANE_WIDTH];
+			float absNormalY[MAX_LANE_WIDTH];
+			float absNormalZ[MAX_LANE_WIDTH];
+			float distance[MAX_LANE_WIDTH];
+		};
+
+		struct CullingView {
+			CullingViewType type;
+			FrustumPlanes planes; // frustum views
+			glm::vec3 centre; // sphere views
+			float radius;
+			glm::vec3 origin; // the view's draw list is sorted by distance from here
+			DrawList* drawList;
+		};
+
+		// Node waiting on the traversal stack, with the views that only partly contain its parent and the views that fully contain it
+		// Children are inside every view their parent is inside of, so only the partial views are tested again, and only against the planes their parent straddled
+		struct NodeVisit {
+			NodeVisit(const unsigned int nodeIndex, const unsigned int partialViews, const unsigned int insideViews) : nodeIndex(nodeIndex), partialViews(partialViews), insideViews(insideViews) {
+				std::fill_n(partialPlanes, MAX_CULLING_VIEWS, (unsigned char)ALL_FRUSTUM_PLANES);
+			}
+
+			unsigned int nodeIndex;
+			unsigned int partialViews;
+			unsigned int insideViews;
+			unsigned char partialPlanes[MAX_CULLING_VIEWS]; // per frustum view
+		};
+
+		void AddFrustumView(const ViewFrustum& frustum, const glm::vec3& origin, DrawList* drawList);
+		void AddSphereView(const glm::vec3& centre, const float radius, DrawList* drawList);
+		void AddShadowViews(EntityManager& ecs, LightManager& lightManager);
+		DrawList* NextShadowCasterList(const unsigned int lightEntityID);
 		bool SphereIsOnOrInFrontOfPlane(const glm::vec3& spherePos, const float sphereRadius, const ViewPlane& plane);
 
+		// Tests one node against every plane at once, the planes across the lanes. Clears the planes the node is fully inside of from inout_partialPlanes
+		template <typename Lanes>
+		FrustumIntersection TestNodeFrustum(const FrustumPlanes& planes, const BVHNode& node, unsigned int& inout_partialPlanes) const;
+		FrustumIntersection TestNodeSphere(const CullingView& view, const BVHNode& node) const;
+		// Planes of a frustum view that aren't exactly where they were in another. Every plane if the view changed type, or for a sphere view if it moved at all
+		static unsigned char MovedPlanes(const CullingView& previous, const CullingView& current);
+
+		// Returns a bit per lane for the objects at slot onwards that are outside the view, the objects across the lanes
+		template <typename Lanes>
+		unsigned int FrustumOutsideLanes(const FrustumPlanes& planes, const unsigned int partialPlanes, const unsigned int slot) const;
+		template <typename Lanes>
+		unsigned int SphereOutsideLanes(const CullingView& view, const unsigned int slot) const;
+
+		// Tests a leaf's objects against the views that only partly contain it and marks each with every view that can see it
+		template <typename Lanes>
+		void TestLeafObjects(const BVHNode& node, const unsigned int partialViews, const unsigned int insideViews, const unsigned char* partialPlanes);
+
+		// A node the traversal stopped at. Together the nodes of a cut cover every object in the tree exactly once
+		// Terminal nodes were either fully inside or fully outside every view, their views are kept so neighbours that ended the same way can be merged
+		// partialPlanes holds, per frustum view, the planes the node wasn't known to be inside of. Null when nothing is known, as for merged nodes
+		struct CutNode {
+			CutNode(const unsigned int nodeIndex, const unsigned int insideViews, const bool terminal, const unsigned char* partialPlanes) : nodeIndex(nodeIndex), insideViews(insideViews), terminal(terminal) {
+				if (partialPlanes) { std::copy_n(partialPlanes, MAX_CULLING_VIEWS, this->partialPlanes); }
+				else { std::fill_n(this->partialPlanes, MAX_CULLING_VIEWS, (unsigned char)ALL_FRUSTUM_PLANES); }
+			}
+
+			unsigned int nodeIndex;
+			unsigned int insideViews;
+			bool terminal;
+			unsigned char partialPlanes[MAX_CULLING_VIEWS];
+		};
+
+		struct OccluderCandidate {
+			float size;
+			unsigned int objectIndex;
+			unsigned int lod;
+		};
+
 		void CullMeshes();
-		void AddMeshToCulledList(const BVHObject& bvhObject);
-		void TestBVHNodeRecursive(const BVHNode* node);
+		// Merges sibling cut nodes that ended the same way into their parent, unless the parent was recently found to straddle a view
+		void CoarsenCut();
+		void CullPotentiallyInvisibleMeshes();
+		void RasterizeOccluders();
+		// Walks down from this frame's cut rather than the root, nodes outside the camera were already left out of it
+		void CullOccludedMeshes();
+		void HideFromCamera(const unsigned int objectIndex);
+		void HideSubtreeFromCamera(const unsigned int nodeIndex);
+		void MarkVisible(const unsigned int objectIndex, const unsigned int viewMask);
+		void MarkSubtreeVisible(const unsigned int nodeIndex, const unsigned int viewMask);
+		void BuildDrawLists();
+		// Coarsest level within the allowed error, starting from the level drawn last frame
+		unsigned int SelectLOD(const MeshData& meshData, const float errorScale, const float allowedError, const unsigned int previousLOD) const;
 		void CullReflectionProbes();
 
 		Camera* activeCamera;
 		ViewFrustum viewFrustum;
+		std::vector<CullingView> views;
 		
 		CollisionManager* collisionManager;
+		EntityManager* ecs;
+
+		bool occlusionCulling;
+		bool autoSelectOccluders;
+		OcclusionBuffer occlusionBuffer;
+		std::vector<OccluderCandidate> occluderCandidates;
+		std::vector<unsigned int> occluderObjects; // sorted, occluders are never tested against themselves
+
+		bool lodSelection;
+		float cameraLODBias;
+		float shadowLODBias;
+		// Level each object was drawn at last frame by the camera and by shadow views, indexed like the global object list
+		std::vector<unsigned char> cameraLODs;
+		std::vector<unsigned char> shadowLODs;
+
+		bool pvsCulling;
+		std::vector<int> objectPVSIndices; // each global object's index in the potentially visible set, -1 if it isn't in it
+		unsigned int objectPVSVersion;
+		unsigned int objectPVSStructureVersion;
+		int decodedPVSCell;
+		std::vector<unsigned char> pvsCellVisibility;
 
 		std::map<float, ReflectionProbe*> culledProbeList;
 		const std::vector<BVHObject>* globalBVHObjectList;
+		const std::vector<BVHNode>* bvhNodes;
+		const std::vector<unsigned int>* bvhObjectIndices;
+		const BVHObjectBounds* bvhObjectBounds;
+		std::vector<NodeVisit> traversalStack;
+
+		// Last frame's cut through the tree. Traversal restarts from these nodes instead of the root while the tree keeps its structure
+		std::vector<CutNode> visibilityCut;
+		std::vector<CutNode> nextCut;
+		unsigned int cutStructureVersion;
+		// Views and tree bounds the cut's plane masks were found with, masks only carry over for planes and bounds that haven't moved since
+		std::vector<CullingView> cutViews;
+		unsigned int cutBoundsVersion;
+		unsigned int frameIndex;
+		std::vector<unsigned int> nodeDescendedFrame; // frame each node was last found partly inside a view and its children visited
+		std::vector<unsigned int> cutSlots; // position + 1 of a node in nextCut while coarsening, 0 if it isn't in the cut
+
+		std::vector<unsigned int> objectViewMasks;
+		std::vector<unsigned int> visibleObjects; // every object with a non zero mask, in the order they were found
+
+		// Lists are kept between frames to avoid reallocating, only the first numShadowCasterLists are in use
+		static std::vector<ShadowCasterList> shadowCasterLists;
+		static unsigned int numShadowCasterLists;
 
 		unsigned int visibleMeshes;
+		unsigned int occludedMeshes;
+		unsigned int pvsCulledMeshes;
+		unsigned int reducedLODMeshes;
 		unsigned int totalMeshes;
 		unsigned int geometryAABBTests;
 	};
@@ -3,12 +3,14 @@
 #include <vector>
 #include <functional>
 #include "ScopeTimer.h"
+#include "FixedTimestep.h"
 #include <string>
 namespace Engine {
 	class SystemManager
 	{
 	public:
-		SystemManager(EntityManager* ecs) : ecs(ecs) {}
+		// deltaTime is the frame time systems read, it is temporarily replaced with the step size while fixed rate systems run
+		SystemManager(EntityManager* ecs, float* deltaTime) : ecs(ecs), deltaTime(deltaTime), fixedStep(120.0f, 8) {}
 		~SystemManager() {}
 
 		template <typename... Components>
@@ -27,14 +29,25 @@ namespace Engine {
 			return true;
 		}
 
-		void ActionSystems() const {
+		// Systems that do their own iteration rather than running once per entity in a view, such as the collision pipeline
+		bool RegisterSystem(const std::string& systemName, std::function<void()> runFunc) {
+			if (systems.find(systemName) != systems.end()) {
+				return false;
+			}
+
+			systems[systemName][0] = []() {};
+			systems[systemName][1] = runFunc;
+			systems[systemName][2] = []() {};
+			systemNames.push_back(systemName);
+			return true;
+		}
+
+		void ActionSystems() {
 			SCOPE_TIMER("SystemManager::ActionSystems()");
 			for (const std::string& name : systemNames) {
 				const std::string scopeName = "SystemManager::ActionSystems::" + name + "::Run()";
 				SCOPE_TIMER(scopeName.c_str());
-				systems.at(name)[0]();
-				systems.at(name)[1]();
-				systems.at(name)[2]();
+				RunAtStepRate(name, systems.at(name));
 			}
 		}
 
@@ -54,19 +67,124 @@ namespace Engine {
 			return true;
 		}
 
-		void ActionPreUpdateSystems() const {
+		bool RegisterPreUpdateSystem(const std::string& systemName, std::function<void()> runFunc) {
+			if (preUpdateSystems.find(systemName) != preUpdateSystems.end()) {
+				return false;
+			}
+
+			preUpdateSystems[systemName][0] = []() {};
+			preUpdateSystems[systemName][1] = runFunc;
+			preUpdateSystems[systemName][2] = []() {};
+			preUpdateSystemNames.push_back(systemName);
+			return true;
+		}
+
+		void ActionPreUpdateSystems() {
 			SCOPE_TIMER("SystemManager::ActionPreUpdateSystems()");
 			for (const std::string& name : preUpdateSystemNames) {
 				const std::string scopeName = "SystemManager::ActionPreUpdateSystems::" + name + "::Run()";
 				SCOPE_TIMER(scopeName.c_str());
-				preUpdateSystems.at(name)[0]();
-				preUpdateSystems.at(name)[1]();
-				preUpdateSystems.at(name)[2]();
+				RunAtStepRate(name, preUpdateSystems.at(name));
 			}
 		}
 
+		// Fixed step systems run together, in registration order, as many times per frame as the fixed step asks for
+		// Used for simulation (collision detection, resolution and integration) so results don't depend on frame rate
+		template <typename... Components>
+		bool RegisterFixedStepSystem(const std::string& systemName, std::function<void(const unsigned int, Components&...)> onActionFunc, std::function<void()> preActionFunc = []() {}, std::function<void()> afterActionFunc = []() {}) {
+			if (fixedStepSystems.find(systemName) != fixedStepSystems.end()) {
+				return false;
+			}
+
+			fixedStepSystems[systemName][0] = preActionFunc;
+			fixedStepSystems[systemName][1] = [this, onActionFunc]() {
+				auto view = ecs->View<Components...>();
+				view.ForEach(onActionFunc);
+			};
+			fixedStepSystems[systemName][2] = afterActionFunc;
+			fixedStepSystemNames.push_back(systemName);
+			return true;
+		}
+
+		bool RegisterFixedStepSystem(const std::string& systemName, std::function<void()> runFunc) {
+			if (fixedStepSystems.find(systemName) != fixedStepSystems.end()) {
+				return false;
+			}
+
+			fixedStepSystems[systemName][0] = []() {};
+			fixedStepSystems[systemName][1] = runFunc;
+			fixedStepSystems[systemName][2] = []() {};
+			fixedStepSystemNames.push_back(systemName);
+			return true;
+		}
+
+		// Returns the number of steps that were run
+		unsigned int ActionFixedStepSystems() {
+			SCOPE_TIMER("SystemManager::ActionFixedStepSystems()");
+			const unsigned int steps = fixedStep.Advance(*deltaTime);
+			if (steps == 0 || fixedStepSystemNames.size() == 0) { return steps; }
+
+			const float frameDelta = *deltaTime;
+			*deltaTime = fixedStep.StepSize();
+			for (unsigned int i = 0; i < steps; i++) {
+				for (const std::string& name : fixedStepSystemNames) {
+					const std::string scopeName = "SystemManager::ActionFixedStepSystems::" + name + "::Run()";
+					SCOPE_TIMER(scopeName.c_str());
+					fixedStepSystems.at(name)[0]();
+					fixedStepSystems.at(name)[1]();
+					fixedStepSystems.at(name)[2]();
+				}
+			}
+			*deltaTime = frameDelta;
+			return steps;
+		}
+
+		FixedTimestep& GetFixedStep() { return fixedStep; }
+		const FixedTimestep& GetFixedStep() const { return fixedStep; }
+
+		// Run an update or pre update system at its own rate rather than once per frame, stepsPerSecond <= 0 goes back to once per frame
+		void SetSystemStepRate(const std::string& systemName, const float stepsPerSecond, const unsigned int maxSubsteps = 4) {
+			if (stepsPerSecond <= 0.0f) {
+				systemStepRates.erase(systemName);
+				return;
+			}
+			systemStepRates[systemName] = FixedTimestep(stepsPerSecond, maxSubsteps);
+		}
+
+		float SystemStepRate(const std::string& systemName) const {
+			std::unordered_map<std::string, FixedTimestep>::const_iterator it = systemStepRates.find(systemName);
+			return (it != systemStepRates.end()) ? it->second.StepsPerSecond() : 0.0f;
+		}
+
 	private:
+		void RunAtStepRate(const std::string& name, const std::function<void()>(&system)[3]) {
+			std::unordered_map<std::string, FixedTimestep>::iterator rate = systemStepRates.find(name);
+			if (rate == systemStepRates.end()) {
+				system[0]();
+				system[1]();
+				system[2]();
+				return;
+			}
+
+			const unsigned int steps = rate->second.Advance(*deltaTime);
+			const float frameDelta = *deltaTime;
+			*deltaTime = rate->second.StepSize();
+			for (unsigned int i = 0; i < steps; i++) {
+				system[0]();
+				system[1]();
+				system[2]();
+			}
+			*deltaTime = frameDelta;
+		}
+
 		EntityManager* ecs;
+		float* deltaTime;
+
+		FixedTimestep fixedStep;
+		std::vector<std::string> fixedStepSystemNames;
+		std::unordered_map<std::string, std::function<void()>[3]> fixedStepSystems;
+
+		std::unordered_map<std::string, FixedTimestep> systemStepRates;
 
 		std::vector<std::string> preUpdateSystemNames;
 		std::unordered_map<std::string, std::function<void()>[3]> preUpdateSystems;
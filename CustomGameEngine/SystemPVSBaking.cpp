@@ -0,0 +1,191 @@
+#include "SystemPVSBaking.h"
+#include "RenderManager.h"
+#include "ThreadPool.h"
+#include "Camera.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cfloat>
+#include <random>
+namespace Engine {
+	void SystemPVSBaking::Run(EntityManager* ecs, const std::string& sceneName, const glm::vec3& boundsMin, const glm::vec3& boundsMax, const float cellSize)
+	{
+		SCOPE_TIMER("SystemPVSBaking::Run");
+		GatherStaticObjects(*ecs);
+		Bake(sceneName, boundsMin, boundsMax, cellSize);
+	}
+
+	void SystemPVSBaking::Run(EntityManager* ecs, const std::string& sceneName, const float cellSize)
+	{
+		SCOPE_TIMER("SystemPVSBaking::Run");
+		GatherStaticObjects(*ecs);
+
+		glm::vec3 boundsMin = glm::vec3(0.0f);
+		glm::vec3 boundsMax = glm::vec3(0.0f);
+		if (!staticObjects.empty()) {
+			boundsMin = staticObjects[0].boundsMin;
+			boundsMax = staticObjects[0].boundsMax;
+			for (const StaticObject& object : staticObjects) {
+				boundsMin = glm::min(boundsMin, object.boundsMin);
+				boundsMax = glm::max(boundsMax, object.boundsMax);
+			}
+		}
+		Bake(sceneName, boundsMin, boundsMax, cellSize);
+	}
+
+	void SystemPVSBaking::Bake(const std::string& sceneName, const glm::vec3& boundsMin, const glm::vec3& boundsMax, const float cellSize)
+	{
+		std::cout << "SYSTEMPVSBAKING::Baking potentially visible set" << std::endl;
+		std::vector<PVSObjectKey> keys;
+		keys.reserve(staticObjects.size());
+		for (const StaticObject& object : staticObjects) { keys.push_back(object.key); }
+
+		const glm::uvec3 dimensions = glm::max(glm::uvec3(glm::ceil((boundsMax - boundsMin) / cellSize)), glm::uvec3(1u));
+		BakedData& bakedData = RenderManager::GetInstance()->GetBakedData();
+		PotentiallyVisibleSet& pvs = bakedData.GetPotentiallyVisibleSet();
+		pvs.Initialise(boundsMin, glm::vec3(cellSize), dimensions, keys);
+
+		// Far enough to see every static mesh from anywhere in the bounds
+		glm::vec3 sceneMin = boundsMin;
+		glm::vec3 sceneMax = boundsMin + glm::vec3(dimensions) * cellSize;
+		for (const StaticObject& object : staticObjects) {
+			sceneMin = glm::min(sceneMin, object.boundsMin);
+			sceneMax = glm::max(sceneMax, object.boundsMax);
+		}
+		farClip = glm::length(sceneMax - sceneMin) * 1.1f + NEAR_CLIP;
+
+		const unsigned int numCells = pvs.NumCells();
+		std::cout << "        - " << staticObjects.size() << " static meshes, " << numCells << " cells" << std::endl;
+
+		// Each chunk has its own buffer, cells only read the shared object list
+		std::vector<std::vector<unsigned char>> cellVisibility(numCells);
+		ThreadPool::GetInstance()->ParallelFor(numCells, 1, [this, &pvs, &cellVisibility](const unsigned int chunkIndex, const unsigned int begin, const unsigned int end) {
+			OcclusionBuffer buffer(FACE_RESOLUTION, FACE_RESOLUTION);
+			std::vector<unsigned int> faceObjects;
+			for (unsigned int cell = begin; cell < end; cell++) {
+				BakeCell(pvs, cell, buffer, faceObjects, cellVisibility[cell]);
+			}
+		});
+
+		unsigned int totalVisible = 0;
+		for (unsigned int cell = 0; cell < numCells; cell++) {
+			pvs.AddCell(cellVisibility[cell]);
+			totalVisible += std::count(cellVisibility[cell].begin(), cellVisibility[cell].end(), 1);
+		}
+
+		if (numCells > 0 && !staticObjects.empty()) {
+			std::cout << "        - " << (100.0f * totalVisible) / ((float)numCells * staticObjects.size()) << "% visible on average, " << pvs.GetEncodedSize() << " bytes of runs" << std::endl;
+		}
+		bakedData.WritePVSToFile(sceneName);
+		staticObjects.clear();
+	}
+
+	void SystemPVSBaking::GatherStaticObjects(EntityManager& ecs)
+	{
+		staticObjects.clear();
+		View<ComponentTransform, ComponentGeometry> geometryView = ecs.View<ComponentTransform, ComponentGeometry>();
+		geometryView.ForEach(std::function<void(const unsigned int, ComponentTransform&, ComponentGeometry&)>([this](const unsigned int entityID, ComponentTransform& transform, ComponentGeometry& geometry) {
+			if (!geometry.IsStatic()) { return; }
+
+			const glm::mat4& model = transform.GetWorldModelMatrix();
+			for (Mesh* mesh : geometry.GetModel()->meshes) {
+				// World bounds of the mesh's local bounds
+				const AABBPoints& localBounds = mesh->GetGeometryAABB();
+				glm::vec3 worldMin = glm::vec3(FLT_MAX);
+				glm::vec3 worldMax = glm::vec3(-FLT_MAX);
+				for (unsigned int corner = 0; corner < 8; corner++) {
+					const glm::vec3 local = glm::vec3((corner & 1) ? localBounds.startMaxX : localBounds.startMinX, (corner & 2) ? localBounds.startMaxY : localBounds.startMinY, (corner & 4) ? localBounds.startMaxZ : localBounds.startMinZ);
+					const glm::vec3 world = glm::vec3(model * glm::vec4(local, 1.0f));
+					worldMin = glm::min(worldMin, world);
+					worldMax = glm::max(worldMax, world);
+				}
+
+				const bool occluder = mesh->GetDrawPrimitive() == GL_TRIANGLES && !mesh->GetMaterial()->GetIsTransparent();
+				staticObjects.push_back({ { entityID, mesh->GetLocalMeshID() }, model, &mesh->GetMeshData(), worldMin, worldMax, occluder });
+			}
+		}));
+
+		std::sort(staticObjects.begin(), staticObjects.end(), [](const StaticObject& a, const StaticObject& b) { return a.key < b.key; });
+	}
+
+	void SystemPVSBaking::BakeCell(const PotentiallyVisibleSet& pvs, const unsigned int cell, OcclusionBuffer& buffer, std::vector<unsigned int>& faceObjects, std::vector<unsigned char>& out_visibleObjects) const
+	{
+		SCOPE_TIMER("SystemPVSBaking::BakeCell");
+		out_visibleObjects.assign(staticObjects.size(), 0);
+
+		const glm::vec3 cellMin = pvs.CellMin(cell);
+		const glm::vec3 cellSize = pvs.GetCellSize();
+		const glm::vec3 cellMax = cellMin + cellSize;
+
+		// The camera can be right up against anything overlapping the cell
+		for (unsigned int i = 0; i < staticObjects.size(); i++) {
+			if (glm::all(glm::lessThanEqual(staticObjects[i].boundsMin, cellMax)) && glm::all(glm::greaterThanEqual(staticObjects[i].boundsMax, cellMin))) { out_visibleObjects[i] = 1; }
+		}
+
+		std::minstd_rand random(cell + 1);
+		std::uniform_real_distribution<float> jitter(0.0f, 1.0f);
+		const float sampleSpacing = (1.0f - 2.0f * SAMPLE_INSET) / CELL_FACE_SAMPLE_GRID;
+		for (unsigned int cellFace = 0; cellFace < 6; cellFace++) {
+			const unsigned int axis = cellFace / 2;
+			const unsigned int uAxis = (axis + 1) % 3;
+			const unsigned int vAxis = (axis + 2) % 3;
+
+			for (unsigned int u = 0; u < CELL_FACE_SAMPLE_GRID; u++) {
+				for (unsigned int v = 0; v < CELL_FACE_SAMPLE_GRID; v++) {
+					// Position within the cell from 0 to 1 on each axis
+					glm::vec3 cellPosition;
+					cellPosition[axis] = (cellFace % 2 == 0) ? 1.0f - SAMPLE_INSET : SAMPLE_INSET;
+					cellPosition[uAxis] = SAMPLE_INSET + (u + jitter(random)) * sampleSpacing;
+					cellPosition[vAxis] = SAMPLE_INSET + (v + jitter(random)) * sampleSpacing;
+					const glm::vec3 samplePosition = cellMin + cellPosition * cellSize;
+
+					// Looking back across the cell only sees what the opposite face's samples see looking out of it
+					for (unsigned int direction = 0; direction < 6; direction++) {
+						if (direction != (cellFace ^ 1u)) { BakeView(samplePosition, direction, buffer, faceObjects, out_visibleObjects); }
+					}
+				}
+			}
+		}
+	}
+
+	void SystemPVSBaking::BakeView(const glm::vec3& position, const unsigned int direction, OcclusionBuffer& buffer, std::vector<unsigned int>& faceObjects, std::vector<unsigned char>& inout_visibleObjects) const
+	{
+		static const glm::vec3 faceDirections[6] = { glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f) };
+		static const glm::vec3 faceUps[6] = { glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f) };
+		const glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, NEAR_CLIP, farClip);
+		const glm::mat4 viewProjection = projection * glm::lookAt(position, position + faceDirections[direction], faceUps[direction]);
+		const ViewFrustum frustum = ViewFrustum::FromViewProjection(viewProjection);
+		const ViewPlane* planes[6] = { &frustum.left, &frustum.right, &frustum.bottom, &frustum.top, &frustum.near, &frustum.far };
+
+		// Only meshes inside this view can hide or be seen
+		faceObjects.clear();
+		bool anyHidden = false;
+		for (unsigned int i = 0; i < staticObjects.size(); i++) {
+			const glm::vec3 boundsCentre = (staticObjects[i].boundsMin + staticObjects[i].boundsMax) * 0.5f;
+			const glm::vec3 extent = (staticObjects[i].boundsMax - staticObjects[i].boundsMin) * 0.5f;
+			bool inside = true;
+			for (unsigned int p = 0; p < 6 && inside; p++) {
+				inside = glm::dot(planes[p]->normal, boundsCentre) + glm::dot(glm::abs(planes[p]->normal), extent) >= planes[p]->distance;
+			}
+			if (inside) {
+				faceObjects.push_back(i);
+				if (!inout_visibleObjects[i]) { anyHidden = true; }
+			}
+		}
+
+		// Later samples often see nothing new, drawing the occluders can't change anything then
+		if (!anyHidden) { return; }
+
+		buffer.Clear(viewProjection);
+		for (const unsigned int i : faceObjects) {
+			if (staticObjects[i].occluder) {
+				const MeshData& meshData = *staticObjects[i].meshData;
+				buffer.RasterizeTriangles(staticObjects[i].model, meshData.GetVertices(), meshData.GetIndices().data(), meshData.GetIndices().size());
+			}
+		}
+		buffer.BuildPyramid();
+
+		for (const unsigned int i : faceObjects) {
+			if (!inout_visibleObjects[i] && !buffer.IsOccluded(staticObjects[i].boundsMin, staticObjects[i].boundsMax)) { inout_visibleObjects[i] = 1; }
+		}
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "EntityManager.h"
+#include "OcclusionBuffer.h"
+#include "PotentiallyVisibleSet.h"
+#include <string>
+namespace Engine {
+	// Bakes the potentially visible set of a scene's static geometry into BakedData, see ComponentGeometry::SetIsStatic
+	// Every line of sight from inside a cell leaves it through one of its faces, so the cell is looked out of from points spread over each face. Static meshes are drawn
+	// into a CPU occlusion buffer and every static mesh not hidden behind them is kept, along with any static mesh overlapping the cell
+	// The faces are only sampled so the set isn't strictly conservative, a mesh only visible through a gap narrower than the spacing between samples can be missed. Use smaller cells where that matters
+	// Never touches the GPU, cells are baked in parallel on the thread pool
+	class SystemPVSBaking
+	{
+	public:
+		// Resolution of each cube face the occlusion buffer is drawn at
+		static constexpr unsigned int FACE_RESOLUTION = 128;
+		// Each face of a cell is split into a grid this many squares a side with one sample at a random point in each, kept this much of the cell inside the face
+		// Samples are seeded by cell so the same scene always bakes the same set
+		static constexpr unsigned int CELL_FACE_SAMPLE_GRID = 3;
+		static constexpr float SAMPLE_INSET = 0.02f;
+		static constexpr float NEAR_CLIP = 0.05f;
+
+		SystemPVSBaking() {}
+		~SystemPVSBaking() {}
+
+		// Bounds should cover everywhere the camera can go. The set is written to Data/PVS/<sceneName>.pvs
+		void Run(EntityManager* ecs, const std::string& sceneName, const glm::vec3& boundsMin, const glm::vec3& boundsMax, const float cellSize);
+		// Covers the bounds of the static geometry
+		void Run(EntityManager* ecs, const std::string& sceneName, const float cellSize);
+
+	private:
+		struct StaticObject {
+			PVSObjectKey key;
+			glm::mat4 model;
+			const MeshData* meshData;
+			glm::vec3 boundsMin;
+			glm::vec3 boundsMax;
+			bool occluder; // opaque triangle meshes hide what's behind them, anything else can only be seen
+		};
+
+		void GatherStaticObjects(EntityManager& ecs);
+		void Bake(const std::string& sceneName, const glm::vec3& boundsMin, const glm::vec3& boundsMax, const float cellSize);
+		void BakeCell(const PotentiallyVisibleSet& pvs, const unsigned int cell, OcclusionBuffer& buffer, std::vector<unsigned int>& faceObjects, std::vector<unsigned char>& out_visibleObjects) const;
+		// Marks every static mesh seen from position looking down one axis, in the order +x, -x, +y, -y, +z, -z
+		void BakeView(const glm::vec3& position, const unsigned int direction, OcclusionBuffer& buffer, std::vector<unsigned int>& faceObjects, std::vector<unsigned char>& inout_visibleObjects) const;
+
+		std::vector<StaticObject> staticObjects;
+		float farClip;
+	};
+}
@@ -4,65 +4,129 @@ namespace Engine
 {
 	void SystemPhysics::OnAction(const unsigned int entityID, ComponentTransform& transform, ComponentPhysics& physics)
 	{
-		SCOPE_TIMER("SystemPhysics::OnAction()");
-		Acceleration(transform, physics);
-
-		// Linear velocity
-		glm::vec3 position = transform.Position();
-		const glm::vec3& velocity = physics.Velocity();
-		//transform->SetLastPosition(position);
-
-		position += velocity * Scene::dt;
-
-		transform.SetPosition(position + velocity); // this is bizarre, why are we adding velocity twice? todo:
-
-		// Angular velocity
-		glm::quat orientation = transform.GetOrientation();
-		const glm::vec3& angularVelocity = physics.AngularVelocity();
+		// Bodies are only gathered here, the whole batch is integrated in AfterAction
+		if (physics.IsAsleep()) { return; }
+		bodies.Add(entityID, &transform, &physics);
+	}
 
-		orientation = orientation + (glm::quat(glm::vec3(angularVelocity * Scene::dt * 0.5f)) * orientation);
-		orientation = glm::normalize(orientation);
+	void SystemPhysics::AfterAction()
+	{
+		SCOPE_TIMER("SystemPhysics::AfterAction()");
+		{
+			SCOPE_TIMER("SystemPhysics::AfterAction::Integrate()");
+			bodies.Integrate(Scene::dt, gravityAxis * -gravity, airDensity);
+		}
 
-		transform.SetOrientation(orientation);
+		ContinuousCollision();
 
-		physics.ClearForces();
-		physics.SetTorque(glm::vec3(0.0f));
+		{
+			SCOPE_TIMER("SystemPhysics::AfterAction::WriteBack()");
+			bodies.WriteBack();
+		}
+		bodies.Clear();
 	}
 
-	void SystemPhysics::Acceleration(ComponentTransform& transform, ComponentPhysics& physics)
+	void SystemPhysics::ContinuousCollision()
 	{
-		const float inverseMass = physics.InverseMass();
-		glm::vec3 velocity = physics.Velocity();
-		glm::vec3 acceleration = physics.Force() * inverseMass;
+		SCOPE_TIMER("SystemPhysics::ContinuousCollision()");
+		// Bodies flagged for continuous collision are swept through the query BVH from where they started the step
+		// At each impact the body stops at the surface, loses its velocity into it and carries on with what's left of the step
+		bool queryBVHRefitted = false;
+		for (unsigned int i = 0; i < bodies.Size(); i++) {
+			if (!bodies.Physics(i)->ContinuousCollision()) { continue; }
+
+			// Transform still holds the start of step position until write back
+			const ComponentTransform* transform = bodies.Transform(i);
+			const glm::vec3& start = transform->Position();
+			const glm::vec3 displacement = bodies.Position(i) - start;
+			const float distance = glm::length(displacement);
+			if (distance == 0.0f) { continue; }
+
+			const unsigned int entityID = bodies.EntityID(i);
+			unsigned int layerMask = ALL_COLLISION_LAYERS;
+			const float radius = SweptRadius(entityID, *transform, layerMask);
+
+			// Anything moving less than its own radius per step can't skip over a collider
+			if (radius <= 0.0f || distance <= radius) { continue; }
+
+			// Every other collider is swept against where it started this step
+			if (!queryBVHRefitted) {
+				collisionManager->UpdateQueryBVH(*active_ecs);
+				queryBVHRefitted = true;
+			}
+
+			const glm::vec3 worldStart = transform->GetWorldPosition();
+			glm::vec3 velocity = bodies.Velocity(i);
+			const glm::vec3 worldEnd = Substep(entityID, worldStart, displacement, radius, layerMask, bodies.Physics(i)->Elasticity(), velocity);
+
+			bodies.SetPosition(i, start + (worldEnd - worldStart));
+			bodies.SetVelocity(i, velocity);
+		}
+	}
 
-		// Apply gravity if component enables it and is not an immovable object
-		if (physics.Gravity() && inverseMass > 0) {
-			acceleration += glm::vec3(gravityAxis.x * -gravity, gravityAxis.y * -gravity, gravityAxis.z * -gravity) * Scene::dt;
+	glm::vec3 SystemPhysics::Substep(const unsigned int entityID, const glm::vec3& start, const glm::vec3& displacement, const float radius, const unsigned int layerMask, const float elasticity, glm::vec3& inout_velocity) const
+	{
+		SCOPE_TIMER("SystemPhysics::Substep()");
+		const CollisionQueryBVH& queryBVH = collisionManager->GetQueryBVH();
+
+		glm::vec3 position = start;
+		glm::vec3 motion = displacement;
+		float remainingTime = Scene::dt;
+
+		for (unsigned int substep = 0; substep < MAX_CCD_SUBSTEPS; substep++) {
+			const float length = glm::length(motion);
+			if (length <= 1e-6f) { break; }
+
+			// Colliders already touched at the start of a substep are left to the narrowphase, including the one just hit
+			RaycastHit hit;
+			if (!queryBVH.SweepSphere(Ray(position, motion / length, length), radius, entityID, hit, layerMask)) {
+				position += motion;
+				break;
+			}
+
+			const float timeOfImpact = hit.distance / length;
+			position += motion * std::min(timeOfImpact + (ccdContactDepth / length), 1.0f);
+			remainingTime *= 1.0f - timeOfImpact;
+
+			// The surface is treated as immovable, with the same restitution the solver would use for the pair
+			const ComponentPhysics* otherPhysics = active_ecs->GetComponent<ComponentPhysics>(hit.entityID);
+			const float restitution = elasticity * (otherPhysics ? otherPhysics->Elasticity() : 0.5f);
+			const float normalSpeed = glm::dot(inout_velocity, hit.normal);
+			if (normalSpeed < 0.0f) { inout_velocity -= hit.normal * normalSpeed * (1.0f + restitution); }
+
+			motion = inout_velocity * remainingTime;
 		}
 
-		const float vMagnitude = glm::length(velocity); //m/s
+		return position;
+	}
 
-		if (vMagnitude > 0) {
-			const float surfaceArea = physics.SurfaceArea(); // m2
-			const float coefficient = physics.DragCoefficient();
-			const float dragMagnitude = coefficient * airDensity * ((vMagnitude * vMagnitude) / 2.0f) * surfaceArea;
-			const glm::vec3 dragDirection = -glm::normalize(velocity);
+	float SystemPhysics::SweptRadius(const unsigned int entityID, const ComponentTransform& transform, unsigned int& out_layerMask) const
+	{
+		const glm::vec3& scale = transform.Scale();
 
-			acceleration += (dragMagnitude * dragDirection) * Scene::dt;
+		if (const ComponentCollisionSphere* sphere = active_ecs->GetComponent<ComponentCollisionSphere>(entityID)) {
+			out_layerMask = collisionManager->AcceptedLayers(sphere->CollisionLayer(), sphere->CollisionMask());
+			return sphere->CollisionRadius() * transform.GetBiggestScaleFactor();
 		}
 
-		velocity += acceleration * Scene::dt;
-		physics.SetVelocity(velocity);
-
-		// Angular
-		physics.UpdateInertiaTensor(transform.GetOrientation());
-
-		const glm::vec3 angularAcceleration = physics.InverseInertiaTensor() * physics.Torque();
-		glm::vec3 angularVelocity = physics.AngularVelocity();
+		// Boxes and hulls are swept as the sphere inscribed in their local bounds, which is what matters for tunnelling
+		glm::vec3 halfExtents = glm::vec3(0.0f);
+		if (const ComponentCollisionAABB* aabb = active_ecs->GetComponent<ComponentCollisionAABB>(entityID)) {
+			const AABBPoints& bounds = aabb->GetBoundary();
+			halfExtents = glm::vec3(bounds.maxX - bounds.minX, bounds.maxY - bounds.minY, bounds.maxZ - bounds.minZ) * 0.5f;
+			out_layerMask = collisionManager->AcceptedLayers(aabb->CollisionLayer(), aabb->CollisionMask());
+		}
+		else if (const ComponentCollisionBox* box = active_ecs->GetComponent<ComponentCollisionBox>(entityID)) {
+			const BoxExtents& extents = box->GetLocalPoints();
+			halfExtents = glm::vec3(extents.maxX - extents.minX, extents.maxY - extents.minY, extents.maxZ - extents.minZ) * 0.5f;
+			out_layerMask = collisionManager->AcceptedLayers(box->CollisionLayer(), box->CollisionMask());
+		}
+		else if (const ComponentCollisionConvex* convex = active_ecs->GetComponent<ComponentCollisionConvex>(entityID)) {
+			if (convex->GetHull()) { halfExtents = (convex->GetHull()->BoundsMax() - convex->GetHull()->BoundsMin()) * 0.5f; }
+			out_layerMask = collisionManager->AcceptedLayers(convex->CollisionLayer(), convex->CollisionMask());
+		}
 
-		angularVelocity += angularAcceleration * Scene::dt;
-		physics.SetAngularVelocity(angularVelocity);
+		halfExtents *= scale;
+		return std::min(halfExtents.x, std::min(halfExtents.y, halfExtents.z));
 	}
-
-	void SystemPhysics::AfterAction() {}
 }
\ No newline at end of file
@@ -2,24 +2,47 @@
 #include "System.h"
 #include "ComponentTransform.h"
 #include "ComponentPhysics.h"
+#include "ComponentCollisionAABB.h"
+#include "ComponentCollisionBox.h"
+#include "ComponentCollisionMesh.h"
+#include "ComponentCollisionConvex.h"
+#include "ComponentCollisionSphere.h"
+#include "RigidBodyStore.h"
+#include "CollisionManager.h"
 namespace Engine 
 {
 	class SystemPhysics : public System
 	{
 	public:
-		SystemPhysics(EntityManager* ecs, const float gravity = 9.8f, const glm::vec3& gravityAxis = glm::vec3(0.0f, 1.0f, 0.0f), const float airDensity = 1.225f) : System(ecs), gravity(gravity), gravityAxis(gravityAxis), airDensity(airDensity) {}
+		SystemPhysics(EntityManager* ecs, CollisionManager* collisionManager, const float gravity = 9.8f, const glm::vec3& gravityAxis = glm::vec3(0.0f, 1.0f, 0.0f), const float airDensity = 1.225f) : System(ecs), collisionManager(collisionManager), gravity(gravity), gravityAxis(gravityAxis), airDensity(airDensity), ccdContactDepth(0.01f) {}
 		~SystemPhysics() {}
 
 		float airDensity; // kg/m3
 		glm::vec3 gravityAxis;
 		float gravity; // represented as acceleration m/s^2
+		float ccdContactDepth; // how far a swept body is allowed into the surface it hits, so the contact is picked up by the narrowphase next frame
+
+		// Impacts a swept body can resolve in one step, any motion left after the last is dropped
+		static constexpr unsigned int MAX_CCD_SUBSTEPS = 4;
 
 		constexpr const char* SystemName() override { return "SYSTEM_PHYSICS"; }
 
 		void OnAction(const unsigned int entityID, ComponentTransform& transform, ComponentPhysics& physics);
 		void AfterAction();
 
+		const RigidBodyStore& Bodies() const { return bodies; }
+
 	private:
-		void Acceleration(ComponentTransform& transform, ComponentPhysics& physics);
+		void ContinuousCollision();
+
+		// Continuous collision
+		float SweptRadius(const unsigned int entityID, const ComponentTransform& transform, unsigned int& out_layerMask) const;
+		// Moves a swept body through its step from start, returning where it ends up. Velocity is updated at each impact
+		glm::vec3 Substep(const unsigned int entityID, const glm::vec3& start, const glm::vec3& displacement, const float radius, const unsigned int layerMask, const float elasticity, glm::vec3& inout_velocity) const;
+
+		CollisionManager* collisionManager;
+
+		// Awake bodies gathered during OnAction this step
+		RigidBodyStore bodies;
 	};
 }
\ No newline at end of file
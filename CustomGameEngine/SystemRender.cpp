@@ -2,7 +2,7 @@
 #include "ComponentAnimator.h"
 #include "ResourceManager.h"
 namespace Engine {
-	std::map<float, std::pair<Mesh*, unsigned int>> SystemRender::transparentMeshes = std::map<float, std::pair<Mesh*, unsigned int>>();
+	DrawList SystemRender::transparentMeshes = DrawList();
 	SystemRender::SystemRender() : ecs(nullptr), lightManager(nullptr)
 	{
 		//camera = nullptr;
@@ -27,25 +27,21 @@ namespace Engine {
 		shadersUsedThisFrame.clear();
 	}
 
-	void SystemRender::RenderMeshes(const std::map<float, std::pair<Mesh*, unsigned int>>& meshesAndDistances, const bool transparencyPass, bool useDefaultForwardShader)
+	void SystemRender::RenderMeshes(const DrawList& drawList, const bool transparencyPass, bool useDefaultForwardShader)
 	{
 		SCOPE_TIMER("SystemRender::RenderMeshes()");
-		std::map<float, std::pair<Mesh*, unsigned int>>::const_iterator meshesAndDistancesIt = meshesAndDistances.begin();
-
-		while (meshesAndDistancesIt != meshesAndDistances.end()) {
-			Mesh* m = meshesAndDistancesIt->second.first;
-			RenderMesh(meshesAndDistancesIt->second.second, m, transparencyPass, useDefaultForwardShader);
-			if (!transparencyPass && m->GetMaterial()->GetIsTransparent()) {
-				transparentMeshes[meshesAndDistancesIt->first] = meshesAndDistancesIt->second;
+		for (const DrawItem& item : drawList) {
+			RenderMesh(item.entityID, item.mesh, transparencyPass, useDefaultForwardShader, item.lod);
+			if (!transparencyPass && item.mesh->GetMaterial()->GetIsTransparent()) {
+				// Taken in draw list order, so the transparent list comes out already sorted
+				transparentMeshes.Add(item);
 			}
-
-			meshesAndDistancesIt++;
 		}
 
-		if (transparencyPass) { transparentMeshes.clear(); }
+		if (transparencyPass) { transparentMeshes.Clear(); }
 	}
 
-	void SystemRender::RenderMesh(const unsigned int entityID, Mesh* mesh, const bool transparencyPass, bool useDefaultForwardShader)
+	void SystemRender::RenderMesh(const unsigned int entityID, Mesh* mesh, const bool transparencyPass, bool useDefaultForwardShader, const unsigned int lod)
 	{
 		SCOPE_TIMER("SystemRender::RenderMesh");
 		ResourceManager* resources = ResourceManager::GetInstance();
@@ -112,6 +108,6 @@ namespace Engine {
 		//else {
 		//	mesh->Draw(*shader, geometry->PBR());
 		//}
-		mesh->Draw(*shader, geometry->PBR());
+		mesh->Draw(*shader, geometry->PBR(), 0, 0, lod);
 	}
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "Camera.h"
 #include "ComponentTransform.h"
 #include "ComponentGeometry.h"
+#include "DrawList.h"
 #include <map>
 namespace Engine {
 	enum PostProcessingEffect {
@@ -33,13 +34,14 @@ namespace Engine {
 		void SetPostProcess(PostProcessingEffect effect) { postProcess = effect; }
 		PostProcessingEffect GetPostProcess() const { return postProcess; }
 
-		void RenderMeshes(const std::map<float, std::pair<Mesh*, unsigned int>>& meshesAndDistances, const bool transparencyPass = false, bool useDefaultForwardShader = false);
+		// Draws the list in order. The opaque pass also collects the transparent meshes it meets into transparentMeshes, in the same order
+		void RenderMeshes(const DrawList& drawList, const bool transparencyPass = false, bool useDefaultForwardShader = false);
 
-		void RenderMesh(const unsigned int entityID, Mesh* mesh, const bool transparencyPass = false, bool useDefaultForwardShader = false);
+		void RenderMesh(const unsigned int entityID, Mesh* mesh, const bool transparencyPass = false, bool useDefaultForwardShader = false, const unsigned int lod = 0);
 
 		float PostProcessKernel[9];
 
-		static std::map<float, std::pair<Mesh*, unsigned int>> transparentMeshes;
+		static DrawList transparentMeshes;
 
 		const Camera* GetActiveCamera() const { return activeCamera; }
 		Camera* GetActiveCamera() { return activeCamera; }
@@ -41,7 +41,7 @@ namespace Engine {
 		SCOPE_TIMER("SystemRenderColliders::AfterAction()");
 		// Render BVH Tree
 		BVHTree* bvhTree = collisionManager->GetBVHTree();
-		RenderBVHNode(bvhTree->GetRootNode());
+		if (!bvhTree->IsEmpty()) { RenderBVHNode(*bvhTree, 0); }
 	}
 
 	void SystemRenderColliders::DrawAABB(const glm::vec3& position, const AABBPoints& aabb, Shader* shader, const glm::vec3& colliderColour)
@@ -71,19 +71,15 @@ namespace Engine {
 	}
 
 
-	void SystemRenderColliders::RenderBVHNode(const BVHNode* node)
+	void SystemRenderColliders::RenderBVHNode(const BVHTree& tree, const unsigned int nodeIndex)
 	{
-		const BVHNode* leftChild = node->GetLeftChild();
-		const BVHNode* rightChild = node->GetRightChild();
+		const BVHNode& node = tree.GetNodes()[nodeIndex];
 
-		if (leftChild) {
-			RenderBVHNode(leftChild);
+		if (!node.IsLeaf()) {
+			RenderBVHNode(tree, nodeIndex + 1);
+			RenderBVHNode(tree, node.first);
 		}
 
-		if (rightChild) {
-			RenderBVHNode(rightChild);
-		}
-
-		DrawAABB(glm::vec3(0.0f), node->GetBoundingBox(), ResourceManager::GetInstance()->ColliderDebugShader(), glm::vec3(1.0f, 0.0f, 0.0f));
+		DrawAABB(glm::vec3(0.0f), node.GetBoundingBox(), ResourceManager::GetInstance()->ColliderDebugShader(), glm::vec3(1.0f, 0.0f, 0.0f));
 	}
 }
\ No newline at end of file
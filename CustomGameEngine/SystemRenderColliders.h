@@ -15,7 +15,7 @@ namespace Engine {
 
 		void DrawAABB(const glm::vec3& position, const AABBPoints& aabb, Shader* shader, const glm::vec3& colliderColour = glm::vec3(0.0f, 1.0f, 0.0f));
 	private:
-		void RenderBVHNode(const BVHNode* node);
+		void RenderBVHNode(const BVHTree& tree, const unsigned int nodeIndex);
 
 		unsigned int VAO, VBO;
 
@@ -6,46 +6,71 @@ namespace Engine {
 	{
 		SCOPE_TIMER("SystemShadowMapping::OnAction()");
 		if (geometry.CastShadows()) {
-			Shader* depthShader = nullptr;
-			if (type == MAP_2D) {
-				depthShader = ResourceManager::GetInstance()->ShadowMapShader();
-			}
-			else {
-				depthShader = ResourceManager::GetInstance()->CubeShadowMapShader();
-			}
+			Shader* depthShader = PrepareCaster(entityID, transform, geometry);
 
-			depthShader->setMat4("model", transform.GetWorldModelMatrix());
-			//depthShader->setBool("instanced", geometry->Instanced());
-			//if (geometry->Instanced()) { geometry->BufferInstanceTransforms(); }
-			depthShader->setVec2("textureScale", geometry.GetTextureScale());
-			depthShader->setBool("hasBones", false);
-
-			// Bones
-			if (geometry.GetModel()->HasBones()) {
-				ComponentAnimator* animator = active_ecs->GetComponent<ComponentAnimator>(entityID);
-				if (animator) {
-					depthShader->setBool("hasBones", true);
-					const std::vector<glm::mat4>& transforms = animator->GetFinalBonesMatrices();
-					for (int i = 0; i < transforms.size(); i++) {
-						depthShader->setMat4("boneTransforms[" + std::to_string(i) + "]", transforms[i]);
-					}
-				}
-			}
+			//geometry->GetModel()->Draw(*depthShader, geometry->NumInstances(), geometry->GetInstanceVAOs());
+			geometry.GetModel()->Draw(*depthShader, 0, {});
+		}
+	}
 
-			if (geometry.Cull_Face()) { glEnable(GL_CULL_FACE); }
-			else { glDisable(GL_CULL_FACE); }
+	void SystemShadowMapping::RenderMeshes(const DrawList& casters)
+	{
+		SCOPE_TIMER("SystemShadowMapping::RenderMeshes()");
+		unsigned int preparedEntity = 0;
+		Shader* depthShader = nullptr;
+		for (const DrawItem& item : casters) {
+			ComponentGeometry* geometry = active_ecs->GetComponent<ComponentGeometry>(item.entityID);
+			if (!geometry->CastShadows()) { continue; }
 
-			if (geometry.Cull_Type() == GL_BACK) {
-				///glCullFace(GL_FRONT);
-				glCullFace(GL_BACK);
+			// An entity's meshes usually sit next to each other in the list, its uniforms only need setting once for the run
+			if (!depthShader || item.entityID != preparedEntity) {
+				depthShader = PrepareCaster(item.entityID, *active_ecs->GetComponent<ComponentTransform>(item.entityID), *geometry);
+				preparedEntity = item.entityID;
 			}
-			else if (geometry.Cull_Type() == GL_FRONT) {
-				//glCullFace(GL_BACK);
-				glCullFace(GL_FRONT);
+			item.mesh->Draw(*depthShader, geometry->PBR(), 0, 0, item.lod);
+		}
+	}
+
+	Shader* SystemShadowMapping::PrepareCaster(const unsigned int entityID, const ComponentTransform& transform, ComponentGeometry& geometry)
+	{
+		Shader* depthShader = nullptr;
+		if (type == MAP_2D) {
+			depthShader = ResourceManager::GetInstance()->ShadowMapShader();
+		}
+		else {
+			depthShader = ResourceManager::GetInstance()->CubeShadowMapShader();
+		}
+
+		depthShader->setMat4("model", transform.GetWorldModelMatrix());
+		//depthShader->setBool("instanced", geometry->Instanced());
+		//if (geometry->Instanced()) { geometry->BufferInstanceTransforms(); }
+		depthShader->setVec2("textureScale", geometry.GetTextureScale());
+		depthShader->setBool("hasBones", false);
+
+		// Bones
+		if (geometry.GetModel()->HasBones()) {
+			ComponentAnimator* animator = active_ecs->GetComponent<ComponentAnimator>(entityID);
+			if (animator) {
+				depthShader->setBool("hasBones", true);
+				const std::vector<glm::mat4>& transforms = animator->GetFinalBonesMatrices();
+				for (int i = 0; i < transforms.size(); i++) {
+					depthShader->setMat4("boneTransforms[" + std::to_string(i) + "]", transforms[i]);
+				}
 			}
+		}
 
-			//geometry->GetModel()->Draw(*depthShader, geometry->NumInstances(), geometry->GetInstanceVAOs());
-			geometry.GetModel()->Draw(*depthShader, 0, {});
+		if (geometry.Cull_Face()) { glEnable(GL_CULL_FACE); }
+		else { glDisable(GL_CULL_FACE); }
+
+		if (geometry.Cull_Type() == GL_BACK) {
+			///glCullFace(GL_FRONT);
+			glCullFace(GL_BACK);
+		}
+		else if (geometry.Cull_Type() == GL_FRONT) {
+			//glCullFace(GL_BACK);
+			glCullFace(GL_FRONT);
 		}
+
+		return depthShader;
 	}
 }
\ No newline at end of file
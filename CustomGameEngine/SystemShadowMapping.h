@@ -2,6 +2,7 @@
 #include "EntityManager.h"
 #include "ComponentGeometry.h"
 #include "ComponentTransform.h"
+#include "DrawList.h"
 namespace Engine {
 	enum DepthMapType {
 		MAP_2D,
@@ -16,9 +17,15 @@ namespace Engine {
 		~SystemShadowMapping() {}
 
 		void OnAction(const unsigned int entityID, ComponentTransform& transform, ComponentGeometry& geometry);
+
+		// Draws only the listed meshes, e.g. the casters culling found for one light, skipping entities that don't cast shadows
+		void RenderMeshes(const DrawList& casters);
 	
 		void SetDepthMapType(const DepthMapType newType) { type = newType; }
 	private:
+		// Sets the model, bone and face culling state for an entity and returns the depth shader to draw it with
+		Shader* PrepareCaster(const unsigned int entityID, const ComponentTransform& transform, ComponentGeometry& geometry);
+
 		DepthMapType type;
 		EntityManager* active_ecs;
 	};
@@ -0,0 +1,98 @@
+#include "ThreadPool.h"
+namespace Engine {
+	ThreadPool* ThreadPool::instance = nullptr;
+
+	ThreadPool::ThreadPool(const unsigned int numWorkers) : job(nullptr), jobCount(0), jobChunkSize(1), jobNumChunks(0), nextChunk(0), chunksRemaining(0), generation(0), activeWorkers(0), stopping(false)
+	{
+		workers.reserve(numWorkers);
+		for (unsigned int i = 0; i < numWorkers; i++) {
+			workers.push_back(std::thread(&ThreadPool::WorkerLoop, this));
+		}
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		workAvailable.notify_all();
+
+		for (std::thread& worker : workers) {
+			worker.join();
+		}
+	}
+
+	void ThreadPool::ParallelFor(const unsigned int count, const unsigned int chunkSize, const ChunkFunc& func, const bool singleThreaded)
+	{
+		if (count == 0) { return; }
+		const unsigned int safeChunkSize = std::max(chunkSize, 1u);
+		const unsigned int numChunks = NumChunks(count, safeChunkSize);
+
+		// Not worth waking workers
+		if (singleThreaded || workers.empty() || numChunks == 1) {
+			for (unsigned int i = 0; i < numChunks; i++) {
+				func(i, i * safeChunkSize, std::min((i + 1) * safeChunkSize, count));
+			}
+			return;
+		}
+
+		{
+			// A worker that woke late for the previous job may still be checking for chunks
+			std::unique_lock<std::mutex> lock(mutex);
+			workFinished.wait(lock, [this]() { return activeWorkers == 0; });
+
+			job = &func;
+			jobCount = count;
+			jobChunkSize = safeChunkSize;
+			jobNumChunks = numChunks;
+			nextChunk = 0;
+			chunksRemaining = numChunks;
+			generation++;
+		}
+		workAvailable.notify_all();
+
+		// Calling thread helps out rather than sitting idle
+		RunChunks();
+
+		std::unique_lock<std::mutex> lock(mutex);
+		workFinished.wait(lock, [this]() { return chunksRemaining == 0 && activeWorkers == 0; });
+		job = nullptr;
+	}
+
+	void ThreadPool::WorkerLoop()
+	{
+		unsigned long long seenGeneration = 0;
+		while (true) {
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				workAvailable.wait(lock, [this, seenGeneration]() { return stopping || generation != seenGeneration; });
+				if (stopping) { return; }
+
+				seenGeneration = generation;
+				activeWorkers++;
+			}
+
+			RunChunks();
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				activeWorkers--;
+			}
+			workFinished.notify_all();
+		}
+	}
+
+	void ThreadPool::RunChunks()
+	{
+		unsigned int chunk = nextChunk.fetch_add(1);
+		while (chunk < jobNumChunks) {
+			const unsigned int begin = chunk * jobChunkSize;
+			const unsigned int end = std::min(begin + jobChunkSize, jobCount);
+			(*job)(chunk, begin, end);
+
+			chunksRemaining.fetch_sub(1);
+			chunk = nextChunk.fetch_add(1);
+		}
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+namespace Engine {
+	// Fixed set of worker threads used to split data parallel work into chunks
+	// Not re-entrant, ParallelFor should only be called from the main thread and never from inside a job
+	class ThreadPool
+	{
+	public:
+		using ChunkFunc = std::function<void(const unsigned int chunkIndex, const unsigned int begin, const unsigned int end)>;
+
+		~ThreadPool();
+
+		static ThreadPool* GetInstance() {
+			if (instance == nullptr) {
+				instance = new ThreadPool(std::max(std::thread::hardware_concurrency(), 2u) - 1u);
+			}
+			return instance;
+		}
+
+		// Split [0, count) into chunks of chunkSize and run func on each, blocking until every chunk is done
+		// Chunk boundaries only depend on count and chunkSize, so per chunk results can be merged in a deterministic order
+		void ParallelFor(const unsigned int count, const unsigned int chunkSize, const ChunkFunc& func, const bool singleThreaded = false);
+
+		static unsigned int NumChunks(const unsigned int count, const unsigned int chunkSize) { return (count + chunkSize - 1) / chunkSize; }
+
+		// Worker threads plus the calling thread
+		unsigned int NumThreads() const { return workers.size() + 1; }
+
+	private:
+		ThreadPool(const unsigned int numWorkers);
+
+		void WorkerLoop();
+		void RunChunks();
+
+		std::vector<std::thread> workers;
+
+		std::mutex mutex;
+		std::condition_variable workAvailable;
+		std::condition_variable workFinished;
+
+		// Current job, only changed while no worker is inside RunChunks
+		const ChunkFunc* job;
+		unsigned int jobCount;
+		unsigned int jobChunkSize;
+		unsigned int jobNumChunks;
+		std::atomic<unsigned int> nextChunk;
+		std::atomic<unsigned int> chunksRemaining;
+
+		unsigned long long generation;
+		unsigned int activeWorkers;
+		bool stopping;
+
+		static ThreadPool* instance;
+	};
+}
@@ -0,0 +1,538 @@
+#include "TriangleMeshBVH.h"
+#include "ScopeTimer.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <glm/glm.hpp>
+namespace Engine {
+	namespace {
+		constexpr char COOKED_MAGIC[4] = { 'T', 'B', 'V', 'H' };
+		constexpr uint32_t COOKED_VERSION = 1;
+
+		struct CookedHeader {
+			char magic[4];
+			uint32_t version;
+			uint64_t sourceHash;
+			uint32_t maxTrianglesPerLeaf;
+			uint32_t numNodes;
+			uint32_t numVertices;
+			uint32_t padding;
+		};
+
+		// Box and edge axes of the box / triangle test only win over the triangle's face if noticeably shallower, so resting contacts keep a stable face normal
+		constexpr float NON_FACE_AXIS_BIAS = 1.05f;
+
+		void HashBytes(uint64_t& hash, const void* data, const size_t size) {
+			const unsigned char* bytes = static_cast<const unsigned char*>(data);
+			for (size_t i = 0; i < size; i++) {
+				hash ^= bytes[i];
+				hash *= 1099511628211ull;
+			}
+		}
+
+		// Keeps slab maths finite for axis aligned rays, 0 * inf would otherwise produce NaN
+		glm::vec3 SafeInverse(const glm::vec3& direction) {
+			glm::vec3 inverse;
+			for (int i = 0; i < 3; i++) {
+				const float d = (fabs(direction[i]) < 1e-20f) ? ((direction[i] < 0.0f) ? -1e-20f : 1e-20f) : direction[i];
+				inverse[i] = 1.0f / d;
+			}
+			return inverse;
+		}
+
+		bool RayBox(const glm::vec3& origin, const glm::vec3& inverseDirection, const glm::vec3& boxMin, const glm::vec3& boxMax, const float maxDistance, float& out_entry) {
+			const glm::vec3 t1 = (boxMin - origin) * inverseDirection;
+			const glm::vec3 t2 = (boxMax - origin) * inverseDirection;
+			const glm::vec3 tNear = glm::min(t1, t2);
+			const glm::vec3 tFar = glm::max(t1, t2);
+			const float tEnter = std::max(std::max(std::max(tNear.x, tNear.y), tNear.z), 0.0f);
+			const float tExit = std::min(std::min(std::min(tFar.x, tFar.y), tFar.z), maxDistance);
+			out_entry = tEnter;
+			return tEnter <= tExit;
+		}
+
+		// Ray against a sphere the origin starts outside of, unit direction
+		bool RaySphere(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3& centre, const float radius, float& out_distance) {
+			const glm::vec3 m = origin - centre;
+			const float b = glm::dot(m, direction);
+			const float c = glm::dot(m, m) - (radius * radius);
+			if (b > 0.0f) { return false; }
+			const float discriminant = (b * b) - c;
+			if (discriminant < 0.0f) { return false; }
+			out_distance = std::max(-b - glm::sqrt(discriminant), 0.0f);
+			return true;
+		}
+
+		// Ray against the cylinder around segment [p, q], only hits on the side of the cylinder count
+		bool RayCylinder(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3& p, const glm::vec3& q, const float radius, float& out_distance, glm::vec3& out_axisPoint) {
+			const glm::vec3 d = q - p;
+			const glm::vec3 m = origin - p;
+			const float dd = glm::dot(d, d);
+			const float nd = glm::dot(direction, d);
+			const float md = glm::dot(m, d);
+
+			const float a = dd - (nd * nd);
+			if (fabs(a) < 1e-12f) { return false; } // parallel to the axis, the end spheres handle it
+
+			const float b = (dd * glm::dot(m, direction)) - (nd * md);
+			const float c = (dd * (glm::dot(m, m) - (radius * radius))) - (md * md);
+			const float discriminant = (b * b) - (a * c);
+			if (discriminant < 0.0f) { return false; }
+
+			const float t = (-b - sqrt(discriminant)) / a;
+			if (t < 0.0f) { return false; }
+
+			const float s = (md + (t * nd)) / dd;
+			if (s < 0.0f || s > 1.0f) { return false; }
+
+			out_distance = t;
+			out_axisPoint = p + d * s;
+			return true;
+		}
+	}
+
+	void TriangleMeshBVH::Build(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& indices)
+	{
+		SCOPE_TIMER("TriangleMeshBVH::Build()");
+		nodes.clear();
+		vertices.clear();
+		sourceHash = HashSource(positions, indices);
+
+		std::vector<glm::vec3> source;
+		source.reserve(indices.size());
+		for (unsigned int i = 0; i + 2 < indices.size(); i += 3) {
+			if (indices[i] >= positions.size() || indices[i + 1] >= positions.size() || indices[i + 2] >= positions.size()) { continue; }
+
+			const glm::vec3& a = positions[indices[i]];
+			const glm::vec3& b = positions[indices[i + 1]];
+			const glm::vec3& c = positions[indices[i + 2]];
+			const glm::vec3 normal = glm::cross(b - a, c - a);
+			if (glm::dot(normal, normal) < 1e-20f) { continue; }
+
+			source.push_back(a);
+			source.push_back(b);
+			source.push_back(c);
+		}
+
+		const unsigned int numTriangles = source.size() / 3;
+		if (numTriangles == 0) { return; }
+
+		std::vector<unsigned int> order(numTriangles);
+		std::vector<glm::vec3> centroids(numTriangles);
+		std::vector<glm::vec3> triangleMin(numTriangles);
+		std::vector<glm::vec3> triangleMax(numTriangles);
+		for (unsigned int i = 0; i < numTriangles; i++) {
+			const glm::vec3& a = source[i * 3];
+			const glm::vec3& b = source[i * 3 + 1];
+			const glm::vec3& c = source[i * 3 + 2];
+			order[i] = i;
+			triangleMin[i] = glm::min(a, glm::min(b, c));
+			triangleMax[i] = glm::max(a, glm::max(b, c));
+			centroids[i] = (a + b + c) / 3.0f;
+		}
+
+		nodes.reserve((2 * numTriangles) / std::max(maxTrianglesPerLeaf, 1u) + 1);
+		nodes.push_back(Node());
+		BuildNode(0, 1, 0, numTriangles, order, centroids, triangleMin, triangleMax);
+
+		// Store triangles in leaf order so each leaf reads one contiguous run
+		vertices.reserve(source.size());
+		for (const unsigned int triangle : order) {
+			vertices.push_back(source[triangle * 3]);
+			vertices.push_back(source[triangle * 3 + 1]);
+			vertices.push_back(source[triangle * 3 + 2]);
+		}
+	}
+
+	void TriangleMeshBVH::BuildNode(const unsigned int nodeIndex, const unsigned int depth, const unsigned int begin, const unsigned int end, std::vector<unsigned int>& order, const std::vector<glm::vec3>& centroids, const std::vector<glm::vec3>& triangleMin, const std::vector<glm::vec3>& triangleMax)
+	{
+		// Median splits halve the range at every level, so even 2^32 triangles stay well inside the stack
+		assert(depth < MAX_STACK_DEPTH);
+
+		glm::vec3 boundsMin = triangleMin[order[begin]];
+		glm::vec3 boundsMax = triangleMax[order[begin]];
+		glm::vec3 centreMin = centroids[order[begin]];
+		glm::vec3 centreMax = centroids[order[begin]];
+		for (unsigned int i = begin + 1; i < end; i++) {
+			boundsMin = glm::min(boundsMin, triangleMin[order[i]]);
+			boundsMax = glm::max(boundsMax, triangleMax[order[i]]);
+			centreMin = glm::min(centreMin, centroids[order[i]]);
+			centreMax = glm::max(centreMax, centroids[order[i]]);
+		}
+
+		nodes[nodeIndex].boundsMin = boundsMin;
+		nodes[nodeIndex].boundsMax = boundsMax;
+
+		// Median split on the longest axis of the triangle centres
+		const glm::vec3 extent = centreMax - centreMin;
+		int axis = 0;
+		if (extent.y > extent[axis]) { axis = 1; }
+		if (extent.z > extent[axis]) { axis = 2; }
+
+		if (end - begin <= maxTrianglesPerLeaf || extent[axis] <= 0.0f) {
+			nodes[nodeIndex].first = begin;
+			nodes[nodeIndex].count = end - begin;
+			return;
+		}
+
+		const unsigned int mid = begin + ((end - begin) / 2);
+		std::nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end, [&centroids, axis](const unsigned int a, const unsigned int b) {
+			return centroids[a][axis] < centroids[b][axis];
+		});
+
+		// Children are allocated together so an interior node only needs the index of the first
+		const unsigned int children = nodes.size();
+		nodes.push_back(Node());
+		nodes.push_back(Node());
+		nodes[nodeIndex].first = children;
+		nodes[nodeIndex].count = 0;
+
+		BuildNode(children, depth + 1, begin, mid, order, centroids, triangleMin, triangleMax);
+		BuildNode(children + 1, depth + 1, mid, end, order, centroids, triangleMin, triangleMax);
+	}
+
+	uint64_t TriangleMeshBVH::HashSource(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& indices)
+	{
+		// FNV-1a over the raw vertex and index data
+		uint64_t hash = 14695981039346656037ull;
+		const uint64_t counts[2] = { positions.size(), indices.size() };
+		HashBytes(hash, counts, sizeof(counts));
+		if (positions.size() > 0) { HashBytes(hash, positions.data(), positions.size() * sizeof(glm::vec3)); }
+		if (indices.size() > 0) { HashBytes(hash, indices.data(), indices.size() * sizeof(unsigned int)); }
+		return hash;
+	}
+
+	bool TriangleMeshBVH::WriteToFile(const std::string& filepath) const
+	{
+		std::ofstream file(filepath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) {
+			std::cout << "ERROR::TRIANGLEMESHBVH::WriteToFile::Unable to open " << filepath << std::endl;
+			return false;
+		}
+
+		CookedHeader header;
+		std::copy(COOKED_MAGIC, COOKED_MAGIC + 4, header.magic);
+		header.version = COOKED_VERSION;
+		header.sourceHash = sourceHash;
+		header.maxTrianglesPerLeaf = maxTrianglesPerLeaf;
+		header.numNodes = nodes.size();
+		header.numVertices = vertices.size();
+		header.padding = 0;
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(nodes.data()), nodes.size() * sizeof(Node));
+		file.write(reinterpret_cast<const char*>(vertices.data()), vertices.size() * sizeof(glm::vec3));
+		return file.good();
+	}
+
+	bool TriangleMeshBVH::LoadFromFile(const std::string& filepath, const uint64_t expectedSourceHash)
+	{
+		std::ifstream file(filepath, std::ios::binary);
+		if (!file.is_open()) { return false; }
+
+		CookedHeader header;
+		file.read(reinterpret_cast<char*>(&header), sizeof(header));
+		if (!file || !std::equal(COOKED_MAGIC, COOKED_MAGIC + 4, header.magic) || header.version != COOKED_VERSION || header.sourceHash != expectedSourceHash || header.numVertices % 3 != 0) {
+			return false;
+		}
+
+		// A truncated file is caught before anything is allocated from the header's counts
+		const std::streamoff dataStart = file.tellg();
+		file.seekg(0, std::ios::end);
+		const uint64_t dataSize = (uint64_t)(file.tellg() - dataStart);
+		file.seekg(dataStart);
+		if (dataSize != ((uint64_t)header.numNodes * sizeof(Node)) + ((uint64_t)header.numVertices * sizeof(glm::vec3))) {
+			std::cout << "ERROR::TRIANGLEMESHBVH::LoadFromFile::Size of " << filepath << " doesn't match its header" << std::endl;
+			return false;
+		}
+
+		std::vector<Node> loadedNodes(header.numNodes);
+		std::vector<glm::vec3> loadedVertices(header.numVertices);
+		file.read(reinterpret_cast<char*>(loadedNodes.data()), loadedNodes.size() * sizeof(Node));
+		file.read(reinterpret_cast<char*>(loadedVertices.data()), loadedVertices.size() * sizeof(glm::vec3));
+		if (!file) { return false; }
+
+		nodes = std::move(loadedNodes);
+		vertices = std::move(loadedVertices);
+		if (!ValidateTree()) {
+			std::cout << "ERROR::TRIANGLEMESHBVH::LoadFromFile::Invalid tree in " << filepath << std::endl;
+			nodes.clear();
+			vertices.clear();
+			return false;
+		}
+
+		maxTrianglesPerLeaf = header.maxTrianglesPerLeaf;
+		sourceHash = header.sourceHash;
+		return true;
+	}
+
+	bool TriangleMeshBVH::ValidateTree() const
+	{
+		if (nodes.empty()) { return vertices.empty(); }
+
+		const uint64_t numNodes = nodes.size();
+		const uint64_t numTriangles = NumTriangles();
+		std::vector<unsigned int> depths(nodes.size(), 0);
+		depths[0] = 1;
+
+		for (unsigned int i = 0; i < nodes.size(); i++) {
+			const Node& node = nodes[i];
+			if (node.count > 0) {
+				if ((uint64_t)node.first + node.count > numTriangles) { return false; }
+				continue;
+			}
+
+			// Children after their parent rules out cycles, and with one parent each a child's depth is known by the time it's reached
+			if (node.first <= i || (uint64_t)node.first + 1 >= numNodes) { return false; }
+			if (depths[node.first] != 0 || depths[node.first + 1] != 0 || depths[i] + 1 >= MAX_STACK_DEPTH) { return false; }
+			depths[node.first] = depths[i] + 1;
+			depths[node.first + 1] = depths[i] + 1;
+		}
+		return true;
+	}
+
+	bool TriangleMeshBVH::Cast(const glm::mat4& model, const glm::mat4& inverseModel, const glm::vec3& origin, const glm::vec3& direction, const float radius, const float maxDistance, float& out_distance, glm::vec3& out_normal, unsigned int& out_triangle, const bool reportInitialOverlap) const
+	{
+		if (nodes.size() == 0) { return false; }
+
+		// The tree is walked in local space, distances along the local ray match world distances as the direction isn't normalised
+		// A world space sphere can reach at most radius / smallest scale in local space, so nodes are grown by that
+		const glm::vec3 localOrigin = glm::vec3(inverseModel * glm::vec4(origin, 1.0f));
+		const glm::vec3 localDirection = glm::vec3(inverseModel * glm::vec4(direction, 0.0f));
+		const glm::vec3 inverseDirection = SafeInverse(localDirection);
+		const float smallestScale = std::min(glm::length(glm::vec3(model[0])), std::min(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+		const glm::vec3 grow = glm::vec3(radius / std::max(smallestScale, 1e-6f));
+
+		float closest = maxDistance;
+		bool hit = false;
+
+		unsigned int stack[MAX_STACK_DEPTH];
+		unsigned int stackSize = 0;
+		stack[stackSize++] = 0;
+
+		while (stackSize > 0) {
+			const Node& node = nodes[stack[--stackSize]];
+
+			float entry;
+			if (!RayBox(localOrigin, inverseDirection, node.boundsMin - grow, node.boundsMax + grow, closest, entry)) { continue; }
+
+			if (node.count == 0) {
+				// Nearest child is pushed last so it is visited first
+				float entryA, entryB;
+				const Node& childA = nodes[node.first];
+				const Node& childB = nodes[node.first + 1];
+				const bool hitA = RayBox(localOrigin, inverseDirection, childA.boundsMin - grow, childA.boundsMax + grow, closest, entryA);
+				const bool hitB = RayBox(localOrigin, inverseDirection, childB.boundsMin - grow, childB.boundsMax + grow, closest, entryB);
+				assert(stackSize + 2 <= MAX_STACK_DEPTH);
+
+				if (hitA && hitB) {
+					const bool aFirst = entryA <= entryB;
+					stack[stackSize++] = aFirst ? node.first + 1 : node.first;
+					stack[stackSize++] = aFirst ? node.first : node.first + 1;
+				}
+				else if (hitA) { stack[stackSize++] = node.first; }
+				else if (hitB) { stack[stackSize++] = node.first + 1; }
+				continue;
+			}
+
+			for (unsigned int triangle = node.first; triangle < node.first + node.count; triangle++) {
+				const glm::vec3* local = TriangleVertices(triangle);
+				const glm::vec3 a = glm::vec3(model * glm::vec4(local[0], 1.0f));
+				const glm::vec3 b = glm::vec3(model * glm::vec4(local[1], 1.0f));
+				const glm::vec3 c = glm::vec3(model * glm::vec4(local[2], 1.0f));
+
+				if (!reportInitialOverlap && radius > 0.0f) {
+					const glm::vec3 offset = ClosestPointOnTriangle(origin, a, b, c) - origin;
+					if (glm::dot(offset, offset) <= radius * radius) { continue; }
+				}
+
+				float distance;
+				glm::vec3 normal;
+				if (SphereCastTriangle(origin, direction, radius, a, b, c, closest, distance, normal)) {
+					closest = distance;
+					out_normal = normal;
+					out_triangle = triangle;
+					hit = true;
+				}
+			}
+		}
+
+		if (hit) { out_distance = closest; }
+		return hit;
+	}
+
+	glm::vec3 TriangleMeshBVH::ClosestPointOnTriangle(const glm::vec3& point, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+	{
+		// Voronoi region tests from Real-Time Collision Detection (Ericson) 5.1.5
+		const glm::vec3 ab = b - a;
+		const glm::vec3 ac = c - a;
+		const glm::vec3 ap = point - a;
+		const float d1 = glm::dot(ab, ap);
+		const float d2 = glm::dot(ac, ap);
+		if (d1 <= 0.0f && d2 <= 0.0f) { return a; }
+
+		const glm::vec3 bp = point - b;
+		const float d3 = glm::dot(ab, bp);
+		const float d4 = glm::dot(ac, bp);
+		if (d3 >= 0.0f && d4 <= d3) { return b; }
+
+		const float vc = (d1 * d4) - (d3 * d2);
+		if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) { return a + ab * (d1 / (d1 - d3)); }
+
+		const glm::vec3 cp = point - c;
+		const float d5 = glm::dot(ab, cp);
+		const float d6 = glm::dot(ac, cp);
+		if (d6 >= 0.0f && d5 <= d6) { return c; }
+
+		const float vb = (d5 * d2) - (d1 * d6);
+		if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) { return a + ac * (d2 / (d2 - d6)); }
+
+		const float va = (d3 * d6) - (d5 * d4);
+		if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) { return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6))); }
+
+		const float denominator = 1.0f / (va + vb + vc);
+		return a + ab * (vb * denominator) + ac * (vc * denominator);
+	}
+
+	bool TriangleMeshBVH::PointInTriangle(const glm::vec3& point, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+	{
+		// Point is assumed to lie on the triangle's plane
+		const glm::vec3 normal = glm::cross(b - a, c - a);
+		if (glm::dot(glm::cross(b - a, point - a), normal) < 0.0f) { return false; }
+		if (glm::dot(glm::cross(c - b, point - b), normal) < 0.0f) { return false; }
+		if (glm::dot(glm::cross(a - c, point - c), normal) < 0.0f) { return false; }
+		return true;
+	}
+
+	bool TriangleMeshBVH::RayTriangle(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const float maxDistance, float& out_distance)
+	{
+		// Moller-Trumbore, triangles are double sided
+		const glm::vec3 edgeA = b - a;
+		const glm::vec3 edgeB = c - a;
+		const glm::vec3 p = glm::cross(direction, edgeB);
+		const float determinant = glm::dot(edgeA, p);
+		if (fabs(determinant) < 1e-12f) { return false; }
+
+		const float inverseDeterminant = 1.0f / determinant;
+		const glm::vec3 s = origin - a;
+		const float u = glm::dot(s, p) * inverseDeterminant;
+		if (u < 0.0f || u > 1.0f) { return false; }
+
+		const glm::vec3 q = glm::cross(s, edgeA);
+		const float v = glm::dot(direction, q) * inverseDeterminant;
+		if (v < 0.0f || u + v > 1.0f) { return false; }
+
+		const float t = glm::dot(edgeB, q) * inverseDeterminant;
+		if (t < 0.0f || t > maxDistance) { return false; }
+
+		out_distance = t;
+		return true;
+	}
+
+	bool TriangleMeshBVH::SphereCastTriangle(const glm::vec3& origin, const glm::vec3& direction, const float radius, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const float maxDistance, float& out_distance, glm::vec3& out_normal)
+	{
+		const glm::vec3 faceNormal = glm::normalize(glm::cross(b - a, c - a));
+
+		if (radius <= 0.0f) {
+			if (!RayTriangle(origin, direction, a, b, c, maxDistance, out_distance)) { return false; }
+			out_normal = (glm::dot(faceNormal, direction) > 0.0f) ? -faceNormal : faceNormal;
+			return true;
+		}
+
+		// Starting inside counts as an immediate hit
+		const glm::vec3 startOffset = origin - ClosestPointOnTriangle(origin, a, b, c);
+		if (glm::dot(startOffset, startOffset) <= radius * radius) {
+			out_distance = 0.0f;
+			out_normal = -direction;
+			return true;
+		}
+
+		// Face: the sphere touches the plane first, which is final if the touching point is inside the triangle
+		const float originHeight = glm::dot(origin - a, faceNormal);
+		const glm::vec3 side = (originHeight >= 0.0f) ? faceNormal : -faceNormal;
+		const float approach = glm::dot(direction, side);
+		if (approach < 0.0f) {
+			const float t = (fabs(originHeight) - radius) / -approach;
+			if (t >= 0.0f && t <= maxDistance) {
+				const glm::vec3 touching = origin + direction * t - side * radius;
+				if (PointInTriangle(touching, a, b, c)) {
+					out_distance = t;
+					out_normal = side;
+					return true;
+				}
+			}
+		}
+
+		// Otherwise the first contact is on an edge or a vertex
+		float closest = maxDistance;
+		bool hit = false;
+		const glm::vec3* corners[3] = { &a, &b, &c };
+		for (int i = 0; i < 3; i++) {
+			const glm::vec3& p = *corners[i];
+			const glm::vec3& q = *corners[(i + 1) % 3];
+
+			float t;
+			glm::vec3 axisPoint;
+			if (RayCylinder(origin, direction, p, q, radius, t, axisPoint) && t <= closest) {
+				closest = t;
+				out_normal = glm::normalize(origin + direction * t - axisPoint);
+				hit = true;
+			}
+
+			if (RaySphere(origin, direction, p, radius, t) && t <= closest) {
+				closest = t;
+				out_normal = glm::normalize(origin + direction * t - p);
+				hit = true;
+			}
+		}
+
+		if (hit) { out_distance = closest; }
+		return hit;
+	}
+
+	bool TriangleMeshBVH::BoxTriangleOverlap(const glm::vec3& boxCentre, const glm::vec3 boxAxes[3], const glm::vec3& boxHalfExtents, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, glm::vec3& out_axis, float& out_depth)
+	{
+		float bestWeighted = FLT_MAX;
+
+		// Returns false if the axis separates the shapes
+		auto testAxis = [&](glm::vec3 axis, const float bias) {
+			const float lengthSqr = glm::dot(axis, axis);
+			if (lengthSqr < 1e-12f) { return true; } // parallel edges, covered by the face axes
+			axis /= sqrt(lengthSqr);
+
+			const float boxCentreProjection = glm::dot(boxCentre, axis);
+			const float boxRadius = boxHalfExtents.x * fabs(glm::dot(boxAxes[0], axis)) + boxHalfExtents.y * fabs(glm::dot(boxAxes[1], axis)) + boxHalfExtents.z * fabs(glm::dot(boxAxes[2], axis));
+			const float projectionA = glm::dot(a, axis);
+			const float projectionB = glm::dot(b, axis);
+			const float projectionC = glm::dot(c, axis);
+			const float triangleMin = std::min(projectionA, std::min(projectionB, projectionC));
+			const float triangleMax = std::max(projectionA, std::max(projectionB, projectionC));
+
+			// Distance the box would have to move along +axis or -axis to separate
+			const float overlapPositive = triangleMax - (boxCentreProjection - boxRadius);
+			const float overlapNegative = (boxCentreProjection + boxRadius) - triangleMin;
+			if (overlapPositive < 0.0f || overlapNegative < 0.0f) { return false; }
+
+			const float depth = std::min(overlapPositive, overlapNegative);
+			if (depth * bias < bestWeighted) {
+				bestWeighted = depth * bias;
+				out_depth = depth;
+				out_axis = (overlapPositive <= overlapNegative) ? axis : -axis;
+			}
+			return true;
+		};
+
+		const glm::vec3 edges[3] = { b - a, c - b, a - c };
+
+		if (!testAxis(glm::cross(edges[0], c - a), 1.0f)) { return false; }
+		for (int i = 0; i < 3; i++) {
+			if (!testAxis(boxAxes[i], NON_FACE_AXIS_BIAS)) { return false; }
+		}
+		for (int i = 0; i < 3; i++) {
+			for (int j = 0; j < 3; j++) {
+				if (!testAxis(glm::cross(boxAxes[i], edges[j]), NON_FACE_AXIS_BIAS)) { return false; }
+			}
+		}
+		return bestWeighted < FLT_MAX;
+	}
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cfloat>
+#include <cassert>
+#include <glm/ext/vector_float3.hpp>
+#include <glm/ext/matrix_float4x4.hpp>
+namespace Engine {
+	// Bounding volume hierarchy over the triangles of a static mesh, used as the mid phase between a mesh collider's bounds and its triangles
+	// Everything is stored in the mesh's local space. Built once from vertex and index data then cached to disk, see ResourceManager::LoadCollisionMesh
+	class TriangleMeshBVH
+	{
+	public:
+		TriangleMeshBVH(const unsigned int maxTrianglesPerLeaf = 4u) : maxTrianglesPerLeaf(maxTrianglesPerLeaf), sourceHash(0) {}
+		~TriangleMeshBVH() {}
+
+		// Indices are a triangle list, degenerate triangles are dropped
+		void Build(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& indices);
+
+		// Cooked data is only loaded when it was built from source data with the same hash, otherwise the tree is left empty
+		bool WriteToFile(const std::string& filepath) const;
+		bool LoadFromFile(const std::string& filepath, const uint64_t expectedSourceHash);
+		static uint64_t HashSource(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& indices);
+		uint64_t SourceHash() const { return sourceHash; }
+
+		unsigned int NumTriangles() const { return vertices.size() / 3; }
+		unsigned int NumNodes() const { return nodes.size(); }
+		const glm::vec3* TriangleVertices(const unsigned int triangle) const { return &vertices[triangle * 3]; }
+
+		// Local space bounds of the whole mesh
+		glm::vec3 BoundsMin() const { return nodes.size() > 0 ? nodes[0].boundsMin : glm::vec3(0.0f); }
+		glm::vec3 BoundsMax() const { return nodes.size() > 0 ? nodes[0].boundsMax : glm::vec3(0.0f); }
+
+		// Calls func(triangleIndex) for every triangle whose bounds overlap the local space box
+		template <typename Func>
+		void ForEachTriangle(const glm::vec3& boxMin, const glm::vec3& boxMax, Func&& func) const {
+			if (nodes.size() == 0) { return; }
+
+			unsigned int stack[MAX_STACK_DEPTH];
+			unsigned int stackSize = 0;
+			stack[stackSize++] = 0;
+
+			while (stackSize > 0) {
+				const Node& node = nodes[stack[--stackSize]];
+				if (node.boundsMin.x > boxMax.x || node.boundsMin.y > boxMax.y || node.boundsMin.z > boxMax.z || node.boundsMax.x < boxMin.x || node.boundsMax.y < boxMin.y || node.boundsMax.z < boxMin.z) { continue; }
+
+				if (node.count > 0) {
+					for (unsigned int triangle = node.first; triangle < node.first + node.count; triangle++) {
+						func(triangle);
+					}
+				}
+				else {
+					assert(stackSize + 2 <= MAX_STACK_DEPTH);
+					stack[stackSize++] = node.first;
+					stack[stackSize++] = node.first + 1;
+				}
+			}
+		}
+
+		// Nearest hit of a ray (radius 0) or swept sphere against the mesh under a model matrix, all in world space. The direction must be normalised
+		// With reportInitialOverlap false, triangles the sphere already touches at the start are ignored rather than returned as a hit at distance 0
+		bool Cast(const glm::mat4& model, const glm::mat4& inverseModel, const glm::vec3& origin, const glm::vec3& direction, const float radius, const float maxDistance, float& out_distance, glm::vec3& out_normal, unsigned int& out_triangle, const bool reportInitialOverlap = true) const;
+
+		// Triangle routines shared by the mesh narrowphase and spatial queries
+		static glm::vec3 ClosestPointOnTriangle(const glm::vec3& point, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c);
+		static bool PointInTriangle(const glm::vec3& point, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c);
+		static bool RayTriangle(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const float maxDistance, float& out_distance);
+		static bool SphereCastTriangle(const glm::vec3& origin, const glm::vec3& direction, const float radius, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const float maxDistance, float& out_distance, glm::vec3& out_normal);
+
+		// Separating axis test of an oriented box against a triangle. On overlap returns the axis of least penetration, pointing from the triangle towards the box
+		static bool BoxTriangleOverlap(const glm::vec3& boxCentre, const glm::vec3 boxAxes[3], const glm::vec3& boxHalfExtents, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, glm::vec3& out_axis, float& out_depth);
+
+	private:
+		// Traversal keeps one sibling per level on the stack plus the two children of the deepest node, so trees are limited to MAX_STACK_DEPTH - 1 levels
+		static constexpr unsigned int MAX_STACK_DEPTH = 64;
+
+		// Leaves have count > 0 and hold triangles [first, first + count). Interior nodes have their two children at first and first + 1
+		struct Node {
+			glm::vec3 boundsMin;
+			unsigned int first;
+			glm::vec3 boundsMax;
+			unsigned int count;
+		};
+
+		void BuildNode(const unsigned int nodeIndex, const unsigned int depth, const unsigned int begin, const unsigned int end, std::vector<unsigned int>& order, const std::vector<glm::vec3>& centroids, const std::vector<glm::vec3>& triangleMin, const std::vector<glm::vec3>& triangleMax);
+
+		// Every node's triangle range and children are inside the arrays, children come after their parent and the tree fits the traversal stack
+		bool ValidateTree() const;
+
+		std::vector<Node> nodes;
+		std::vector<glm::vec3> vertices; // three per triangle, in leaf order
+		unsigned int maxTrianglesPerLeaf;
+		uint64_t sourceHash;
+	};
+}